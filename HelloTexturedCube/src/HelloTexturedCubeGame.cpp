@@ -28,6 +28,8 @@ void HelloTexturedCubeGame::BaseGame_LoadContent()
 	GetCameraSpirit().MoveTo(Point3::Replicate(3));
 	GetCameraSpirit().LookAt(Point3(0), true);
 
+	DeclareRenderState(_rotation); // With pipelined frames draw gets a copy.
+
 	// Create geometry:
 	{
 		const Vertex cubeVerts[] =
@@ -112,13 +114,14 @@ void HelloTexturedCubeGame::BaseGame_LoadContent()
 
 void HelloTexturedCubeGame::BaseGame_UnloadContent()
 {
+	UndeclareRenderState(_rotation);
 }
 
 void HelloTexturedCubeGame::BaseGame_Update()
 {
 	VERUS_QREF_TIMER;
 
-	_rotation += Vector3(dt * 0.03f, dt * 0.05f, dt * 0.07f);
+	_rotation.GetForUpdate() += Vector3(dt * 0.03f, dt * 0.05f, dt * 0.07f);
 }
 
 void HelloTexturedCubeGame::BaseGame_Draw()
@@ -147,10 +150,10 @@ void HelloTexturedCubeGame::BaseGame_DrawView(CGI::RcViewDesc viewDesc)
 		renderer.GetFramebufferHandle_AutoWithDepth(renderer->GetSwapChainBufferIndex()),
 		{ Vector4(0), Vector4(1) });
 
-	World::RCamera camera = GetDefaultCamera();
+	World::RCamera camera = GetDrawCamera();
 	camera.SetAspectRatio(renderer.GetCurrentViewAspectRatio());
 	camera.Update();
-	Transform3 matW = Transform3::rotationZYX(_rotation);
+	Transform3 matW = Transform3::rotationZYX(_rotation.GetForDraw());
 
 	_ubShaderVS._matW = matW.UniformBufferFormat();
 	_ubShaderVS._matVP = camera.GetMatrixVP().UniformBufferFormat();
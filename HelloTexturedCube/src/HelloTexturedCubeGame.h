@@ -25,17 +25,17 @@ namespace verus
 				float _phase;
 			};
 
-			Vector3          _rotation = Vector3(0);
-			CGI::GeometryPwn _geo;
-			CGI::ShaderPwn   _shader;
-			CGI::PipelinePwn _pipe;
-			CGI::TexturePwn  _tex;
-			CSZ              _shaderCode;
-			CGI::CSHandle    _csh; // Complex set handle. Simple set has one uniform buffer. Complex set additionally has textures.
-			UB_ShaderVS      _ubShaderVS;
-			UB_ShaderFS      _ubShaderFS;
-			int              _vertCount = 0;
-			int              _indexCount = 0;
+			RenderState<Vector3> _rotation = Vector3(0); // Update changes it, draw uses it, see EnablePipelinedFrames().
+			CGI::GeometryPwn     _geo;
+			CGI::ShaderPwn       _shader;
+			CGI::PipelinePwn     _pipe;
+			CGI::TexturePwn      _tex;
+			CSZ                  _shaderCode;
+			CGI::CSHandle        _csh; // Complex set handle. Simple set has one uniform buffer. Complex set additionally has textures.
+			UB_ShaderVS          _ubShaderVS;
+			UB_ShaderFS          _ubShaderFS;
+			int                  _vertCount = 0;
+			int                  _indexCount = 0;
 
 		public:
 			HelloTexturedCubeGame();
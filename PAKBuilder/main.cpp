@@ -4,15 +4,21 @@
 *	PACK format with compression & encryption.
 *
 *	OFFSET DATA
-*	0      "2PAK"
+*	0      "3PAK" ("2PAK" for legacy format)
 *	4      entries offset
 *	12     entries size
 *	20     uncompressed file size
-*	28     compressed & encrypted data
+*	28     data block (see IO::PakBlockHeader), 2PAK: compressed & encrypted data
 *	...
 *	10000  filename
 *	10240  offset in PACK file
-*	10248  compressed file size + 8 bytes (see offset 20)
+*	10248  data block size + 8 bytes (see offset 20)
+*
+*	Options:
+*	-v2               write legacy 2PAK
+*	-codec=lz|zlib|none
+*	-nocipher         don't encrypt 3PAK chunks
+*	-bench            also build 2PAK and compare load throughput
 *
 *******************************************************************************/
 #include <verus.h>
@@ -37,42 +43,72 @@ WCHAR                 g_outputDir[MAX_PATH] = {};
 WIN32_FIND_DATA       g_fd = {};
 int                   g_depth = 0;
 std::queue<FileEntry> g_fileEntries;
+bool                  g_legacy = false;
+bool                  g_cipher = true;
+bool                  g_bench = false;
+IO::CodecType         g_codec = IO::CodecType::lz;
 
+void BuildPAK(RcString pathname);
+void Benchmark(RcString pathnameV2, RcString pathnameV3);
 void TraverseDirectory(CWSZ parentDir, CWSZ foundDir, IO::RFile pakFile);
 
 void Run()
 {
-	std::wcout << _T("PACK Builder 1.3") << std::endl;
+	std::wcout << _T("PACK Builder 1.4") << std::endl;
 	std::wcout << _T("Copyright (c) 2006-2022 Dmitry Maluev") << std::endl;
-	std::wcout << _T("Arguments: [PAK/folder name] [input directory] [PAK output directory]") << std::endl;
+	std::wcout << _T("Arguments: [PAK/folder name] [input directory] [PAK output directory] [options]") << std::endl;
 
 	int argCount;
 	LPWSTR* argArray = CommandLineToArgvW(GetCommandLine(), &argCount);
-	if (argCount < 2)
+	Vector<CWSZ> vArgs;
+	VERUS_FOR(i, argCount)
+	{
+		if (i > 0 && L'-' == argArray[i][0])
+		{
+			if (!wcscmp(argArray[i], _T("-v2")))
+				g_legacy = true;
+			else if (!wcscmp(argArray[i], _T("-nocipher")))
+				g_cipher = false;
+			else if (!wcscmp(argArray[i], _T("-bench")))
+				g_bench = true;
+			else if (!wcscmp(argArray[i], _T("-codec=lz")))
+				g_codec = IO::CodecType::lz;
+			else if (!wcscmp(argArray[i], _T("-codec=zlib")))
+				g_codec = IO::CodecType::zlib;
+			else if (!wcscmp(argArray[i], _T("-codec=none")))
+				g_codec = IO::CodecType::none;
+			else
+				std::wcerr << _T("WARNING: Unknown option: ") << argArray[i] << std::endl;
+			continue;
+		}
+		vArgs.push_back(argArray[i]);
+	}
+	const int posArgCount = Utils::Cast32(vArgs.size());
+	if (posArgCount < 2)
 	{
 		std::wcout << _T("Enter PAK/folder name: ");
 		std::wcin.getline(g_filename, MAX_PATH);
 	}
 	else
 	{
-		wcscpy_s(g_filename, MAX_PATH, argArray[1]);
+		wcscpy_s(g_filename, MAX_PATH, vArgs[1]);
 	}
-	if (argCount > 2)
+	if (posArgCount > 2)
 	{
-		wcscpy_s(g_inputDir, MAX_PATH, argArray[2]);
+		wcscpy_s(g_inputDir, MAX_PATH, vArgs[2]);
 	}
 	else
 	{
-		wcscpy_s(g_inputDir, MAX_PATH, argArray[0]);
+		wcscpy_s(g_inputDir, MAX_PATH, vArgs[0]);
 		PathRemoveFileSpec(g_inputDir);
 	}
-	if (argCount > 3)
+	if (posArgCount > 3)
 	{
-		wcscpy_s(g_outputDir, MAX_PATH, argArray[3]);
+		wcscpy_s(g_outputDir, MAX_PATH, vArgs[3]);
 	}
 	else
 	{
-		wcscpy_s(g_outputDir, MAX_PATH, argArray[0]);
+		wcscpy_s(g_outputDir, MAX_PATH, vArgs[0]);
 		PathRemoveFileSpec(g_outputDir);
 	}
 	LocalFree(argArray);
@@ -82,13 +118,35 @@ void Run()
 
 	std::wstringstream ssPathName;
 	ssPathName << g_outputDir << _T("\\") << g_filename << _T(".pak");
+	const String pathname = Str::WideToUtf8(ssPathName.str());
+	BuildPAK(pathname);
+
+	if (g_bench)
+	{
+		std::wstringstream ssPathNameV2;
+		ssPathNameV2 << g_outputDir << _T("\\") << g_filename << _T(".2pak.tmp");
+		const String pathnameV2 = Str::WideToUtf8(ssPathNameV2.str());
+		const bool legacy = g_legacy;
+		g_legacy = true;
+		BuildPAK(pathnameV2);
+		g_legacy = legacy;
+		Benchmark(pathnameV2, pathname);
+		IO::FileSystem::Delete(_C(pathnameV2));
+	}
+
+	if (posArgCount < 2)
+		system("pause");
+}
+
+void BuildPAK(RcString pathname)
+{
 	IO::File pakFile;
-	if (!pakFile.Open(_C(Str::WideToUtf8(ssPathName.str())), "wb"))
+	if (!pakFile.Open(_C(pathname), "wb"))
 	{
-		std::wcerr << _T("ERROR: Unable to create file ") << g_filename << _T(".pak. Error code: 0x") << std::hex << GetLastError() << std::endl;
+		std::wcerr << _T("ERROR: Unable to create file ") << _C(Str::Utf8ToWide(pathname)) << _T(". Error code: 0x") << std::hex << GetLastError() << std::endl;
 		throw std::exception();
 	}
-	const UINT32 magic = 'KAP2';
+	const UINT32 magic = g_legacy ? IO::PakArchive::s_magicV2 : IO::PakArchive::s_magicV3;
 	pakFile << magic;
 	INT64 temp = 0;
 	pakFile << temp;
@@ -123,11 +181,52 @@ void Run()
 	pakFile.Seek(12, SEEK_SET);
 	pakFile << entriesSize;
 	pakFile.Close();
-	if (argCount < 2)
-		system("pause");
 }
 
-INT64 WriteData(CWSZ name, RcString password, IO::RFile pakFile, const BYTE* p, INT64 size)
+void Benchmark(RcString pathnameV2, RcString pathnameV3)
+{
+	const int runCount = 3;
+
+	auto LoadAll = [](RcString pathname, INT64& totalSize)
+	{
+		IO::PakArchive pak;
+		if (!pak.Init(_C(pathname)))
+		{
+			std::wcerr << _T("ERROR: Unable to open file ") << _C(Str::Utf8ToWide(pathname)) << std::endl;
+			throw std::exception();
+		}
+		double best = std::numeric_limits<double>::max();
+		Vector<BYTE> vData;
+		VERUS_FOR(run, runCount)
+		{
+			totalSize = 0;
+			const std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+			const INT64 entryCount = pak.GetEntryCount();
+			VERUS_FOR(i, entryCount)
+			{
+				const IO::PakArchive::Entry entry = pak.GetEntryAt(i);
+				IO::FileSystem::LoadResourceFromPAK(entry._name, vData, IO::FileSystem::LoadDesc(), pak, entry._name);
+				totalSize += vData.size();
+			}
+			const std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+			best = Math::Min(best, std::chrono::duration_cast<std::chrono::duration<double>>(t1 - t0).count());
+		}
+		return best;
+	};
+
+	INT64 sizeV2 = 0, sizeV3 = 0;
+	const double timeV2 = LoadAll(pathnameV2, sizeV2);
+	const double timeV3 = LoadAll(pathnameV3, sizeV3);
+	const double mb = 1.0 / (1024 * 1024);
+
+	std::wcout << std::endl;
+	std::wcout << _T("Benchmark (best of ") << runCount << _T(" runs, ") << (sizeV3 * mb) << _T(" MB):") << std::endl;
+	std::wcout << _T("  2PAK: ") << (timeV2 * 1000) << _T(" ms, ") << (sizeV2 * mb / timeV2) << _T(" MB/s") << std::endl;
+	std::wcout << _T("  3PAK: ") << (timeV3 * 1000) << _T(" ms, ") << (sizeV3 * mb / timeV3) << _T(" MB/s") << std::endl;
+	std::wcout << _T("  Speedup: ") << (timeV2 / timeV3) << _T("x") << std::endl;
+}
+
+INT64 WriteDataV2(CWSZ name, RcString password, IO::RFile pakFile, const BYTE* p, INT64 size)
 {
 	pakFile << size;
 	uLongf zipSize = uLongf(size) * 2;
@@ -145,6 +244,23 @@ INT64 WriteData(CWSZ name, RcString password, IO::RFile pakFile, const BYTE* p,
 	return sizeof(INT64) + zipSize;
 }
 
+INT64 WriteData(CWSZ name, RcString password, IO::RFile pakFile, const BYTE* p, INT64 size, int part = 0)
+{
+	if (g_legacy)
+		return WriteDataV2(name, password, pakFile, p, size);
+
+	Vector<BYTE> vBlock;
+	if (!IO::FileSystem::EncodePakData(g_codec, g_cipher, password, p, size, vBlock, part))
+	{
+		std::wcerr << _T("ERROR: Unable to compress file: ") << name << std::endl;
+		throw std::exception();
+	}
+
+	pakFile << size;
+	pakFile.Write(vBlock.data(), vBlock.size());
+	return sizeof(INT64) + vBlock.size();
+}
+
 INT64 WriteTexture(CWSZ name, RcString password, IO::RFile pakFile, const Vector<BYTE>& vData)
 {
 	size_t headerSize = sizeof(IO::DDSHeader);
@@ -202,7 +318,7 @@ INT64 WriteTexture(CWSZ name, RcString password, IO::RFile pakFile, const Vector
 
 		const INT64 partOffset = pakFile.GetPosition() - pakStartPos;
 		const INT64 partSize64 = partSize;
-		const INT64 partZipSize = WriteData(name, password, pakFile, vPart.data(), partSize);
+		const INT64 partZipSize = WriteData(name, password, pakFile, vPart.data(), partSize, part);
 
 		pakFile.Seek(pakStartPos + headerSize + part * sizeof(INT64) * 3, SEEK_SET);
 		pakFile << partOffset;
@@ -0,0 +1,10 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+#include "GeometryNull.h"
+#include "TextureNull.h"
+#include "ShaderNull.h"
+#include "PipelineNull.h"
+#include "CommandBufferNull.h"
+#include "ExtRealityNull.h"
+#include "RendererNull.h"
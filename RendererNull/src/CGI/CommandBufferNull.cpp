@@ -0,0 +1,134 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "pch.h"
+
+using namespace verus;
+using namespace verus::CGI;
+
+CommandBufferNull::CommandBufferNull()
+{
+}
+
+CommandBufferNull::~CommandBufferNull()
+{
+	Done();
+}
+
+void CommandBufferNull::Init()
+{
+	VERUS_INIT();
+}
+
+void CommandBufferNull::Done()
+{
+	VERUS_DONE(CommandBufferNull);
+}
+
+void CommandBufferNull::InitOneTimeSubmit()
+{
+	Init();
+}
+
+void CommandBufferNull::DoneOneTimeSubmit()
+{
+	Done();
+}
+
+void CommandBufferNull::Begin()
+{
+}
+
+void CommandBufferNull::End()
+{
+}
+
+void CommandBufferNull::PipelineImageMemoryBarrier(TexturePtr tex, ImageLayout oldLayout, ImageLayout newLayout, Range mipLevels, Range arrayLayers)
+{
+}
+
+void CommandBufferNull::BeginRenderPass(RPHandle renderPassHandle, FBHandle framebufferHandle, std::initializer_list<Vector4> ilClearValues, ViewportScissorFlags vsf)
+{
+	VERUS_QREF_RENDERER_NULL;
+
+	RendererNull::RcFramebuffer framebuffer = pRendererNull->GetFramebuffer(framebufferHandle);
+	SetViewportAndScissor(vsf, framebuffer._width, framebuffer._height);
+}
+
+void CommandBufferNull::NextSubpass()
+{
+}
+
+void CommandBufferNull::EndRenderPass()
+{
+}
+
+void CommandBufferNull::BindPipeline(PipelinePtr pipe)
+{
+	VERUS_QREF_RENDERER_NULL;
+	pRendererNull->CountPipelineBind();
+}
+
+void CommandBufferNull::SetViewport(std::initializer_list<Vector4> il, float minDepth, float maxDepth)
+{
+	if (il.size() > 0)
+	{
+		const float w = il.begin()->Width();
+		const float h = il.begin()->Height();
+		_viewportSize = Vector4(w, h, 1 / w, 1 / h);
+	}
+}
+
+void CommandBufferNull::SetScissor(std::initializer_list<Vector4> il)
+{
+}
+
+void CommandBufferNull::SetBlendConstants(const float* p)
+{
+}
+
+void CommandBufferNull::BindVertexBuffers(GeometryPtr geo, UINT32 bindingsFilter)
+{
+}
+
+void CommandBufferNull::BindIndexBuffer(GeometryPtr geo)
+{
+}
+
+bool CommandBufferNull::BindDescriptors(ShaderPtr shader, int setNumber, CSHandle complexSetHandle)
+{
+	VERUS_QREF_RENDERER_NULL;
+	auto& shaderNull = static_cast<RShaderNull>(*shader);
+	pRendererNull->CountDescriptorBind(shaderNull.GetUniformBufferSize(setNumber));
+	return true;
+}
+
+void CommandBufferNull::PushConstants(ShaderPtr shader, int offset, int size, const void* p, ShaderStageFlags stageFlags)
+{
+}
+
+void CommandBufferNull::Draw(int vertexCount, int instanceCount, int firstVertex, int firstInstance)
+{
+	VERUS_QREF_RENDERER_NULL;
+	pRendererNull->CountDraw(vertexCount, instanceCount);
+}
+
+void CommandBufferNull::DrawIndexed(int indexCount, int instanceCount, int firstIndex, int vertexOffset, int firstInstance)
+{
+	VERUS_QREF_RENDERER_NULL;
+	pRendererNull->CountDraw(indexCount, instanceCount);
+}
+
+void CommandBufferNull::Dispatch(int groupCountX, int groupCountY, int groupCountZ)
+{
+	VERUS_QREF_RENDERER_NULL;
+	pRendererNull->CountDispatch();
+}
+
+void CommandBufferNull::DispatchMesh(int groupCountX, int groupCountY, int groupCountZ)
+{
+	VERUS_QREF_RENDERER_NULL;
+	pRendererNull->CountDispatch();
+}
+
+void CommandBufferNull::TraceRays(int width, int height, int depth)
+{
+}
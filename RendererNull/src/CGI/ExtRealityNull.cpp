@@ -0,0 +1,25 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "pch.h"
+
+using namespace verus;
+using namespace verus::CGI;
+
+ExtRealityNull::ExtRealityNull()
+{
+}
+
+ExtRealityNull::~ExtRealityNull()
+{
+	Done();
+}
+
+XrSwapchain ExtRealityNull::GetSwapChain(int viewIndex)
+{
+	return XR_NULL_HANDLE;
+}
+
+void ExtRealityNull::GetSwapChainSize(int viewIndex, int32_t& w, int32_t& h)
+{
+	w = 0;
+	h = 0;
+}
@@ -0,0 +1,21 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace CGI
+	{
+		// OpenXR is not supported, this object is never initialized.
+		class ExtRealityNull : public BaseExtReality
+		{
+		public:
+			ExtRealityNull();
+			virtual ~ExtRealityNull() override;
+
+		private:
+			virtual XrSwapchain GetSwapChain(int viewIndex) override;
+			virtual void GetSwapChainSize(int viewIndex, int32_t& w, int32_t& h) override;
+		};
+		VERUS_TYPEDEFS(ExtRealityNull);
+	}
+}
@@ -0,0 +1,80 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "pch.h"
+
+using namespace verus;
+using namespace verus::CGI;
+
+GeometryNull::GeometryNull()
+{
+}
+
+GeometryNull::~GeometryNull()
+{
+	Done();
+}
+
+void GeometryNull::Init(RcGeometryDesc desc)
+{
+	VERUS_INIT();
+
+	_name = desc._name;
+	_dynBindingsMask = desc._dynBindingsMask;
+	_32BitIndices = desc._32BitIndices;
+
+	int i = 0;
+	while (desc._pVertexInputAttrDesc[i]._offset >= 0)
+	{
+		const int binding = desc._pVertexInputAttrDesc[i]._binding;
+		if (binding < 0)
+			_instBindingsMask |= (1 << -binding);
+		i++;
+	}
+
+	_vStrides.reserve(GetBindingCount(desc._pVertexInputAttrDesc));
+	i = 0;
+	while (desc._pStrides[i] > 0)
+	{
+		_vStrides.push_back(desc._pStrides[i]);
+		i++;
+	}
+
+	_vVertexBufferSizes.reserve(4);
+}
+
+void GeometryNull::Done()
+{
+	ForceScheduled();
+
+	VERUS_DONE(GeometryNull);
+}
+
+void GeometryNull::CreateVertexBuffer(int count, int binding)
+{
+	if (_vVertexBufferSizes.size() <= binding)
+		_vVertexBufferSizes.resize(binding + 1);
+	_vVertexBufferSizes[binding] = static_cast<INT64>(count) * _vStrides[binding];
+}
+
+void GeometryNull::UpdateVertexBuffer(const void* p, int binding, PBaseCommandBuffer pCB, INT64 size, INT64 offset)
+{
+	VERUS_QREF_RENDERER_NULL;
+	pRendererNull->CountUpload(size ? size * _vStrides[binding] : _vVertexBufferSizes[binding]);
+}
+
+void GeometryNull::CreateIndexBuffer(int count)
+{
+	const int elementSize = _32BitIndices ? sizeof(UINT32) : sizeof(UINT16);
+	_indexBufferSize = static_cast<INT64>(count) * elementSize;
+}
+
+void GeometryNull::UpdateIndexBuffer(const void* p, PBaseCommandBuffer pCB, INT64 size, INT64 offset)
+{
+	VERUS_QREF_RENDERER_NULL;
+	const int elementSize = _32BitIndices ? sizeof(UINT32) : sizeof(UINT16);
+	pRendererNull->CountUpload(size ? size * elementSize : _indexBufferSize);
+}
+
+Continue GeometryNull::Scheduled_Update()
+{
+	return Continue::yes;
+}
@@ -0,0 +1,31 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace CGI
+	{
+		class GeometryNull : public BaseGeometry
+		{
+			Vector<INT64> _vVertexBufferSizes;
+			Vector<int>   _vStrides;
+			INT64         _indexBufferSize = 0;
+
+		public:
+			GeometryNull();
+			virtual ~GeometryNull() override;
+
+			virtual void Init(RcGeometryDesc desc) override;
+			virtual void Done() override;
+
+			virtual void CreateVertexBuffer(int count, int binding) override;
+			virtual void UpdateVertexBuffer(const void* p, int binding, PBaseCommandBuffer pCB, INT64 size, INT64 offset) override;
+
+			virtual void CreateIndexBuffer(int count) override;
+			virtual void UpdateIndexBuffer(const void* p, PBaseCommandBuffer pCB, INT64 size, INT64 offset) override;
+
+			virtual Continue Scheduled_Update() override;
+		};
+		VERUS_TYPEDEFS(GeometryNull);
+	}
+}
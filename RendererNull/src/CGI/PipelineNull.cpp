@@ -0,0 +1,26 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "pch.h"
+
+using namespace verus;
+using namespace verus::CGI;
+
+PipelineNull::PipelineNull()
+{
+}
+
+PipelineNull::~PipelineNull()
+{
+	Done();
+}
+
+void PipelineNull::Init(RcPipelineDesc desc)
+{
+	VERUS_INIT();
+
+	_vertexInputBindingsFilter = desc._vertexInputBindingsFilter;
+}
+
+void PipelineNull::Done()
+{
+	VERUS_DONE(PipelineNull);
+}
@@ -0,0 +1,19 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace CGI
+	{
+		class PipelineNull : public BasePipeline
+		{
+		public:
+			PipelineNull();
+			virtual ~PipelineNull() override;
+
+			virtual void Init(RcPipelineDesc desc) override;
+			virtual void Done() override;
+		};
+		VERUS_TYPEDEFS(PipelineNull);
+	}
+}
@@ -0,0 +1,286 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "pch.h"
+
+using namespace verus;
+using namespace verus::CGI;
+
+RendererNull::RendererNull()
+{
+}
+
+RendererNull::~RendererNull()
+{
+	Done();
+}
+
+void RendererNull::ReleaseMe()
+{
+	Free();
+	TestAllocCount();
+}
+
+void RendererNull::Init()
+{
+	VERUS_INIT();
+
+	_vRenderPasses.reserve(20);
+	_vFramebuffers.reserve(40);
+
+	_swapChainBufferCount = 2;
+}
+
+void RendererNull::Done()
+{
+	WaitIdle();
+
+	if (ImGui::GetCurrentContext())
+	{
+		ImGui::DestroyContext();
+		Renderer::I().ImGuiSetCurrentContext(nullptr);
+	}
+
+	DeleteFramebuffer(FBHandle::Make(-2));
+	DeleteRenderPass(RPHandle::Make(-2));
+
+	VERUS_DONE(RendererNull);
+}
+
+void RendererNull::ImGuiInit(RPHandle renderPassHandle)
+{
+	VERUS_QREF_RENDERER;
+	VERUS_QREF_CONST_SETTINGS;
+
+	IMGUI_CHECKVERSION();
+	ImGuiContext* pContext = ImGui::CreateContext();
+	renderer.ImGuiSetCurrentContext(pContext);
+	auto& io = ImGui::GetIO();
+	io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
+	io.ConfigWindowsMoveFromTitleBarOnly = true;
+	io.IniFilename = nullptr;
+	if (!settings._imguiFont.empty())
+	{
+		Vector<BYTE> vData;
+		IO::FileSystem::LoadResource(_C(settings._imguiFont), vData);
+		void* pFontData = IM_ALLOC(vData.size());
+		memcpy(pFontData, vData.data(), vData.size());
+		io.Fonts->AddFontFromMemoryTTF(pFontData, Utils::Cast32(vData.size()), static_cast<float>(settings.GetFontSize()), nullptr, io.Fonts->GetGlyphRangesCyrillic());
+	}
+
+	ImGui::StyleColorsDark();
+
+	// There is no platform or renderer backend, but font atlas must be built anyway:
+	BYTE* pPixels = nullptr;
+	int width = 0, height = 0;
+	io.Fonts->GetTexDataAsRGBA32(&pPixels, &width, &height);
+}
+
+void RendererNull::ImGuiRenderDrawData()
+{
+	VERUS_QREF_RENDERER;
+	renderer.UpdateUtilization();
+	ImGui::Render();
+}
+
+void RendererNull::ResizeSwapChain()
+{
+}
+
+PBaseExtReality RendererNull::GetExtReality()
+{
+	return &_extReality;
+}
+
+void RendererNull::BeginFrame()
+{
+	VERUS_QREF_RENDERER;
+
+	_swapChainBufferIndex = -1;
+
+	auto& io = ImGui::GetIO();
+	io.DisplaySize = ImVec2(
+		static_cast<float>(renderer.GetScreenSwapChainWidth()),
+		static_cast<float>(renderer.GetScreenSwapChainHeight()));
+	ImGui::NewFrame();
+}
+
+void RendererNull::AcquireSwapChainImage()
+{
+	_swapChainBufferIndex = 0;
+}
+
+void RendererNull::EndFrame()
+{
+	UpdateScheduled();
+
+	ImGui::EndFrame();
+
+	_ringBufferIndex = (_ringBufferIndex + 1) % s_ringBufferSize;
+}
+
+void RendererNull::WaitIdle()
+{
+}
+
+void RendererNull::OnMinimized()
+{
+}
+
+// Resources:
+
+PBaseCommandBuffer RendererNull::InsertCommandBuffer()
+{
+	return TStoreCommandBuffers::Insert();
+}
+
+PBaseGeometry RendererNull::InsertGeometry()
+{
+	return TStoreGeometry::Insert();
+}
+
+PBasePipeline RendererNull::InsertPipeline()
+{
+	return TStorePipelines::Insert();
+}
+
+PBaseShader RendererNull::InsertShader()
+{
+	return TStoreShaders::Insert();
+}
+
+PBaseTexture RendererNull::InsertTexture()
+{
+	return TStoreTextures::Insert();
+}
+
+void RendererNull::DeleteCommandBuffer(PBaseCommandBuffer p)
+{
+	TStoreCommandBuffers::Delete(static_cast<PCommandBufferNull>(p));
+}
+
+void RendererNull::DeleteGeometry(PBaseGeometry p)
+{
+	TStoreGeometry::Delete(static_cast<PGeometryNull>(p));
+}
+
+void RendererNull::DeletePipeline(PBasePipeline p)
+{
+	TStorePipelines::Delete(static_cast<PPipelineNull>(p));
+}
+
+void RendererNull::DeleteShader(PBaseShader p)
+{
+	TStoreShaders::Delete(static_cast<PShaderNull>(p));
+}
+
+void RendererNull::DeleteTexture(PBaseTexture p)
+{
+	TStoreTextures::Delete(static_cast<PTextureNull>(p));
+}
+
+RPHandle RendererNull::CreateRenderPass(std::initializer_list<RP::Attachment> ilA, std::initializer_list<RP::Subpass> ilS, std::initializer_list<RP::Dependency> ilD)
+{
+	RenderPass renderPass;
+	renderPass._subpassCount = Utils::Cast32(ilS.size());
+
+	const int nextIndex = GetNextRenderPassIndex();
+	if (nextIndex >= _vRenderPasses.size())
+		_vRenderPasses.push_back(renderPass);
+	else
+		_vRenderPasses[nextIndex] = renderPass;
+
+	return RPHandle::Make(nextIndex);
+}
+
+FBHandle RendererNull::CreateFramebuffer(RPHandle renderPassHandle, std::initializer_list<TexturePtr> il, int w, int h, int swapChainBufferIndex, CubeMapFace cubeMapFace)
+{
+	RcRenderPass renderPass = GetRenderPass(renderPassHandle);
+	Framebuffer framebuffer;
+	framebuffer._subpassCount = renderPass._subpassCount;
+	framebuffer._width = w;
+	framebuffer._height = h;
+
+	const int nextIndex = GetNextFramebufferIndex();
+	if (nextIndex >= _vFramebuffers.size())
+		_vFramebuffers.push_back(framebuffer);
+	else
+		_vFramebuffers[nextIndex] = framebuffer;
+
+	return FBHandle::Make(nextIndex);
+}
+
+void RendererNull::DeleteRenderPass(RPHandle handle)
+{
+	if (handle.IsSet())
+		_vRenderPasses[handle.Get()] = RenderPass();
+	else if (-2 == handle.Get())
+		_vRenderPasses.clear();
+}
+
+void RendererNull::DeleteFramebuffer(FBHandle handle)
+{
+	if (handle.IsSet())
+		_vFramebuffers[handle.Get()] = Framebuffer();
+	else if (-2 == handle.Get())
+		_vFramebuffers.clear();
+}
+
+int RendererNull::GetNextRenderPassIndex() const
+{
+	const int count = Utils::Cast32(_vRenderPasses.size());
+	VERUS_FOR(i, count)
+	{
+		if (!_vRenderPasses[i]._subpassCount)
+			return i;
+	}
+	return count;
+}
+
+int RendererNull::GetNextFramebufferIndex() const
+{
+	const int count = Utils::Cast32(_vFramebuffers.size());
+	VERUS_FOR(i, count)
+	{
+		if (!_vFramebuffers[i]._subpassCount)
+			return i;
+	}
+	return count;
+}
+
+RendererNull::RcRenderPass RendererNull::GetRenderPass(RPHandle handle) const
+{
+	return _vRenderPasses[handle.Get()];
+}
+
+RendererNull::RcFramebuffer RendererNull::GetFramebuffer(FBHandle handle) const
+{
+	return _vFramebuffers[handle.Get()];
+}
+
+// Stats:
+
+void RendererNull::CountDraw(int vertexCount, int instanceCount)
+{
+	_stats._drawCount++;
+	_stats._vertexCount += static_cast<UINT64>(vertexCount) * instanceCount;
+}
+
+void RendererNull::CountDispatch()
+{
+	_stats._dispatchCount++;
+}
+
+void RendererNull::CountPipelineBind()
+{
+	_stats._pipelineBindCount++;
+}
+
+void RendererNull::CountDescriptorBind(int uniformBufferSize)
+{
+	_stats._descriptorBindCount++;
+	_stats._uploadedBytes += uniformBufferSize;
+}
+
+void RendererNull::CountUpload(INT64 size)
+{
+	_stats._uploadedBytes += size;
+}
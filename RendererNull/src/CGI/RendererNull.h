@@ -0,0 +1,101 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace CGI
+	{
+		typedef Store<CommandBufferNull> TStoreCommandBuffers;
+		typedef Store<GeometryNull>      TStoreGeometry;
+		typedef Store<PipelineNull>      TStorePipelines;
+		typedef Store<ShaderNull>        TStoreShaders;
+		typedef Store<TextureNull>       TStoreTextures;
+		// Renderer without GPU for headless mode. All the engine code runs as usual, but nothing is drawn.
+		// Draw calls, bindings and uploads are counted, so that CPU cost of a frame can be measured on build agents.
+		class RendererNull : public Singleton<RendererNull>, public BaseRenderer,
+			private TStoreCommandBuffers, private TStoreGeometry, private TStorePipelines, private TStoreShaders, private TStoreTextures
+		{
+		public:
+			struct RenderPass
+			{
+				int _subpassCount = 0;
+			};
+			VERUS_TYPEDEFS(RenderPass);
+
+			struct Framebuffer
+			{
+				int _subpassCount = 0;
+				int _width = 0;
+				int _height = 0;
+			};
+			VERUS_TYPEDEFS(Framebuffer);
+
+		private:
+			ExtRealityNull      _extReality;
+			Vector<RenderPass>  _vRenderPasses;
+			Vector<Framebuffer> _vFramebuffers;
+
+		public:
+			RendererNull();
+			~RendererNull();
+
+			virtual void ReleaseMe() override;
+
+			void Init();
+			void Done();
+
+			virtual void ImGuiInit(RPHandle renderPassHandle) override;
+			virtual void ImGuiRenderDrawData() override;
+
+			virtual void ResizeSwapChain() override;
+
+			virtual PBaseExtReality GetExtReality() override;
+
+			// Which graphics API?
+			virtual Gapi GetGapi() override { return Gapi::null; }
+
+			// <FrameCycle>
+			virtual void BeginFrame() override;
+			virtual void AcquireSwapChainImage() override;
+			virtual void EndFrame() override;
+			virtual void WaitIdle() override;
+			virtual void OnMinimized() override;
+			// </FrameCycle>
+
+			// <Resources>
+			virtual PBaseCommandBuffer InsertCommandBuffer() override;
+			virtual PBaseGeometry      InsertGeometry() override;
+			virtual PBasePipeline      InsertPipeline() override;
+			virtual PBaseShader        InsertShader() override;
+			virtual PBaseTexture       InsertTexture() override;
+
+			virtual void DeleteCommandBuffer(PBaseCommandBuffer p) override;
+			virtual void DeleteGeometry(PBaseGeometry p) override;
+			virtual void DeletePipeline(PBasePipeline p) override;
+			virtual void DeleteShader(PBaseShader p) override;
+			virtual void DeleteTexture(PBaseTexture p) override;
+
+			virtual RPHandle CreateRenderPass(std::initializer_list<RP::Attachment> ilA, std::initializer_list<RP::Subpass> ilS, std::initializer_list<RP::Dependency> ilD) override;
+			virtual FBHandle CreateFramebuffer(RPHandle renderPassHandle, std::initializer_list<TexturePtr> il, int w, int h,
+				int swapChainBufferIndex = -1, CubeMapFace cubeMapFace = CubeMapFace::none) override;
+			virtual void DeleteRenderPass(RPHandle handle) override;
+			virtual void DeleteFramebuffer(FBHandle handle) override;
+			int GetNextRenderPassIndex() const;
+			int GetNextFramebufferIndex() const;
+			RcRenderPass GetRenderPass(RPHandle handle) const;
+			RcFramebuffer GetFramebuffer(FBHandle handle) const;
+			// </Resources>
+
+			// <Stats>
+			void CountDraw(int vertexCount, int instanceCount);
+			void CountDispatch();
+			void CountPipelineBind();
+			void CountDescriptorBind(int uniformBufferSize);
+			void CountUpload(INT64 size);
+			// </Stats>
+		};
+		VERUS_TYPEDEFS(RendererNull);
+	}
+}
+
+#define VERUS_QREF_RENDERER_NULL CGI::PRendererNull pRendererNull = CGI::RendererNull::P()
@@ -0,0 +1,77 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "pch.h"
+
+using namespace verus;
+using namespace verus::CGI;
+
+ShaderNull::ShaderNull()
+{
+}
+
+ShaderNull::~ShaderNull()
+{
+	Done();
+}
+
+void ShaderNull::Init(CSZ source, CSZ sourceName, CSZ* branches)
+{
+	VERUS_INIT();
+
+	_sourceName = sourceName; // Nothing to compile.
+}
+
+void ShaderNull::Done()
+{
+	VERUS_DONE(ShaderNull);
+}
+
+void ShaderNull::CreateDescriptorSet(int setNumber, const void* pSrc, int size, int capacity, std::initializer_list<Sampler> il, ShaderStageFlags stageFlags)
+{
+	VERUS_RT_ASSERT(_vUniformBufferSizes.size() == setNumber);
+	VERUS_RT_ASSERT(!(reinterpret_cast<intptr_t>(pSrc) & 0xF));
+
+	_vUniformBufferSizes.push_back(size);
+}
+
+void ShaderNull::CreatePipelineLayout()
+{
+}
+
+CSHandle ShaderNull::BindDescriptorSetTextures(int setNumber, std::initializer_list<TexturePtr> il, const int* pMipLevels, const int* pArrayLayers)
+{
+	// <NewComplexSetHandle>
+	int complexSetHandle = -1;
+	VERUS_FOR(i, _vComplexSets.size())
+	{
+		if (!_vComplexSets[i])
+		{
+			complexSetHandle = i;
+			break;
+		}
+	}
+	if (-1 == complexSetHandle)
+	{
+		complexSetHandle = Utils::Cast32(_vComplexSets.size());
+		_vComplexSets.resize(complexSetHandle + 1);
+	}
+	// </NewComplexSetHandle>
+
+	_vComplexSets[complexSetHandle] = true;
+
+	return CSHandle::Make(complexSetHandle);
+}
+
+void ShaderNull::FreeDescriptorSet(CSHandle& complexSetHandle)
+{
+	if (complexSetHandle.IsSet() && complexSetHandle.Get() < _vComplexSets.size())
+		_vComplexSets[complexSetHandle.Get()] = false;
+	complexSetHandle = CSHandle();
+}
+
+void ShaderNull::BeginBindDescriptors()
+{
+}
+
+void ShaderNull::EndBindDescriptors()
+{
+}
@@ -0,0 +1,36 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace CGI
+	{
+		class ShaderNull : public BaseShader
+		{
+			Vector<int>  _vUniformBufferSizes;
+			Vector<bool> _vComplexSets; // True if the handle is in use.
+
+		public:
+			ShaderNull();
+			virtual ~ShaderNull() override;
+
+			virtual void Init(CSZ source, CSZ sourceName, CSZ* branches) override;
+			virtual void Done() override;
+
+			virtual void CreateDescriptorSet(int setNumber, const void* pSrc, int size, int capacity, std::initializer_list<Sampler> il, ShaderStageFlags stageFlags) override;
+			virtual void CreatePipelineLayout() override;
+			virtual CSHandle BindDescriptorSetTextures(int setNumber, std::initializer_list<TexturePtr> il, const int* pMipLevels, const int* pArrayLayers) override;
+			virtual void FreeDescriptorSet(CSHandle& complexSetHandle) override;
+
+			virtual void BeginBindDescriptors() override;
+			virtual void EndBindDescriptors() override;
+
+			//
+			// Null
+			//
+
+			int GetUniformBufferSize(int setNumber) const { return _vUniformBufferSizes[setNumber]; }
+		};
+		VERUS_TYPEDEFS(ShaderNull);
+	}
+}
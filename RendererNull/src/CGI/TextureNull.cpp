@@ -0,0 +1,85 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "pch.h"
+
+using namespace verus;
+using namespace verus::CGI;
+
+TextureNull::TextureNull()
+{
+}
+
+TextureNull::~TextureNull()
+{
+	Done();
+}
+
+void TextureNull::Init(RcTextureDesc desc)
+{
+	VERUS_INIT();
+	VERUS_RT_ASSERT(desc._width > 0 && desc._height > 0);
+	VERUS_QREF_RENDERER;
+
+	// Variables:
+	_size = Vector4(
+		float(desc._width),
+		float(desc._height),
+		1.f / desc._width,
+		1.f / desc._height);
+	if (desc._name)
+		_name = desc._name;
+	_desc = desc;
+	_initAtFrame = renderer.GetFrameCount();
+	if (desc._flags & TextureDesc::Flags::anyShaderResource)
+		_mainLayout = ImageLayout::xsReadOnly;
+	_bytesPerPixel = FormatToBytesPerPixel(desc._format);
+
+	_desc._mipLevels = _desc._mipLevels ? _desc._mipLevels : Math::ComputeMipLevels(_desc._width, _desc._height, _desc._depth);
+	if (_desc._flags & TextureDesc::Flags::cubeMap)
+		_desc._arrayLayers *= +CubeMapFace::count;
+}
+
+void TextureNull::Done()
+{
+	ForceScheduled();
+
+	VERUS_DONE(TextureNull);
+}
+
+void TextureNull::UpdateSubresource(const void* p, int mipLevel, int arrayLayer, PBaseCommandBuffer pCB)
+{
+	VERUS_QREF_RENDERER_NULL;
+
+	const int w = Math::Max(1, _desc._width >> mipLevel);
+	const int h = Math::Max(1, _desc._height >> mipLevel);
+	const int d = Math::Max(1, _desc._depth >> mipLevel);
+
+	INT64 size;
+	if (IsBC(_desc._format))
+		size = IO::DDSHeader::ComputeBcLevelSize(w, h, Is4BitsBC(_desc._format));
+	else
+		size = static_cast<INT64>(_bytesPerPixel) * w * h;
+	pRendererNull->CountUpload(size * d);
+}
+
+bool TextureNull::ReadbackSubresource(void* p, bool recordCopyCommand, PBaseCommandBuffer pCB)
+{
+	VERUS_QREF_RENDERER;
+
+	if (p) // There is no GPU, so the data is always zero:
+	{
+		const int w = Math::Max(1, _desc._width >> _desc._readbackMip);
+		const int h = Math::Max(1, _desc._height >> _desc._readbackMip);
+		memset(p, 0, _bytesPerPixel * w * h);
+	}
+
+	return _initAtFrame + BaseRenderer::s_ringBufferSize < renderer.GetFrameCount();
+}
+
+void TextureNull::GenerateMips(PBaseCommandBuffer pCB)
+{
+}
+
+Continue TextureNull::Scheduled_Update()
+{
+	return Continue::yes;
+}
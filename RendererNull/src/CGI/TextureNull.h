@@ -0,0 +1,26 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace CGI
+	{
+		class TextureNull : public BaseTexture
+		{
+		public:
+			TextureNull();
+			virtual ~TextureNull() override;
+
+			virtual void Init(RcTextureDesc desc) override;
+			virtual void Done() override;
+
+			virtual void UpdateSubresource(const void* p, int mipLevel, int arrayLayer, PBaseCommandBuffer pCB) override;
+			virtual bool ReadbackSubresource(void* p, bool recordCopyCommand, PBaseCommandBuffer pCB) override;
+
+			virtual void GenerateMips(PBaseCommandBuffer pCB) override;
+
+			virtual Continue Scheduled_Update() override;
+		};
+		VERUS_TYPEDEFS(TextureNull);
+	}
+}
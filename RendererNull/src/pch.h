@@ -0,0 +1,6 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+#include <verus.h>
+
+#include "CGI/CGI.h"
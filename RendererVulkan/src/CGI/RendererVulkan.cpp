@@ -55,6 +55,7 @@ void RendererVulkan::Init()
 	_vFramebuffers.reserve(40);
 
 	VulkanCompilerInit();
+	InitShaderCache();
 
 	if (settings._openXR)
 		_extReality.Init();
@@ -172,6 +173,19 @@ bool RendererVulkan::VulkanCompile(CSZ source, CSZ sourceName, CSZ* defines, Bas
 #endif
 }
 
+CSZ RendererVulkan::VulkanCompilerVersion()
+{
+#ifdef _WIN32
+	PFNVULKANCOMPILERVERSION VulkanCompilerVersion = reinterpret_cast<PFNVULKANCOMPILERVERSION>(
+		GetProcAddress(LoadLibraryA("VulkanShaderCompiler.dll"), "VulkanCompilerVersion"));
+	return VulkanCompilerVersion();
+#else
+	PFNVULKANCOMPILERVERSION VulkanCompilerVersion = reinterpret_cast<PFNVULKANCOMPILERVERSION>(
+		dlsym(dlopen("./libVulkanShaderCompiler.so", RTLD_LAZY), "VulkanCompilerVersion"));
+	return VulkanCompilerVersion();
+#endif
+}
+
 VKAPI_ATTR VkBool32 VKAPI_CALL RendererVulkan::DebugUtilsMessengerCallback(
 	VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverityFlagBits,
 	VkDebugUtilsMessageTypeFlagsEXT messageTypeFlags,
@@ -724,6 +738,24 @@ void RendererVulkan::CreateSamplers()
 	// </Clamp>
 }
 
+void RendererVulkan::InitShaderCache()
+{
+	_shaderCompilerVersion = VulkanCompilerVersion();
+	VERUS_LOG_INFO("Shader compiler: " << _shaderCompilerVersion);
+
+	_shaderCachePath.clear();
+	const String writablePath = _C(Utils::I().GetWritablePath());
+	if (writablePath.empty())
+		return;
+	const String path = writablePath + "ShaderCacheVulkan";
+#ifdef _WIN32
+	CreateDirectoryA(_C(path), nullptr);
+#else
+	mkdir(_C(path), 0755);
+#endif
+	_shaderCachePath = path + "/";
+}
+
 VkCommandBuffer RendererVulkan::CreateVkCommandBuffer(VkCommandPool commandPool)
 {
 	VkResult res = VK_SUCCESS;
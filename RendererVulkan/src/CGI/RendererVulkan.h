@@ -87,6 +87,8 @@ namespace verus
 			Vector<VkSampler>        _vSamplers;
 			Vector<VkRenderPass>     _vRenderPasses;
 			Vector<Framebuffer>      _vFramebuffers;
+			String                   _shaderCachePath;
+			String                   _shaderCompilerVersion;
 			bool                     _advancedLineRasterization = false;
 
 		public:
@@ -102,6 +104,7 @@ namespace verus
 			static void VulkanCompilerDone();
 			static bool VulkanCompile(CSZ source, CSZ sourceName, CSZ* defines, BaseShaderInclude* pInclude,
 				CSZ entryPoint, CSZ target, UINT32 flags, UINT32** ppCode, UINT32* pSize, CSZ* ppErrorMsgs);
+			static CSZ VulkanCompilerVersion();
 
 		private:
 			static VKAPI_ATTR VkBool32 VKAPI_CALL DebugUtilsMessengerCallback(
@@ -126,6 +129,7 @@ namespace verus
 			void CreateCommandPools();
 			void CreateSyncObjects();
 			void CreateSamplers();
+			void InitShaderCache();
 
 		public:
 			// <CreateAndGet>
@@ -209,6 +213,10 @@ namespace verus
 			virtual void UpdateUtilization() override;
 
 			bool IsAdvancedLineRasterizationSupported() const { return _advancedLineRasterization; }
+
+			// Compiled SPIR-V is stored in this directory, empty if there is no writable path:
+			RcString GetShaderCachePath() const { return _shaderCachePath; }
+			RcString GetShaderCompilerVersion() const { return _shaderCompilerVersion; }
 		};
 		VERUS_TYPEDEFS(RendererVulkan);
 	}
@@ -219,6 +227,7 @@ namespace verus
 		typedef void(*PFNVULKANCOMPILERDONE)();
 		typedef bool(*PFNVULKANCOMPILE)(CSZ source, CSZ sourceName, CSZ* defines, CGI::BaseShaderInclude* pInclude,
 			CSZ entryPoint, CSZ target, UINT32 flags, UINT32** ppCode, UINT32* pSize, CSZ* ppErrorMsgs);
+		typedef CSZ(*PFNVULKANCOMPILERVERSION)();
 	}
 }
 
@@ -38,37 +38,55 @@ void ShaderVulkan::Init(CSZ source, CSZ sourceName, CSZ* branches)
 {
 	VERUS_INIT();
 	VERUS_QREF_CONST_SETTINGS;
+	VERUS_QREF_RENDERER_VULKAN;
 
 	_sourceName = sourceName;
-	ShaderInclude inc;
 #ifdef _DEBUG
 	const UINT32 flags = 1;
 #else
 	const UINT32 flags = 0;
 #endif
-	UINT32* pCode = nullptr;
-	UINT32 size = 0;
-	CSZ pErrorMsgs = nullptr;
 
-	auto CheckErrorMsgs = [this](CSZ pErrorMsgs)
-	{
-		if (pErrorMsgs)
-			OnError(pErrorMsgs);
-	};
+	static const char s_stageLetters[] = "VHDGFC";
+	static CSZ s_targets[] = { "vs", "hs", "ds", "gs", "fs", "cs" };
+	static CSZ s_typeDefines[] = { "_VS", "_HS", "_DS", "_GS", "_FS", "_CS" };
 
-	auto CreateShaderModule = [](const UINT32* pCode, UINT32 size, VkShaderModule& shaderModule)
+	RcString cachePath = pRendererVulkan->GetShaderCachePath();
+	const String sourceHash = cachePath.empty() ? String() : ComputeSourceHash(source);
+
+	auto CreateShaderModule = [](const Vector<UINT32>& vCode, VkShaderModule& shaderModule)
 	{
-		if (!pCode || !size)
+		if (vCode.empty())
 			return;
 		VERUS_QREF_RENDERER_VULKAN;
 		VkResult res = VK_SUCCESS;
 		VkShaderModuleCreateInfo vksmci = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
-		vksmci.codeSize = size;
-		vksmci.pCode = pCode;
+		vksmci.codeSize = vCode.size() * sizeof(UINT32);
+		vksmci.pCode = vCode.data();
 		if (VK_SUCCESS != (res = vkCreateShaderModule(pRendererVulkan->GetVkDevice(), &vksmci, pRendererVulkan->GetAllocator(), &shaderModule)))
 			throw VERUS_RUNTIME_ERROR << "vkCreateShaderModule(); res=" << res;
 	};
 
+	// <System defines>
+	Vector<String> vSystemDefines;
+	vSystemDefines.reserve(12);
+	vSystemDefines.push_back("_ANISOTROPY_LEVEL");
+	vSystemDefines.push_back(std::to_string(settings._gpuAnisotropyLevel));
+	vSystemDefines.push_back("_SHADER_QUALITY");
+	vSystemDefines.push_back(std::to_string(settings._gpuShaderQuality));
+	vSystemDefines.push_back("_SHADOW_QUALITY");
+	vSystemDefines.push_back(std::to_string(settings._sceneShadowQuality));
+	vSystemDefines.push_back("_WATER_QUALITY");
+	vSystemDefines.push_back(std::to_string(settings._sceneWaterQuality));
+	vSystemDefines.push_back("VERUS_MAX_BONES");
+	vSystemDefines.push_back(std::to_string(VERUS_MAX_BONES));
+	vSystemDefines.push_back("_VULKAN");
+	vSystemDefines.push_back("1");
+	// </System defines>
+
+	// <Variants>
+	Vector<String> vBranches;
+	Vector<StageVariant> vVariants;
 	while (*branches)
 	{
 		String entry, stageEntries[+Stage::count], stages;
@@ -82,117 +100,106 @@ void ShaderVulkan::Init(CSZ source, CSZ sourceName, CSZ* branches)
 			continue;
 		}
 
-		// <User defines>
-		Vector<CSZ> vDefines;
-		vDefines.reserve(40);
-		const int count = Utils::Cast32(vMacroName.size());
-		VERUS_FOR(i, count)
-		{
-			vDefines.push_back(_C(vMacroName[i]));
-			vDefines.push_back(_C(vMacroValue[i]));
-		}
-		// </User defines>
-
-		// <System defines>
-		char defAnisotropyLevel[64] = {};
-		{
-			sprintf_s(defAnisotropyLevel, "%d", settings._gpuAnisotropyLevel);
-			vDefines.push_back("_ANISOTROPY_LEVEL");
-			vDefines.push_back(defAnisotropyLevel);
-		}
-		char defShaderQuality[64] = {};
-		{
-			sprintf_s(defShaderQuality, "%d", settings._gpuShaderQuality);
-			vDefines.push_back("_SHADER_QUALITY");
-			vDefines.push_back(defShaderQuality);
-		}
-		char defShadowQuality[64] = {};
-		{
-			sprintf_s(defShadowQuality, "%d", settings._sceneShadowQuality);
-			vDefines.push_back("_SHADOW_QUALITY");
-			vDefines.push_back(defShadowQuality);
-		}
-		char defWaterQuality[64] = {};
-		{
-			sprintf_s(defWaterQuality, "%d", settings._sceneWaterQuality);
-			vDefines.push_back("_WATER_QUALITY");
-			vDefines.push_back(defWaterQuality);
-		}
-		char defMaxNumBones[64] = {};
-		{
-			sprintf_s(defMaxNumBones, "%d", VERUS_MAX_BONES);
-			vDefines.push_back("VERUS_MAX_BONES");
-			vDefines.push_back(defMaxNumBones);
-		}
-		vDefines.push_back("_VULKAN");
-		vDefines.push_back("1");
-		const int typeIndex = Utils::Cast32(vDefines.size());
-		vDefines.push_back("_XS");
-		vDefines.push_back("1");
-		vDefines.push_back(nullptr);
-		// </System defines>
-
 		Compiled compiled;
 		compiled._entry = entry;
 
-		if (strchr(_C(stages), 'V'))
+		VERUS_FOR(i, +Stage::count)
 		{
+			if (!strchr(_C(stages), s_stageLetters[i]))
+				continue;
 			compiled._stageCount++;
-			vDefines[typeIndex] = "_VS";
-			if (!RendererVulkan::VulkanCompile(source, sourceName, vDefines.data(), &inc, _C(stageEntries[+Stage::vs]), "vs", flags, &pCode, &size, &pErrorMsgs))
-				CheckErrorMsgs(pErrorMsgs);
-			CreateShaderModule(pCode, size, compiled._shaderModules[+Stage::vs]);
-		}
+			if (Stage::cs == static_cast<Stage>(i))
+				_compute = true;
+
+			StageVariant variant;
+			variant._entry = stageEntries[i];
+			variant._compiledIndex = Utils::Cast32(vBranches.size());
+			variant._stage = static_cast<Stage>(i);
+			// User defines go first:
+			const int count = Utils::Cast32(vMacroName.size());
+			variant._vDefines.reserve(count * 2 + vSystemDefines.size() + 2);
+			VERUS_FOR(j, count)
+			{
+				variant._vDefines.push_back(vMacroName[j]);
+				variant._vDefines.push_back(vMacroValue[j]);
+			}
+			variant._vDefines.insert(variant._vDefines.end(), vSystemDefines.begin(), vSystemDefines.end());
+			variant._vDefines.push_back(s_typeDefines[i]);
+			variant._vDefines.push_back("1");
 
-		if (strchr(_C(stages), 'H'))
-		{
-			compiled._stageCount++;
-			vDefines[typeIndex] = "_HS";
-			if (!RendererVulkan::VulkanCompile(source, sourceName, vDefines.data(), &inc, _C(stageEntries[+Stage::hs]), "hs", flags, &pCode, &size, &pErrorMsgs))
-				CheckErrorMsgs(pErrorMsgs);
-			CreateShaderModule(pCode, size, compiled._shaderModules[+Stage::hs]);
-		}
+			if (!cachePath.empty())
+			{
+				StringStream ss;
+				ss << pRendererVulkan->GetShaderCompilerVersion() << "|" << sourceHash << "|" << sourceName << "|";
+				ss << variant._entry << "|" << s_targets[i] << "|" << flags;
+				for (const auto& x : variant._vDefines)
+					ss << "|" << x;
+				const String key = ss.str();
+				variant._key = Convert::ToMd5String(Vector<BYTE>(key.begin(), key.end()));
+			}
 
-		if (strchr(_C(stages), 'D'))
-		{
-			compiled._stageCount++;
-			vDefines[typeIndex] = "_DS";
-			if (!RendererVulkan::VulkanCompile(source, sourceName, vDefines.data(), &inc, _C(stageEntries[+Stage::ds]), "ds", flags, &pCode, &size, &pErrorMsgs))
-				CheckErrorMsgs(pErrorMsgs);
-			CreateShaderModule(pCode, size, compiled._shaderModules[+Stage::ds]);
+			vVariants.push_back(std::move(variant));
 		}
 
-		if (strchr(_C(stages), 'G'))
-		{
-			compiled._stageCount++;
-			vDefines[typeIndex] = "_GS";
-			if (!RendererVulkan::VulkanCompile(source, sourceName, vDefines.data(), &inc, _C(stageEntries[+Stage::gs]), "gs", flags, &pCode, &size, &pErrorMsgs))
-				CheckErrorMsgs(pErrorMsgs);
-			CreateShaderModule(pCode, size, compiled._shaderModules[+Stage::gs]);
-		}
+		vBranches.push_back(branch);
+		_mapCompiled[branch] = compiled;
+		branches++;
+	}
+	// </Variants>
 
-		if (strchr(_C(stages), 'F'))
-		{
-			compiled._stageCount++;
-			vDefines[typeIndex] = "_FS";
-			if (!RendererVulkan::VulkanCompile(source, sourceName, vDefines.data(), &inc, _C(stageEntries[+Stage::fs]), "fs", flags, &pCode, &size, &pErrorMsgs))
-				CheckErrorMsgs(pErrorMsgs);
-			CreateShaderModule(pCode, size, compiled._shaderModules[+Stage::fs]);
-		}
+	// <Compile>
+	Vector<int> vMissed;
+	vMissed.reserve(vVariants.size());
+	VERUS_FOR(i, Utils::Cast32(vVariants.size()))
+	{
+		RStageVariant variant = vVariants[i];
+		if (variant._key.empty() || !LoadFromCache(cachePath + variant._key + ".spv", variant._vCode))
+			vMissed.push_back(i);
+	}
+
+	// Compiler keeps its state per thread, so all missed variants can be compiled at once:
+	auto Compile = [&](int index)
+	{
+		RStageVariant variant = vVariants[vMissed[index]];
+		Vector<CSZ> vDefines;
+		vDefines.reserve(variant._vDefines.size() + 1);
+		for (const auto& x : variant._vDefines)
+			vDefines.push_back(_C(x));
+		vDefines.push_back(nullptr);
 
-		if (strchr(_C(stages), 'C'))
+		ShaderInclude inc;
+		UINT32* pCode = nullptr;
+		UINT32 size = 0;
+		CSZ pErrorMsgs = nullptr;
+		if (!RendererVulkan::VulkanCompile(source, sourceName, vDefines.data(), &inc, _C(variant._entry),
+			s_targets[+variant._stage], flags, &pCode, &size, &pErrorMsgs) && pErrorMsgs)
+			variant._errorMsgs = pErrorMsgs;
+		if (pCode && size)
 		{
-			compiled._stageCount++;
-			vDefines[typeIndex] = "_CS";
-			if (!RendererVulkan::VulkanCompile(source, sourceName, vDefines.data(), &inc, _C(stageEntries[+Stage::cs]), "cs", flags, &pCode, &size, &pErrorMsgs))
-				CheckErrorMsgs(pErrorMsgs);
-			CreateShaderModule(pCode, size, compiled._shaderModules[+Stage::cs]);
-			_compute = true;
+			// Copy it before the next compile on this thread:
+			variant._vCode.assign(pCode, pCode + size / sizeof(UINT32));
+			if (!variant._key.empty())
+				SaveToCache(cachePath + variant._key + ".spv", variant._vCode);
 		}
+	};
+	if (Jobs::IsValidSingleton() && Jobs::I().IsInitialized())
+	{
+		Jobs::I().ParallelFor(0, Utils::Cast32(vMissed.size()), Compile);
+	}
+	else
+	{
+		VERUS_FOR(i, Utils::Cast32(vMissed.size()))
+			Compile(i);
+	}
+	if (!vMissed.empty())
+		VERUS_LOG_DEBUG("Init(); " << sourceName << ", compiled " << vMissed.size() << " of " << vVariants.size() << " stages");
+	// </Compile>
 
-		_mapCompiled[branch] = compiled;
-
-		branches++;
+	for (const auto& variant : vVariants)
+	{
+		if (!variant._errorMsgs.empty())
+			OnError(_C(variant._errorMsgs));
+		CreateShaderModule(variant._vCode, _mapCompiled[vBranches[variant._compiledIndex]]._shaderModules[+variant._stage]);
 	}
 
 	_vDescriptorSetDesc.reserve(4);
@@ -685,6 +692,85 @@ void ShaderVulkan::OnError(CSZ s)
 		renderer.OnShaderWarning(s);
 }
 
+String ShaderVulkan::ComputeSourceHash(CSZ source)
+{
+	// Included files are also hashed, even if they are excluded by preprocessor:
+	Vector<BYTE> vAll(source, source + strlen(source));
+	Vector<String> vIncluded;
+	Vector<String> vPending;
+	auto FindIncludes = [&vIncluded, &vPending](CSZ text)
+	{
+		CSZ p = strstr(text, "#include");
+		while (p)
+		{
+			p += strlen("#include");
+			p += strspn(p, " \t");
+			if ('\"' == *p || '<' == *p)
+			{
+				const size_t span = strcspn(p + 1, "\">" VERUS_CRNL);
+				const String name(p + 1, span);
+				if (std::find(vIncluded.begin(), vIncluded.end(), name) == vIncluded.end())
+				{
+					vIncluded.push_back(name);
+					vPending.push_back(name);
+				}
+			}
+			p = strstr(p, "#include");
+		}
+	};
+
+	FindIncludes(source);
+	while (!vPending.empty())
+	{
+		const String name = vPending.back();
+		vPending.pop_back();
+		const String url = String("[Shaders]:") + name;
+		Vector<BYTE> vData;
+		IO::FileSystem::LoadResource(_C(url), vData, IO::FileSystem::LoadDesc(true, 0, false));
+		vAll.insert(vAll.end(), name.begin(), name.end());
+		vAll.push_back(0);
+		if (vData.empty())
+			continue;
+		vAll.insert(vAll.end(), vData.begin(), vData.end());
+		FindIncludes(reinterpret_cast<CSZ>(vData.data()));
+	}
+
+	return Convert::ToMd5String(vAll);
+}
+
+bool ShaderVulkan::LoadFromCache(RcString pathname, Vector<UINT32>& vCode)
+{
+	IO::File file;
+	if (!file.Open(_C(pathname), "rb"))
+		return false;
+	const INT64 size = file.GetSize();
+	if (size < 20 || (size & 0x3)) // Header has 5 words.
+		return false;
+	vCode.resize(size / sizeof(UINT32));
+	if (file.Read(vCode.data(), size) != size || vCode[0] != 0x07230203) // SPIR-V magic number.
+	{
+		vCode.clear();
+		return false;
+	}
+	return true;
+}
+
+void ShaderVulkan::SaveToCache(RcString pathname, const Vector<UINT32>& vCode)
+{
+	// Write to temporary file first, so that other instances never see a partial file:
+	StringStream ss;
+	ss << pathname << "." << std::this_thread::get_id() << ".tmp";
+	const String tmp = ss.str();
+	{
+		IO::File file;
+		if (!file.Open(_C(tmp), "wb"))
+			return;
+		file.Write(vCode.data(), vCode.size() * sizeof(UINT32));
+	}
+	if (std::rename(_C(tmp), _C(pathname)))
+		std::remove(_C(tmp));
+}
+
 void ShaderVulkan::UpdateUtilization()
 {
 	VERUS_QREF_RENDERER;
@@ -19,6 +19,19 @@ namespace verus
 		private:
 			typedef Map<String, Compiled> TMapCompiled;
 
+			// One stage of one branch, which is loaded from cache or compiled:
+			struct StageVariant
+			{
+				Vector<String> _vDefines; // Name and value pairs.
+				Vector<UINT32> _vCode;
+				String         _entry;
+				String         _key; // Empty if there is no cache.
+				String         _errorMsgs;
+				int            _compiledIndex = 0;
+				Stage          _stage = Stage::count;
+			};
+			VERUS_TYPEDEFS(StageVariant);
+
 			struct DescriptorSetDesc
 			{
 				Vector<Sampler>    _vSamplers;
@@ -85,6 +98,12 @@ namespace verus
 
 			void OnError(CSZ s);
 
+			// <Cache>
+			static String ComputeSourceHash(CSZ source);
+			static bool LoadFromCache(RcString pathname, Vector<UINT32>& vCode);
+			static void SaveToCache(RcString pathname, const Vector<UINT32>& vCode);
+			// </Cache>
+
 			void UpdateUtilization();
 		};
 		VERUS_TYPEDEFS(ShaderVulkan);
@@ -2,9 +2,11 @@
 #pragma once
 
 #include "Elastic.h"
+#include "CompiledMotion.h"
 #include "Motion.h"
 #include "Skeleton.h"
 #include "Animation.h"
+#include "Crowd.h"
 #include "Warp.h"
 #include "Orbit.h"
 #include "Shaker.h"
@@ -30,6 +30,7 @@ void Collection::Async_WhenLoaded(CSZ url, RcBlob blob)
 	md._motion.Deserialize(sp);
 	if (md._duration)
 		md._motion.ComputePlaybackSpeed(md._duration);
+	md._motion.Compile();
 }
 
 void Collection::AddMotion(CSZ name, bool loop, float duration)
@@ -46,6 +47,13 @@ void Collection::AddMotion(CSZ name, bool loop, float duration)
 	IO::Async::I().Load(name, this);
 }
 
+RMotionData Collection::InsertMotion(CSZ name, bool loop)
+{
+	RMotionData md = *TStoreMotions::Insert(name);
+	md._loop = loop;
+	return md;
+}
+
 void Collection::DeleteAll()
 {
 	IO::Async::Cancel(this);
@@ -76,6 +84,12 @@ Animation::~Animation()
 }
 
 void Animation::Update(int layerCount, PLayer pLayers)
+{
+	UpdateTime();
+	UpdateSkeleton(layerCount, pLayers);
+}
+
+void Animation::UpdateTime(bool deferEvents)
 {
 	VERUS_QREF_TIMER;
 
@@ -87,6 +101,7 @@ void Animation::Update(int layerCount, PLayer pLayers)
 	if (!_transitionMotion.GetBoneCount() && _pSkeleton->GetBoneCount())
 		_pSkeleton->InsertBonesIntoMotion(_transitionMotion);
 
+	_deferEvents = deferEvents;
 	if (_playing)
 	{
 		float dt2 = dt;
@@ -111,42 +126,70 @@ void Animation::Update(int layerCount, PLayer pLayers)
 				_time = md._loop ? fmod(_time, duration) : duration;
 				md._motion.ResetTriggers(GetTriggerStatesArray()); // New loop, reset triggers.
 				if (_pDelegate)
-					_pDelegate->Animation_OnEnd(_C(_currentMotion)); // This can call TransitionTo and change everything.
+				{
+					if (_deferEvents)
+					{
+						Event event;
+						event._name = _currentMotion;
+						event._end = true;
+						_vEvents.push_back(std::move(event));
+					}
+					else
+					{
+						_pDelegate->Animation_OnEnd(_C(_currentMotion)); // This can call TransitionTo and change everything.
+					}
+				}
 			}
 		}
 	}
-
-	UpdateSkeleton(layerCount, pLayers);
+	_deferEvents = false;
 }
 
-void Animation::UpdateSkeleton(int layerCount, PLayer pLayers)
+void Animation::UpdateSkeleton(int layerCount, PLayer pLayers, Skeleton::PPoseScratch pScratch)
 {
 	if (!_currentMotion.empty() && layerCount >= 0) // Special layer -1 should not modify the skeleton.
 	{
 		RMotionData md = *_pCollection->Find(_C(_currentMotion));
 
+		Skeleton::LayeredMotion motion;
+		motion._pMotion = &md._motion;
+		motion._pBlendMotion = GetBlendMotion();
+		motion._blendAlpha = GetBlendAlpha();
+		motion._time = _time;
+
 		int layeredMotionCount = 0;
 		Skeleton::LayeredMotion layeredMotions[s_maxLayers];
 
 		for (int i = 0; i < layerCount && i < s_maxLayers; ++i)
 		{
-			layeredMotions[i]._pMotion = pLayers[i]._pAnimation->GetMotion(); // Can be in blend state.
+			RAnimation animation = *pLayers[i]._pAnimation;
+			layeredMotions[i]._pMotion = animation.FindMotion();
+			layeredMotions[i]._pBlendMotion = animation.GetBlendMotion(); // Can be in blend state.
+			layeredMotions[i]._blendAlpha = animation.GetBlendAlpha();
 			layeredMotions[i]._rootBone = pLayers[i]._rootBone;
-			layeredMotions[i]._alpha = pLayers[i]._pAnimation->GetAlpha();
-			layeredMotions[i]._time = pLayers[i]._pAnimation->GetTime();
+			layeredMotions[i]._alpha = animation.GetAlpha();
+			layeredMotions[i]._time = animation.GetTime();
 			layeredMotionCount++;
 		}
 
-		if (_transition)
-		{
-			md._motion.BindBlendMotion(&_transitionMotion, Math::ApplyEasing(_easing, _transitionTime / _transitionDuration));
-			_pSkeleton->ApplyMotion(md._motion, _time, layeredMotionCount, layeredMotions);
-		}
+		_pSkeleton->ApplyMotion(motion, layeredMotionCount, layeredMotions, pScratch);
+	}
+}
+
+void Animation::DispatchEvents()
+{
+	if (_vEvents.empty())
+		return;
+	Vector<Event> vEvents;
+	std::swap(vEvents, _vEvents); // Delegate can call Update().
+	if (!_pDelegate)
+		return;
+	for (const auto& event : vEvents)
+	{
+		if (event._end)
+			_pDelegate->Animation_OnEnd(_C(event._name)); // This can call TransitionTo and change everything.
 		else
-		{
-			md._motion.BindBlendMotion(nullptr, 0);
-			_pSkeleton->ApplyMotion(md._motion, _time, layeredMotionCount, layeredMotions);
-		}
+			_pDelegate->Animation_OnTrigger(_C(event._name), event._state);
 	}
 }
 
@@ -184,7 +227,7 @@ void Animation::TransitionTo(CSZ name, Interval duration, int randTime, PMotion
 		if (!pFromMotion)
 			pMotion = &_pCollection->Find(_C(_currentMotion))->_motion;
 		if (_transition) // Already in transition?
-			pMotion->BindBlendMotion(&_transitionMotion, Math::ApplyEasing(_easing, _transitionTime / _transitionDuration));
+			pMotion->BindBlendMotion(GetBlendMotion(), GetBlendAlpha());
 		pMotion->BakeMotionAt(_time, _transitionMotion); // Capture current pose.
 		pMotion->BindBlendMotion(nullptr, 0);
 	}
@@ -234,25 +277,43 @@ bool Animation::TransitionToNew(std::initializer_list<CSZ> names, Interval durat
 
 void Animation::Motion_OnTrigger(CSZ name, int state)
 {
-	if (_pDelegate)
+	if (!_pDelegate)
+		return;
+	if (_deferEvents)
+	{
+		Event event;
+		event._name = name;
+		event._state = state;
+		_vEvents.push_back(std::move(event));
+	}
+	else
+	{
 		_pDelegate->Animation_OnTrigger(name, state);
+	}
 }
 
 PMotion Animation::GetMotion()
 {
-	PMotion p = nullptr;
+	PMotion p = FindMotion();
+	if (p && _transition)
+		p->BindBlendMotion(GetBlendMotion(), GetBlendAlpha());
+	return p;
+}
+
+PMotion Animation::FindMotion() const
+{
 	if (_currentMotion.empty())
 	{
 		if (!_prevMotion.empty())
-			p = &_pCollection->Find(_C(_prevMotion))->_motion;
+			return &_pCollection->Find(_C(_prevMotion))->_motion;
+		return nullptr;
 	}
-	else
-	{
-		p = &_pCollection->Find(_C(_currentMotion))->_motion;
-	}
-	if (p && _transition)
-		p->BindBlendMotion(&_transitionMotion, Math::ApplyEasing(_easing, _transitionTime / _transitionDuration));
-	return p;
+	return &_pCollection->Find(_C(_currentMotion))->_motion;
+}
+
+float Animation::GetBlendAlpha() const
+{
+	return _transition ? Math::ApplyEasing(_easing, _transitionTime / _transitionDuration) : 0;
 }
 
 float Animation::GetAlpha(CSZ name) const
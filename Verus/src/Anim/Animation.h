@@ -34,6 +34,8 @@ namespace verus
 			virtual void Async_WhenLoaded(CSZ url, RcBlob blob) override;
 
 			void AddMotion(CSZ name, bool loop = true, float duration = 0);
+			// Adds empty motion, which is not loaded from file, caller must init and fill it:
+			RMotionData InsertMotion(CSZ name, bool loop = true);
 			void DeleteAll();
 			PMotionData Find(CSZ name);
 			int GetMaxBones();
@@ -61,6 +63,15 @@ namespace verus
 			VERUS_TYPEDEFS(Layer);
 
 		private:
+			// Delegate's call, which is postponed, see UpdateTime():
+			struct Event
+			{
+				String _name;
+				int    _state = 0;
+				bool   _end = false;
+			};
+			VERUS_TYPEDEFS(Event);
+
 			PCollection        _pCollection = nullptr;
 			PAnimationDelegate _pDelegate = nullptr;
 			PSkeleton          _pSkeleton = nullptr;
@@ -68,19 +79,25 @@ namespace verus
 			String             _currentMotion;
 			String             _prevMotion;
 			Vector<int>        _vTriggerStates;
+			Vector<Event>      _vEvents;
 			Easing             _easing = Easing::quadInOut;
 			float              _time = 0;
 			float              _transitionDuration = 0;
 			float              _transitionTime = 0;
 			bool               _transition = false;
 			bool               _playing = false;
+			bool               _deferEvents = false;
 
 		public:
 			Animation();
 			~Animation();
 
 			void Update(int layerCount = 0, PLayer pLayers = nullptr);
-			void UpdateSkeleton(int layerCount = 0, PLayer pLayers = nullptr);
+			// Parts of Update(). Motions are not modified, so different animations can be updated in parallel (see Crowd).
+			// When events are deferred, delegate's methods are called later by DispatchEvents():
+			void UpdateTime(bool deferEvents = false);
+			void UpdateSkeleton(int layerCount = 0, PLayer pLayers = nullptr, Skeleton::PPoseScratch pScratch = nullptr);
+			void DispatchEvents();
 
 			void BindCollection(PCollection p);
 			void BindSkeleton(PSkeleton p);
@@ -103,7 +120,12 @@ namespace verus
 
 			virtual void Motion_OnTrigger(CSZ name, int state) override;
 
+			// Binds blend motion, if in transition:
 			PMotion GetMotion();
+			// Motion is not modified, blend motion must be used explicitly:
+			PMotion FindMotion() const;
+			PMotion GetBlendMotion() { return _transition ? &_transitionMotion : nullptr; }
+			float GetBlendAlpha() const;
 			float GetAlpha(CSZ name = nullptr) const;
 			float GetTime();
 			bool IsNearEdge(float t = 0.1f, Edge edge = Edge::begin | Edge::end);
@@ -0,0 +1,310 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "verus.h"
+
+using namespace verus;
+using namespace verus::Anim;
+
+namespace
+{
+	std::atomic_uint g_compiledMotionVersion;
+}
+
+CompiledMotion::CompiledMotion()
+{
+}
+
+CompiledMotion::~CompiledMotion()
+{
+	Done();
+}
+
+void CompiledMotion::Init(RMotion motion, bool quantizeRotations)
+{
+	VERUS_INIT();
+
+	_fps = motion.GetFps();
+	_fpsInv = motion.GetFpsInv();
+	_version = ++g_compiledMotionVersion;
+	if (!_version) // Zero means not compiled.
+		_version = ++g_compiledMotionVersion;
+	_quantized = quantizeRotations;
+
+	_vBones.reserve(motion.GetBoneCount());
+	motion.ForEachBone([this](Motion::RBone motionBone)
+		{
+			Bone bone;
+			bone._name = motionBone._name;
+			bone._flags = +motionBone._flags;
+
+			bone._rot._offset = Utils::Cast32(_vRotFrames.size());
+			bone._rot._count = Utils::Cast32(motionBone._mapRot.size());
+			for (const auto& kv : motionBone._mapRot)
+			{
+				_vRotFrames.push_back(kv.first);
+				if (_quantized)
+				{
+					const Quat q = VMath::normalize(kv.second._q);
+					_vRotKeysQuantized.push_back(static_cast<INT16>(round(q.getX() * SHRT_MAX)));
+					_vRotKeysQuantized.push_back(static_cast<INT16>(round(q.getY() * SHRT_MAX)));
+					_vRotKeysQuantized.push_back(static_cast<INT16>(round(q.getZ() * SHRT_MAX)));
+					_vRotKeysQuantized.push_back(static_cast<INT16>(round(q.getW() * SHRT_MAX)));
+				}
+				else
+				{
+					_vRotKeys.push_back(kv.second._q);
+				}
+			}
+
+			bone._pos._offset = Utils::Cast32(_vPosFrames.size());
+			bone._pos._count = Utils::Cast32(motionBone._mapPos.size());
+			for (const auto& kv : motionBone._mapPos)
+			{
+				_vPosFrames.push_back(kv.first);
+				_vPosKeys.push_back(kv.second);
+			}
+
+			bone._scale._offset = Utils::Cast32(_vScaleFrames.size());
+			bone._scale._count = Utils::Cast32(motionBone._mapScale.size());
+			for (const auto& kv : motionBone._mapScale)
+			{
+				_vScaleFrames.push_back(kv.first);
+				_vScaleKeys.push_back(kv.second);
+			}
+
+			_vBones.push_back(std::move(bone));
+			return Continue::yes;
+		});
+}
+
+void CompiledMotion::Done()
+{
+	VERUS_DONE(CompiledMotion);
+}
+
+int CompiledMotion::FindBoneIndex(CSZ name) const
+{
+	auto it = std::lower_bound(_vBones.begin(), _vBones.end(), name, [](RcBone bone, CSZ name)
+		{
+			return bone._name < name;
+		});
+	if (it != _vBones.end() && it->_name == name)
+		return Utils::Cast32(it - _vBones.begin());
+	return -1;
+}
+
+void CompiledMotion::SampleBone(int index, float time, RCursor cursor, RQuat q, RVector3 pos, RVector3 scale) const
+{
+	if (cursor._version != _version)
+	{
+		cursor._version = _version;
+		cursor._vKeys.assign(_vBones.size() * 3, -1);
+	}
+
+	RcBone bone = _vBones[index];
+	const Motion::Bone::Flags flags = static_cast<Motion::Bone::Flags>(bone._flags);
+	int* pHints = &cursor._vKeys[index * 3];
+
+	time = Math::Max(0.f, time); // Negative time is not allowed.
+	const int frame = static_cast<int>(_fps * time); // Frame is before or at 'time'.
+
+	int frames[4];
+	int indices[4];
+	{
+		const float alpha = FindControlPoints(bone._rot, _vRotFrames.data(), frame, time, pHints[0], frames, indices);
+		Quat keys[4];
+		VERUS_FOR(i, 4)
+		{
+			if (indices[i] >= 0)
+				keys[i] = GetRotationKey(indices[i]);
+		}
+		q = Motion::Bone::InterpolateRotation(!!(flags & Motion::Bone::Flags::slerpRot), frames, keys, alpha);
+	}
+	{
+		const float alpha = FindControlPoints(bone._pos, _vPosFrames.data(), frame, time, pHints[1], frames, indices);
+		Vector3 keys[4];
+		VERUS_FOR(i, 4)
+		{
+			if (indices[i] >= 0)
+				keys[i] = _vPosKeys[indices[i]];
+		}
+		pos = Motion::Bone::InterpolateVector(!!(flags & Motion::Bone::Flags::splinePos), Vector3(0), frames, keys, alpha);
+	}
+	{
+		const float alpha = FindControlPoints(bone._scale, _vScaleFrames.data(), frame, time, pHints[2], frames, indices);
+		Vector3 keys[4];
+		VERUS_FOR(i, 4)
+		{
+			if (indices[i] >= 0)
+				keys[i] = _vScaleKeys[indices[i]];
+		}
+		scale = Motion::Bone::InterpolateVector(!!(flags & Motion::Bone::Flags::splineScale), Vector3(1, 1, 1), frames, keys, alpha);
+	}
+}
+
+int CompiledMotion::FindKeyframe(const int* pFrames, int count, int frame, int& hint)
+{
+	// Time usually advances a little, so try the same keyframe and the next one:
+	if (hint >= 0 && hint < count && pFrames[hint] <= frame)
+	{
+		if (hint + 1 == count || frame < pFrames[hint + 1])
+			return hint;
+		if (hint + 2 == count || frame < pFrames[hint + 2])
+			return ++hint;
+	}
+	hint = Utils::Cast32(std::upper_bound(pFrames, pFrames + count, frame) - pFrames) - 1;
+	return hint;
+}
+
+float CompiledMotion::FindControlPoints(RcTrack track, const int* pFrames, int frame, float time, int& hint, int frames[4], int indices[4]) const
+{
+	VERUS_FOR(i, 4)
+	{
+		frames[i] = -1;
+		indices[i] = -1;
+	}
+	if (!track._count) // No frames at all, so return null.
+		return 0;
+
+	// Same control points as in Motion::Bone::FindControlPoints:
+	const int key = FindKeyframe(pFrames + track._offset, track._count, frame, hint);
+	VERUS_FOR(i, 4)
+	{
+		const int j = key - 1 + i;
+		if (j >= 0 && j < track._count)
+		{
+			frames[i] = pFrames[track._offset + j];
+			indices[i] = track._offset + j;
+		}
+	}
+	if (key < 0) // There are no frames before 'time'.
+		return time / (frames[2] * _fpsInv);
+	if (key + 1 == track._count) // There are no frames after 'time'.
+		return 0;
+	return (time - (frames[1] * _fpsInv)) / ((frames[2] - frames[1]) * _fpsInv);
+}
+
+Quat CompiledMotion::GetRotationKey(int index) const
+{
+	if (!_quantized)
+		return _vRotKeys[index];
+	const INT16* p = &_vRotKeysQuantized[index << 2];
+	const float scale = 1.f / SHRT_MAX;
+	return VMath::normalize(Quat(p[0] * scale, p[1] * scale, p[2] * scale, p[3] * scale));
+}
+
+void CompiledMotion::Test()
+{
+	Random random(1234);
+	Motion motion;
+	motion.Init();
+	motion.SetFps(30);
+	motion.SetFrameCount(90);
+	VERUS_FOR(i, 8)
+	{
+		Motion::PBone pBone = motion.InsertBone(_C("Bone" + std::to_string(i)));
+		Motion::Bone::Flags flags = Motion::Bone::Flags::none;
+		if (i & 0x1)
+			flags |= Motion::Bone::Flags::slerpRot;
+		if (i & 0x2)
+			flags |= Motion::Bone::Flags::splinePos | Motion::Bone::Flags::splineScale;
+		pBone->SetFlags(flags);
+		const int keyCount = i; // Also test empty tracks.
+		VERUS_FOR(j, keyCount)
+		{
+			const Vector3 euler(random.NextFloat(-1, 1), random.NextFloat(-1, 1), random.NextFloat(-1, 1));
+			pBone->InsertKeyframeRotation(random.Next(0, 90), euler);
+			pBone->InsertKeyframePosition(random.Next(0, 90), Vector3(random.NextFloat(-1, 1), random.NextFloat(-1, 1), random.NextFloat(-1, 1)));
+			pBone->InsertKeyframeScale(random.Next(0, 90), Vector3(random.NextFloat(0.5f, 2), random.NextFloat(0.5f, 2), random.NextFloat(0.5f, 2)));
+		}
+	}
+
+	VERUS_FOR(quantized, 2)
+	{
+		CompiledMotion compiledMotion;
+		compiledMotion.Init(motion, !!quantized);
+		Cursor cursor;
+		const float maxError = quantized ? 1e-3f : 1e-5f;
+		auto Check = [&](float time)
+		{
+			VERUS_FOR(i, compiledMotion.GetBoneCount())
+			{
+				Motion::PBone pBone = motion.GetBoneByIndex(i);
+				VERUS_RT_ASSERT(compiledMotion.FindBoneIndex(_C(pBone->GetName())) == i);
+				Quat q, qRef;
+				Vector3 euler, pos, posRef, scale, scaleRef;
+				pBone->ComputeRotationAt(time, euler, qRef);
+				pBone->ComputePositionAt(time, posRef);
+				pBone->ComputeScaleAt(time, scaleRef);
+				compiledMotion.SampleBone(i, time, cursor, q, pos, scale);
+				VERUS_RT_ASSERT(abs(VMath::dot(q, qRef)) > 1 - maxError);
+				VERUS_RT_ASSERT(VMath::length(pos - posRef) < maxError);
+				VERUS_RT_ASSERT(VMath::length(scale - scaleRef) < maxError);
+			}
+		};
+		for (float time = -0.1f; time < 3.5f; time += 0.01f) // Playback.
+			Check(time);
+		VERUS_FOR(i, 100) // Seeking.
+			Check(random.NextFloat(0, 3.5f));
+	}
+	VERUS_RT_ASSERT(-1 == CompiledMotion().FindBoneIndex("Bone0"));
+}
+
+void CompiledMotion::Benchmark()
+{
+	Random random(1234);
+	Motion motion;
+	motion.Init();
+	motion.SetFps(30);
+	motion.SetFrameCount(300);
+	VERUS_FOR(i, 64)
+	{
+		Motion::PBone pBone = motion.InsertBone(_C("Bone" + std::to_string(i)));
+		VERUS_FOR(frame, 300)
+		{
+			const Vector3 euler(random.NextFloat(-1, 1), random.NextFloat(-1, 1), random.NextFloat(-1, 1));
+			pBone->InsertKeyframeRotation(frame, euler);
+			pBone->InsertKeyframePosition(frame, Vector3(random.NextFloat(-1, 1), random.NextFloat(-1, 1), random.NextFloat(-1, 1)));
+			pBone->InsertKeyframeScale(frame, Vector3(1, 1, 1));
+		}
+	}
+	CompiledMotion compiledMotion;
+	compiledMotion.Init(motion);
+	Cursor cursor;
+	Vector<Motion::PBone> vBones(64);
+	VERUS_FOR(i, 64)
+		vBones[i] = motion.GetBoneByIndex(i);
+
+	// 100 characters with 64 bones each:
+	const int sampleCount = 100 * 300;
+	Quat q;
+	Vector3 euler, pos, scale;
+	float sum = 0;
+	const double motionMs = Utils::MeasureBestTime([&]()
+		{
+			VERUS_FOR(i, sampleCount)
+			{
+				const float time = (i % 300) * (1 / 30.f) + 0.01f;
+				VERUS_FOR(j, 64)
+				{
+					vBones[j]->ComputeRotationAt(time, euler, q);
+					vBones[j]->ComputePositionAt(time, pos);
+					vBones[j]->ComputeScaleAt(time, scale);
+					sum += pos.getX();
+				}
+			}
+		});
+	const double compiledMs = Utils::MeasureBestTime([&]()
+		{
+			VERUS_FOR(i, sampleCount)
+			{
+				const float time = (i % 300) * (1 / 30.f) + 0.01f;
+				VERUS_FOR(j, 64)
+				{
+					compiledMotion.SampleBone(j, time, cursor, q, pos, scale);
+					sum += pos.getX();
+				}
+			}
+		});
+
+	VERUS_LOG_INFO("Benchmark(); Motion: " << motionMs << " ms, compiled: " << compiledMs << " ms (" << sum << ")");
+}
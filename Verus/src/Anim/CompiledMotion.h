@@ -0,0 +1,94 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace Anim
+	{
+		class Motion;
+		VERUS_TYPEDEFS(Motion);
+
+		// Runtime representation of Motion, which is faster to sample, see Motion::Compile().
+		// Keyframes of each track are stored in contiguous arrays, bones are accessed by index.
+		// Rotations can be quantized to 16-bit integers.
+		// Cursor remembers the last keyframe of each track, so when time advances, the next keyframe is found in O(1).
+		// Triggers are not compiled, Motion handles them.
+		class CompiledMotion : public Object
+		{
+		public:
+			// One cursor per playback, don't share it between characters:
+			class Cursor
+			{
+				friend class CompiledMotion;
+
+				Vector<int> _vKeys; // The last keyframe at or before time, for each track.
+				UINT32      _version = 0;
+
+			public:
+				void Reset() { _version = 0; }
+			};
+			VERUS_TYPEDEFS(Cursor);
+
+		private:
+			struct Track
+			{
+				int _offset = 0; // In frame and key arrays.
+				int _count = 0;
+			};
+			VERUS_TYPEDEFS(Track);
+
+			struct Bone
+			{
+				String _name;
+				Track  _rot;
+				Track  _pos;
+				Track  _scale;
+				UINT32 _flags = 0;
+			};
+			VERUS_TYPEDEFS(Bone);
+
+			Vector<Bone>    _vBones; // Same order as in Motion.
+			Vector<int>     _vRotFrames;
+			Vector<int>     _vPosFrames;
+			Vector<int>     _vScaleFrames;
+			Vector<Quat>    _vRotKeys;
+			Vector<INT16>   _vRotKeysQuantized; // Four values per keyframe.
+			Vector<Vector3> _vPosKeys;
+			Vector<Vector3> _vScaleKeys;
+			int             _fps = 0;
+			float           _fpsInv = 0;
+			UINT32          _version = 0;
+			bool            _quantized = false;
+
+		public:
+			CompiledMotion();
+			~CompiledMotion();
+
+			void Init(RMotion motion, bool quantizeRotations = false);
+			void Done();
+
+			// Changes every time the motion is compiled, so that cached bone indices can be validated:
+			UINT32 GetVersion() const { return _version; }
+
+			int GetBoneCount() const { return Utils::Cast32(_vBones.size()); }
+			CSZ GetBoneName(int index) const { return _C(_vBones[index]._name); }
+			UINT32 GetBoneFlags(int index) const { return _vBones[index]._flags; }
+			// Binary search, bones are sorted by name:
+			int FindBoneIndex(CSZ name) const;
+
+			// Same result as Motion::Bone::Compute*At. Blend motion is applied by the caller, which should find
+			// blend motion's bones once, see Motion::Bone::BlendWithFirstKeyframe():
+			void SampleBone(int index, float time, RCursor cursor, RQuat q, RVector3 pos, RVector3 scale) const;
+
+			static void Test();
+			// Compares Motion with CompiledMotion, results are written to log:
+			static void Benchmark();
+
+		private:
+			static int FindKeyframe(const int* pFrames, int count, int frame, int& hint);
+			float FindControlPoints(RcTrack track, const int* pFrames, int frame, float time, int& hint, int frames[4], int indices[4]) const;
+			Quat GetRotationKey(int index) const;
+		};
+		VERUS_TYPEDEFS(CompiledMotion);
+	}
+}
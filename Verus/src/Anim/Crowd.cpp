@@ -0,0 +1,240 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "verus.h"
+
+using namespace verus;
+using namespace verus::Anim;
+
+Crowd::Crowd()
+{
+}
+
+Crowd::~Crowd()
+{
+}
+
+void Crowd::Add(RAnimation animation, int layerCount, Animation::PLayer pLayers)
+{
+	VERUS_RT_ASSERT(layerCount <= Animation::s_maxLayers);
+	Entry entry;
+	entry._pAnimation = &animation;
+	entry._layerCount = Math::Min(layerCount, Animation::s_maxLayers);
+	VERUS_FOR(i, entry._layerCount)
+		entry._layers[i] = pLayers[i];
+	_vEntries.push_back(entry);
+}
+
+void Crowd::Update()
+{
+	const bool useJobs = Jobs::IsValidSingleton() && Jobs::I().IsInitialized();
+	const int scratchCount = useJobs ? Jobs::I().GetWorkerCount() + 1 : 1;
+	if (Utils::Cast32(_vScratch.size()) < scratchCount)
+		_vScratch.resize(scratchCount);
+
+	auto UpdateEntry = [this](int i)
+	{
+		REntry entry = _vEntries[i];
+		const int workerIndex = Jobs::GetCurrentWorkerIndex();
+		Skeleton::RPoseScratch scratch = _vScratch[workerIndex + 1];
+		VERUS_FOR(j, entry._layerCount)
+			entry._layers[j]._pAnimation->UpdateTime(true);
+		entry._pAnimation->UpdateTime(true);
+		entry._pAnimation->UpdateSkeleton(entry._layerCount, entry._layers, &scratch);
+	};
+	if (useJobs)
+	{
+		Jobs::I().ParallelFor(0, GetCount(), UpdateEntry);
+	}
+	else
+	{
+		VERUS_FOR(i, GetCount())
+			UpdateEntry(i);
+	}
+
+	// Delegates can change animations, call them after all jobs are done:
+	for (auto& entry : _vEntries)
+	{
+		VERUS_FOR(j, entry._layerCount)
+			entry._layers[j]._pAnimation->DispatchEvents();
+		entry._pAnimation->DispatchEvents();
+	}
+	_vEntries.clear();
+}
+
+void Crowd::Test()
+{
+	if (!Physics::Bullet::IsValidSingleton()) // Required by Skeleton::Done().
+		return;
+
+	VERUS_QREF_TIMER;
+
+	struct Recorder : AnimationDelegate
+	{
+		Vector<String> _vEvents;
+
+		virtual void Animation_OnEnd(CSZ name) override
+		{
+			_vEvents.push_back(String("End:") + name);
+		}
+		virtual void Animation_OnTrigger(CSZ name, int state) override
+		{
+			_vEvents.push_back(String("Trigger:") + name + ":" + std::to_string(state));
+		}
+	};
+
+	// Two short looped motions with triggers, shared by all characters:
+	const int boneCount = 8;
+	CSZ motionNames[] = { "Walk", "Run" };
+	Skeleton skeleton;
+	skeleton.Init();
+	Collection collection;
+	VERUS_FOR(i, boneCount)
+	{
+		Skeleton::Bone bone;
+		bone._name = "Bone" + std::to_string(i);
+		if (i)
+			bone._parentName = "Bone" + std::to_string(i - 1);
+		skeleton.InsertBone(bone);
+	}
+	VERUS_FOR(m, 2)
+	{
+		RMotionData md = collection.InsertMotion(motionNames[m]);
+		md._motion.Init();
+		md._motion.SetFps(100);
+		md._motion.SetFrameCount(10);
+		VERUS_FOR(i, boneCount)
+		{
+			Motion::PBone pMotionBone = md._motion.InsertBone(_C("Bone" + std::to_string(i)));
+			pMotionBone->InsertKeyframePosition(0, Vector3(static_cast<float>(i), 0, 0));
+			pMotionBone->InsertKeyframePosition(5, Vector3(static_cast<float>(i), 1.f + m, 0));
+			pMotionBone->InsertKeyframeRotation(5, Vector3(0, 0.1f * i, 0.2f * m));
+		}
+		md._motion.FindBone("Bone0")->InsertKeyframeTrigger(3 + m, 1);
+		md._motion.FindBone("Bone0")->InsertKeyframeTrigger(7, 0);
+	}
+
+	// First half is updated by Crowd, second half by Animation::Update(), character i and count + i must match:
+	const int count = 16;
+	Vector<Skeleton> vSkeletons(count * 2);
+	Vector<Animation> vAnimations(count * 2);
+	Vector<Recorder> vRecorders(count * 2);
+	VERUS_FOR(i, count * 2)
+	{
+		vSkeletons[i] = skeleton;
+		vAnimations[i].BindCollection(&collection);
+		vAnimations[i].BindSkeleton(&vSkeletons[i]);
+		vAnimations[i].SetDelegate(&vRecorders[i]);
+		vAnimations[i].TransitionTo(motionNames[0], 0, (i % count) * 15);
+	}
+
+	auto CountEnds = [](const Recorder& recorder)
+	{
+		return std::count_if(recorder._vEvents.begin(), recorder._vEvents.end(), [](RcString s) { return Str::StartsWith(_C(s), "End:"); });
+	};
+
+	// Time step comes from the timer, both halves use the same one:
+	const float gameSpeed = timer.GetGameSpeed();
+	timer.SetGameSpeed(10);
+	timer.Update();
+	Crowd crowd;
+	bool run = false;
+	for (int step = 0; step < 100000 && CountEnds(vRecorders[count]) < 4; ++step)
+	{
+		if (!run && CountEnds(vRecorders[count]) >= 2) // Blend motions are used during transition.
+		{
+			run = true;
+			VERUS_FOR(i, count * 2)
+				vAnimations[i].TransitionTo(motionNames[1], 0.05f);
+		}
+
+		timer.Update();
+		VERUS_FOR(i, count)
+			crowd.Add(vAnimations[i]);
+		crowd.Update();
+		VERUS_FOR(i, count)
+			vAnimations[count + i].Update();
+
+		VERUS_FOR(i, count)
+		{
+			RcSkeleton serialSkeleton = vSkeletons[count + i];
+			vSkeletons[i].ForEachBone([&serialSkeleton](Skeleton::RcBone bone)
+				{
+					const Transform3 matExpected = serialSkeleton.FindBone(_C(bone._name))->_matFinal;
+					VERUS_FOR(col, 4)
+						VERUS_RT_ASSERT(Vector3(bone._matFinal.getCol(col)).IsEqual(matExpected.getCol(col), 1e-5f));
+					return Continue::yes;
+				});
+		}
+	}
+	timer.SetGameSpeed(gameSpeed);
+
+	VERUS_RT_ASSERT(run && CountEnds(vRecorders[count]) >= 4);
+	VERUS_FOR(i, count)
+	{
+		VERUS_RT_ASSERT(vRecorders[i]._vEvents == vRecorders[count + i]._vEvents);
+		VERUS_RT_ASSERT(CountEnds(vRecorders[i]) > 0);
+		VERUS_RT_ASSERT(std::count(vRecorders[i]._vEvents.begin(), vRecorders[i]._vEvents.end(), "Trigger:Bone0:1") > 0);
+	}
+}
+
+void Crowd::Benchmark()
+{
+	if (!Physics::Bullet::IsValidSingleton()) // Required by Skeleton::Done().
+		return;
+
+	// Humanoid-like skeleton with 64 bones, like in Skeleton::Benchmark():
+	const int boneCount = 64;
+	const int frameCount = 300;
+	Random random(1234);
+	Skeleton skeleton;
+	skeleton.Init();
+	Collection collection;
+	RMotionData md = collection.InsertMotion("Motion");
+	md._motion.Init();
+	md._motion.SetFps(30);
+	md._motion.SetFrameCount(frameCount);
+	VERUS_FOR(i, boneCount)
+	{
+		Skeleton::Bone bone;
+		bone._name = "Bone" + std::to_string(i);
+		if (i)
+			bone._parentName = "Bone" + std::to_string((i - 1) / 2);
+		bone._matToBoneSpace = Transform3::translation(Vector3(0, -0.1f * i, 0));
+		bone._matFromBoneSpace = Transform3::translation(Vector3(0, 0.1f * i, 0));
+		skeleton.InsertBone(bone);
+
+		Motion::PBone pMotionBone = md._motion.InsertBone(_C(bone._name));
+		for (int frame = 0; frame < frameCount; frame += 3)
+		{
+			pMotionBone->InsertKeyframeRotation(frame, Vector3(random.NextFloat(-1, 1), random.NextFloat(-1, 1), random.NextFloat(-1, 1)));
+			pMotionBone->InsertKeyframePosition(frame, Vector3(random.NextFloat(-1, 1), random.NextFloat(-1, 1), random.NextFloat(-1, 1)));
+		}
+	}
+	md._motion.Compile();
+
+	const int count = 1000;
+	Vector<Skeleton> vSkeletons(count);
+	Vector<Animation> vAnimations(count);
+	VERUS_FOR(i, count)
+	{
+		vSkeletons[i] = skeleton;
+		vAnimations[i].BindCollection(&collection);
+		vAnimations[i].BindSkeleton(&vSkeletons[i]);
+		vAnimations[i].TransitionTo("Motion", 0, random.Next(0, 255));
+	}
+
+	Crowd crowd;
+	const double serialMs = Utils::MeasureBestTime([&vAnimations]()
+		{
+			for (auto& x : vAnimations)
+				x.Update();
+		});
+	const double crowdMs = Utils::MeasureBestTime([&vAnimations, &crowd]()
+		{
+			for (auto& x : vAnimations)
+				crowd.Add(x);
+			crowd.Update();
+		});
+
+	const int workerCount = (Jobs::IsValidSingleton() && Jobs::I().IsInitialized()) ? Jobs::I().GetWorkerCount() : 0;
+	VERUS_LOG_INFO("Benchmark(); " << count << " characters, per frame: Animation::Update(): " << serialMs << " ms, Crowd (" << workerCount << " workers): " << crowdMs << " ms");
+}
@@ -0,0 +1,43 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace Anim
+	{
+		// Updates animations of many characters, skeletons are posed in parallel using jobs.
+		// Each thread has its own pose scratch, each job writes only into its own skeleton.
+		// Triggers and Animation_OnEnd are collected and delegates are called after all poses are ready.
+		class Crowd
+		{
+			struct Entry
+			{
+				PAnimation       _pAnimation = nullptr;
+				Animation::Layer _layers[Animation::s_maxLayers];
+				int              _layerCount = 0;
+			};
+			VERUS_TYPEDEFS(Entry);
+
+			Vector<Entry>                 _vEntries;
+			Vector<Skeleton::PoseScratch> _vScratch; // Calling thread, then worker threads.
+
+		public:
+			Crowd();
+			~Crowd();
+
+			// Adds animation for the next Update(), same arguments as in Animation::Update().
+			// Layer animations are updated by the same job, so don't add them separately:
+			void Add(RAnimation animation, int layerCount = 0, Animation::PLayer pLayers = nullptr);
+			// Updates all added animations and clears the list:
+			void Update();
+
+			int GetCount() const { return Utils::Cast32(_vEntries.size()); }
+
+			// Compares with Animation::Update(): poses must match, events must arrive once and in the same order:
+			static void Test();
+			// Serial Animation::Update() versus Crowd, results are written to log:
+			static void Benchmark();
+		};
+		VERUS_TYPEDEFS(Crowd);
+	}
+}
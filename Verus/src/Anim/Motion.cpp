@@ -131,27 +131,28 @@ bool Motion::Bone::FindKeyframeTrigger(int frame, int& state) const
 }
 
 void Motion::Bone::ComputeRotationAt(float time, RVector3 euler, RQuat q) const
+{
+	ComputeRotationAt(time, euler, q, _pMotion->GetBlendMotion(), _pMotion->GetBlendAlpha());
+}
+
+void Motion::Bone::ComputePositionAt(float time, RVector3 pos) const
+{
+	ComputePositionAt(time, pos, _pMotion->GetBlendMotion(), _pMotion->GetBlendAlpha());
+}
+
+void Motion::Bone::ComputeScaleAt(float time, RVector3 scale) const
+{
+	ComputeScaleAt(time, scale, _pMotion->GetBlendMotion(), _pMotion->GetBlendAlpha());
+}
+
+void Motion::Bone::ComputeRotationAt(float time, RVector3 euler, RQuat q, PMotion pBlendMotion, float blendAlpha) const
 {
 	int frames[4];
 	Rotation keys[4];
 	const float alpha = FindControlPoints(_mapRot, frames, keys, time);
+	const Quat qKeys[4] = { keys[0]._q, keys[1]._q, keys[2]._q, keys[3]._q };
+	q = InterpolateRotation(!!(_flags & Flags::slerpRot), frames, qKeys, alpha);
 
-	if (_flags & Flags::slerpRot)
-	{
-		const Rotation null(Quat(0));
-		RcRotation prev = (frames[1] == -1) ? null : keys[1];
-		RcRotation next = (frames[2] == -1) ? null : keys[2];
-		q = VMath::slerp(alpha, prev._q, next._q);
-	}
-	else
-	{
-		const Rotation null(Quat(0));
-		RcRotation prev = (frames[1] == -1) ? null : keys[1];
-		RcRotation next = (frames[2] == -1) ? null : keys[2];
-		q = Math::NLerp(alpha, prev._q, next._q);
-	}
-
-	PMotion pBlendMotion = _pMotion->GetBlendMotion();
 	if (pBlendMotion)
 	{
 		PBone pBone = pBlendMotion->FindBone(_C(_name));
@@ -162,9 +163,9 @@ void Motion::Bone::ComputeRotationAt(float time, RVector3 euler, RQuat q) const
 			if (pBone->FindKeyframeRotation(0, eulerBlend, qBlend))
 			{
 				if (_flags & Flags::slerpRot)
-					q = VMath::slerp(_pMotion->GetBlendAlpha(), qBlend, q);
+					q = VMath::slerp(blendAlpha, qBlend, q);
 				else
-					q = Math::NLerp(_pMotion->GetBlendAlpha(), qBlend, q);
+					q = Math::NLerp(blendAlpha, qBlend, q);
 			}
 		}
 	}
@@ -172,42 +173,13 @@ void Motion::Bone::ComputeRotationAt(float time, RVector3 euler, RQuat q) const
 	euler.EulerFromQuaternion(q);
 }
 
-void Motion::Bone::ComputePositionAt(float time, RVector3 pos) const
+void Motion::Bone::ComputePositionAt(float time, RVector3 pos, PMotion pBlendMotion, float blendAlpha) const
 {
 	int frames[4];
 	Vector3 keys[4];
 	const float alpha = FindControlPoints(_mapPos, frames, keys, time);
+	pos = InterpolateVector(!!(_flags & Flags::splinePos), Vector3(0), frames, keys, alpha);
 
-	if (_flags & Flags::splinePos)
-	{
-		const Vector3 null(0);
-		if (frames[1] == -1) { frames[1] = 0; keys[1] = null; }
-		if (frames[2] == -1) { frames[2] = 0; keys[2] = null; }
-		// Extrapolate:
-		if (frames[0] == -1) { frames[0] = frames[1] * 2 - frames[2]; keys[0] = keys[1] * 2 - keys[2]; }
-		if (frames[3] == -1) { frames[3] = frames[2] * 2 - frames[1]; keys[3] = keys[2] * 2 - keys[1]; }
-		// Ratio controls the direction and length of tangents. One keyframe can have different tangent lengths to match speed.
-		const int intervals[3] =
-		{
-			frames[1] - frames[0],
-			frames[2] - frames[1],
-			frames[3] - frames[2]
-		};
-		const float ratioA = static_cast<float>(intervals[0]) / (intervals[0] + intervals[1]);
-		const float ratioB = static_cast<float>(intervals[1]) / (intervals[1] + intervals[2]);
-		const Vector3 tanA = VMath::lerp(ratioA, keys[1] - keys[0], keys[2] - keys[1]) * s_magicValueForCircle * (1 - ratioA);
-		const Vector3 tanB = VMath::lerp(ratioB, keys[2] - keys[1], keys[3] - keys[2]) * s_magicValueForCircle * ratioB;
-		pos = glm::hermite(keys[1].GLM(), tanA.GLM(), keys[2].GLM(), tanB.GLM(), alpha);
-	}
-	else
-	{
-		const Vector3 null(0);
-		RcVector3 prev = (frames[1] == -1) ? null : keys[1];
-		RcVector3 next = (frames[2] == -1) ? null : keys[2];
-		pos = VMath::lerp(alpha, prev, next);
-	}
-
-	PMotion pBlendMotion = _pMotion->GetBlendMotion();
 	if (pBlendMotion)
 	{
 		PBone pBone = pBlendMotion->FindBone(_C(_name));
@@ -215,20 +187,63 @@ void Motion::Bone::ComputePositionAt(float time, RVector3 pos) const
 		{
 			Vector3 posBlend;
 			if (pBone->FindKeyframePosition(0, posBlend))
-				pos = VMath::lerp(_pMotion->GetBlendAlpha(), posBlend, pos);
+				pos = VMath::lerp(blendAlpha, posBlend, pos);
 		}
 	}
 }
 
-void Motion::Bone::ComputeScaleAt(float time, RVector3 scale) const
+void Motion::Bone::ComputeScaleAt(float time, RVector3 scale, PMotion pBlendMotion, float blendAlpha) const
 {
 	int frames[4];
 	Vector3 keys[4];
 	const float alpha = FindControlPoints(_mapScale, frames, keys, time);
+	scale = InterpolateVector(!!(_flags & Flags::splineScale), Vector3(1, 1, 1), frames, keys, alpha);
+
+	if (pBlendMotion)
+	{
+		PBone pBone = pBlendMotion->FindBone(_C(_name));
+		if (pBone)
+		{
+			Vector3 scaleBlend;
+			if (pBone->FindKeyframeScale(0, scaleBlend))
+				scale = VMath::lerp(blendAlpha, scaleBlend, scale);
+		}
+	}
+}
+
+void Motion::Bone::BlendWithFirstKeyframe(float blendAlpha, bool slerpRot, RQuat q, RVector3 pos, RVector3 scale) const
+{
+	// Same as Compute*At with blend motion:
+	Vector3 eulerBlend, posBlend, scaleBlend;
+	Quat qBlend;
+	if (FindKeyframeRotation(0, eulerBlend, qBlend))
+	{
+		if (slerpRot)
+			q = VMath::slerp(blendAlpha, qBlend, q);
+		else
+			q = Math::NLerp(blendAlpha, qBlend, q);
+	}
+	if (FindKeyframePosition(0, posBlend))
+		pos = VMath::lerp(blendAlpha, posBlend, pos);
+	if (FindKeyframeScale(0, scaleBlend))
+		scale = VMath::lerp(blendAlpha, scaleBlend, scale);
+}
 
-	if (_flags & Flags::splineScale)
+Quat Motion::Bone::InterpolateRotation(bool slerp, const int frames[4], const Quat keys[4], float alpha)
+{
+	const Quat null(0);
+	RcQuat prev = (frames[1] == -1) ? null : keys[1];
+	RcQuat next = (frames[2] == -1) ? null : keys[2];
+	if (slerp)
+		return VMath::slerp(alpha, prev, next);
+	else
+		return Math::NLerp(alpha, prev, next);
+}
+
+Vector3 Motion::Bone::InterpolateVector(bool spline, RcVector3 null, int frames[4], Vector3 keys[4], float alpha)
+{
+	if (spline)
 	{
-		const Vector3 null(1, 1, 1);
 		if (frames[1] == -1) { frames[1] = 0; keys[1] = null; }
 		if (frames[2] == -1) { frames[2] = 0; keys[2] = null; }
 		// Extrapolate:
@@ -245,26 +260,13 @@ void Motion::Bone::ComputeScaleAt(float time, RVector3 scale) const
 		const float ratioB = static_cast<float>(intervals[1]) / (intervals[1] + intervals[2]);
 		const Vector3 tanA = VMath::lerp(ratioA, keys[1] - keys[0], keys[2] - keys[1]) * s_magicValueForCircle * (1 - ratioA);
 		const Vector3 tanB = VMath::lerp(ratioB, keys[2] - keys[1], keys[3] - keys[2]) * s_magicValueForCircle * ratioB;
-		scale = glm::hermite(keys[1].GLM(), tanA.GLM(), keys[2].GLM(), tanB.GLM(), alpha);
+		return glm::hermite(keys[1].GLM(), tanA.GLM(), keys[2].GLM(), tanB.GLM(), alpha);
 	}
 	else
 	{
-		const Vector3 null(1, 1, 1);
 		RcVector3 prev = (frames[1] == -1) ? null : keys[1];
 		RcVector3 next = (frames[2] == -1) ? null : keys[2];
-		scale = VMath::lerp(alpha, prev, next);
-	}
-
-	PMotion pBlendMotion = _pMotion->GetBlendMotion();
-	if (pBlendMotion)
-	{
-		PBone pBone = pBlendMotion->FindBone(_C(_name));
-		if (pBone)
-		{
-			Vector3 scaleBlend;
-			if (pBone->FindKeyframeScale(0, scaleBlend))
-				scale = VMath::lerp(_pMotion->GetBlendAlpha(), scaleBlend, scale);
-		}
+		return VMath::lerp(alpha, prev, next);
 	}
 }
 
@@ -921,6 +923,7 @@ void Motion::Init()
 void Motion::Done()
 {
 	DeleteAllBones();
+	_compiledMotion.Done();
 	VERUS_DONE(Motion);
 }
 
@@ -953,6 +956,7 @@ Motion::PBone Motion::InsertBone(CSZ name)
 	PBone pBone = FindBone(name);
 	if (pBone)
 		return pBone;
+	_compiledMotion.Done(); // Bone indices will change.
 	Bone bone(this);
 	bone.Rename(name);
 	_mapBones[name] = bone;
@@ -962,11 +966,15 @@ Motion::PBone Motion::InsertBone(CSZ name)
 void Motion::DeleteBone(CSZ name)
 {
 	VERUS_IF_FOUND_IN(TMapBones, _mapBones, name, it)
+	{
+		_compiledMotion.Done();
 		_mapBones.erase(it);
+	}
 }
 
 void Motion::DeleteAllBones()
 {
+	_compiledMotion.Done();
 	_mapBones.clear();
 }
 
@@ -1032,6 +1040,12 @@ void Motion::Deserialize(IO::RStream stream)
 	}
 }
 
+void Motion::Compile(bool quantizeRotations)
+{
+	_compiledMotion.Done();
+	_compiledMotion.Init(*this, quantizeRotations);
+}
+
 void Motion::BakeMotionAt(float time, Motion& dest) const
 {
 	float nativeTime = time * _playbackSpeed;
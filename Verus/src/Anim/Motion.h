@@ -39,6 +39,7 @@ namespace verus
 
 			private:
 				friend class Motion;
+				friend class CompiledMotion;
 
 				static const float s_magicValueForCircle;
 
@@ -220,9 +221,20 @@ namespace verus
 				void ComputeRotationAt(float time, RVector3 euler, RQuat q) const;
 				void ComputePositionAt(float time, RVector3 pos) const;
 				void    ComputeScaleAt(float time, RVector3 scale) const;
+				// Blend motion is given explicitly, instead of the one bound to motion:
+				void ComputeRotationAt(float time, RVector3 euler, RQuat q, Motion* pBlendMotion, float blendAlpha) const;
+				void ComputePositionAt(float time, RVector3 pos, Motion* pBlendMotion, float blendAlpha) const;
+				void    ComputeScaleAt(float time, RVector3 scale, Motion* pBlendMotion, float blendAlpha) const;
 				void  ComputeTriggerAt(float time, int& state) const;
 				void   ComputeMatrixAt(float time, RTransform3 mat);
 
+				// This bone belongs to blend motion, its keyframes at frame zero are mixed with sampled transform:
+				void BlendWithFirstKeyframe(float blendAlpha, bool slerpRot, RQuat q, RVector3 pos, RVector3 scale) const;
+
+				// Interpolation between control points found for some time, also used by CompiledMotion:
+				static Quat InterpolateRotation(bool slerp, const int frames[4], const Quat keys[4], float alpha);
+				static Vector3 InterpolateVector(bool spline, RcVector3 null, int frames[4], Vector3 keys[4], float alpha);
+
 				void MoveKeyframe(int direction, Channel channel, int frame);
 
 				int GetRotationKeyCount() const { return Utils::Cast32(_mapRot.size()); }
@@ -257,7 +269,8 @@ namespace verus
 
 			typedef Map<String, Bone> TMapBones;
 
-			TMapBones _mapBones;
+			TMapBones      _mapBones;
+			CompiledMotion _compiledMotion;
 			Motion* _pBlendMotion = nullptr;
 			int       _frameCount = 60;
 			int       _fps = 12;
@@ -307,6 +320,11 @@ namespace verus
 			void Serialize(IO::RStream stream);
 			void Deserialize(IO::RStream stream);
 
+			// Creates runtime representation, which is used by Skeleton::ApplyMotion.
+			// Compile again after editing, changes to keyframes are not tracked:
+			void Compile(bool quantizeRotations = false);
+			PcCompiledMotion GetCompiledMotion() const { return _compiledMotion.IsInitialized() ? &_compiledMotion : nullptr; }
+
 			void BakeMotionAt(float time, Motion& dest) const;
 			void BindBlendMotion(Motion* p, float alpha);
 			Motion* GetBlendMotion() const { return _pBlendMotion; }
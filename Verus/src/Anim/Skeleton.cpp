@@ -19,6 +19,7 @@ void Skeleton::operator=(RcSkeleton that)
 	for (const auto& kv : that._mapBones)
 		_mapBones[kv.first] = kv.second;
 	_primaryBoneCount = that._primaryBoneCount;
+	_pPoseBonesOwner = nullptr;
 }
 
 void Skeleton::Init()
@@ -103,6 +104,7 @@ Skeleton::PBone Skeleton::InsertBone(RBone bone)
 
 	bone._shaderIndex = Utils::Cast32(_mapBones.size()); // Assume bones are added in same order as matrices in shader.
 	_mapBones[bone._name] = bone;
+	_pPoseBonesOwner = nullptr;
 	return FindBone(_C(bone._name));
 }
 
@@ -132,170 +134,308 @@ Skeleton::PBone Skeleton::FindBoneByIndex(int index)
 
 void Skeleton::ApplyMotion(RMotion motion, float time, int layeredMotionCount, PLayeredMotion pLayeredMotions)
 {
-	if (_ragdollMode)
+	LayeredMotion boundMotion;
+	boundMotion._pMotion = &motion;
+	boundMotion._pBlendMotion = motion.GetBlendMotion();
+	boundMotion._blendAlpha = motion.GetBlendAlpha();
+	boundMotion._time = time;
+	_vBoundLayeredMotions.assign(pLayeredMotions, pLayeredMotions + layeredMotionCount);
+	for (auto& x : _vBoundLayeredMotions)
 	{
-		for (auto& kv : _mapBones)
+		if (x._pMotion)
 		{
-			RBone bone = kv.second;
-			if (bone._pRigidBody)
-			{
-				btTransform btr;
-				bone._pRigidBody->getMotionState()->getWorldTransform(btr);
-				bone._matFinal = _matRagdollToWorldInv * Transform3(btr) * bone._matToActorSpace;
-			}
-			else
-			{
-				bone._matFinal = Transform3::identity();
-				if (bone._shaderIndex >= 0)
-				{
-					PBone pParent = FindBone(_C(bone._parentName));
-					while (pParent)
-					{
-						if (pParent->_pRigidBody)
-						{
-							btTransform btr;
-							pParent->_pRigidBody->getMotionState()->getWorldTransform(btr);
-							bone._matFinal = _matRagdollToWorldInv * Transform3(btr) * pParent->_matToActorSpace;
-							break;
-						}
-						pParent = FindBone(_C(pParent->_parentName));
-					}
-				}
-			}
-			bone._matFinalInv = VMath::inverse(bone._matFinal);
+			x._pBlendMotion = x._pMotion->GetBlendMotion();
+			x._blendAlpha = x._pMotion->GetBlendAlpha();
 		}
+	}
+
+	ApplyMotion(boundMotion, layeredMotionCount, _vBoundLayeredMotions.data());
+
+	// Reset blend motion!
+	motion.BindBlendMotion(nullptr, 0);
+	VERUS_FOR(i, layeredMotionCount)
+	{
+		if (pLayeredMotions[i]._pMotion)
+			pLayeredMotions[i]._pMotion->BindBlendMotion(nullptr, 0);
+	}
+}
+
+void Skeleton::ApplyMotion(RcLayeredMotion motion, int layeredMotionCount, PcLayeredMotion pLayeredMotions, PPoseScratch pScratch)
+{
+	if (_ragdollMode)
+	{
+		ApplyRagdoll();
 		return;
 	}
 
-	_pCurrentMotion = &motion;
-	_currentTime = time * _pCurrentMotion->GetPlaybackSpeed(); // To native time.
-	if (_pCurrentMotion->IsReversed())
-		_currentTime = _pCurrentMotion->GetNativeDuration() - _currentTime;
+	if (_pPoseBonesOwner != this)
+		UpdatePoseBones();
+	const int poseBoneCount = Utils::Cast32(_vPoseBones.size());
+	if (Utils::Cast32(_vPoseTracks.size()) < layeredMotionCount + 1)
+		_vPoseTracks.resize(layeredMotionCount + 1);
 
-	_layeredMotionCount = layeredMotionCount;
-	_pLayeredMotions = pLayeredMotions;
+	RPoseScratch scratch = pScratch ? *pScratch : _poseScratch;
+	if (Utils::Cast32(scratch._vRot.size()) < poseBoneCount)
+	{
+		scratch._vRot.resize(poseBoneCount);
+		scratch._vPos.resize(poseBoneCount);
+		scratch._vScale.resize(poseBoneCount);
+		scratch._vFinal.resize(poseBoneCount);
+		scratch._vSampled.resize(poseBoneCount);
+		scratch._vMask.resize(poseBoneCount);
+	}
 
-	ResetBones();
-	for (auto& kv : _mapBones)
+	RcMotion mainMotion = *motion._pMotion;
+	float currentTime = motion._time * mainMotion.GetPlaybackSpeed(); // To native time.
+	if (mainMotion.IsReversed())
+		currentTime = mainMotion.GetNativeDuration() - currentTime;
+
+	// Local transforms of the current motion:
+	RPoseTrack track = _vPoseTracks[0];
+	BindPoseTrack(motion, track);
+	VERUS_FOR(i, poseBoneCount)
 	{
-		RBone bone = kv.second;
-		if (!bone._ready)
+		const int motionBone = track._vMotionBones.empty() ? -1 : track._vMotionBones[i];
+		scratch._vSampled[i] = SampleBone(motion, track, motionBone, _C(_vPoseBones[i]->_name), currentTime,
+			scratch._vRot[i], scratch._vPos[i], scratch._vScale[i]);
+	}
+
+	// Blend with other motions:
+	VERUS_FOR(layer, layeredMotionCount)
+	{
+		RcLayeredMotion layeredMotion = pLayeredMotions[layer];
+		if (!layeredMotion._pMotion || layeredMotion._alpha <= 0)
+			continue;
+
+		RcMotion motionL = *layeredMotion._pMotion;
+		const float alpha = layeredMotion._alpha;
+		float timeL = layeredMotion._time * motionL.GetPlaybackSpeed(); // To native time.
+		if (motionL.IsReversed())
+			timeL = motionL.GetNativeDuration() - timeL;
+
+		RPoseTrack trackL = _vPoseTracks[layer + 1];
+		BindPoseTrack(layeredMotion, trackL);
+		PcBone pRootBone = FindBone(layeredMotion._rootBone);
+		const int rootIndex = pRootBone ? pRootBone->_poseIndex : -1;
+		VERUS_FOR(i, poseBoneCount)
 		{
-			_pCurrentBone = &bone;
-			_matParents = Transform3::identity();
-			RecursiveBoneUpdate();
+			// Root bone and all descendants, parents are already processed:
+			const int parent = _vPoseParents[i];
+			scratch._vMask[i] = (i == rootIndex) ||
+				((parent >= 0) ? scratch._vMask[parent] : _vPoseBones[i]->_parentName == layeredMotion._rootBone);
+			if (!scratch._vSampled[i] || !scratch._vMask[i])
+				continue;
+
+			// Layered motion can also be in blend state.
+			Quat qL;
+			Vector3 scaleL, posL;
+			const int motionBone = trackL._vMotionBones.empty() ? -1 : trackL._vMotionBones[i];
+			if (SampleBone(layeredMotion, trackL, motionBone, _C(_vPoseBones[i]->_name), timeL, qL, posL, scaleL))
+			{
+				// Mix with layered motion:
+				scratch._vRot[i] = VMath::slerp(alpha, scratch._vRot[i], qL);
+				scratch._vPos[i] = VMath::lerp(alpha, scratch._vPos[i], posL);
+				scratch._vScale[i] = VMath::lerp(alpha, scratch._vScale[i], scaleL);
+			}
 		}
 	}
 
-	// Reset blend motion!
-	motion.BindBlendMotion(nullptr, 0);
-	VERUS_FOR(i, _layeredMotionCount)
+	// Root bone of the motion moves bones, which have no parent:
+	Quat q;
+	Vector3 scale, pos;
+	const bool rootSampled = SampleBone(motion, track, track._rootMotionBone, RootName(), currentTime, q, pos, scale);
+	const Transform3 matRoot = VMath::appendScale(Transform3(q, pos), scale);
+
+	// Local to model space, parents come first, so this is a single pass:
+	VERUS_FOR(i, poseBoneCount)
 	{
-		if (_pLayeredMotions[i]._pMotion)
-			_pLayeredMotions[i]._pMotion->BindBlendMotion(nullptr, 0);
+		RBone bone = *_vPoseBones[i];
+		Transform3 mat = Transform3::identity();
+		if (scratch._vSampled[i])
+		{
+			const Transform3 matSRT = VMath::appendScale(Transform3(scratch._vRot[i], scratch._vPos[i]), scratch._vScale[i]);
+			const Transform3 matBone = bone._matExternal * matSRT;
+			mat = bone._matFromBoneSpace * matBone * bone._matToBoneSpace * bone._matAdapt;
+		}
+
+		const int parent = _vPoseParents[i];
+		if (parent >= 0)
+			scratch._vFinal[i] = scratch._vFinal[parent] * mat;
+		else
+			scratch._vFinal[i] = rootSampled ? matRoot * mat : mat;
+		bone._matFinal = scratch._vFinal[i];
 	}
 }
 
 void Skeleton::UpdateUniformBufferArray(mataff* p) const
 {
+	if (_pPoseBonesOwner == this)
+	{
+		const int poseBoneCount = Utils::Cast32(_vPoseBones.size());
+		VERUS_FOR(i, poseBoneCount)
+		{
+			const int shaderIndex = _vPoseShaderIndices[i];
+			if (shaderIndex >= 0 && shaderIndex < VERUS_MAX_BONES)
+				_vPoseBones[i]->_matFinal.UniformBufferFormat(p[shaderIndex]);
+		}
+		return;
+	}
+
 	for (const auto& kv : _mapBones)
 	{
 		RcBone bone = kv.second;
 		if (bone._shaderIndex >= 0 && bone._shaderIndex < VERUS_MAX_BONES)
-			p[bone._shaderIndex] = bone._matFinal.UniformBufferFormat();
+			bone._matFinal.UniformBufferFormat(p[bone._shaderIndex]);
 	}
 }
 
 void Skeleton::ResetFinalPose()
 {
 	for (auto& kv : _mapBones)
-	{
 		kv.second._matFinal = Transform3::identity();
-		kv.second._matFinalInv = Transform3::identity();
-	}
 }
 
-void Skeleton::ResetBones()
+void Skeleton::UpdatePoseBones()
 {
+	_vPoseBones.clear();
+	_vPoseBones.reserve(_mapBones.size());
+	for (auto& kv : _mapBones)
+		kv.second._poseIndex = -1;
+
+	// Depth-first, so that parents are added before children:
+	Vector<PBone> vStack;
 	for (auto& kv : _mapBones)
-		kv.second._ready = false;
+	{
+		PBone pBone = &kv.second;
+		while (pBone && pBone->_poseIndex < 0)
+		{
+			vStack.push_back(pBone);
+			pBone->_poseIndex = INT_MAX; // Mark it.
+			pBone = FindBone(_C(pBone->_parentName));
+		}
+		while (!vStack.empty())
+		{
+			vStack.back()->_poseIndex = Utils::Cast32(_vPoseBones.size());
+			_vPoseBones.push_back(vStack.back());
+			vStack.pop_back();
+		}
+	}
+
+	const int poseBoneCount = Utils::Cast32(_vPoseBones.size());
+	_vPoseParents.resize(poseBoneCount);
+	_vPoseShaderIndices.resize(poseBoneCount);
+	VERUS_FOR(i, poseBoneCount)
+	{
+		PcBone pParent = FindBone(_C(_vPoseBones[i]->_parentName));
+		_vPoseParents[i] = pParent ? pParent->_poseIndex : -1;
+		_vPoseShaderIndices[i] = _vPoseBones[i]->_shaderIndex;
+		VERUS_RT_ASSERT(_vPoseParents[i] < i);
+	}
+
+	// Bone indices must be found again:
+	for (auto& track : _vPoseTracks)
+		track._version = 0;
+
+	_pPoseBonesOwner = this;
 }
 
-void Skeleton::RecursiveBoneUpdate()
+void Skeleton::BindPoseTrack(RcLayeredMotion motion, RPoseTrack track)
 {
-	Transform3 mat;
-	PBone pCurrentBone = _pCurrentBone;
+	PcCompiledMotion pCompiledMotion = motion._pMotion->GetCompiledMotion();
+	if (!pCompiledMotion)
+	{
+		track._vMotionBones.clear();
+		track._vBlendBones.clear();
+		track._pBlendMotion = nullptr;
+		track._version = 0;
+		return;
+	}
 
-	Motion::PBone pMotionBone = _pCurrentMotion->FindBone(_C(pCurrentBone->_name));
+	if (track._version != pCompiledMotion->GetVersion())
+	{
+		const int poseBoneCount = Utils::Cast32(_vPoseBones.size());
+		track._vMotionBones.resize(poseBoneCount);
+		VERUS_FOR(i, poseBoneCount)
+			track._vMotionBones[i] = pCompiledMotion->FindBoneIndex(_C(_vPoseBones[i]->_name));
+		track._rootMotionBone = pCompiledMotion->FindBoneIndex(RootName());
+		track._version = pCompiledMotion->GetVersion();
+		track._pBlendMotion = nullptr; // Blend bones must be found again.
+	}
 
-	if (pMotionBone)
+	// Blend motion's bones are also found once, not per bone per frame:
+	const int blendBoneCount = motion._pBlendMotion ? motion._pBlendMotion->GetBoneCount() : 0;
+	if (track._pBlendMotion != motion._pBlendMotion || track._blendBoneCount != blendBoneCount)
 	{
-		Quat q;
-		Vector3 scale, euler, pos;
-		pMotionBone->ComputeRotationAt(_currentTime, euler, q);
-		pMotionBone->ComputePositionAt(_currentTime, pos);
-		pMotionBone->ComputeScaleAt(_currentTime, scale);
-
-		// Blend with other motions:
-		VERUS_FOR(i, _layeredMotionCount)
+		track._pBlendMotion = motion._pBlendMotion;
+		track._blendBoneCount = blendBoneCount;
+		track._vBlendBones.clear();
+		if (motion._pBlendMotion)
 		{
-			if (!_pLayeredMotions[i]._pMotion)
-				continue;
-
-			PMotion pLayeredMotion = _pLayeredMotions[i]._pMotion;
-			Motion::PBone pLayeredBone = pLayeredMotion->FindBone(_C(pCurrentBone->_name));
-			const float alpha = _pLayeredMotions[i]._alpha;
-			float time = _pLayeredMotions[i]._time * pLayeredMotion->GetPlaybackSpeed(); // To native time.
-			if (pLayeredMotion->IsReversed())
-				time = pLayeredMotion->GetNativeDuration() - time;
-			if (pLayeredBone && alpha > 0 &&
-				(pCurrentBone->_name == _pLayeredMotions[i]._rootBone ||
-					IsParentOf(_C(pCurrentBone->_name), _pLayeredMotions[i]._rootBone)))
-			{
-				// Layered motion can also be in blend state.
-				Quat qL;
-				Vector3 scaleL, eulerL, posL;
-				pLayeredBone->ComputeRotationAt(time, eulerL, qL);
-				pLayeredBone->ComputePositionAt(time, posL);
-				pLayeredBone->ComputeScaleAt(time, scaleL);
-
-				// Mix with layered motion:
-				q = VMath::slerp(alpha, q, qL);
-				pos = VMath::lerp(alpha, pos, posL);
-				scale = VMath::lerp(alpha, scale, scaleL);
-			}
+			const int boneCount = pCompiledMotion->GetBoneCount();
+			track._vBlendBones.resize(boneCount);
+			VERUS_FOR(i, boneCount)
+				track._vBlendBones[i] = motion._pBlendMotion->FindBone(pCompiledMotion->GetBoneName(i));
 		}
-
-		const Transform3 matSRT = VMath::appendScale(Transform3(q, pos), scale);
-		const Transform3 matBone = pCurrentBone->_matExternal * matSRT;
-		mat = pCurrentBone->_matFromBoneSpace * matBone * pCurrentBone->_matToBoneSpace * pCurrentBone->_matAdapt;
 	}
-	else
-		mat = Transform3::identity();
+}
 
-	_pCurrentBone = FindBone(_C(pCurrentBone->_parentName));
-	if (_pCurrentBone)
+bool Skeleton::SampleBone(RcLayeredMotion motion, RPoseTrack track, int motionBone, CSZ name, float time, RQuat q, RVector3 pos, RVector3 scale)
+{
+	PcCompiledMotion pCompiledMotion = motion._pMotion->GetCompiledMotion();
+	if (pCompiledMotion)
 	{
-		if (_pCurrentBone->_ready)
-			_matParents = _pCurrentBone->_matFinal;
-		else
-			RecursiveBoneUpdate();
+		if (motionBone < 0)
+			return false;
+		pCompiledMotion->SampleBone(motionBone, time, track._cursor, q, pos, scale);
+		if (motion._pBlendMotion && !track._vBlendBones.empty() && track._vBlendBones[motionBone])
+		{
+			const Motion::Bone::Flags flags = static_cast<Motion::Bone::Flags>(pCompiledMotion->GetBoneFlags(motionBone));
+			track._vBlendBones[motionBone]->BlendWithFirstKeyframe(motion._blendAlpha, !!(flags & Motion::Bone::Flags::slerpRot), q, pos, scale);
+		}
+		return true;
 	}
-	else if (pMotionBone = _pCurrentMotion->FindBone(RootName()))
+
+	Motion::PBone pMotionBone = motion._pMotion->FindBone(name);
+	if (!pMotionBone)
+		return false;
+	Vector3 euler;
+	pMotionBone->ComputeRotationAt(time, euler, q, motion._pBlendMotion, motion._blendAlpha);
+	pMotionBone->ComputePositionAt(time, pos, motion._pBlendMotion, motion._blendAlpha);
+	pMotionBone->ComputeScaleAt(time, scale, motion._pBlendMotion, motion._blendAlpha);
+	return true;
+}
+
+void Skeleton::ApplyRagdoll()
+{
+	for (auto& kv : _mapBones)
 	{
-		Quat q;
-		Vector3 scale, euler, pos;
-		pMotionBone->ComputeRotationAt(_currentTime, euler, q);
-		pMotionBone->ComputePositionAt(_currentTime, pos);
-		pMotionBone->ComputeScaleAt(_currentTime, scale);
-		const Transform3 matSRT = VMath::appendScale(Transform3(q, pos), scale);
-		mat = matSRT * mat;
+		RBone bone = kv.second;
+		if (bone._pRigidBody)
+		{
+			btTransform btr;
+			bone._pRigidBody->getMotionState()->getWorldTransform(btr);
+			bone._matFinal = _matRagdollToWorldInv * Transform3(btr) * bone._matToActorSpace;
+		}
+		else
+		{
+			bone._matFinal = Transform3::identity();
+			if (bone._shaderIndex >= 0)
+			{
+				PBone pParent = FindBone(_C(bone._parentName));
+				while (pParent)
+				{
+					if (pParent->_pRigidBody)
+					{
+						btTransform btr;
+						pParent->_pRigidBody->getMotionState()->getWorldTransform(btr);
+						bone._matFinal = _matRagdollToWorldInv * Transform3(btr) * pParent->_matToActorSpace;
+						break;
+					}
+					pParent = FindBone(_C(pParent->_parentName));
+				}
+			}
+		}
 	}
-
-	_matParents = _matParents * mat;
-	pCurrentBone->_matFinal = _matParents;
-	pCurrentBone->_matFinalInv = VMath::inverse(_matParents);
-	pCurrentBone->_ready = true;
 }
 
 void Skeleton::InsertBonesIntoMotion(RMotion motion) const
@@ -342,6 +482,7 @@ void Skeleton::AdjustPrimaryBones(const Vector<String>& vPrimaryBones)
 	}
 
 	_primaryBoneCount = 0;
+	_pPoseBonesOwner = nullptr; // Shader indices will change.
 
 	for (const auto& kv : mapSort)
 	{
@@ -1265,3 +1406,158 @@ void Skeleton::ComputeBoneLengths(Map<String, float>& m, bool accumulated)
 			kv.second += 0.02f;
 	}
 }
+
+void Skeleton::Test()
+{
+	if (!Physics::Bullet::IsValidSingleton()) // Required by Done().
+		return;
+
+	// Bones are inserted before their parents, positions add up along the chain:
+	const int boneCount = 8;
+	Skeleton skeleton;
+	skeleton.Init();
+	Motion motion;
+	motion.Init();
+	motion.SetFps(10);
+	motion.SetFrameCount(10);
+	Motion layeredMotion;
+	layeredMotion.Init();
+	layeredMotion.SetFps(10);
+	layeredMotion.SetFrameCount(10);
+	for (int i = boneCount - 1; i >= 0; --i)
+	{
+		Bone bone;
+		bone._name = "Bone" + std::to_string(i);
+		if (i)
+			bone._parentName = "Bone" + std::to_string(i - 1);
+		skeleton.InsertBone(bone);
+		Motion::PBone pMotionBone = motion.InsertBone(_C(bone._name));
+		pMotionBone->InsertKeyframePosition(0, Vector3(static_cast<float>(i), 1, 0));
+		pMotionBone->InsertKeyframePosition(5, Vector3(static_cast<float>(i), 2, 0));
+		pMotionBone->InsertKeyframeRotation(5, Vector3(0, 0.1f * i, 0));
+		layeredMotion.InsertBone(_C(bone._name))->InsertKeyframePosition(0, Vector3(0, 3, 0));
+	}
+	motion.InsertBone(RootName())->InsertKeyframePosition(0, Vector3(0, 0, 5));
+
+	skeleton.ApplyMotion(motion, 0);
+	float sum = 0;
+	VERUS_FOR(i, boneCount)
+	{
+		sum += i;
+		PcBone pBone = skeleton.FindBone(_C("Bone" + std::to_string(i)));
+		VERUS_RT_ASSERT(Vector3(pBone->_matFinal.getTranslation()).IsEqual(Vector3(sum, i + 1.f, 5), 1e-5f));
+	}
+
+	// Only Bone4 and descendants are affected by layered motion:
+	LayeredMotion layer;
+	layer._pMotion = &layeredMotion;
+	layer._rootBone = "Bone4";
+	layer._alpha = 1;
+	skeleton.ApplyMotion(motion, 0, 1, &layer);
+	VERUS_RT_ASSERT(Vector3(skeleton.FindBone("Bone3")->_matFinal.getTranslation()).IsEqual(Vector3(6, 4, 5), 1e-5f));
+	VERUS_RT_ASSERT(Vector3(skeleton.FindBone("Bone5")->_matFinal.getTranslation()).IsEqual(Vector3(6, 10, 5), 1e-5f));
+
+	// Compiled motion must give the same pose:
+	const float times[] = { 0, 0.25f, 0.5f, 0.8f, 0.3f };
+	Vector<Transform3> vExpected;
+	for (float time : times)
+	{
+		skeleton.ApplyMotion(motion, time, 1, &layer);
+		skeleton.ForEachBone([&vExpected](RcBone bone)
+			{
+				vExpected.push_back(bone._matFinal);
+				return Continue::yes;
+			});
+	}
+	motion.Compile();
+	layeredMotion.Compile();
+	Skeleton skeletonCopy;
+	skeletonCopy = skeleton;
+	int index = 0;
+	for (float time : times)
+	{
+		skeleton.ApplyMotion(motion, time, 1, &layer);
+		skeletonCopy.ApplyMotion(motion, time, 1, &layer);
+		skeletonCopy.ForEachBone([&skeleton, &vExpected, &index](RcBone bone)
+			{
+				const Transform3 matExpected = vExpected[index++];
+				const Transform3 mat = skeleton.FindBone(_C(bone._name))->_matFinal;
+				VERUS_FOR(col, 4)
+				{
+					VERUS_RT_ASSERT(Vector3(mat.getCol(col)).IsEqual(matExpected.getCol(col), 1e-5f));
+					VERUS_RT_ASSERT(Vector3(bone._matFinal.getCol(col)).IsEqual(matExpected.getCol(col), 1e-5f));
+				}
+				return Continue::yes;
+			});
+	}
+
+	// Palette:
+	mataff palette[boneCount];
+	skeleton.UpdateUniformBufferArray(palette);
+	skeleton.ForEachBone([&palette](RcBone bone)
+		{
+			VERUS_RT_ASSERT(palette[bone._shaderIndex] == bone._matFinal.UniformBufferFormat());
+			return Continue::yes;
+		});
+}
+
+void Skeleton::Benchmark()
+{
+	if (!Physics::Bullet::IsValidSingleton()) // Required by Done().
+		return;
+
+	// Humanoid-like skeleton with 64 bones:
+	const int boneCount = 64;
+	const int frameCount = 300;
+	Random random(1234);
+	Skeleton skeleton;
+	skeleton.Init();
+	Motion motion;
+	motion.Init();
+	motion.SetFps(30);
+	motion.SetFrameCount(frameCount);
+	VERUS_FOR(i, boneCount)
+	{
+		Bone bone;
+		bone._name = "Bone" + std::to_string(i);
+		if (i)
+			bone._parentName = "Bone" + std::to_string((i - 1) / 2);
+		bone._matToBoneSpace = Transform3::translation(Vector3(0, -0.1f * i, 0));
+		bone._matFromBoneSpace = Transform3::translation(Vector3(0, 0.1f * i, 0));
+		skeleton.InsertBone(bone);
+
+		Motion::PBone pMotionBone = motion.InsertBone(_C(bone._name));
+		for (int frame = 0; frame < frameCount; frame += 3)
+		{
+			pMotionBone->InsertKeyframeRotation(frame, Vector3(random.NextFloat(-1, 1), random.NextFloat(-1, 1), random.NextFloat(-1, 1)));
+			pMotionBone->InsertKeyframePosition(frame, Vector3(random.NextFloat(-1, 1), random.NextFloat(-1, 1), random.NextFloat(-1, 1)));
+		}
+	}
+
+	const int skeletonCount = 1000;
+	Vector<Skeleton> vSkeletons(skeletonCount);
+	for (auto& x : vSkeletons)
+		x = skeleton;
+	Vector<mataff> vPalette(boneCount);
+
+	float sum = 0;
+	auto Pose = [&vSkeletons, &vPalette, &motion, &sum](int poseCount)
+	{
+		VERUS_FOR(i, poseCount)
+		{
+			const float time = i * (1 / 60.f);
+			for (auto& x : vSkeletons)
+			{
+				x.ApplyMotion(motion, time);
+				x.UpdateUniformBufferArray(vPalette.data());
+				sum += vPalette.back()[0][3];
+			}
+		}
+	};
+
+	const double motionMs = Utils::MeasureBestTime([&Pose]() { Pose(10); }) / 10;
+	motion.Compile();
+	const double compiledMs = Utils::MeasureBestTime([&Pose]() { Pose(60); }) / 60;
+
+	VERUS_LOG_INFO("Benchmark(); " << skeletonCount << " skeletons, per frame: Motion: " << motionMs << " ms, compiled: " << compiledMs << " ms (" << sum << ")");
+}
@@ -20,18 +20,31 @@ namespace verus
 			struct LayeredMotion
 			{
 				PMotion _pMotion = nullptr;
+				PMotion _pBlendMotion = nullptr; // Used instead of the one bound to motion, see ApplyMotion().
 				CSZ     _rootBone = nullptr;
 				float   _alpha = 0;
+				float   _blendAlpha = 0;
 				float   _time = 0;
 			};
 			VERUS_TYPEDEFS(LayeredMotion);
 
+			// Temporary data for pose evaluation. Skeletons can be posed in parallel, each thread with its own scratch:
+			struct PoseScratch
+			{
+				Vector<Quat>       _vRot;
+				Vector<Vector3>    _vPos;
+				Vector<Vector3>    _vScale;
+				Vector<Transform3> _vFinal;
+				Vector<BYTE>       _vSampled; // Current motion has this bone.
+				Vector<BYTE>       _vMask; // Layered motion affects this bone.
+			};
+			VERUS_TYPEDEFS(PoseScratch);
+
 			struct Bone : AllocatorAware
 			{
 				Transform3         _matToBoneSpace = Transform3::identity();
 				Transform3         _matFromBoneSpace = Transform3::identity();
 				Transform3         _matFinal = Transform3::identity();
-				Transform3         _matFinalInv = Transform3::identity();
 				Transform3         _matExternal = Transform3::identity();
 				Transform3         _matAdapt = Transform3::identity();
 				Transform3         _matToActorSpace = Transform3::identity();
@@ -49,6 +62,7 @@ namespace verus
 				float              _mass = 0;
 				float              _friction = 0;
 				int                _shaderIndex = 0; // Index of a matrix in the vertex shader.
+				int                _poseIndex = -1; // Index in flattened array, see UpdatePoseBones().
 				bool               _ready = false;
 				bool               _rigBone = true;
 				bool               _hinge = false; // btHingeConstraint vs btConeTwistConstraint.
@@ -60,19 +74,33 @@ namespace verus
 			typedef Map<String, Bone> TMapBones;
 			typedef Map<int, int> TMapPrimary;
 
-			Transform3   _matParents = Transform3::identity();
-			Transform3   _matRagdollToWorld = Transform3::identity();
-			Transform3   _matRagdollToWorldInv = Transform3::identity();
-			TMapBones    _mapBones;
-			TMapPrimary  _mapPrimary;
-			PBone        _pCurrentBone = nullptr;
-			PMotion      _pCurrentMotion = nullptr;
-			PLayeredMotion _pLayeredMotions = nullptr;
-			float        _currentTime = 0;
-			float        _mass = 0;
-			int          _primaryBoneCount = 0;
-			int          _layeredMotionCount = 0;
-			bool         _ragdollMode = false;
+			// Motion, which is applied to the pose, with bone indices of its compiled version:
+			struct PoseTrack
+			{
+				CompiledMotion::Cursor _cursor;
+				Vector<int>            _vMotionBones; // For each pose bone.
+				Vector<Motion::PBone>  _vBlendBones; // For each bone of compiled motion.
+				PMotion                _pBlendMotion = nullptr;
+				int                    _blendBoneCount = 0;
+				int                    _rootMotionBone = -1;
+				UINT32                 _version = 0;
+			};
+			VERUS_TYPEDEFS(PoseTrack);
+
+			Transform3         _matRagdollToWorld = Transform3::identity();
+			Transform3         _matRagdollToWorldInv = Transform3::identity();
+			TMapBones          _mapBones;
+			TMapPrimary        _mapPrimary;
+			Vector<PBone>      _vPoseBones; // Parents come before children.
+			Vector<int>        _vPoseParents; // Index in _vPoseBones or -1.
+			Vector<int>        _vPoseShaderIndices;
+			Vector<PoseTrack>  _vPoseTracks; // Current motion, then layered motions.
+			Vector<LayeredMotion> _vBoundLayeredMotions;
+			PoseScratch        _poseScratch; // When no scratch is given.
+			const Skeleton*    _pPoseBonesOwner = nullptr; // Pointers are not valid in a copy.
+			float              _mass = 0;
+			int                _primaryBoneCount = 0;
+			bool               _ragdollMode = false;
 
 		public:
 			Skeleton();
@@ -94,16 +122,26 @@ namespace verus
 			PBone FindBoneByIndex(int index);
 
 			// Sets the current pose using motion object (Motion).
+			// Blend motions are bound to motions, see Motion::BindBlendMotion(), this method resets them.
 			void ApplyMotion(RMotion motion, float time,
 				int layeredMotionCount = 0, PLayeredMotion pLayeredMotions = nullptr);
+			// Same, but blend motions are given explicitly and motions are not modified.
+			// Only motion's _pMotion, _time, _pBlendMotion and _blendAlpha are used.
+			// Different skeletons can be posed in parallel, if each thread has its own scratch:
+			void ApplyMotion(RcLayeredMotion motion,
+				int layeredMotionCount = 0, PcLayeredMotion pLayeredMotions = nullptr, PPoseScratch pScratch = nullptr);
 
 			// Fills the array of matrices that will be used by a shader.
 			void UpdateUniformBufferArray(mataff* p) const;
 
 			void ResetFinalPose();
 
-			VERUS_P(void ResetBones());
-			VERUS_P(void RecursiveBoneUpdate());
+			// Flattens the hierarchy, called automatically when bones change:
+			VERUS_P(void UpdatePoseBones());
+			VERUS_P(void BindPoseTrack(RcLayeredMotion motion, RPoseTrack track));
+			// Uses compiled motion if it's available:
+			VERUS_P(bool SampleBone(RcLayeredMotion motion, RPoseTrack track, int motionBone, CSZ name, float time, RQuat q, RVector3 pos, RVector3 scale));
+			VERUS_P(void ApplyRagdoll());
 
 			int GetBoneCount() const { return _primaryBoneCount ? _primaryBoneCount : Utils::Cast32(_mapBones.size()); }
 
@@ -157,6 +195,10 @@ namespace verus
 			Vector3 GetHighestSpeed(RMotion motion, CSZ name, RcVector3 scale = Vector3(1, 0, 1), bool positive = false);
 
 			void ComputeBoneLengths(Map<String, float>& m, bool accumulated = false);
+
+			static void Test();
+			// Poses 1000 skeletons, results are written to log:
+			static void Benchmark();
 		};
 		VERUS_TYPEDEFS(Skeleton);
 	}
@@ -38,7 +38,7 @@ void Warp::Update(RSkeleton skeleton)
 				if (zone._posW.IsZero())
 					zone._posW = posWorldSpace;
 
-				Point3 prevPosBindSpace = pBone->_matFinalInv * zone._posW;
+				Point3 prevPosBindSpace = VMath::inverse(pBone->_matFinal) * zone._posW;
 
 				// Bind-pose space:
 				const Vector3 dirMove = zone._pos - prevPosBindSpace;
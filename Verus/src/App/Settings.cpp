@@ -162,6 +162,16 @@ void Settings::ParseCommandLineArgs(int argc, char* argv[])
 			_commandLine._borderlessWindowed = true;
 		if (IsArg(i, "--restarted"))
 			_commandLine._restarted = true;
+		if (IsArg(i, "--headless"))
+			_commandLine._headless = true;
+		if (IsArg(i, "--frames") && i + 1 < argc)
+			_commandLine._frameCount = atoi(argv[i + 1]);
+		if (IsArg(i, "--test"))
+			_commandLine._test = true;
+		if (IsArg(i, "--benchmark"))
+			_commandLine._benchmark = true;
+		if (IsArg(i, "--prewarm-shaders"))
+			_commandLine._prewarmShaders = true;
 	}
 
 	SetFilename("Settings.json");
@@ -221,6 +231,7 @@ void Settings::Load()
 	_gpuTrilinearFilter = GetB("gpuTrilinearFilter", _gpuTrilinearFilter);
 	_inputMouseSensitivity = GetF("inputMouseSensitivity", _inputMouseSensitivity);
 	_openXR = GetB("openXR", _openXR);
+	_physicsAsyncSimulation = GetB("physicsAsyncSimulation", _physicsAsyncSimulation);
 	_postProcessAntiAliasing = GetB("postProcessAntiAliasing", _postProcessAntiAliasing);
 	_postProcessBloom = GetB("postProcessBloom", _postProcessBloom);
 	_postProcessCinema = GetB("postProcessCinema", _postProcessCinema);
@@ -276,6 +287,9 @@ void Settings::HandleCommandLineArgs()
 		_displayMode = DisplayMode::borderlessWindowed;
 		MatchScreen();
 	}
+
+	_headless = _commandLine._headless;
+	_frameCount = _commandLine._frameCount;
 }
 
 void Settings::Validate()
@@ -317,6 +331,7 @@ void Settings::Save()
 	Set("gpuTrilinearFilter", _gpuTrilinearFilter);
 	Set("inputMouseSensitivity", _inputMouseSensitivity);
 	Set("openXR", _openXR);
+	Set("physicsAsyncSimulation", _physicsAsyncSimulation);
 	Set("postProcessAntiAliasing", _postProcessAntiAliasing);
 	Set("postProcessBloom", _postProcessBloom);
 	Set("postProcessCinema", _postProcessCinema);
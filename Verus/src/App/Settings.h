@@ -117,10 +117,15 @@ namespace verus
 			{
 				int  _gapi = -1;
 				int  _openXR = -1;
+				int  _frameCount = 0;
 				bool _exclusiveFullscreen = false;
 				bool _windowed = false;
 				bool _borderlessWindowed = false;
 				bool _restarted = false;
+				bool _headless = false;
+				bool _test = false;
+				bool _benchmark = false;
+				bool _prewarmShaders = false;
 			};
 
 			enum Platform : int
@@ -138,6 +143,7 @@ namespace verus
 			int         _gapi = 0;
 			float       _inputMouseSensitivity = 1;
 			bool        _openXR = false;
+			bool        _physicsAsyncSimulation = false;
 			bool        _physicsSupportDebugDraw = false;
 			String      _uiLang = "EN";
 			CommandLine _commandLine;
@@ -145,6 +151,8 @@ namespace verus
 			String      _imguiFont;
 			float       _highDpiScale = 1;
 			Platform    _platform = Platform::classic;
+			int         _frameCount = 0; // Quit after this many frames, zero means never.
+			bool        _headless = false; // No window, RendererNull is used.
 
 			Settings();
 			~Settings();
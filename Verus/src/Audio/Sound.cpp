@@ -71,6 +71,12 @@ void Sound::UpdateHRTF()
 }
 
 void Sound::Async_WhenLoaded(CSZ url, RcBlob blob)
+{
+	Async_Process(url, blob);
+	Async_Commit(url, blob);
+}
+
+void Sound::Async_Process(CSZ url, RcBlob blob)
 {
 	VERUS_RT_ASSERT(_url == url);
 	VERUS_RT_ASSERT(!_buffer);
@@ -87,11 +93,9 @@ void Sound::Async_WhenLoaded(CSZ url, RcBlob blob)
 		throw VERUS_RUNTIME_ERROR << "ov_open_callbacks(); " << ret;
 
 	povi = ov_info(&ovf, -1);
-	const ALenum format = (povi->channels == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+	_channelCount = povi->channels;
+	_sampleRate = povi->rate;
 
-	alGenBuffers(1, &_buffer);
-
-	_length = static_cast<float>(ov_time_total(&ovf, -1));
 	const INT64 pcmSize = ov_pcm_total(&ovf, -1) * 2 * povi->channels + 1;
 	_vPcmBuffer.resize(pcmSize);
 	int bitstream, offset = 0;
@@ -101,8 +105,21 @@ void Sound::Async_WhenLoaded(CSZ url, RcBlob blob)
 		offset += count;
 		count = ov_read(&ovf, reinterpret_cast<char*>(&_vPcmBuffer[offset]), Utils::Cast32(_vPcmBuffer.size()) - offset, 0, 2, 1, &bitstream);
 	} while (count > 0);
-	alBufferData(_buffer, format, _vPcmBuffer.data(), offset, povi->rate);
+	_pcmSize = offset;
 	ov_clear(&ovf);
+}
+
+void Sound::Async_Commit(CSZ url, RcBlob blob)
+{
+	VERUS_RT_ASSERT(_url == url);
+	VERUS_RT_ASSERT(!_buffer);
+
+	const ALenum format = (_channelCount == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+
+	alGenBuffers(1, &_buffer);
+
+	_length = static_cast<float>(_pcmSize / (2 * _channelCount)) / _sampleRate;
+	alBufferData(_buffer, format, _vPcmBuffer.data(), _pcmSize, _sampleRate);
 
 	if (!IsFlagSet(SoundFlags::keepPcmBuffer))
 	{
@@ -30,6 +30,9 @@ namespace verus
 			Interval     _pitch = 1;
 			float        _referenceDistance = 4;
 			float        _length = 0;
+			int          _pcmSize = 0;
+			int          _channelCount = 0;
+			int          _sampleRate = 0;
 
 		public:
 			// Note that this structure contains some default values for new sources, which can be changed per source.
@@ -68,6 +71,8 @@ namespace verus
 
 			// <Resources>
 			virtual void Async_WhenLoaded(CSZ url, RcBlob blob) override;
+			virtual void Async_Process(CSZ url, RcBlob blob) override;
+			virtual void Async_Commit(CSZ url, RcBlob blob) override;
 			bool IsLoaded() const { return IsFlagSet(SoundFlags::loaded); }
 			Str GetURL() const { return _C(_url); }
 			// </Resources>
@@ -209,6 +209,7 @@ void StreamPlayer::Seek(int pos)
 void StreamPlayer::ThreadProc()
 {
 	VERUS_RT_ASSERT(IsInitialized());
+	VERUS_PROFILE_THREAD("StreamPlayer");
 	try
 	{
 		SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
@@ -217,6 +218,7 @@ void StreamPlayer::ThreadProc()
 			VERUS_LOCK(*this);
 
 			_cv.wait_for(lock, std::chrono::milliseconds(530));
+			VERUS_PROFILE_SCOPE("StreamPlayer::Tick");
 
 			if (IsFlagSet(StreamPlayerFlags::play))
 			{
@@ -10,9 +10,22 @@ namespace verus
 			unknown,
 			vulkan,
 			direct3D11,
-			direct3D12
+			direct3D12,
+			null
 		};
 
+		// CPU-side work, which was submitted to the renderer. Only RendererNull counts it.
+		struct RendererStats
+		{
+			UINT64 _drawCount = 0;
+			UINT64 _vertexCount = 0; // Including instances.
+			UINT64 _dispatchCount = 0;
+			UINT64 _pipelineBindCount = 0;
+			UINT64 _descriptorBindCount = 0;
+			UINT64 _uploadedBytes = 0; // Buffers, textures and uniforms.
+		};
+		VERUS_TYPEDEFS(RendererStats);
+
 		struct BaseRendererDesc
 		{
 			GlobalVarsClipboard _gvc;
@@ -29,6 +42,7 @@ namespace verus
 		protected:
 			Vector<PScheduled> _vScheduled;
 			BaseRendererDesc   _desc;
+			RendererStats      _stats;
 			int                _swapChainBufferCount = 0;
 			int                _swapChainBufferIndex = 0;
 			int                _ringBufferIndex = 0;
@@ -48,6 +62,9 @@ namespace verus
 			int GetSwapChainBufferIndex() const { return _swapChainBufferIndex; }
 			int GetRingBufferIndex() const { return _ringBufferIndex; }
 
+			RcRendererStats GetStats() const { return _stats; }
+			void ResetStats() { _stats = RendererStats(); }
+
 			void Schedule(PScheduled p);
 			void Unschedule(PScheduled p);
 			void UpdateScheduled();
@@ -178,7 +178,10 @@ void ShaderPtr::Init(RcShaderDesc desc)
 	_p->SetUserDefines(desc._userDefines);
 	_p->SetSaveCompiled(desc._saveCompiled);
 	if (desc._url)
+	{
+		renderer.AddShaderSource(desc);
 		_p->Load(desc._url);
+	}
 	else
 		_p->Init(desc._source, "", desc._branches);
 }
@@ -338,6 +338,17 @@ void DeferredShading::InitByTerrain(TexturePtr texHeightmap, TexturePtr texBlend
 		});
 }
 
+void DeferredShading::DoneByTerrain(TexturePtr texHeightmap)
+{
+	if (!IsInitialized() || !texHeightmap || _texTerrainHeightmap != texHeightmap)
+		return;
+
+	_texTerrainHeightmap = nullptr;
+	_texTerrainBlend = nullptr;
+	_terrainMapSide = 1;
+	InitByTerrain(nullptr, nullptr, 0);
+}
+
 void DeferredShading::Done()
 {
 	VERUS_DONE(DeferredShading);
@@ -126,6 +126,8 @@ namespace verus
 			void InitByAtmosphere(TexturePtr texShadow);
 			void InitByBloom(TexturePtr tex);
 			void InitByTerrain(TexturePtr texHeightmap, TexturePtr texBlend, int mapSide);
+			// Unbinds terrain's textures, if they are still used:
+			void DoneByTerrain(TexturePtr texHeightmap);
 
 			void Done();
 
@@ -57,6 +57,11 @@ void Renderer::Init(PRendererDelegate pDelegate, bool allowInitShaders)
 	default:
 		VERUS_LOG_INFO("Using Vulkan");
 	}
+	if (settings._headless)
+	{
+		dll = "RendererNull.dll";
+		VERUS_LOG_INFO("Using Null (headless)");
+	}
 	BaseRendererDesc desc;
 	_pBaseRenderer = BaseRenderer::Load(dll, desc);
 
@@ -618,6 +623,54 @@ void Renderer::OnShaderWarning(CSZ s)
 	VERUS_LOG_WARN("Shader Warning:\n" << s);
 }
 
+void Renderer::AddShaderSource(RcShaderDesc desc)
+{
+	const String userDefines = desc._userDefines ? desc._userDefines : "";
+	auto it = std::find_if(_vShaderSources.begin(), _vShaderSources.end(), [&desc, &userDefines](RcShaderSource source)
+		{
+			return source._url == desc._url && source._hasUserDefines == !!desc._userDefines && source._userDefines == userDefines;
+		});
+	if (_vShaderSources.end() == it)
+	{
+		_vShaderSources.resize(_vShaderSources.size() + 1);
+		it = _vShaderSources.end() - 1;
+		it->_url = desc._url;
+		it->_userDefines = userDefines;
+		it->_hasUserDefines = !!desc._userDefines;
+	}
+}
+
+void Renderer::PrewarmShaderCache()
+{
+	VERUS_QREF_SETTINGS;
+
+	if (Gapi::vulkan != _gapi)
+	{
+		VERUS_LOG_WARN("PrewarmShaderCache(); Only Vulkan renderer has the shader cache");
+		return;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	const App::QualitySettings prevQualitySettings = settings;
+	const Vector<ShaderSource> vShaderSources = _vShaderSources;
+	for (int q = +App::QualitySettings::OverallQuality::low; q <= +App::QualitySettings::OverallQuality::ultra; ++q)
+	{
+		settings.SetQuality(static_cast<App::QualitySettings::OverallQuality>(q));
+		for (const auto& source : vShaderSources)
+		{
+			// Ignore list depends on settings, which are used when the shader is loaded, so all branches are compiled:
+			ShaderDesc shaderDesc(_C(source._url));
+			shaderDesc._userDefines = source._hasUserDefines ? _C(source._userDefines) : nullptr;
+			ShaderPwn shader;
+			shader.Init(shaderDesc);
+		}
+	}
+	static_cast<App::RQualitySettings>(settings) = prevQualitySettings;
+
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	VERUS_LOG_INFO("PrewarmShaderCache(); " << vShaderSources.size() << " shaders, " << ms << " ms");
+}
+
 void Renderer::ImGuiSetCurrentContext(ImGuiContext* pContext)
 {
 	ImGui::SetCurrentContext(pContext);
@@ -56,7 +56,16 @@ namespace verus
 				glm::vec2 _pos;
 			};
 
+			struct ShaderSource // For PrewarmShaderCache().
+			{
+				String _url;
+				String _userDefines;
+				bool   _hasUserDefines = false;
+			};
+			VERUS_TYPEDEFS(ShaderSource);
+
 			Vector<Utilization>      _vUtilization;
+			Vector<ShaderSource>     _vShaderSources;
 			App::PWindow             _pMainWindow = nullptr;
 			PBaseRenderer            _pBaseRenderer = nullptr;
 			PRendererDelegate        _pRendererDelegate = nullptr;
@@ -153,6 +162,11 @@ namespace verus
 			void OnShaderError(CSZ s);
 			void OnShaderWarning(CSZ s);
 
+			// Shader cache:
+			void AddShaderSource(RcShaderDesc desc);
+			// Compiles shaders, which were loaded from files so far, with each overall quality, so that they are in the disk cache:
+			void PrewarmShaderCache();
+
 			// ImGui:
 			virtual void ImGuiSetCurrentContext(ImGuiContext* pContext);
 			void ImGuiUpdateStyle();
@@ -4,24 +4,146 @@
 using namespace verus;
 using namespace verus::D;
 
+namespace
+{
+	std::atomic<UINT64> g_logGeneration(0);
+
+	// Validation layer messages, which are not useful, they follow "UNASSIGNED-":
+	struct IgnoredPrefix
+	{
+		CSZ    _prefix;
+		size_t _length;
+	};
+#define VERUS_IGNORED_PREFIX(s) { s, sizeof(s) - 1 }
+	const IgnoredPrefix g_ignoredPrefixes[] =
+	{
+		VERUS_IGNORED_PREFIX("BestPractices-TransitionUndefinedToReadOnly"),
+		VERUS_IGNORED_PREFIX("BestPractices-vkAllocateMemory-small-allocation"),
+		VERUS_IGNORED_PREFIX("BestPractices-vkBindMemory-small-dedicated-allocation"),
+		VERUS_IGNORED_PREFIX("BestPractices-vkCreateDevice-physical-device-features-not-retrieved"),
+		VERUS_IGNORED_PREFIX("BestPractices-vkCreateInstance-specialuse-extension-debugging"),
+		VERUS_IGNORED_PREFIX("CoreValidation-Shader-InconsistentSpirv"),
+		VERUS_IGNORED_PREFIX("CoreValidation-Shader-OutputNotConsumed")
+	};
+#undef VERUS_IGNORED_PREFIX
+
+	// Generations of logs, which exist, their thread buffers can be abandoned:
+	std::mutex          g_liveLogsMutex;
+	std::vector<UINT64> g_vLiveLogs;
+
+	bool IsLogAlive(UINT64 generation)
+	{
+		return std::find(g_vLiveLogs.begin(), g_vLiveLogs.end(), generation) != g_vLiveLogs.end();
+	}
+
+	// Tells the writer thread, that the buffer will not get new messages.
+	// Usually there is one log, tests add a private one:
+	struct LogThreadBuffers
+	{
+		struct Entry
+		{
+			Log::PThreadBuffer _p = nullptr;
+			UINT64             _generation = 0;
+		};
+
+		std::vector<Entry> _vEntries;
+
+		~LogThreadBuffers()
+		{
+			std::lock_guard<std::mutex> lock(g_liveLogsMutex);
+			for (const auto& x : _vEntries)
+			{
+				if (IsLogAlive(x._generation))
+					x._p->Abandon();
+			}
+		}
+	};
+	thread_local LogThreadBuffers g_logThreadBuffers;
+
+	// Messages, which are still in ring buffers, must be written before the program dies:
+	std::terminate_handler g_prevTerminateHandler = nullptr;
+	void OnTerminate()
+	{
+		if (Log::IsValidSingleton())
+			Log::I().Flush();
+		if (g_prevTerminateHandler)
+			g_prevTerminateHandler();
+		abort();
+	}
+#ifdef _WIN32
+	LPTOP_LEVEL_EXCEPTION_FILTER g_prevExceptionFilter = nullptr;
+	LONG WINAPI OnUnhandledException(EXCEPTION_POINTERS* pExceptionInfo)
+	{
+		if (Log::IsValidSingleton())
+			Log::I().Flush();
+		return g_prevExceptionFilter ? g_prevExceptionFilter(pExceptionInfo) : EXCEPTION_CONTINUE_SEARCH;
+	}
+#endif
+}
+
+// Log::ThreadBuffer:
+
+Log::ThreadBuffer::ThreadBuffer()
+{
+	_pSlots.reset(new BYTE[s_slotCount * s_slotSize]);
+	_writeCount = 0;
+	_readCount = 0;
+	_abandoned = false;
+}
+
+// Log:
+
+Log::Log() : Log(NoAssign())
+{
+	Assign(this); // Fully constructed.
+	_singleton = true;
+	g_prevTerminateHandler = std::set_terminate(OnTerminate);
+#ifdef _WIN32
+	g_prevExceptionFilter = SetUnhandledExceptionFilter(OnUnhandledException);
+#endif
+}
+
+Log::Log(NoAssign noAssign) : Singleton(noAssign)
+{
+	_maxSeverity = +Severity::debug;
+	_droppedCount = 0;
+	_wake = false;
+	_generation = ++g_logGeneration;
+	{
+		std::lock_guard<std::mutex> lock(g_liveLogsMutex);
+		g_vLiveLogs.push_back(_generation);
+	}
+	_thread = std::thread(&Log::ThreadProc, this);
+}
+
+Log::~Log()
+{
+	if (_singleton)
+	{
+#ifdef _WIN32
+		SetUnhandledExceptionFilter(g_prevExceptionFilter);
+#endif
+		std::set_terminate(g_prevTerminateHandler);
+	}
+	{
+		// Exiting threads must not touch buffers from now on:
+		std::lock_guard<std::mutex> lock(g_liveLogsMutex);
+		g_vLiveLogs.erase(std::remove(g_vLiveLogs.begin(), g_vLiveLogs.end(), _generation), g_vLiveLogs.end());
+	}
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopThread = true;
+	}
+	_cv.notify_one();
+	_cvSpace.notify_all();
+	if (_thread.joinable())
+		_thread.join();
+}
+
 void Log::Write(CSZ txt, std::thread::id tid, CSZ filename, UINT32 line, Severity severity)
 {
-	if (strstr(txt, "UNASSIGNED-BestPractices-TransitionUndefinedToReadOnly"))
-		return;
-	if (strstr(txt, "UNASSIGNED-BestPractices-vkAllocateMemory-small-allocation"))
-		return;
-	if (strstr(txt, "UNASSIGNED-BestPractices-vkBindMemory-small-dedicated-allocation"))
-		return;
-	if (strstr(txt, "UNASSIGNED-BestPractices-vkCreateDevice-physical-device-features-not-retrieved"))
-		return;
-	if (strstr(txt, "UNASSIGNED-BestPractices-vkCreateInstance-specialuse-extension-debugging"))
-		return;
-	if (strstr(txt, "UNASSIGNED-CoreValidation-Shader-InconsistentSpirv"))
+	if (+severity > _maxSeverity.load(std::memory_order_relaxed) || IsIgnored(txt))
 		return;
-	if (strstr(txt, "UNASSIGNED-CoreValidation-Shader-OutputNotConsumed"))
-		return;
-
-	VERUS_LOCK(*this);
 
 #ifdef _DEBUG
 	if (severity <= Severity::error)
@@ -29,38 +151,277 @@ void Log::Write(CSZ txt, std::thread::id tid, CSZ filename, UINT32 line, Severit
 		SDL_TriggerBreakpoint();
 	}
 #endif
-	char timestamp[40];
-	FormatTime(timestamp, sizeof(timestamp));
-	CSZ severityLetter = GetSeverityLetter(severity);
-	const String filenameEx = ExtractFilename(filename);
+
+	Record record;
+	record._time = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	record._tid = tid;
+	record._line = line;
+	record._severity = severity;
+	CSZ p = strrchr(filename, '/');
+	if (!p)
+		p = strrchr(filename, '\\');
+	filename = p ? p + 1 : filename;
+	const size_t filenameLength = Math::Min(strcspn(filename, "."), sizeof(record._filename) - 1);
+	memcpy(record._filename, filename, filenameLength);
+	record._filename[filenameLength] = 0;
+	const size_t maxLength = s_slotCount / 2 * s_slotSize - sizeof(Record);
+	record._length = static_cast<UINT32>(Math::Min(strlen(txt), maxLength));
+	record._slotCount = static_cast<UINT32>((sizeof(Record) + record._length + s_slotSize - 1) / s_slotSize);
+
+	PThreadBuffer pBuffer = GetThreadBuffer();
+	const UINT64 writeCount = pBuffer->_writeCount.load(std::memory_order_relaxed);
+	const UINT32 pos = writeCount & (s_slotCount - 1);
+	// Record must be contiguous, so the end of ring buffer can be skipped:
+	const UINT32 skipCount = (pos + record._slotCount > s_slotCount) ? s_slotCount - pos : 0;
+	const UINT64 newWriteCount = writeCount + skipCount + record._slotCount;
+
+	// Buffer is full? Wait for the writer thread:
+	if (newWriteCount - pBuffer->_readCount.load(std::memory_order_acquire) > s_slotCount && !WaitForSpace(pBuffer, newWriteCount))
+	{
+		_droppedCount++;
+		return;
+	}
+
+	BYTE* pSlots = pBuffer->_pSlots.get();
+	if (skipCount)
+	{
+		Record skip;
+		skip._slotCount = skipCount;
+		memcpy(pSlots + pos * s_slotSize, &skip, sizeof(skip));
+	}
+	BYTE* pDest = pSlots + ((writeCount + skipCount) & (s_slotCount - 1)) * s_slotSize;
+	memcpy(pDest, &record, sizeof(record));
+	memcpy(pDest + sizeof(record), txt, record._length);
+	pBuffer->_writeCount.store(newWriteCount, std::memory_order_release);
+
+	if (Severity::error == severity)
+	{
+		Flush();
+	}
+	else if (newWriteCount - pBuffer->_readCount.load(std::memory_order_relaxed) > s_slotCount / 2)
+	{
+		if (!_wake.exchange(true))
+			_cv.notify_one();
+	}
+}
+
+void Log::Flush()
+{
+	if (IsWriterThread())
+		return; // Would wait for itself.
+	std::unique_lock<std::mutex> lock(_mutex);
+	if (_stopThread)
+		return;
+	const UINT64 ticket = ++_flushRequested;
+	_cv.notify_one();
+	_cvFlushed.wait(lock, [this, ticket]() { return _flushDone >= ticket; });
+}
+
+void Log::SetPathname(CSZ pathname)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_pathname = pathname ? pathname : "";
+}
+
+Log::PThreadBuffer Log::GetThreadBuffer()
+{
+	auto& vEntries = g_logThreadBuffers._vEntries;
+	for (const auto& x : vEntries)
+	{
+		if (x._generation == _generation)
+			return x._p;
+	}
+
+	// Forget buffers of logs, which no longer exist:
+	{
+		std::lock_guard<std::mutex> lock(g_liveLogsMutex);
+		vEntries.erase(std::remove_if(vEntries.begin(), vEntries.end(), [](const LogThreadBuffers::Entry& x)
+			{
+				return !IsLogAlive(x._generation);
+			}), vEntries.end());
+	}
+
+	LogThreadBuffers::Entry entry;
+	{
+		std::lock_guard<std::mutex> lock(_mutexBuffers);
+		_vBuffers.push_back(std::make_unique<ThreadBuffer>());
+		entry._p = _vBuffers.back().get();
+	}
+	entry._generation = _generation;
+	vEntries.push_back(entry);
+	return entry._p;
+}
+
+bool Log::WaitForSpace(PThreadBuffer pBuffer, UINT64 writeCount)
+{
+	if (IsWriterThread())
+		return false; // Would wait for itself.
+	auto HasSpace = [pBuffer, writeCount]()
+	{
+		return writeCount - pBuffer->_readCount.load(std::memory_order_acquire) <= s_slotCount;
+	};
+	std::unique_lock<std::mutex> lock(_mutex);
+	_wake = true;
+	_cv.notify_one();
+	_cvSpace.wait(lock, [this, &HasSpace]() { return _stopThread || HasSpace(); });
+	return HasSpace();
+}
+
+void Log::ThreadProc()
+{
+	while (true)
+	{
+		UINT64 ticket = 0;
+		bool stop = false;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_cv.wait_for(lock, std::chrono::milliseconds(50), [this]() { return _stopThread || _flushRequested > _flushDone || _wake; });
+			_wake = false;
+			ticket = _flushRequested;
+			stop = _stopThread;
+		}
+
+		Collect();
+		WriteEntries();
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_flushDone = ticket;
+		}
+		_cvFlushed.notify_all();
+		_cvSpace.notify_all();
+
+		if (stop)
+			break;
+	}
+	_pFile.reset();
+}
+
+void Log::Collect()
+{
+	std::lock_guard<std::mutex> lock(_mutexBuffers);
+	for (auto it = _vBuffers.begin(); it != _vBuffers.end();)
+	{
+		PThreadBuffer pBuffer = it->get();
+		const bool abandoned = pBuffer->_abandoned; // Nothing is written after this flag is set.
+		const UINT64 writeCount = pBuffer->_writeCount.load(std::memory_order_acquire);
+		UINT64 readCount = pBuffer->_readCount.load(std::memory_order_relaxed);
+		const BYTE* pSlots = pBuffer->_pSlots.get();
+		while (readCount < writeCount)
+		{
+			const BYTE* pSrc = pSlots + (readCount & (s_slotCount - 1)) * s_slotSize;
+			Entry entry;
+			memcpy(&entry._record, pSrc, sizeof(Record));
+			readCount += entry._record._slotCount;
+			if (!entry._record._time)
+				continue;
+			entry._text.assign(reinterpret_cast<CSZ>(pSrc + sizeof(Record)), entry._record._length);
+			_vEntries.push_back(std::move(entry));
+		}
+		pBuffer->_readCount.store(readCount, std::memory_order_release);
+
+		if (abandoned)
+			it = _vBuffers.erase(it);
+		else
+			++it;
+	}
+}
+
+void Log::WriteEntries()
+{
+	if (_vEntries.empty())
+		return;
+
+	std::stable_sort(_vEntries.begin(), _vEntries.end(), [](RcEntry a, RcEntry b)
+		{
+			return a._record._time < b._record._time;
+		});
+
 	StringStream ss;
-	ss << timestamp << " [" << severityLetter << "] [" << tid << "] [" << filenameEx << ":" << line << "] " << txt << std::endl;
+	char timestamp[40] = {};
+	INT64 second = -1;
+	for (const auto& entry : _vEntries)
+	{
+		RcRecord record = entry._record;
+		// Calendar time only changes once per second:
+		if (record._time / 1000000 != second)
+		{
+			second = record._time / 1000000;
+			FormatTime(timestamp, sizeof(timestamp), record._time);
+		}
+		else
+		{
+			sprintf_s(timestamp + strlen(timestamp) - 6, 7, "%06d", static_cast<int>(record._time % 1000000));
+		}
+		ss << timestamp << " [" << GetSeverityLetter(record._severity) << "] [" << record._tid << "] [";
+		ss << record._filename << ":" << record._line << "] " << entry._text << std::endl;
+	}
+	_vEntries.clear();
 	const String s = ss.str();
 
-	if (_pathname.empty())
+	OpenFile();
+	if (!_pFile)
+		return;
+	_pFile->Write(_C(s), s.length());
+	fflush(_pFile->GetFile());
+	_fileSize += s.length();
+
+	// Keep one old file:
+	if (_fileSize > s_maxFileSize)
 	{
-		_pathname += _C(Utils::I().GetWritablePath());
-		_pathname += "Log.txt";
+		_pFile.reset();
+		const size_t pos = _openPathname.rfind('.');
+		const String backup = (String::npos == pos) ? _openPathname + ".1" : _openPathname.substr(0, pos) + ".1" + _openPathname.substr(pos);
+		IO::FileSystem::Delete(_C(backup));
+#ifdef _WIN32
+		_wrename(_C(Str::Utf8ToWide(_C(_openPathname))), _C(Str::Utf8ToWide(_C(backup))));
+#else
+		rename(_C(_openPathname), _C(backup));
+#endif
+		_openPathname.clear();
 	}
+}
 
-	IO::File file;
-	if (file.Open(_C(_pathname), "a"))
+void Log::OpenFile()
+{
+	String pathname;
 	{
-		if (file.GetSize() > 100 * 1024)
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_pathname.empty() && Utils::IsValidSingleton())
 		{
-			file.Close();
-			file.Open(_C(_pathname), "w");
+			_pathname += _C(Utils::I().GetWritablePath());
+			_pathname += "Log.txt";
 		}
-		file.Write(_C(s), s.length());
+		pathname = _pathname;
 	}
+	if (_pFile && pathname == _openPathname)
+		return;
+
+	_pFile.reset();
+	_openPathname = pathname;
+	if (pathname.empty())
+		return;
+	_pFile = std::make_unique<IO::File>();
+	if (!_pFile->Open(_C(pathname), "a"))
+	{
+		_pFile.reset();
+		return;
+	}
+	_pFile->Seek(0, SEEK_END);
+	_fileSize = _pFile->GetPosition();
 }
 
 void Log::FormatTime(char* buffer, size_t size)
 {
-	const auto now = std::chrono::system_clock::now();
-	const time_t tnow = std::chrono::system_clock::to_time_t(now);
-	const auto trimmed = std::chrono::system_clock::from_time_t(tnow);
-	const int ms = static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(now - trimmed).count());
+	FormatTime(buffer, size, std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+void Log::FormatTime(char* buffer, size_t size, INT64 time)
+{
+	const time_t tnow = static_cast<time_t>(time / 1000000);
+	const int ms = static_cast<int>(time % 1000000);
 	char msText[16];
 	sprintf_s(msText, ".%06d", ms);
 	tm* pTM = localtime(&tnow);
@@ -89,3 +450,168 @@ String Log::ExtractFilename(CSZ filename)
 	p = strrchr(filename, '.');
 	return p ? String(filename, p) : String(filename);
 }
+
+bool Log::IsIgnored(CSZ txt)
+{
+	CSZ p = strstr(txt, "UNASSIGNED-");
+	if (!p)
+		return false;
+	p += strlen("UNASSIGNED-");
+	for (const auto& x : g_ignoredPrefixes)
+	{
+		if (!strncmp(p, x._prefix, x._length))
+			return true;
+	}
+	return false;
+}
+
+void Log::Test()
+{
+	// Private instance, so that messages of other threads still go to the singleton's file:
+	const String writablePath = Utils::IsValidSingleton() ? String(_C(Utils::I().GetWritablePath())) : String();
+	const String testPathname = writablePath + "LogTest.txt";
+	const String testBackup = writablePath + "LogTest.1.txt"; // Less than 2 MB is written.
+	IO::FileSystem::Delete(_C(testPathname));
+	IO::FileSystem::Delete(_C(testBackup));
+
+	const int wrapCount = 3 * s_slotCount;
+	const int threadCount = 4;
+	const int threadLineCount = 500;
+	const String longText(s_slotCount * s_slotSize, 'y'); // Will be truncated.
+	{
+		Log log{ NoAssign() };
+		log.SetPathname(_C(testPathname));
+		auto WriteDebug = [&log](RcString text)
+		{
+			log.Write(_C(text), std::this_thread::get_id(), __FILE__, __LINE__, Severity::debug);
+		};
+
+		// Records of different size wrap around the ring buffer many times, so the end is often skipped.
+		// Write() must wait for the writer thread, when the ring buffer is full:
+		VERUS_FOR(i, wrapCount)
+		{
+			StringStream ss;
+			ss << "Test(); wrap=" << i << " " << String(i % 100, 'x');
+			WriteDebug(ss.str());
+		}
+		WriteDebug(longText);
+
+		// Threads write, flush and exit, their buffers must be removed:
+		PThreadBuffer threadBuffers[threadCount] = {};
+		Vector<std::thread> vThreads;
+		vThreads.reserve(threadCount);
+		VERUS_FOR(i, threadCount)
+		{
+			vThreads.push_back(std::thread([i, &log, &threadBuffers, &WriteDebug]()
+				{
+					threadBuffers[i] = log.GetThreadBuffer();
+					VERUS_FOR(line, threadLineCount)
+					{
+						StringStream ss;
+						ss << "Test(); thread=" << i << " line=" << line;
+						WriteDebug(ss.str());
+						if (!(line % 100))
+							log.Flush(); // Many tickets at once.
+					}
+					log.Flush();
+				}));
+		}
+		for (auto& x : vThreads)
+			x.join();
+		log.Flush();
+		VERUS_RT_ASSERT(!log.GetDroppedCount());
+		{
+			std::lock_guard<std::mutex> lock(log._mutexBuffers);
+			for (const auto& pBuffer : log._vBuffers)
+			{
+				for (PThreadBuffer x : threadBuffers)
+					VERUS_RT_ASSERT(pBuffer.get() != x);
+			}
+		}
+	} // Writer thread writes the rest and closes the file.
+
+	// Every line must be in the file, lines from one thread must be in order:
+	String text;
+	for (CSZ pathname : { _C(testBackup), _C(testPathname) })
+	{
+		IO::File file;
+		if (file.Open(pathname, "rb"))
+		{
+			const size_t size = text.size();
+			text.resize(size + static_cast<size_t>(file.GetSize()));
+			file.Read(&text[size], text.size() - size);
+		}
+	}
+	int wrapExpected = 0;
+	int lineExpected[threadCount] = {};
+	bool longFound = false;
+	StringStream ss(text);
+	String line;
+	while (std::getline(ss, line))
+	{
+		size_t pos;
+		if ((pos = line.find("Test(); wrap=")) != String::npos)
+		{
+			VERUS_RT_ASSERT(atoi(_C(line) + pos + 13) == wrapExpected);
+			wrapExpected++;
+		}
+		else if ((pos = line.find("Test(); thread=")) != String::npos)
+		{
+			const int thread = atoi(_C(line) + pos + 15);
+			VERUS_RT_ASSERT(thread >= 0 && thread < threadCount);
+			VERUS_RT_ASSERT(atoi(strstr(_C(line) + pos, "line=") + 5) == lineExpected[thread]);
+			lineExpected[thread]++;
+		}
+		else if (line.find("yyyy") != String::npos)
+		{
+			VERUS_RT_ASSERT(line.length() < longText.length());
+			longFound = true;
+		}
+	}
+	VERUS_RT_ASSERT(wrapExpected == wrapCount && longFound);
+	for (int x : lineExpected)
+		VERUS_RT_ASSERT(x == threadLineCount);
+	IO::FileSystem::Delete(_C(testPathname));
+	IO::FileSystem::Delete(_C(testBackup));
+}
+
+void Log::Benchmark()
+{
+	const int threadCount = 8;
+	const int lineCount = 1000000;
+
+	// Private instance keeps the main log readable:
+	const String writablePath = Utils::IsValidSingleton() ? String(_C(Utils::I().GetWritablePath())) : String();
+	double writeMs = DBL_MAX;
+	double flushMs = 0;
+	{
+		Log log{ NoAssign() };
+		log.SetPathname(_C(writablePath + "LogBenchmark.txt"));
+
+		flushMs = Utils::MeasureBestTime([&writeMs, &log]()
+			{
+				const auto start = std::chrono::steady_clock::now();
+				Vector<std::thread> vThreads;
+				vThreads.reserve(threadCount);
+				VERUS_FOR(i, threadCount)
+				{
+					vThreads.push_back(std::thread([i, &log]()
+						{
+							for (int line = i; line < lineCount; line += threadCount)
+							{
+								StringStream ss;
+								ss << "Benchmark(); line=" << line;
+								log.Write(_C(ss.str()), std::this_thread::get_id(), __FILE__, __LINE__, Severity::debug);
+							}
+						}));
+				}
+				for (auto& x : vThreads)
+					x.join();
+				const auto written = std::chrono::steady_clock::now();
+				log.Flush();
+				writeMs = Math::Min(writeMs, std::chrono::duration<double, std::milli>(written - start).count());
+			}, 3);
+	}
+
+	VERUS_LOG_INFO("Benchmark(); " << lineCount << " lines from " << threadCount << " threads: " << writeMs << " ms in threads, " << flushMs << " ms until flushed");
+}
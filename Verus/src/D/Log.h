@@ -8,8 +8,19 @@
 
 namespace verus
 {
+	namespace IO
+	{
+		class File;
+	}
+
 	namespace D
 	{
+		// Write() copies the message into a ring buffer of the calling thread, it doesn't lock or call the system.
+		// Background thread collects messages from all threads, sorts them by time and writes them to file.
+		// When the file grows too big, it is renamed to Log.1.txt and a new file is started.
+		// Errors are flushed before Write() returns, so that they are not lost if the program crashes.
+		// If the ring buffer is full, Write() waits for the writer thread. Messages from the writer thread itself are dropped.
+		// Everything is flushed on std::terminate() and on unhandled exception.
 		class Log : public Singleton<Log>
 		{
 		public:
@@ -21,18 +32,111 @@ namespace verus
 				debug
 			};
 
+			struct Record
+			{
+				INT64           _time = 0; // Microseconds since epoch.
+				std::thread::id _tid;
+				UINT32          _line = 0;
+				UINT32          _length = 0; // Text follows the record.
+				UINT32          _slotCount = 0; // Record with zero time skips the end of ring buffer.
+				Severity        _severity = Severity::error;
+				char            _filename[32];
+			};
+			VERUS_TYPEDEFS(Record);
+
+			class ThreadBuffer
+			{
+				friend class Log;
+
+				std::unique_ptr<BYTE[]> _pSlots;
+				std::atomic<UINT64>     _writeCount; // In slots.
+				std::atomic<UINT64>     _readCount;
+				std::atomic_bool        _abandoned; // Thread has finished.
+
+			public:
+				ThreadBuffer();
+
+				void Abandon() { _abandoned = true; }
+			};
+			VERUS_TYPEDEFS(ThreadBuffer);
+
+			struct Entry
+			{
+				Record _record;
+				String _text;
+			};
+			VERUS_TYPEDEFS(Entry);
+
 		private:
-			std::mutex  _mutex;
-			std::string _pathname;
+			static const int s_slotSize = 64;
+			static const int s_slotCount = 2048; // Power of two, 128 KB per thread.
+			static const INT64 s_maxFileSize = 1024 * 1024;
+
+			std::vector<std::unique_ptr<ThreadBuffer>> _vBuffers;
+			std::vector<Entry>                         _vEntries; // Used by the writer thread.
+			std::mutex                                 _mutex;
+			std::mutex                                 _mutexBuffers;
+			std::condition_variable                    _cv;
+			std::condition_variable                    _cvFlushed;
+			std::condition_variable                    _cvSpace; // Writer thread has collected messages.
+			std::thread                                _thread;
+			std::string                                _pathname;
+			std::string                                _openPathname;
+			std::unique_ptr<IO::File>                  _pFile; // Used by the writer thread.
+			INT64                                      _fileSize = 0;
+			UINT64                                     _generation = 0;
+			UINT64                                     _flushRequested = 0;
+			UINT64                                     _flushDone = 0;
+			std::atomic<UINT64>                        _droppedCount;
+			std::atomic_int                            _maxSeverity;
+			std::atomic_bool                           _wake;
+			bool                                       _stopThread = false;
+			bool                                       _singleton = false; // Handles crashes.
+
+			// Private instance, which doesn't replace the singleton, used by tests and benchmarks:
+			explicit Log(NoAssign noAssign);
 
 		public:
+			Log();
+			~Log();
+
 			std::mutex& GetMutex() { return _mutex; }
 
 			void Write(CSZ txt, std::thread::id tid, CSZ filename, UINT32 line, Severity severity);
+			// Returns when all messages, which were written before this call, are in the file:
+			void Flush();
+			// Messages, which could not wait for free space:
+			UINT64 GetDroppedCount() const { return _droppedCount.load(); }
+
+			Severity GetMaxSeverity() const { return static_cast<Severity>(_maxSeverity.load()); }
+			void SetMaxSeverity(Severity severity) { _maxSeverity = +severity; }
+
+			// Default is Log.txt in writable path:
+			void SetPathname(CSZ pathname);
+
+			UINT64 GetGeneration() const { return _generation; }
 
 			static void FormatTime(char* buffer, size_t size);
+			static void FormatTime(char* buffer, size_t size, INT64 time);
 			static CSZ GetSeverityLetter(Severity severity);
 			static String ExtractFilename(CSZ filename);
+
+			static bool IsIgnored(CSZ txt);
+
+			// Uses a private instance and LogTest.txt, the singleton keeps writing to its file:
+			static void Test();
+			// Writes a million lines from 8 threads into a private instance, results are written to log:
+			static void Benchmark();
+
+		private:
+			PThreadBuffer GetThreadBuffer();
+			bool WaitForSpace(PThreadBuffer pBuffer, UINT64 writeCount);
+			bool IsWriterThread() const { return std::this_thread::get_id() == _thread.get_id(); }
+			void ThreadProc();
+			void Collect();
+			void WriteEntries();
+			void OpenFile();
 		};
+		VERUS_TYPEDEFS(Log);
 	}
 }
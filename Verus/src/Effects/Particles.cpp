@@ -4,6 +4,14 @@
 using namespace verus;
 using namespace verus::Effects;
 
+namespace
+{
+	inline __m128 LerpPS(__m128 a, __m128 b, __m128 t)
+	{
+		return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+	}
+}
+
 CGI::ShaderPwn                           Particles::s_shader;
 CGI::PipelinePwns<Particles::PIPE_COUNT> Particles::s_pipe;
 Particles::UB_ParticlesVS                Particles::s_ubParticlesVS;
@@ -162,8 +170,6 @@ void Particles::Init(CSZ url)
 	_particlesPerSecond = root.child("particlesPerSecond").text().as_float(_particlesPerSecond);
 	_zone = root.child("zone").text().as_float(_zone);
 
-	_vParticles.resize(_capacity);
-
 	if (BillboardType::none == _billboardType) // Use point sprites?
 	{
 		_vVB.resize(_capacity);
@@ -219,6 +225,19 @@ void Particles::Init(CSZ url)
 		_geo->CreateVertexBuffer(_capacity * 4, 0);
 		_geo->CreateIndexBuffer(_indexCount);
 
+		// Index buffer never changes:
+		VERUS_FOR(i, _capacity)
+		{
+			const int vertexOffset = i << 2;
+			const int indexOffset = i * 6;
+			_vIB[indexOffset + 0] = vertexOffset + 0;
+			_vIB[indexOffset + 1] = vertexOffset + 2;
+			_vIB[indexOffset + 2] = vertexOffset + 1;
+			_vIB[indexOffset + 3] = vertexOffset + 0;
+			_vIB[indexOffset + 4] = vertexOffset + 3;
+			_vIB[indexOffset + 5] = vertexOffset + 2;
+		}
+
 		if (!s_pipe[PIPE_BILLBOARDS])
 		{
 			CGI::PipelineDesc pipeDesc(_geo, s_shader, "#Billboards", renderer.GetDS().GetRenderPassHandle_ForwardRendering());
@@ -228,6 +247,8 @@ void Particles::Init(CSZ url)
 		}
 	}
 
+	ResizePool(_capacity);
+
 	_ratio = static_cast<float>(_tilesetY) / static_cast<float>(_tilesetX);
 }
 
@@ -247,51 +268,14 @@ void Particles::Update()
 
 	VERUS_QREF_TIMER;
 
-	Vector3 wind = Vector3(0);
-	if (World::Atmosphere::IsValidSingleton())
-	{
-		VERUS_QREF_ATMO;
-		wind = atmo.GetWindVelocity();
-	}
-
-	if (BillboardType::none == _billboardType)
-	{
-		VERUS_FOR(i, _capacity)
-		{
-			if (_vParticles[i]._timeLeft >= 0)
-			{
-				_vParticles[i]._timeLeft -= dt;
-				if (_vParticles[i]._timeLeft < 0)
-				{
-					_vParticles[i]._timeLeft = -1;
-					continue;
-				}
-
-				if (_pDelegate)
-				{
-					Vector3 up, normal;
-					Transform3 matrix;
-					_pDelegate->Particles_OnUpdate(*this, i, _vParticles[i], up, normal, matrix);
-				}
-				else
-				{
-					Point3 hitPoint;
-					Vector3 hitNormal;
-					TimeCorrectedVerletIntegration(_vParticles[i], hitPoint, hitNormal);
-
-					const float t = glm::quadraticEaseInOut(1 - _vParticles[i]._timeLeft * _vParticles[i]._invTotalTime);
-					const Vector4 color = VMath::lerp(t, _vParticles[i]._beginColor, _vParticles[i]._endColor);
-					const float size = Math::Lerp(_vParticles[i]._beginSize, _vParticles[i]._endSize, t);
-					const float additive = Math::Lerp(_vParticles[i]._beginAdditive, _vParticles[i]._endAdditive, t);
+	UpdateDesc desc;
+	desc._accel = GetAcceleration();
+	desc._dt = dt;
+	desc._dtSq = timer.GetDeltaTimeSq();
+	desc._dtInv = timer.GetDeltaTimeInv();
+	desc._verletValue = timer.GetVerletValue();
 
-					PushPointSprite(i, color, size, additive);
-				}
-			}
-		}
-		if (_drawCount)
-			_geo->UpdateVertexBuffer(_vVB.data(), 0, nullptr, _drawCount);
-	}
-	else // Billboards:
+	if (BillboardType::none != _billboardType)
 	{
 		VERUS_QREF_WM;
 		World::PCamera pHeadCamera = wm.GetHeadCamera();
@@ -317,48 +301,23 @@ void Particles::Update()
 
 		Matrix3 matAim3;
 		matAim3.TrackToZ(normal, &up);
-		Transform3 matAim(matAim3, Vector3(0));
-
-		VERUS_FOR(i, _capacity)
-		{
-			if (_vParticles[i]._timeLeft >= 0)
-			{
-				_vParticles[i]._timeLeft -= dt;
-				if (_vParticles[i]._timeLeft < 0)
-				{
-					_vParticles[i]._timeLeft = -1;
-					continue;
-				}
-
-				if (_pDelegate)
-				{
-					_pDelegate->Particles_OnUpdate(*this, i, _vParticles[i], up, normal, matAim);
-				}
-				else
-				{
-					if (!_decal)
-					{
-						Point3 hitPoint;
-						Vector3 hitNormal;
-						TimeCorrectedVerletIntegration(_vParticles[i], hitPoint, hitNormal);
-					}
-
-					const float t = glm::quadraticEaseInOut(1 - _vParticles[i]._timeLeft * _vParticles[i]._invTotalTime);
-					const Vector4 color = VMath::lerp(t, _vParticles[i]._beginColor, _vParticles[i]._endColor);
-					const float size = Math::Lerp(_vParticles[i]._beginSize, _vParticles[i]._endSize, t);
-					const float spin = Math::Lerp(_vParticles[i]._beginSpin, _vParticles[i]._endSpin, t);
-					const float additive = Math::Lerp(_vParticles[i]._beginAdditive, _vParticles[i]._endAdditive, t);
-
-					if (BillboardType::axial == _billboardType && _decal)
-						normal = _vParticles[i]._velocity;
+		desc._matAim = Transform3(matAim3, Vector3(0));
+		desc._up = up;
+		desc._normal = normal;
+	}
 
-					const Transform3 matW = GetBillboardMatrix(i, size, spin, up, normal, matAim);
+	if (_pDelegate)
+		UpdateWithDelegate(desc);
+	else
+		UpdatePool(desc);
 
-					PushBillboard(i, color, matW, additive);
-				}
-			}
+	if (_drawCount)
+	{
+		if (BillboardType::none == _billboardType)
+		{
+			_geo->UpdateVertexBuffer(_vVB.data(), 0, nullptr, _drawCount);
 		}
-		if (_drawCount)
+		else
 		{
 			_geo->UpdateVertexBuffer(_vVB.data(), 0, nullptr, _drawCount * 4);
 			_geo->UpdateIndexBuffer(_vIB.data(), nullptr, _drawCount * 6);
@@ -548,7 +507,7 @@ int Particles::Add(RcPoint3 pos, RcVector3 dir, float scale, PcVector4 pUserColo
 	const Vector3 accel = _gravity * _gravityStrength + wind * _windStrength;
 
 	RRandom random = utils.GetRandom();
-	RParticle particle = _vParticles[_addAt];
+	Particle particle;
 	particle._pUser = pUser;
 	const int index = _addAt;
 
@@ -596,6 +555,8 @@ int Particles::Add(RcPoint3 pos, RcVector3 dir, float scale, PcVector4 pUserColo
 	if (_decal)
 		particle._endSpin = particle._beginSpin;
 
+	SetParticle(index, particle);
+
 	_addAt++;
 	_addAt %= _capacity;
 
@@ -621,72 +582,94 @@ void Particles::AddFlow(RcPoint3 pos, RcVector3 dirOffset, float scale, PcVector
 
 bool Particles::TimeCorrectedVerletIntegration(RParticle particle, RPoint3 point, RVector3 normal)
 {
-	VERUS_QREF_TIMER;
-
 	bool hit = false;
 
+	if (VerletStep(particle, GetAcceleration()))
+	{
+		VERUS_QREF_WM;
+		if (wm.RayTestEx(particle._prevPosition, particle._position, nullptr, &point, &normal, nullptr, Physics::Bullet::I().GetMainMask()))
+		{
+			hit = true;
+			Bounce(particle, point, normal);
+		}
+		else
+			particle._inContact = false;
+	}
+
+	UpdateAxis(particle);
+
+	return hit;
+}
+
+bool Particles::EulerIntegration(RParticle particle, RPoint3 point, RVector3 normal)
+{
+	return false;
+}
+
+Vector3 Particles::GetAcceleration() const
+{
 	Vector3 wind = Vector3(0);
 	if (World::Atmosphere::IsValidSingleton())
 	{
 		VERUS_QREF_ATMO;
 		wind = atmo.GetWindVelocity();
 	}
+	return _gravity * _gravityStrength + wind * _windStrength;
+}
+
+bool Particles::VerletStep(RParticle particle, RcVector3 accel)
+{
+	VERUS_QREF_TIMER;
 
-	const Vector3 accel = _gravity * _gravityStrength + wind * _windStrength;
 	const Point3 currentPos = particle._position;
 	particle._position += (currentPos - particle._prevPosition) * timer.GetVerletValue() + accel * timer.GetDeltaTimeSq();
 	particle._prevPosition = currentPos;
 	particle._velocity = (particle._position - currentPos) * timer.GetDeltaTimeInv();
 
-	if (_collide)
+	if (!_collide)
+		return false;
+
+	if (particle._inContact && VMath::lengthSqr(particle._velocity) < 0.15 * 0.15f)
 	{
-		if (particle._inContact && VMath::lengthSqr(particle._velocity) < 0.15 * 0.15f)
-		{
-			particle._velocity = Vector3(0);
-			particle._position = currentPos;
-			particle._prevPosition = currentPos;
-		}
-		else
-		{
-			VERUS_QREF_WM;
-			if (wm.RayTestEx(particle._prevPosition, particle._position, nullptr, &point, &normal, nullptr, Physics::Bullet::I().GetMainMask()))
-			{
-				hit = true;
-				particle._inContact = normal.getY() > 0.7071f;
-				particle._velocity = particle._velocity.Reflect(normal) * _bounceStrength;
-				particle._prevPosition = point;
-				particle._position = point + particle._velocity * timer.GetDeltaTime();
-			}
-			else
-				particle._inContact = false;
-		}
+		particle._velocity = Vector3(0);
+		particle._position = currentPos;
+		particle._prevPosition = currentPos;
+		return false;
 	}
+	return true;
+}
 
-	if (BillboardType::axial == _billboardType && !_decal)
-		particle._axis = VMath::normalizeApprox(particle._velocity);
+void Particles::Bounce(RParticle particle, RcPoint3 point, RcVector3 normal)
+{
+	VERUS_QREF_TIMER;
 
-	return hit;
+	particle._inContact = normal.getY() > 0.7071f;
+	particle._velocity = particle._velocity.Reflect(normal) * _bounceStrength;
+	particle._prevPosition = point;
+	particle._position = point + particle._velocity * timer.GetDeltaTime();
 }
 
-bool Particles::EulerIntegration(RParticle particle, RPoint3 point, RVector3 normal)
+void Particles::UpdateAxis(RParticle particle)
 {
-	return false;
+	if (BillboardType::axial == _billboardType && !_decal)
+		particle._axis = VMath::normalizeApprox(particle._velocity);
 }
 
-void Particles::PushPointSprite(int index, RcVector4 color, float size, float additive)
+void Particles::PushPointSprite(RcParticle particle, RcVector4 color, float size, float additive)
 {
-	_vVB[_drawCount].pos.x = _vParticles[index]._position.getX();
-	_vVB[_drawCount].pos.y = _vParticles[index]._position.getY();
-	_vVB[_drawCount].pos.z = _vParticles[index]._position.getZ();
-	_vVB[_drawCount].pos.w = additive;
-	_vVB[_drawCount].tc0.x = _vParticles[index]._tcOffset.getX();
-	_vVB[_drawCount].tc0.y = _vParticles[index]._tcOffset.getY();
-	_vVB[_drawCount].color = color.ToColor();
-	_vVB[_drawCount].psize = size;
+	RVertex vertex = _vVB[_drawCount];
+	vertex.pos.x = particle._position.getX();
+	vertex.pos.y = particle._position.getY();
+	vertex.pos.z = particle._position.getZ();
+	vertex.pos.w = additive;
+	vertex.tc0.x = particle._tcOffset.getX();
+	vertex.tc0.y = particle._tcOffset.getY();
+	vertex.color = color.ToColor();
+	vertex.psize = size;
 	_drawCount++;
 }
 
-void Particles::PushBillboard(int index, RcVector4 color, RcTransform3 matW, float additive)
+void Particles::PushBillboard(RcParticle particle, RcVector4 color, RcTransform3 matW, float additive)
 {
 	Point3 pos[4] =
 	{
@@ -706,6 +689,7 @@ void Particles::PushBillboard(int index, RcVector4 color, RcTransform3 matW, flo
 	VERUS_FOR(i, 4)
 		pos[i] = matW * pos[i];
 
+	const UINT32 packedColor = color.ToColor();
 	const int vertexOffset = _drawCount << 2;
 	VERUS_FOR(i, 4)
 	{
@@ -714,24 +698,16 @@ void Particles::PushBillboard(int index, RcVector4 color, RcTransform3 matW, flo
 		vertex.pos.y = pos[i].getY();
 		vertex.pos.z = pos[i].getZ();
 		vertex.pos.w = additive;
-		vertex.tc0[0] = tc[i].getX() * _tilesetSize.getZ() + _vParticles[index]._tcOffset.getX();
-		vertex.tc0[1] = tc[i].getY() * _tilesetSize.getW() + _vParticles[index]._tcOffset.getY();
-		vertex.color = color.ToColor();
+		vertex.tc0[0] = tc[i].getX() * _tilesetSize.getZ() + particle._tcOffset.getX();
+		vertex.tc0[1] = tc[i].getY() * _tilesetSize.getW() + particle._tcOffset.getY();
+		vertex.color = packedColor;
 		vertex.psize = 1;
 	}
 
-	const int indexOffset = _drawCount * 6;
-	_vIB[indexOffset + 0] = vertexOffset + 0;
-	_vIB[indexOffset + 1] = vertexOffset + 2;
-	_vIB[indexOffset + 2] = vertexOffset + 1;
-	_vIB[indexOffset + 3] = vertexOffset + 0;
-	_vIB[indexOffset + 4] = vertexOffset + 3;
-	_vIB[indexOffset + 5] = vertexOffset + 2;
-
 	_drawCount++;
 }
 
-Transform3 Particles::GetBillboardMatrix(int index, float size, float spin, RcVector3 up, RcVector3 normal, RTransform3 matAim)
+Transform3 Particles::GetBillboardMatrix(RcParticle particle, float size, float spin, RcVector3 up, RcVector3 normal, RTransform3 matAim)
 {
 	Vector3 up2(up), normal2(normal);
 
@@ -755,7 +731,7 @@ Transform3 Particles::GetBillboardMatrix(int index, float size, float spin, RcVe
 		}
 		else
 		{
-			up2 = _vParticles[index]._axis;
+			up2 = particle._axis;
 			const Vector3 right = VMath::cross(up2, normal2);
 			normal2 = VMath::normalizeApprox(VMath::cross(right, up2));
 			Matrix3 matAim3;
@@ -766,6 +742,456 @@ Transform3 Particles::GetBillboardMatrix(int index, float size, float spin, RcVe
 	break;
 	}
 
-	return Transform3::translation(Vector3(_vParticles[index]._position)) * matAim *
+	return Transform3::translation(Vector3(particle._position)) * matAim *
 		Transform3(VMath::appendScale(Matrix3::rotationZ(spin), Vector3(size * _ratio, size, 0)), Vector3(0));
 }
+
+void Particles::ResizePool(int capacity)
+{
+	const int size = (capacity + 3) & ~3;
+	_pool._vPosX.assign(size, 0);
+	_pool._vPosY.assign(size, 0);
+	_pool._vPosZ.assign(size, 0);
+	_pool._vPrevPosX.assign(size, 0);
+	_pool._vPrevPosY.assign(size, 0);
+	_pool._vPrevPosZ.assign(size, 0);
+	_pool._vVelX.assign(size, 0);
+	_pool._vVelY.assign(size, 0);
+	_pool._vVelZ.assign(size, 0);
+	_pool._vTimeLeft.assign(size, -1);
+	_pool._vInvTotalTime.assign(size, 0);
+	_pool._vBeginAdditive.assign(size, 0);
+	_pool._vEndAdditive.assign(size, 0);
+	_pool._vBeginSize.assign(size, 0);
+	_pool._vEndSize.assign(size, 0);
+	_pool._vBeginSpin.assign(size, 0);
+	_pool._vEndSpin.assign(size, 0);
+	_pool._vBeginColor.assign(size, glm::vec4(1));
+	_pool._vEndColor.assign(size, glm::vec4(1));
+	_pool._vAxis.assign(size, glm::vec3(0, 1, 0));
+	_pool._vTcOffset.assign(size, glm::vec2(0));
+	_pool._vUser.assign(size, nullptr);
+	_pool._vInContact.assign(size, 0);
+	_addAt = 0;
+}
+
+void Particles::GetParticle(int index, RParticle particle) const
+{
+	particle._position = Point3(_pool._vPosX[index], _pool._vPosY[index], _pool._vPosZ[index]);
+	particle._prevPosition = Point3(_pool._vPrevPosX[index], _pool._vPrevPosY[index], _pool._vPrevPosZ[index]);
+	particle._velocity = Vector3(_pool._vVelX[index], _pool._vVelY[index], _pool._vVelZ[index]);
+	particle._tcOffset = Vector4(_pool._vTcOffset[index].x, _pool._vTcOffset[index].y);
+	particle._axis = _pool._vAxis[index];
+	particle._beginColor = _pool._vBeginColor[index];
+	particle._endColor = _pool._vEndColor[index];
+	particle._pUser = _pool._vUser[index];
+	particle._invTotalTime = _pool._vInvTotalTime[index];
+	particle._timeLeft = _pool._vTimeLeft[index];
+	particle._beginAdditive = _pool._vBeginAdditive[index];
+	particle._endAdditive = _pool._vEndAdditive[index];
+	particle._beginSize = _pool._vBeginSize[index];
+	particle._endSize = _pool._vEndSize[index];
+	particle._beginSpin = _pool._vBeginSpin[index];
+	particle._endSpin = _pool._vEndSpin[index];
+	particle._inContact = !!_pool._vInContact[index];
+}
+
+void Particles::SetParticle(int index, RcParticle particle)
+{
+	_pool._vPosX[index] = particle._position.getX();
+	_pool._vPosY[index] = particle._position.getY();
+	_pool._vPosZ[index] = particle._position.getZ();
+	_pool._vPrevPosX[index] = particle._prevPosition.getX();
+	_pool._vPrevPosY[index] = particle._prevPosition.getY();
+	_pool._vPrevPosZ[index] = particle._prevPosition.getZ();
+	_pool._vVelX[index] = particle._velocity.getX();
+	_pool._vVelY[index] = particle._velocity.getY();
+	_pool._vVelZ[index] = particle._velocity.getZ();
+	_pool._vTcOffset[index] = glm::vec2(particle._tcOffset.getX(), particle._tcOffset.getY());
+	_pool._vAxis[index] = particle._axis.GLM();
+	_pool._vBeginColor[index] = particle._beginColor.GLM();
+	_pool._vEndColor[index] = particle._endColor.GLM();
+	_pool._vUser[index] = particle._pUser;
+	_pool._vInvTotalTime[index] = particle._invTotalTime;
+	_pool._vTimeLeft[index] = particle._timeLeft;
+	_pool._vBeginAdditive[index] = particle._beginAdditive;
+	_pool._vEndAdditive[index] = particle._endAdditive;
+	_pool._vBeginSize[index] = particle._beginSize;
+	_pool._vEndSize[index] = particle._endSize;
+	_pool._vBeginSpin[index] = particle._beginSpin;
+	_pool._vEndSpin[index] = particle._endSpin;
+	_pool._vInContact[index] = particle._inContact ? 1 : 0;
+}
+
+void Particles::UpdatePool(RcUpdateDesc desc)
+{
+	const int poolSize = GetPoolSize();
+	if (!poolSize)
+		return;
+
+	const bool integrate = BillboardType::none == _billboardType || !_decal;
+	const int chunkCount = (poolSize + s_chunkSize - 1) / s_chunkSize;
+	_vChunkDrawOffsets.resize(chunkCount);
+	Parallel::For(0, chunkCount, [this, &desc, integrate](int chunk)
+		{
+			_vChunkDrawOffsets[chunk] = IntegrateChunk(chunk, desc, integrate);
+		});
+
+	if (_collide && integrate)
+		CollidePool(desc);
+
+	// Each chunk writes its vertices after the vertices of previous chunks:
+	int drawCount = 0;
+	for (auto& x : _vChunkDrawOffsets)
+	{
+		const int count = x;
+		x = drawCount;
+		drawCount += count;
+	}
+	_drawCount = drawCount;
+
+	Parallel::For(0, chunkCount, [this, &desc](int chunk)
+		{
+			WriteChunk(chunk, _vChunkDrawOffsets[chunk], desc);
+		});
+}
+
+void Particles::UpdateWithDelegate(RcUpdateDesc desc)
+{
+	Particle particle;
+	Vector3 up = desc._up;
+	Vector3 normal = desc._normal;
+	Transform3 matAim = desc._matAim;
+	const int poolSize = GetPoolSize();
+	VERUS_FOR(i, poolSize)
+	{
+		float& timeLeft = _pool._vTimeLeft[i];
+		if (timeLeft < 0)
+			continue;
+		timeLeft -= desc._dt;
+		if (timeLeft < 0)
+		{
+			timeLeft = -1;
+			continue;
+		}
+
+		GetParticle(i, particle);
+		_pDelegate->Particles_OnUpdate(*this, i, particle, up, normal, matAim);
+		SetParticle(i, particle);
+	}
+}
+
+int Particles::IntegrateChunk(int chunk, RcUpdateDesc desc, bool integrate)
+{
+	static const BYTE bitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+	const int from = chunk * s_chunkSize;
+	const int to = Math::Min(from + s_chunkSize, GetPoolSize());
+
+	float* pPos[3] = { _pool._vPosX.data(), _pool._vPosY.data(), _pool._vPosZ.data() };
+	float* pPrevPos[3] = { _pool._vPrevPosX.data(), _pool._vPrevPosY.data(), _pool._vPrevPosZ.data() };
+	float* pVel[3] = { _pool._vVelX.data(), _pool._vVelY.data(), _pool._vVelZ.data() };
+	float* pTimeLeft = _pool._vTimeLeft.data();
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 minusOne = _mm_set1_ps(-1);
+	const __m128 dt = _mm_set1_ps(desc._dt);
+	const __m128 dtInv = _mm_set1_ps(desc._dtInv);
+	const __m128 verletValue = _mm_set1_ps(desc._verletValue);
+	const __m128 accelDtSq[3] =
+	{
+		_mm_set1_ps(desc._accel.getX() * desc._dtSq),
+		_mm_set1_ps(desc._accel.getY() * desc._dtSq),
+		_mm_set1_ps(desc._accel.getZ() * desc._dtSq)
+	};
+
+	int aliveCount = 0;
+	for (int i = from; i < to; i += 4)
+	{
+		__m128 timeLeft = _mm_loadu_ps(pTimeLeft + i);
+		if (!_mm_movemask_ps(_mm_cmpge_ps(timeLeft, zero)))
+			continue;
+
+		timeLeft = _mm_sub_ps(timeLeft, dt);
+		const __m128 alive = _mm_cmpge_ps(timeLeft, zero);
+		timeLeft = _mm_or_ps(_mm_and_ps(alive, timeLeft), _mm_andnot_ps(alive, minusOne));
+		_mm_storeu_ps(pTimeLeft + i, timeLeft);
+
+		const int mask = _mm_movemask_ps(alive);
+		aliveCount += bitCount[mask];
+		if (!integrate || !mask)
+			continue;
+
+		// Time-corrected Verlet, dead particles keep their state:
+		VERUS_FOR(axis, 3)
+		{
+			const __m128 pos = _mm_loadu_ps(pPos[axis] + i);
+			const __m128 prevPos = _mm_loadu_ps(pPrevPos[axis] + i);
+			const __m128 vel = _mm_loadu_ps(pVel[axis] + i);
+			const __m128 newPos = _mm_add_ps(pos, _mm_add_ps(_mm_mul_ps(_mm_sub_ps(pos, prevPos), verletValue), accelDtSq[axis]));
+			const __m128 newVel = _mm_mul_ps(_mm_sub_ps(newPos, pos), dtInv);
+			_mm_storeu_ps(pPos[axis] + i, _mm_or_ps(_mm_and_ps(alive, newPos), _mm_andnot_ps(alive, pos)));
+			_mm_storeu_ps(pPrevPos[axis] + i, _mm_or_ps(_mm_and_ps(alive, pos), _mm_andnot_ps(alive, prevPos)));
+			_mm_storeu_ps(pVel[axis] + i, _mm_or_ps(_mm_and_ps(alive, newVel), _mm_andnot_ps(alive, vel)));
+		}
+	}
+	return aliveCount;
+}
+
+void Particles::CollidePool(RcUpdateDesc desc)
+{
+	VERUS_QREF_WM;
+
+	const Physics::Group mask = Physics::Bullet::I().GetMainMask();
+
+	_vRayQueries.clear();
+	_vRayParticles.clear();
+	const int poolSize = GetPoolSize();
+	VERUS_FOR(i, poolSize)
+	{
+		if (_pool._vTimeLeft[i] < 0)
+			continue;
+
+		const Vector3 velocity(_pool._vVelX[i], _pool._vVelY[i], _pool._vVelZ[i]);
+		if (_pool._vInContact[i] && VMath::lengthSqr(velocity) < 0.15f * 0.15f) // Resting?
+		{
+			_pool._vVelX[i] = _pool._vVelY[i] = _pool._vVelZ[i] = 0;
+			_pool._vPosX[i] = _pool._vPrevPosX[i];
+			_pool._vPosY[i] = _pool._vPrevPosY[i];
+			_pool._vPosZ[i] = _pool._vPrevPosZ[i];
+			continue;
+		}
+
+		Physics::RayQuery query;
+		query._pointA = Point3(_pool._vPrevPosX[i], _pool._vPrevPosY[i], _pool._vPrevPosZ[i]);
+		query._pointB = Point3(_pool._vPosX[i], _pool._vPosY[i], _pool._vPosZ[i]);
+		query._mask = mask;
+		_vRayQueries.push_back(query);
+		_vRayParticles.push_back(i);
+	}
+
+	const int count = Utils::Cast32(_vRayQueries.size());
+	_vRayHits.resize(count);
+	wm.RayTestBatch(_vRayQueries.data(), _vRayHits.data(), count);
+	VERUS_FOR(i, count)
+	{
+		const int index = _vRayParticles[i];
+		Physics::RcRayHit hit = _vRayHits[i];
+		if (!hit._hit)
+		{
+			_pool._vInContact[index] = 0;
+			continue;
+		}
+
+		const Vector3 velocity = Vector3(_pool._vVelX[index], _pool._vVelY[index], _pool._vVelZ[index]).Reflect(hit._normal) * _bounceStrength;
+		const Point3 pos = hit._point + velocity * desc._dt;
+		_pool._vInContact[index] = (hit._normal.getY() > 0.7071f) ? 1 : 0;
+		_pool._vVelX[index] = velocity.getX();
+		_pool._vVelY[index] = velocity.getY();
+		_pool._vVelZ[index] = velocity.getZ();
+		_pool._vPrevPosX[index] = hit._point.getX();
+		_pool._vPrevPosY[index] = hit._point.getY();
+		_pool._vPrevPosZ[index] = hit._point.getZ();
+		_pool._vPosX[index] = pos.getX();
+		_pool._vPosY[index] = pos.getY();
+		_pool._vPosZ[index] = pos.getZ();
+	}
+}
+
+void Particles::WriteChunk(int chunk, int drawOffset, RcUpdateDesc desc)
+{
+	const int from = chunk * s_chunkSize;
+	const int to = Math::Min(from + s_chunkSize, GetPoolSize());
+	const bool billboards = BillboardType::none != _billboardType;
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 one = _mm_set1_ps(1);
+	const __m128 two = _mm_set1_ps(2);
+	const __m128 four = _mm_set1_ps(4);
+
+	alignas(16) float size[4];
+	alignas(16) float spin[4];
+	alignas(16) float additive[4];
+	alignas(16) float lerpT[4];
+	alignas(16) float rgba[4];
+
+	int drawIndex = drawOffset;
+	for (int i = from; i < to; i += 4)
+	{
+		const __m128 timeLeft = _mm_loadu_ps(&_pool._vTimeLeft[i]);
+		const int mask = _mm_movemask_ps(_mm_cmpge_ps(timeLeft, zero));
+		if (!mask)
+			continue;
+
+		// Quadratic ease in-out:
+		const __m128 p = _mm_min_ps(_mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(timeLeft, _mm_loadu_ps(&_pool._vInvTotalTime[i]))), zero), one);
+		const __m128 easeIn = _mm_mul_ps(two, _mm_mul_ps(p, p));
+		const __m128 easeOut = _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(four, p), easeIn), one);
+		const __m128 firstHalf = _mm_cmplt_ps(p, half);
+		const __m128 t = _mm_or_ps(_mm_and_ps(firstHalf, easeIn), _mm_andnot_ps(firstHalf, easeOut));
+
+		_mm_store_ps(size, LerpPS(_mm_loadu_ps(&_pool._vBeginSize[i]), _mm_loadu_ps(&_pool._vEndSize[i]), t));
+		_mm_store_ps(additive, LerpPS(_mm_loadu_ps(&_pool._vBeginAdditive[i]), _mm_loadu_ps(&_pool._vEndAdditive[i]), t));
+		if (billboards)
+			_mm_store_ps(spin, LerpPS(_mm_loadu_ps(&_pool._vBeginSpin[i]), _mm_loadu_ps(&_pool._vEndSpin[i]), t));
+		_mm_store_ps(lerpT, t);
+
+		VERUS_FOR(lane, 4)
+		{
+			if (!(mask & (1 << lane)))
+				continue;
+			const int index = i + lane;
+			// Linear, like VMath::lerp(), color is clamped only when it's packed:
+			_mm_store_ps(rgba, LerpPS(_mm_loadu_ps(&_pool._vBeginColor[index].x), _mm_loadu_ps(&_pool._vEndColor[index].x), _mm_set1_ps(lerpT[lane])));
+			const UINT32 color = Convert::ColorFloatToInt32(rgba);
+			if (billboards)
+			{
+				WriteBillboard(index, drawIndex, color, size[lane], spin[lane], additive[lane], desc);
+			}
+			else
+			{
+				RVertex vertex = _vVB[drawIndex];
+				vertex.pos = glm::vec4(_pool._vPosX[index], _pool._vPosY[index], _pool._vPosZ[index], additive[lane]);
+				vertex.tc0 = _pool._vTcOffset[index];
+				vertex.color = color;
+				vertex.psize = size[lane];
+			}
+			drawIndex++;
+		}
+	}
+}
+
+void Particles::WriteBillboard(int index, int drawIndex, UINT32 color, float size, float spin, float additive, RcUpdateDesc desc)
+{
+	static const float corners[4][4] =
+	{
+		{ +1, +1, 1, 0 },
+		{ -1, +1, 0, 0 },
+		{ -1, -1, 0, 1 },
+		{ +1, -1, 1, 1 }
+	};
+
+	Vector3 right = desc._matAim.getCol0();
+	Vector3 up = desc._matAim.getCol1();
+	if (BillboardType::axial == _billboardType)
+	{
+		const Vector3 velocity(_pool._vVelX[index], _pool._vVelY[index], _pool._vVelZ[index]);
+		Matrix3 matAim3;
+		if (_decal)
+		{
+			matAim3.TrackToZ(-velocity, &desc._up);
+		}
+		else
+		{
+			const Vector3 up2 = VMath::normalizeApprox(velocity);
+			const Vector3 right2 = VMath::cross(up2, desc._normal);
+			const Vector3 normal2 = VMath::normalizeApprox(VMath::cross(right2, up2));
+			matAim3.TrackToZ(normal2, &up2);
+		}
+		right = matAim3.getCol0();
+		up = matAim3.getCol1();
+	}
+
+	// Same as GetBillboardMatrix(), but only two axes are needed:
+	const float c = cos(spin);
+	const float s = sin(spin);
+	const float halfW = 0.5f * size * _ratio;
+	const float halfH = 0.5f * size;
+	const Vector3 axisX = right * (c * halfW) + up * (s * halfW);
+	const Vector3 axisY = up * (c * halfH) - right * (s * halfH);
+	const Point3 pos(_pool._vPosX[index], _pool._vPosY[index], _pool._vPosZ[index]);
+	const glm::vec2 tcOffset = _pool._vTcOffset[index];
+
+	const int vertexOffset = drawIndex << 2;
+	VERUS_FOR(i, 4)
+	{
+		const Point3 corner = pos + axisX * corners[i][0] + axisY * corners[i][1];
+		RVertex vertex = _vVB[vertexOffset + i];
+		vertex.pos = glm::vec4(corner.getX(), corner.getY(), corner.getZ(), additive);
+		vertex.tc0.x = corners[i][2] * _tilesetSize.getZ() + tcOffset.x;
+		vertex.tc0.y = corners[i][3] * _tilesetSize.getW() + tcOffset.y;
+		vertex.color = color;
+		vertex.psize = 1;
+	}
+}
+
+void Particles::Benchmark()
+{
+	const int count = 100000;
+	const int frameCount = 10;
+
+	Particles particles;
+	particles._capacity = count;
+	particles._vVB.resize(count);
+	particles.ResizePool(count);
+
+	UpdateDesc desc;
+	desc._accel = Vector3(0, -9.8f, 0);
+	desc._dt = 1 / 60.f;
+	desc._dtSq = desc._dt * desc._dt;
+	desc._dtInv = 60;
+	desc._verletValue = 1;
+
+	// Both approaches start with the same particles, which live long enough:
+	Random random(7);
+	Vector<Particle> vParticles(count);
+	VERUS_FOR(i, count)
+	{
+		RParticle particle = vParticles[i];
+		particle._position = Point3(random.NextFloat() * 100, random.NextFloat() * 100, random.NextFloat() * 100);
+		particle._velocity = Vector3(random.NextFloat(), random.NextFloat() * 10, random.NextFloat());
+		particle._prevPosition = particle._position - particle._velocity * desc._dt;
+		particle._beginColor = Vector4(random.NextFloat(), random.NextFloat(), random.NextFloat(), 1);
+		particle._endColor = Vector4(random.NextFloat(), random.NextFloat(), random.NextFloat(), 0);
+		particle._timeLeft = 1000 + random.NextFloat();
+		particle._invTotalTime = 1 / 1100.f;
+		particle._beginSize = 0.1f;
+		particle._endSize = 1;
+		particle._endAdditive = 1;
+		particles.SetParticle(i, particle);
+	}
+
+	// Former approach, one particle at a time:
+	const double recordsMs = Utils::MeasureBestTime([&]()
+		{
+			VERUS_FOR(frame, frameCount)
+			{
+				particles._drawCount = 0;
+				for (auto& particle : vParticles)
+				{
+					if (particle._timeLeft < 0)
+						continue;
+					particle._timeLeft -= desc._dt;
+					if (particle._timeLeft < 0)
+					{
+						particle._timeLeft = -1;
+						continue;
+					}
+
+					const Point3 currentPos = particle._position;
+					particle._position += (currentPos - particle._prevPosition) * desc._verletValue + desc._accel * desc._dtSq;
+					particle._prevPosition = currentPos;
+					particle._velocity = (particle._position - currentPos) * desc._dtInv;
+
+					const float t = glm::quadraticEaseInOut(1 - particle._timeLeft * particle._invTotalTime);
+					const Vector4 color = VMath::lerp(t, particle._beginColor, particle._endColor);
+					const float size = Math::Lerp(particle._beginSize, particle._endSize, t);
+					const float additive = Math::Lerp(particle._beginAdditive, particle._endAdditive, t);
+
+					particles.PushPointSprite(particle, color, size, additive);
+				}
+			}
+		});
+	const int recordsDrawCount = particles._drawCount;
+
+	const double poolMs = Utils::MeasureBestTime([&]()
+		{
+			VERUS_FOR(frame, frameCount)
+				particles.UpdatePool(desc);
+		});
+	VERUS_RT_ASSERT(particles._drawCount == recordsDrawCount);
+
+	VERUS_LOG_INFO("Benchmark(); " << count << " particles, " << frameCount << " frames, records: " << recordsMs << " ms, pool: " << poolMs
+		<< " ms, speedup: " << recordsMs / poolMs);
+}
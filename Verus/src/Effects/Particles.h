@@ -67,6 +67,51 @@ namespace verus
 			};
 			VERUS_TYPEDEFS(Vertex);
 
+			// Particle pool is a structure of arrays, so that four particles can be processed at once.
+			// Its size is capacity rounded up to a multiple of four, extra particles are always dead:
+			struct Pool
+			{
+				Vector<float>     _vPosX;
+				Vector<float>     _vPosY;
+				Vector<float>     _vPosZ;
+				Vector<float>     _vPrevPosX;
+				Vector<float>     _vPrevPosY;
+				Vector<float>     _vPrevPosZ;
+				Vector<float>     _vVelX;
+				Vector<float>     _vVelY;
+				Vector<float>     _vVelZ;
+				Vector<float>     _vTimeLeft; // Negative for dead particles.
+				Vector<float>     _vInvTotalTime;
+				Vector<float>     _vBeginAdditive;
+				Vector<float>     _vEndAdditive;
+				Vector<float>     _vBeginSize;
+				Vector<float>     _vEndSize;
+				Vector<float>     _vBeginSpin;
+				Vector<float>     _vEndSpin;
+				Vector<glm::vec4> _vBeginColor; // Float, so that HDR colors are not clamped before blending.
+				Vector<glm::vec4> _vEndColor;
+				Vector<glm::vec3> _vAxis; // Set by delegate, see UpdateAxis().
+				Vector<glm::vec2> _vTcOffset;
+				Vector<void*>     _vUser;
+				Vector<BYTE>      _vInContact;
+			};
+			VERUS_TYPEDEFS(Pool);
+
+			struct UpdateDesc
+			{
+				Transform3 _matAim = Transform3::identity();
+				Vector3    _accel = Vector3(0);
+				Vector3    _up = Vector3(0, 1, 0);
+				Vector3    _normal = Vector3(0, 0, 1);
+				float      _dt = 0;
+				float      _dtSq = 0;
+				float      _dtInv = 0;
+				float      _verletValue = 1;
+			};
+			VERUS_TYPEDEFS(UpdateDesc);
+
+			static const int s_chunkSize = 1024; // Particles per job, multiple of four.
+
 			static CGI::ShaderPwn                s_shader;
 			static CGI::PipelinePwns<PIPE_COUNT> s_pipe;
 			static UB_ParticlesVS                s_ubParticlesVS;
@@ -87,9 +132,13 @@ namespace verus
 			Vector3            _endSpinRange = Vector3(0, 1, 1);
 			Vector3            _gravity = Vector3(0, -9.8f, 0);
 			String             _url;
-			Vector<Particle>   _vParticles;
+			Pool               _pool;
 			Vector<Vertex>     _vVB;
 			Vector<UINT16>     _vIB;
+			Vector<Physics::RayQuery> _vRayQueries;
+			Vector<Physics::RayHit> _vRayHits;
+			Vector<int>        _vRayParticles;
+			Vector<int>        _vChunkDrawOffsets;
 			CGI::GeometryPwn   _geo;
 			CGI::TexturePwn    _tex;
 			CGI::CSHandle      _csh;
@@ -179,9 +228,35 @@ namespace verus
 			bool TimeCorrectedVerletIntegration(RParticle particle, RPoint3 point, RVector3 normal);
 			bool EulerIntegration(RParticle particle, RPoint3 point, RVector3 normal);
 
-			void PushPointSprite(int index, RcVector4 color, float size, float additive);
-			void PushBillboard(int index, RcVector4 color, RcTransform3 matW, float additive);
-			Transform3 GetBillboardMatrix(int index, float size, float spin, RcVector3 up, RcVector3 normal, RTransform3 matAim);
+			// For delegates, which draw particles themselves:
+			void PushPointSprite(RcParticle particle, RcVector4 color, float size, float additive);
+			void PushBillboard(RcParticle particle, RcVector4 color, RcTransform3 matW, float additive);
+			Transform3 GetBillboardMatrix(RcParticle particle, float size, float spin, RcVector3 up, RcVector3 normal, RTransform3 matAim);
+
+			// Updates many point sprites without GPU, compares the pool with one particle at a time approach, results are written to log:
+			static void Benchmark();
+
+		private:
+			Vector3 GetAcceleration() const;
+			// Returns true if collision must be tested:
+			bool VerletStep(RParticle particle, RcVector3 accel);
+			void Bounce(RParticle particle, RcPoint3 point, RcVector3 normal);
+			void UpdateAxis(RParticle particle);
+
+			// <Pool>
+			void ResizePool(int capacity);
+			int GetPoolSize() const { return Utils::Cast32(_pool._vTimeLeft.size()); }
+			void GetParticle(int index, RParticle particle) const;
+			void SetParticle(int index, RcParticle particle);
+			void UpdatePool(RcUpdateDesc desc);
+			void UpdateWithDelegate(RcUpdateDesc desc);
+			// Returns the number of particles, which are still alive:
+			int IntegrateChunk(int chunk, RcUpdateDesc desc, bool integrate);
+			// Rays of all moving particles are tested in one batch:
+			void CollidePool(RcUpdateDesc desc);
+			void WriteChunk(int chunk, int drawOffset, RcUpdateDesc desc);
+			void WriteBillboard(int index, int drawIndex, UINT32 color, float size, float spin, float additive, RcUpdateDesc desc);
+			// </Pool>
 		};
 		VERUS_TYPEDEFS(Particles);
 	}
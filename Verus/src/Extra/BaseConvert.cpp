@@ -191,52 +191,57 @@ void BaseConvert::Mesh::Optimize()
 	}
 
 	// Weld vertices, remove duplicates:
-	int similarVertCount = 0;
-	int degenerateFaceCount = 0;
-	Vector<UberVertex> vVbOpt; // This will not contain equal vertices.
-	Vector<Face> vIbOpt; // This can get smaller than current IB, if there are zero-area triangles.
-	vVbOpt.reserve(_vertCount);
-	vIbOpt.reserve(_faceCount);
-	VERUS_FOR(face, _faceCount) // For each triangle:
-	{
-		_pBaseConvert->OnProgress(float(face) / _faceCount * 100);
-		Face newFace;
-		int pushedCount = 0;
-		VERUS_FOR(i, 3) // For each vertex in triangle:
+	Vector<glm::vec3> vPositions(_vertCount);
+	VERUS_FOR(i, _vertCount)
+		vPositions[i] = _vUberVerts[i]._pos;
+	Vector<UINT32> vRemap;
+	const int uniqueVertCount = MeshOptimizer::Weld(vPositions, 0.001f, vRemap, [this](int a, int b)
 		{
-			RcUberVertex test = _vUberVerts[_vFaces[face]._indices[i]]; // Fetch vertex.
-			const auto similar = std::find(vVbOpt.begin(), vVbOpt.end(), test);
-			const int index = (similar == vVbOpt.end()) ? -1 : Utils::Cast32(std::distance(vVbOpt.begin(), similar));
-			if (index < 0) // No similar vertex found.
-			{
-				newFace._indices[i] = Utils::Cast32(vVbOpt.size());
-				vVbOpt.push_back(test);
-				pushedCount++;
-			}
-			else
-			{
-				newFace._indices[i] = index;
-				similarVertCount++;
-			}
-		}
-		if (newFace._indices[0] != newFace._indices[1] &&
-			newFace._indices[1] != newFace._indices[2] &&
-			newFace._indices[2] != newFace._indices[0])
+			return _vUberVerts[a] == _vUberVerts[b];
+		});
+	_pBaseConvert->OnProgress(25);
+
+	// Remove triangles with zero area:
+	int degenerateFaceCount = 0;
+	Vector<UINT32> vIndices;
+	vIndices.reserve(_faceCount * 3);
+	VERUS_FOR(face, _faceCount)
+	{
+		const UINT32 i0 = vRemap[_vFaces[face]._indices[0]];
+		const UINT32 i1 = vRemap[_vFaces[face]._indices[1]];
+		const UINT32 i2 = vRemap[_vFaces[face]._indices[2]];
+		if (i0 != i1 && i1 != i2 && i2 != i0)
 		{
-			vIbOpt.push_back(newFace); // Add triangle, if it's area is more than zero.
+			vIndices.push_back(i0);
+			vIndices.push_back(i1);
+			vIndices.push_back(i2);
 		}
 		else
 		{
 			degenerateFaceCount++;
-			vVbOpt.resize(vVbOpt.size() - pushedCount); // Rollback.
 		}
 	}
-	_vUberVerts.assign(vVbOpt.begin(), vVbOpt.end());
-	_vFaces.assign(vIbOpt.begin(), vIbOpt.end());
+
+	// Unique vertices keep their order, also remove unused vertices:
+	{
+		Vector<UberVertex> vVbOpt;
+		vVbOpt.reserve(uniqueVertCount);
+		VERUS_FOR(i, _vertCount)
+		{
+			if (vRemap[i] == vVbOpt.size())
+				vVbOpt.push_back(_vUberVerts[i]);
+		}
+		MeshOptimizer::OptimizeVertexFetch(vIndices, uniqueVertCount, vRemap);
+		_vUberVerts.resize(vRemap.size());
+		VERUS_FOR(i, vRemap.size())
+			_vUberVerts[i] = vVbOpt[vRemap[i]];
+	}
+	const int similarVertCount = _vertCount - uniqueVertCount;
+	const int unusedVertCount = uniqueVertCount - Utils::Cast32(_vUberVerts.size());
 	_vertCount = Utils::Cast32(_vUberVerts.size());
-	_faceCount = Utils::Cast32(_vFaces.size());
+	_faceCount = Utils::Cast32(vIndices.size() / 3);
 	StringStream ssWeldReport;
-	ssWeldReport << "Weld report: " << similarVertCount << " similar vertices removed, " << degenerateFaceCount << " degenerate faces removed";
+	ssWeldReport << "Weld report: " << similarVertCount << " similar vertices removed, " << degenerateFaceCount << " degenerate faces removed, " << unusedVertCount << " unused vertices removed";
 	_pBaseConvert->OnProgressText(_C(ssWeldReport.str()));
 
 	{
@@ -244,13 +249,49 @@ void BaseConvert::Mesh::Optimize()
 		ss << _name << ": (" << _vertCount << " vertices, " << _faceCount << " faces)";
 		_pBaseConvert->OnProgressText(_C(ss.str()));
 	}
+	_pBaseConvert->OnProgress(50);
+
+	auto AssignFaces = [this, &vIndices]()
+	{
+		_vFaces.resize(_faceCount);
+		VERUS_FOR(i, _faceCount)
+		{
+			VERUS_FOR(j, 3)
+				_vFaces[i]._indices[j] = vIndices[i * 3 + j];
+		}
+	};
 
-	// Optimize (using AMD Tootle):
-	StringStream ss2;
-	ss2 << _name << ": Optimize (Tootle)";
-	_pBaseConvert->OnProgressText(_C(ss2.str()));
+	// Delegate can use external optimizer:
 	if (_pBaseConvert->_pDelegate)
-		_pBaseConvert->_pDelegate->BaseConvert_Optimize(_vUberVerts, _vFaces);
+	{
+		AssignFaces();
+		if (_pBaseConvert->_pDelegate->BaseConvert_Optimize(_vUberVerts, _vFaces))
+			return;
+	}
+
+	// Optimize for vertex cache, overdraw and vertex fetch:
+	const float acmrBefore = MeshOptimizer::ComputeACMR(vIndices, _vertCount);
+	Vector<UINT32> vClusters;
+	MeshOptimizer::OptimizeVertexCache(vIndices, _vertCount, &vClusters);
+	vPositions.resize(_vertCount);
+	VERUS_FOR(i, _vertCount)
+		vPositions[i] = _vUberVerts[i]._pos;
+	MeshOptimizer::OptimizeOverdraw(vIndices, vPositions, vClusters);
+	_pBaseConvert->OnProgress(75);
+	MeshOptimizer::OptimizeVertexFetch(vIndices, _vertCount, vRemap);
+	{
+		Vector<UberVertex> vVbOpt;
+		vVbOpt.reserve(_vertCount);
+		for (UINT32 index : vRemap)
+			vVbOpt.push_back(_vUberVerts[index]);
+		_vUberVerts.swap(vVbOpt);
+	}
+	AssignFaces();
+	const float acmrAfter = MeshOptimizer::ComputeACMR(vIndices, _vertCount);
+
+	StringStream ss;
+	ss << _name << ": ACMR " << acmrBefore << " -> " << acmrAfter << " (" << vClusters.size() << " clusters)";
+	_pBaseConvert->OnProgressText(_C(ss.str()));
 }
 
 void BaseConvert::Mesh::RecalculateTangentSpace()
@@ -270,7 +311,7 @@ void BaseConvert::Mesh::RecalculateTangentSpace()
 		vTc0[i] = _vUberVerts[i]._tc0;
 	}
 
-	Vector<UINT16> vIndices;
+	Vector<UINT32> vIndices;
 	vIndices.resize(_faceCount * 3);
 	VERUS_FOR(i, _faceCount)
 	{
@@ -394,61 +435,105 @@ void BaseConvert::Mesh::SerializeX3D3(IO::RFile file)
 	RecalculateTangentSpace();
 	Compress();
 
+	// Vertex bindings are stored exactly like they are in memory, see World::BaseMesh::LoadX3D3():
+	const bool robotic = _boneCount > 0 && _pBaseConvert->UseRigidBones();
+	World::BaseMesh::X3DMeshHeader header = {};
+	header._vertCount = _vertCount;
+	header._indexCount = _faceCount * 3;
+	header._flags = World::BaseMesh::X3DFlags::none;
+	if (robotic)
+		header._flags |= World::BaseMesh::X3DFlags::robotic;
+	if (_vertCount > USHRT_MAX + 1)
+		header._flags |= World::BaseMesh::X3DFlags::indices32;
+	memcpy(&header._posDeq[0], &_posScale, 12);
+	memcpy(&header._posDeq[3], &_posBias, 12);
+	memcpy(&header._tc0Deq[0], &_tc0Scale, 8);
+	memcpy(&header._tc0Deq[2], &_tc0Bias, 8);
+	if (_found & Found::texCoord1)
+	{
+		memcpy(&header._tc1Deq[0], &_tc1Scale, 8);
+		memcpy(&header._tc1Deq[2], &_tc1Bias, 8);
+	}
+
+	Vector<UINT32> vIndices;
+	vIndices.reserve(_faceCount * 3);
+	for (const auto& face : _vFaces)
+		vIndices.insert(vIndices.end(), face._indices, face._indices + 3);
+
+	Vector<World::BaseMesh::VertexInputBinding0> vBinding0(_vertCount);
+	Vector<World::BaseMesh::VertexInputBinding2> vBinding2(_vertCount);
+	Vector<glm::vec3> vPositions(_vertCount);
+	VERUS_FOR(i, _vertCount)
+	{
+		vBinding0[i]._pos[0] = _vZipPos[i]._x;
+		vBinding0[i]._pos[1] = _vZipPos[i]._y;
+		vBinding0[i]._pos[2] = _vZipPos[i]._z;
+		vBinding0[i]._pos[3] = robotic ? static_cast<short>(_vUberVerts[i].GetDominantIndex()) : 0;
+		vBinding0[i]._tc0[0] = _vZipTc0[i]._u;
+		vBinding0[i]._tc0[1] = _vZipTc0[i]._v;
+		vBinding0[i]._nrm[0] = _vZipNormal[i]._x;
+		vBinding0[i]._nrm[1] = _vZipNormal[i]._y;
+		vBinding0[i]._nrm[2] = _vZipNormal[i]._z;
+		Convert::Sint8ToSint16(&_vZipTan[i]._x, vBinding2[i]._tan, 3); // Single byte is not supported in OpenGL.
+		Convert::Sint8ToSint16(&_vZipBin[i]._x, vBinding2[i]._bin, 3);
+		vPositions[i] = _vUberVerts[i]._pos;
+	}
+
+	Vector<World::BaseMesh::Meshlet> vMeshlets;
+	MeshOptimizer::BuildMeshlets(vIndices, vPositions, vMeshlets);
+
 	file.WriteText("<X3D>");
 
 	file.WriteText(VERUS_CRNL VERUS_CRNL "<VN>");
-	file.WriteString("3.1");
+	file.WriteString("3.2");
 
-	file.WriteText(VERUS_CRNL VERUS_CRNL "<IX>");
+	file.WriteText(VERUS_CRNL VERUS_CRNL "<MH>");
 	file.BeginBlock();
-	file.WriteString(_C(std::to_string(_faceCount)));
-	VERUS_FOR(i, _faceCount)
-		file.Write(&_vFaces[i], 6);
+	file.Write(&header, sizeof(header));
 	file.EndBlock();
 
-	file.WriteText(VERUS_CRNL VERUS_CRNL "<VX>");
+	file.WriteText(VERUS_CRNL VERUS_CRNL "<IB>");
 	file.BeginBlock();
-	file.WriteString(_C(std::to_string(_vertCount)));
-	file.Write(&_posScale, 12);
-	file.Write(&_posBias, 12);
-	VERUS_FOR(i, _vertCount)
-		file.Write(&_vZipPos[i], 6);
+	if (header._flags & World::BaseMesh::X3DFlags::indices32)
+	{
+		file.Write(vIndices.data(), vIndices.size() * sizeof(UINT32));
+	}
+	else
+	{
+		const Vector<UINT16> vIndices16(vIndices.begin(), vIndices.end());
+		file.Write(vIndices16.data(), vIndices16.size() * sizeof(UINT16));
+	}
 	file.EndBlock();
 
-	file.WriteText(VERUS_CRNL VERUS_CRNL "<NL>");
+	file.WriteText(VERUS_CRNL VERUS_CRNL "<B0>");
 	file.BeginBlock();
-	VERUS_FOR(i, _vertCount)
-		file.Write(&_vZipNormal[i], 3);
+	file.Write(vBinding0.data(), vBinding0.size() * sizeof(World::BaseMesh::VertexInputBinding0));
 	file.EndBlock();
 
-	file.WriteText(VERUS_CRNL VERUS_CRNL "<TS>");
+	file.WriteText(VERUS_CRNL VERUS_CRNL "<B2>");
 	file.BeginBlock();
-	VERUS_FOR(i, _vertCount)
-	{
-		file.Write(&_vZipTan[i], 3);
-		file.Write(&_vZipBin[i], 3);
-	}
-	file.EndBlock();
-
-	file.WriteText(VERUS_CRNL VERUS_CRNL "<T0>");
-	file.BeginBlock();
-	file.Write(&_tc0Scale, 8);
-	file.Write(&_tc0Bias, 8);
-	VERUS_FOR(i, _vertCount)
-		file.Write(&_vZipTc0[i], 4);
+	file.Write(vBinding2.data(), vBinding2.size() * sizeof(World::BaseMesh::VertexInputBinding2));
 	file.EndBlock();
 
 	if (_found & Found::texCoord1)
 	{
-		file.WriteText(VERUS_CRNL VERUS_CRNL "<T1>");
-		file.BeginBlock();
-		file.Write(&_tc1Scale, 8);
-		file.Write(&_tc1Bias, 8);
+		Vector<World::BaseMesh::VertexInputBinding3> vBinding3(_vertCount);
 		VERUS_FOR(i, _vertCount)
-			file.Write(&_vZipTc1[i], 4);
+		{
+			vBinding3[i]._tc1[0] = _vZipTc1[i]._u;
+			vBinding3[i]._tc1[1] = _vZipTc1[i]._v;
+		}
+		file.WriteText(VERUS_CRNL VERUS_CRNL "<B3>");
+		file.BeginBlock();
+		file.Write(vBinding3.data(), vBinding3.size() * sizeof(World::BaseMesh::VertexInputBinding3));
 		file.EndBlock();
 	}
 
+	file.WriteText(VERUS_CRNL VERUS_CRNL "<ML>");
+	file.BeginBlock();
+	file.Write(vMeshlets.data(), vMeshlets.size() * sizeof(World::BaseMesh::Meshlet));
+	file.EndBlock();
+
 	if (_boneCount > 0)
 	{
 		// Must be the same order as in X file! Do not sort.
@@ -473,24 +558,22 @@ void BaseConvert::Mesh::SerializeX3D3(IO::RFile file)
 		if (fileDebug.Open(_C(pathname), "wb"))
 			fileDebug.Write(_C(ssDebug.str()), ssDebug.str().length());
 
-		if (!_pBaseConvert->UseRigidBones())
+		if (!robotic)
 		{
-			file.WriteText(VERUS_CRNL VERUS_CRNL "<SS>");
-			file.BeginBlock();
+			Vector<World::BaseMesh::VertexInputBinding1> vBinding1(_vertCount);
 			UINT32 ii, ww;
 			VERUS_FOR(i, _vertCount)
 			{
 				_vUberVerts[i].CompileBits(ii, ww);
-				file << ii << ww;
+				VERUS_FOR(j, 4)
+				{
+					vBinding1[i]._bi[j] = (ii >> (j << 3)) & 0xFF;
+					vBinding1[i]._bw[j] = (ww >> (j << 3)) & 0xFF;
+				}
 			}
-			file.EndBlock();
-		}
-		else
-		{
-			file.WriteText(VERUS_CRNL VERUS_CRNL "<SR>");
+			file.WriteText(VERUS_CRNL VERUS_CRNL "<B1>");
 			file.BeginBlock();
-			VERUS_FOR(i, _vertCount)
-				file << BYTE(_vUberVerts[i].GetDominantIndex());
+			file.Write(vBinding1.data(), vBinding1.size() * sizeof(World::BaseMesh::VertexInputBinding1));
 			file.EndBlock();
 		}
 	}
@@ -46,7 +46,7 @@ namespace verus
 
 				struct Face
 				{
-					UINT16 _indices[3];
+					UINT32 _indices[3];
 				};
 				VERUS_TYPEDEFS(Face);
 
@@ -234,9 +234,10 @@ namespace verus
 		{
 			virtual void BaseConvert_OnProgress(float percent) = 0;
 			virtual void BaseConvert_OnProgressText(CSZ txt) = 0;
-			virtual void BaseConvert_Optimize(
+			// Return true if the mesh was optimized, otherwise built-in MeshOptimizer is used:
+			virtual bool BaseConvert_Optimize(
 				Vector<BaseConvert::Mesh::UberVertex>& vVB,
-				Vector<BaseConvert::Mesh::Face>& vIB) = 0;
+				Vector<BaseConvert::Mesh::Face>& vIB) { return false; }
 			virtual bool BaseConvert_CanOverwriteFile(CSZ filename) { return true; }
 		};
 		VERUS_TYPEDEFS(BaseConvertDelegate);
@@ -253,11 +253,12 @@ void ConvertGLTF::ProcessMesh(const tinygltf::Mesh& mesh, int nodeIndex, int ski
 			const auto& buffer = _model.buffers[bufferView.buffer];
 			const int byteStride = accessor.ByteStride(bufferView);
 
-			if (accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+			const bool indices32 = (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT);
+			if (accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT && !indices32)
 				throw VERUS_RECOVERABLE << "Invalid componentType for indices: " << accessor.componentType;
 			if (accessor.type != TINYGLTF_TYPE_SCALAR)
 				throw VERUS_RECOVERABLE << "Invalid type for indices: " << accessor.type;
-			if (byteStride != 2)
+			if (byteStride != (indices32 ? 4 : 2))
 				throw VERUS_RECOVERABLE << "Invalid byteStride for indices: " << byteStride;
 
 			{
@@ -276,8 +277,11 @@ void ConvertGLTF::ProcessMesh(const tinygltf::Mesh& mesh, int nodeIndex, int ski
 				Mesh::Face face;
 				VERUS_FOR(i, 3)
 				{
-					const UINT16* pSrc = reinterpret_cast<const UINT16*>(p + byteStride * (faceIndex * 3 + i));
-					face._indices[i] = *pSrc;
+					const BYTE* pSrc = p + byteStride * (faceIndex * 3 + i);
+					if (indices32)
+						face._indices[i] = *reinterpret_cast<const UINT32*>(pSrc);
+					else
+						face._indices[i] = *reinterpret_cast<const UINT16*>(pSrc);
 				}
 				if (_desc._flipFaces)
 					std::swap(face._indices[1], face._indices[2]);
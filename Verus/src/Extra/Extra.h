@@ -1,6 +1,7 @@
 // Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
 #pragma once
 
+#include "MeshOptimizer.h"
 #include "BaseConvert.h"
 #include "ConvertGLTF.h"
 #include "ConvertX.h"
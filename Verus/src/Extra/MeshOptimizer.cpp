@@ -0,0 +1,492 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "verus.h"
+
+using namespace verus;
+using namespace verus::Extra;
+
+void MeshOptimizer::OptimizeVertexCache(Vector<UINT32>& vIndices, int vertCount, Vector<UINT32>* pClusters, int cacheSize)
+{
+	const int indexCount = Utils::Cast32(vIndices.size());
+	if (pClusters)
+		pClusters->clear();
+	if (indexCount < 3)
+		return;
+
+	// Triangles of each vertex, stored in one array:
+	Vector<int> vLiveCount(vertCount); // Triangles, which are not yet emitted.
+	for (UINT32 index : vIndices)
+		vLiveCount[index]++;
+	Vector<int> vOffsets(vertCount + 1);
+	VERUS_FOR(i, vertCount)
+		vOffsets[i + 1] = vOffsets[i] + vLiveCount[i];
+	Vector<int> vAdjacency(indexCount);
+	{
+		Vector<int> vFill(vOffsets.begin(), vOffsets.end() - 1);
+		VERUS_FOR(i, indexCount)
+			vAdjacency[vFill[vIndices[i]]++] = i / 3;
+	}
+
+	Vector<int> vTimeStamps(vertCount); // When the vertex entered the cache.
+	Vector<BYTE> vEmitted(indexCount / 3);
+	Vector<int> vDeadEnd; // Recently used vertices, which can still have some triangles.
+	Vector<int> vCandidates;
+	Vector<UINT32> vOutput;
+	vDeadEnd.reserve(indexCount);
+	vCandidates.reserve(64);
+	vOutput.reserve(indexCount);
+
+	int time = cacheSize + 1;
+	int cursor = 0;
+	int fanning = 0;
+	while (fanning >= 0)
+	{
+		// Emit all remaining triangles around fanning vertex:
+		vCandidates.clear();
+		for (int i = vOffsets[fanning]; i < vOffsets[fanning + 1]; ++i)
+		{
+			const int tri = vAdjacency[i];
+			if (vEmitted[tri])
+				continue;
+			vEmitted[tri] = 1;
+			VERUS_FOR(j, 3)
+			{
+				const UINT32 index = vIndices[tri * 3 + j];
+				vOutput.push_back(index);
+				vDeadEnd.push_back(index);
+				vCandidates.push_back(index);
+				vLiveCount[index]--;
+				if (time - vTimeStamps[index] > cacheSize) // Cache miss?
+					vTimeStamps[index] = time++;
+			}
+		}
+
+		// Next fanning vertex should still be in cache, when all it's triangles are emitted:
+		int next = -1;
+		int bestPriority = -1;
+		for (int index : vCandidates)
+		{
+			if (vLiveCount[index] <= 0)
+				continue;
+			const int age = time - vTimeStamps[index];
+			const int priority = (age + 2 * vLiveCount[index] <= cacheSize) ? age : 0;
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = index;
+			}
+		}
+
+		if (next < 0) // Dead end, new cluster begins:
+		{
+			while (!vDeadEnd.empty())
+			{
+				const int index = vDeadEnd.back();
+				vDeadEnd.pop_back();
+				if (vLiveCount[index] > 0)
+				{
+					next = index;
+					break;
+				}
+			}
+			for (; next < 0 && cursor < vertCount; ++cursor)
+			{
+				if (vLiveCount[cursor] > 0)
+					next = cursor;
+			}
+			if (pClusters && next >= 0)
+			{
+				const UINT32 tri = Utils::Cast32(vOutput.size() / 3);
+				if (pClusters->empty() || pClusters->back() != tri)
+					pClusters->push_back(tri);
+			}
+		}
+		fanning = next;
+	}
+
+	vIndices.swap(vOutput);
+	if (pClusters && (pClusters->empty() || pClusters->front()))
+		pClusters->insert(pClusters->begin(), 0);
+}
+
+void MeshOptimizer::OptimizeOverdraw(Vector<UINT32>& vIndices, const Vector<glm::vec3>& vPositions, const Vector<UINT32>& vClusters)
+{
+	const int triCount = Utils::Cast32(vIndices.size() / 3);
+	const int clusterCount = Utils::Cast32(vClusters.size());
+	if (clusterCount <= 1)
+		return;
+
+	struct Cluster
+	{
+		glm::vec3 _center = glm::vec3(0);
+		glm::vec3 _normal = glm::vec3(0);
+		float     _area = 0;
+		float     _sortKey = 0;
+		int       _from = 0;
+		int       _to = 0;
+	};
+	Vector<Cluster> vClusterData(clusterCount);
+
+	// Area-weighted centers and normals:
+	glm::vec3 meshCenter(0);
+	float meshArea = 0;
+	VERUS_FOR(i, clusterCount)
+	{
+		Cluster& cluster = vClusterData[i];
+		cluster._from = vClusters[i];
+		cluster._to = (i + 1 < clusterCount) ? vClusters[i + 1] : triCount;
+		for (int tri = cluster._from; tri < cluster._to; ++tri)
+		{
+			const glm::vec3& p0 = vPositions[vIndices[tri * 3 + 0]];
+			const glm::vec3& p1 = vPositions[vIndices[tri * 3 + 1]];
+			const glm::vec3& p2 = vPositions[vIndices[tri * 3 + 2]];
+			const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			const float area = glm::length(n) * 0.5f;
+			cluster._center += (p0 + p1 + p2) * (area / 3);
+			cluster._normal += n;
+			cluster._area += area;
+		}
+		meshCenter += cluster._center;
+		meshArea += cluster._area;
+	}
+	if (meshArea > 0)
+		meshCenter /= meshArea;
+
+	// Clusters, which are far from the center and look outside, are likely to occlude others:
+	for (auto& cluster : vClusterData)
+	{
+		if (cluster._area > 0)
+			cluster._center /= cluster._area;
+		const float len = glm::length(cluster._normal);
+		if (len > 0)
+			cluster._sortKey = glm::dot(cluster._center - meshCenter, cluster._normal / len);
+	}
+	std::stable_sort(vClusterData.begin(), vClusterData.end(), [](const Cluster& a, const Cluster& b)
+		{
+			return a._sortKey > b._sortKey;
+		});
+
+	Vector<UINT32> vOutput;
+	vOutput.reserve(vIndices.size());
+	for (const auto& cluster : vClusterData)
+		vOutput.insert(vOutput.end(), vIndices.begin() + cluster._from * 3, vIndices.begin() + cluster._to * 3);
+	vIndices.swap(vOutput);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(Vector<UINT32>& vIndices, int vertCount, Vector<UINT32>& vRemap)
+{
+	vRemap.clear();
+	vRemap.reserve(vertCount);
+	Vector<UINT32> vNewIndices(vertCount, UINT32_MAX);
+	for (auto& index : vIndices)
+	{
+		if (UINT32_MAX == vNewIndices[index])
+		{
+			vNewIndices[index] = Utils::Cast32(vRemap.size());
+			vRemap.push_back(index);
+		}
+		index = vNewIndices[index];
+	}
+}
+
+void MeshOptimizer::BuildMeshlets(
+	const Vector<UINT32>& vIndices,
+	const Vector<glm::vec3>& vPositions,
+	Vector<World::BaseMesh::Meshlet>& vMeshlets,
+	int maxVertCount,
+	int maxTriCount)
+{
+	vMeshlets.clear();
+	const int indexCount = Utils::Cast32(vIndices.size());
+	Vector<int> vMeshletOfVertex(vPositions.size(), -1); // Last meshlet, which used this vertex.
+
+	auto AddMeshlet = [&vIndices, &vPositions, &vMeshlets](int from, int to)
+	{
+		World::BaseMesh::Meshlet meshlet = {};
+		meshlet._firstIndex = from;
+		meshlet._indexCount = to - from;
+
+		// Bounding sphere around the center of AABB:
+		glm::vec3 mn(+FLT_MAX), mx(-FLT_MAX);
+		for (int i = from; i < to; ++i)
+		{
+			mn = glm::min(mn, vPositions[vIndices[i]]);
+			mx = glm::max(mx, vPositions[vIndices[i]]);
+		}
+		const glm::vec3 center = (mn + mx) * 0.5f;
+		float radiusSq = 0;
+		for (int i = from; i < to; ++i)
+			radiusSq = Math::Max(radiusSq, glm::distance2(center, vPositions[vIndices[i]]));
+
+		// Normal cone, which contains all triangle normals:
+		glm::vec3 axis(0);
+		for (int i = from; i < to; i += 3)
+		{
+			const glm::vec3 n = glm::cross(
+				vPositions[vIndices[i + 1]] - vPositions[vIndices[i]],
+				vPositions[vIndices[i + 2]] - vPositions[vIndices[i]]);
+			const float len = glm::length(n);
+			if (len > 0)
+				axis += n / len;
+		}
+		float minDot = -1;
+		const float axisLen = glm::length(axis);
+		if (axisLen > 0)
+		{
+			axis /= axisLen;
+			minDot = 1;
+			for (int i = from; i < to; i += 3)
+			{
+				const glm::vec3 n = glm::cross(
+					vPositions[vIndices[i + 1]] - vPositions[vIndices[i]],
+					vPositions[vIndices[i + 2]] - vPositions[vIndices[i]]);
+				const float len = glm::length(n);
+				if (len > 0)
+					minDot = Math::Min(minDot, glm::dot(n / len, axis));
+			}
+		}
+
+		memcpy(meshlet._center, &center, sizeof(meshlet._center));
+		meshlet._radius = sqrt(radiusSq);
+		memcpy(meshlet._coneAxis, &axis, sizeof(meshlet._coneAxis));
+		meshlet._coneCutoff = (minDot > 0) ? sqrt(1 - minDot * minDot) : 1; // Wider than hemisphere cannot be culled.
+		vMeshlets.push_back(meshlet);
+	};
+
+	int from = 0;
+	int vertCount = 0;
+	for (int i = 0; i < indexCount; i += 3)
+	{
+		const int meshletIndex = Utils::Cast32(vMeshlets.size());
+		int newVertCount = 0;
+		VERUS_FOR(j, 3)
+		{
+			if (vMeshletOfVertex[vIndices[i + j]] != meshletIndex)
+				newVertCount++;
+		}
+		if (vertCount + newVertCount > maxVertCount || (i - from) / 3 >= maxTriCount) // Full?
+		{
+			AddMeshlet(from, i);
+			from = i;
+			vertCount = 0;
+		}
+		VERUS_FOR(j, 3)
+		{
+			int& meshletOfVertex = vMeshletOfVertex[vIndices[i + j]];
+			if (meshletOfVertex != Utils::Cast32(vMeshlets.size()))
+			{
+				meshletOfVertex = Utils::Cast32(vMeshlets.size());
+				vertCount++;
+			}
+		}
+	}
+	if (from < indexCount)
+		AddMeshlet(from, indexCount);
+}
+
+float MeshOptimizer::ComputeACMR(const Vector<UINT32>& vIndices, int vertCount, int cacheSize)
+{
+	const int triCount = Utils::Cast32(vIndices.size() / 3);
+	if (!triCount)
+		return 0;
+	Vector<int> vTimeStamps(vertCount);
+	int time = cacheSize + 1;
+	int missCount = 0;
+	for (UINT32 index : vIndices)
+	{
+		if (time - vTimeStamps[index] > cacheSize)
+		{
+			vTimeStamps[index] = time++;
+			missCount++;
+		}
+	}
+	return static_cast<float>(missCount) / triCount;
+}
+
+void MeshOptimizer::Test()
+{
+	// Grid with shuffled triangles, each triangle has it's own vertices:
+	const int side = 24;
+	Vector<glm::vec3> vPositions;
+	Vector<UINT32> vTriangles;
+	VERUS_FOR(i, side)
+	{
+		VERUS_FOR(j, side)
+		{
+			const glm::vec3 corners[4] =
+			{
+				glm::vec3(float(j), 0, float(i)),
+				glm::vec3(float(j + 1), 0, float(i)),
+				glm::vec3(float(j), 0, float(i + 1)),
+				glm::vec3(float(j + 1), 0, float(i + 1))
+			};
+			vTriangles.push_back(Utils::Cast32(vTriangles.size()));
+			vTriangles.push_back(Utils::Cast32(vTriangles.size()));
+			vPositions.push_back(corners[0]);
+			vPositions.push_back(corners[2]);
+			vPositions.push_back(corners[1]);
+			vPositions.push_back(corners[1]);
+			vPositions.push_back(corners[2]);
+			vPositions.push_back(corners[3]);
+		}
+	}
+	Random random(1234);
+	std::shuffle(vTriangles.begin(), vTriangles.end(), random.GetGenerator());
+
+	// Weld vertices with a tiny error:
+	VERUS_FOR(i, vPositions.size())
+		vPositions[i] += glm::vec3(random.NextFloat(-0.0004f, 0.0004f));
+	Vector<UINT32> vRemap;
+	const int vertCount = Weld(vPositions, 0.001f, vRemap, [&vPositions](int a, int b)
+		{
+			return glm::all(glm::epsilonEqual(vPositions[a], vPositions[b], 0.001f));
+		});
+	VERUS_RT_ASSERT((side + 1) * (side + 1) == vertCount);
+
+	Vector<UINT32> vIndices;
+	Vector<glm::vec3> vUniquePositions(vertCount);
+	for (UINT32 tri : vTriangles)
+	{
+		VERUS_FOR(i, 3)
+		{
+			const UINT32 index = vRemap[tri * 3 + i];
+			vIndices.push_back(index);
+			vUniquePositions[index] = vPositions[tri * 3 + i];
+		}
+	}
+	auto GetSortedTriangles = [](const Vector<UINT32>& vIndices, const Vector<glm::vec3>& vPositions)
+	{
+		Vector<glm::ivec3> vSorted;
+		VERUS_FOR(i, vIndices.size() / 3)
+		{
+			glm::ivec3 tri;
+			VERUS_FOR(j, 3)
+			{
+				const glm::vec3& pos = vPositions[vIndices[i * 3 + j]];
+				tri[j] = static_cast<int>(glm::round(pos.x)) * 1000 + static_cast<int>(glm::round(pos.z));
+			}
+			vSorted.push_back(tri);
+		}
+		std::sort(vSorted.begin(), vSorted.end(), [](const glm::ivec3& a, const glm::ivec3& b)
+			{
+				return std::lexicographical_compare(&a[0], &a[0] + 3, &b[0], &b[0] + 3);
+			});
+		return vSorted;
+	};
+	const Vector<glm::ivec3> vSortedBefore = GetSortedTriangles(vIndices, vUniquePositions);
+	const float acmrBefore = ComputeACMR(vIndices, vertCount);
+
+	Vector<UINT32> vClusters;
+	OptimizeVertexCache(vIndices, vertCount, &vClusters);
+	VERUS_RT_ASSERT(!vClusters.empty() && !vClusters.front());
+	OptimizeOverdraw(vIndices, vUniquePositions, vClusters);
+	OptimizeVertexFetch(vIndices, vertCount, vRemap);
+	VERUS_RT_ASSERT(vertCount == vRemap.size());
+	Vector<glm::vec3> vNewPositions(vertCount);
+	VERUS_FOR(i, vertCount)
+		vNewPositions[i] = vUniquePositions[vRemap[i]];
+
+	// Same triangles, same winding, better order:
+	VERUS_RT_ASSERT(vSortedBefore == GetSortedTriangles(vIndices, vNewPositions));
+	const float acmrAfter = ComputeACMR(vIndices, vertCount);
+	VERUS_RT_ASSERT(acmrAfter < acmrBefore && acmrAfter < 1);
+	VERUS_FOR(i, vIndices.size())
+		VERUS_RT_ASSERT(vIndices[i] <= i);
+
+	// Meshlets of a flat grid, they cover all triangles:
+	Vector<World::BaseMesh::Meshlet> vMeshlets;
+	BuildMeshlets(vIndices, vNewPositions, vMeshlets);
+	UINT32 nextIndex = 0;
+	for (const auto& meshlet : vMeshlets)
+	{
+		VERUS_RT_ASSERT(meshlet._firstIndex == nextIndex && meshlet._indexCount > 0 && meshlet._indexCount <= 124 * 3);
+		Set<UINT32> setVerts(vIndices.begin() + meshlet._firstIndex, vIndices.begin() + meshlet._firstIndex + meshlet._indexCount);
+		VERUS_RT_ASSERT(setVerts.size() <= 64);
+		const glm::vec3 center = glm::make_vec3(meshlet._center);
+		for (UINT32 index : setVerts)
+			VERUS_RT_ASSERT(glm::distance(center, vNewPositions[index]) <= meshlet._radius + 0.001f);
+		VERUS_RT_ASSERT(glm::epsilonEqual(abs(meshlet._coneAxis[1]), 1.f, 0.01f) && meshlet._coneCutoff < 0.1f);
+		nextIndex += meshlet._indexCount;
+	}
+	VERUS_RT_ASSERT(nextIndex == vIndices.size());
+}
+
+void MeshOptimizer::Benchmark()
+{
+	// Million triangles, each triangle has it's own vertices, random order:
+	const int side = 708;
+	Vector<glm::vec3> vPositions;
+	Vector<UINT32> vTriangles;
+	vPositions.reserve(side * side * 6);
+	vTriangles.reserve(side * side * 2);
+	VERUS_FOR(i, side)
+	{
+		VERUS_FOR(j, side)
+		{
+			const float h00 = sin(j * 0.05f) * cos(i * 0.05f);
+			const float h10 = sin((j + 1) * 0.05f) * cos(i * 0.05f);
+			const float h01 = sin(j * 0.05f) * cos((i + 1) * 0.05f);
+			const float h11 = sin((j + 1) * 0.05f) * cos((i + 1) * 0.05f);
+			vTriangles.push_back(Utils::Cast32(vTriangles.size()));
+			vTriangles.push_back(Utils::Cast32(vTriangles.size()));
+			vPositions.push_back(glm::vec3(float(j), h00, float(i)));
+			vPositions.push_back(glm::vec3(float(j), h01, float(i + 1)));
+			vPositions.push_back(glm::vec3(float(j + 1), h10, float(i)));
+			vPositions.push_back(glm::vec3(float(j + 1), h10, float(i)));
+			vPositions.push_back(glm::vec3(float(j), h01, float(i + 1)));
+			vPositions.push_back(glm::vec3(float(j + 1), h11, float(i + 1)));
+		}
+	}
+	Random random(1234);
+	std::shuffle(vTriangles.begin(), vTriangles.end(), random.GetGenerator());
+
+	// Each step is measured on a copy of its input, its output is the input of the next step:
+	const int runCount = 3;
+	Vector<UINT32> vRemap;
+	int vertCount = 0;
+	const double weldMs = Utils::MeasureBestTime([&]()
+		{
+			vertCount = Weld(vPositions, 0.001f, vRemap, [&vPositions](int a, int b)
+				{
+					return glm::all(glm::epsilonEqual(vPositions[a], vPositions[b], 0.001f));
+				});
+		}, runCount);
+	Vector<UINT32> vIndices;
+	Vector<glm::vec3> vUniquePositions(vertCount);
+	vIndices.reserve(vTriangles.size() * 3);
+	for (UINT32 tri : vTriangles)
+	{
+		VERUS_FOR(i, 3)
+		{
+			const UINT32 index = vRemap[tri * 3 + i];
+			vIndices.push_back(index);
+			vUniquePositions[index] = vPositions[tri * 3 + i];
+		}
+	}
+	const float acmrBefore = ComputeACMR(vIndices, vertCount);
+
+	Vector<UINT32> vOutput;
+	Vector<UINT32> vClusters;
+	const double cacheMs = Utils::MeasureBestTime([&]()
+		{
+			vOutput = vIndices;
+			OptimizeVertexCache(vOutput, vertCount, &vClusters);
+		}, runCount);
+	vIndices.swap(vOutput);
+	const double overdrawMs = Utils::MeasureBestTime([&]()
+		{
+			vOutput = vIndices;
+			OptimizeOverdraw(vOutput, vUniquePositions, vClusters);
+		}, runCount);
+	vIndices.swap(vOutput);
+	const double fetchMs = Utils::MeasureBestTime([&]()
+		{
+			vOutput = vIndices;
+			OptimizeVertexFetch(vOutput, vertCount, vRemap);
+		}, runCount);
+	vIndices.swap(vOutput);
+	const float acmrAfter = ComputeACMR(vIndices, vertCount);
+
+	VERUS_LOG_INFO("Benchmark(); Triangles: " << vTriangles.size() << ", vertices: " << vPositions.size() << " -> " << vertCount
+		<< ", weld: " << weldMs << " ms, vertex cache: " << cacheMs << " ms, overdraw: " << overdrawMs << " ms, vertex fetch: " << fetchMs << " ms"
+		<< ", ACMR: " << acmrBefore << " -> " << acmrAfter << ", clusters: " << vClusters.size());
+}
@@ -0,0 +1,123 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace Extra
+	{
+		// Reorders triangles and vertices, so that GPU spends less time on vertex processing, overdraw and fetching.
+		// Vertex cache pass is based on Tipsify (Sander, Nehab, Barczak), it works in linear time.
+		// Overdraw pass sorts clusters of triangles, which Tipsify outputs, by their occlusion potential.
+		// Index buffer uses 32-bit indices, three indices per triangle.
+		class MeshOptimizer
+		{
+		public:
+			// Finds equal vertices in linear time using hash grid, returns the number of unique vertices.
+			// For each vertex vRemap gives the index of unique vertex, unique vertices keep their order.
+			// Equal vertices must have positions, which differ by less than tolerance on each axis.
+			// If several unique vertices are equal, the first one is used, like std::find would do.
+			template<typename TFunc>
+			static int Weld(
+				const Vector<glm::vec3>& vPositions,
+				float tolerance,
+				Vector<UINT32>& vRemap,
+				TFunc isEqual) // bool isEqual(int uniqueOriginalIndex, int index)
+			{
+				const int count = Utils::Cast32(vPositions.size());
+				vRemap.resize(count);
+				HashMap<UINT64, int> mapCells; // Head of the list of unique vertices in each cell.
+				mapCells.reserve(count);
+				Vector<int> vNext; // Next unique vertex in the same cell.
+				Vector<int> vUnique; // Original index of each unique vertex.
+				vNext.reserve(count);
+				vUnique.reserve(count);
+
+				// Cell is twice as big as tolerance, so only one neighbor on each axis must be checked:
+				const float scale = 0.5f / tolerance;
+				auto MakeKey = [](INT64 x, INT64 y, INT64 z)
+				{
+					return ((x & 0x1FFFFF) << 42) | ((y & 0x1FFFFF) << 21) | (z & 0x1FFFFF);
+				};
+				VERUS_FOR(i, count)
+				{
+					const glm::vec3 pos = vPositions[i] * scale;
+					const glm::vec3 cell = glm::floor(pos);
+					const glm::vec3 frac = pos - cell;
+					const INT64 c[3] = { static_cast<INT64>(cell.x), static_cast<INT64>(cell.y), static_cast<INT64>(cell.z) };
+					const INT64 n[3] = { frac.x < 0.5f ? -1 : 1, frac.y < 0.5f ? -1 : 1, frac.z < 0.5f ? -1 : 1 };
+
+					int match = INT_MAX;
+					VERUS_FOR(j, 8)
+					{
+						const auto it = mapCells.find(MakeKey(
+							c[0] + ((j & 0x1) ? n[0] : 0),
+							c[1] + ((j & 0x2) ? n[1] : 0),
+							c[2] + ((j & 0x4) ? n[2] : 0)));
+						if (it == mapCells.end())
+							continue;
+						for (int u = it->second; u >= 0; u = vNext[u])
+						{
+							if (u < match && isEqual(vUnique[u], i))
+								match = u;
+						}
+					}
+
+					if (INT_MAX == match)
+					{
+						match = Utils::Cast32(vUnique.size());
+						vUnique.push_back(i);
+						vNext.push_back(-1);
+						const auto ret = mapCells.emplace(MakeKey(c[0], c[1], c[2]), match);
+						if (!ret.second)
+						{
+							vNext[match] = ret.first->second;
+							ret.first->second = match;
+						}
+					}
+					vRemap[i] = match;
+				}
+				return Utils::Cast32(vUnique.size());
+			}
+
+			// Returns the first triangle of each cluster in vClusters (can be nullptr):
+			static void OptimizeVertexCache(
+				Vector<UINT32>& vIndices,
+				int vertCount,
+				Vector<UINT32>* pClusters = nullptr,
+				int cacheSize = 16);
+
+			// Front clusters, which face away from the center, are drawn first:
+			static void OptimizeOverdraw(
+				Vector<UINT32>& vIndices,
+				const Vector<glm::vec3>& vPositions,
+				const Vector<UINT32>& vClusters);
+
+			// Vertices are sorted by their first use, unused vertices are removed. Index buffer is updated.
+			// For each new vertex vRemap gives it's old index:
+			static void OptimizeVertexFetch(
+				Vector<UINT32>& vIndices,
+				int vertCount,
+				Vector<UINT32>& vRemap);
+
+			// Splits index buffer into contiguous meshlets, computes their bounding spheres and normal cones.
+			// Vertex cache optimization should be done first, so that meshlets are compact:
+			static void BuildMeshlets(
+				const Vector<UINT32>& vIndices,
+				const Vector<glm::vec3>& vPositions,
+				Vector<World::BaseMesh::Meshlet>& vMeshlets,
+				int maxVertCount = 64,
+				int maxTriCount = 124);
+
+			// Average cache miss ratio (vertex shader invocations per triangle) of FIFO cache:
+			static float ComputeACMR(
+				const Vector<UINT32>& vIndices,
+				int vertCount,
+				int cacheSize = 16);
+
+			static void Test();
+			// Optimizes synthetic mesh with a million triangles, results are written to log:
+			static void Benchmark();
+		};
+		VERUS_TYPEDEFS(MeshOptimizer);
+	}
+}
@@ -25,14 +25,32 @@ VERUS_TYPEDEFS(MyRendererDelegate);
 
 struct BaseGame::Pimpl : AllocatorAware
 {
-	PBaseGame         _p = nullptr;
-	World::MainCamera _camera;
-	Spirit            _cameraSpirit;
-	bool              _defaultCameraMovement = true;
-	bool              _escapeKeyExitGame = true;
-	bool              _minimized = false;
-	bool              _rawInputEvents = false;
-	bool              _showFPS = true;
+	PBaseGame                _p = nullptr;
+	World::MainCamera        _camera;
+	World::MainCamera        _drawCamera; // Copy of _camera, which is used by draw with pipelined frames.
+	Spirit                   _cameraSpirit;
+	Vector<PBaseRenderState> _vRenderStates;
+	bool                     _defaultCameraMovement = true;
+	bool                     _escapeKeyExitGame = true;
+	bool                     _minimized = false;
+	bool                     _rawInputEvents = false;
+	bool                     _showFPS = true;
+	bool                     _showProfiler = false;
+
+	// <LoopStats>
+	std::chrono::steady_clock::time_point _loopStartTime;
+	int                      _loopFrameCount = 0;
+	// </LoopStats>
+
+	// <RenderThread>
+	std::thread              _renderThread;
+	std::mutex               _renderMutex;
+	std::condition_variable  _renderCV;
+	std::exception_ptr       _renderException;
+	bool                     _pipelinedFrames = false;
+	bool                     _drawRequested = false;
+	bool                     _stopRenderThread = false;
+	// </RenderThread>
 
 	Pimpl(PBaseGame p) : _p(p)
 	{
@@ -40,7 +58,250 @@ struct BaseGame::Pimpl : AllocatorAware
 
 	~Pimpl()
 	{
+		StopRenderThread();
 	}
+
+	void HandleCameraInput()
+	{
+		if (!_defaultCameraMovement)
+			return;
+		VERUS_QREF_IM;
+		const float speed = im.IsKeyPressed(SDL_SCANCODE_SPACE) ? 20.f : 2.f;
+		if (im.IsKeyPressed(SDL_SCANCODE_W))
+			_cameraSpirit.MoveFront(speed);
+		if (im.IsKeyPressed(SDL_SCANCODE_S))
+			_cameraSpirit.MoveFront(-speed);
+		if (im.IsKeyPressed(SDL_SCANCODE_A))
+			_cameraSpirit.MoveSide(-speed);
+		if (im.IsKeyPressed(SDL_SCANCODE_D))
+			_cameraSpirit.MoveSide(speed);
+	}
+
+	void UpdateCameraSpirit()
+	{
+		if (!_defaultCameraMovement)
+			return;
+		_cameraSpirit.HandleActions();
+		_cameraSpirit.Update();
+	}
+
+	// With pipelined frames draw uses a copy, see ExtractRenderState():
+	void UpdateDefaultCamera()
+	{
+		if (_defaultCameraMovement)
+		{
+			_camera.MoveEyeTo(_cameraSpirit.GetPosition());
+			_camera.MoveAtTo(_cameraSpirit.GetPosition() + _cameraSpirit.GetFrontDirection());
+			if (World::Water::IsValidSingleton())
+			{
+				VERUS_QREF_WATER;
+				if (water.IsInitialized())
+					_camera.ExcludeWaterLine();
+			}
+			_camera.Update();
+			if (World::WorldManager::IsValidSingleton())
+				World::WorldManager::I().SetAllCameras(&_camera);
+		}
+		else
+		{
+			if (World::WorldManager::IsValidSingleton())
+				World::WorldManager::I().SetAllCameras(nullptr);
+		}
+	}
+
+	void ExtractRenderState()
+	{
+		_p->BaseGame_ExtractRenderState();
+		for (auto p : _vRenderStates)
+			p->BaseRenderState_Publish();
+
+		if (!_pipelinedFrames)
+			return;
+
+		// Update of the next frame changes camera and nodes, while this frame is drawn, so draw gets a copy:
+		_drawCamera = _camera;
+		if (World::WorldManager::IsValidSingleton())
+		{
+			VERUS_QREF_WM;
+			if (wm.GetHeadCamera() == &_camera)
+				wm.SetAllCameras(&_drawCamera);
+			if (wm.IsInitialized() && wm.GetPassCamera())
+				wm.PublishRenderState();
+		}
+	}
+
+	// Draw reads live state of these, while update of the next frame changes it, so frames with them are not pipelined:
+	CSZ FindUnpipelinedContent() const
+	{
+		if (World::WorldManager::IsValidSingleton())
+		{
+			VERUS_QREF_WM;
+			int countPerType[+World::NodeType::count];
+			wm.GetNodeCount(countPerType);
+			if (countPerType[+World::NodeType::terrain])
+				return "terrain"; // Also forest and grass, which use terrain.
+			if (countPerType[+World::NodeType::particles] || countPerType[+World::NodeType::emitter])
+				return "particles";
+		}
+		if (World::Water::IsValidSingleton() && World::Water::I().IsInitialized())
+			return "water";
+		if (World::Atmosphere::IsValidSingleton() && World::Atmosphere::I().IsInitialized())
+			return "atmosphere";
+		return nullptr;
+	}
+
+	void ShowFPS()
+	{
+		VERUS_QREF_RENDERER;
+		VERUS_QREF_CONST_SETTINGS;
+		VERUS_QREF_TIMER;
+		if (!_showFPS || settings._headless || !timer.IsEventEvery(500))
+			return;
+		char title[40];
+		CSZ gapi = "";
+		switch (renderer->GetGapi())
+		{
+		case CGI::Gapi::vulkan:     gapi = "Vulkan"; break;
+		case CGI::Gapi::direct3D11: gapi = "Direct3D 11"; break;
+		case CGI::Gapi::direct3D12: gapi = "Direct3D 12"; break;
+		case CGI::Gapi::null:       gapi = "Null"; break;
+		}
+		sprintf_s(title, "GAPI: %s, FPS: %.1f", gapi, renderer.GetFps());
+		SDL_SetWindowTitle(renderer.GetMainWindow()->GetSDL(), title);
+	}
+
+	// Between renderer's BeginFrame() and Draw(), so that the window is a part of this frame's ImGui:
+	void DrawProfiler()
+	{
+#ifdef VERUS_ENABLE_PROFILER
+		VERUS_QREF_CONST_SETTINGS;
+		if (!_showProfiler || settings._headless || !Profiler::IsValidSingleton())
+			return;
+		Profiler::I().DrawImGui(&_showProfiler);
+#endif
+	}
+
+	// <LoopStats>
+	void BeginLoop()
+	{
+		VERUS_QREF_RENDERER;
+		renderer->ResetStats(); // Count only the frames of the loop.
+		_loopStartTime = std::chrono::steady_clock::now();
+		_loopFrameCount = 0;
+	}
+
+	void CountFrame()
+	{
+		VERUS_QREF_CONST_SETTINGS;
+		VERUS_PROFILE_END_FRAME();
+		_loopFrameCount++;
+		if (settings._frameCount > 0 && settings._frameCount == _loopFrameCount)
+			_p->Exit();
+	}
+
+	// Average CPU cost of a frame, which can be tracked per commit:
+	void LogLoopStats()
+	{
+		VERUS_QREF_RENDERER;
+		if (!_loopFrameCount)
+			return;
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _loopStartTime).count();
+		CGI::RcRendererStats stats = renderer->GetStats();
+		const double frameCount = _loopFrameCount;
+		VERUS_LOG_INFO("Loop stats; frames: " << _loopFrameCount
+			<< ", ms per frame: " << ms / frameCount
+			<< ", draws: " << stats._drawCount / frameCount
+			<< ", vertices: " << stats._vertexCount / frameCount
+			<< ", dispatches: " << stats._dispatchCount / frameCount
+			<< ", pipeline binds: " << stats._pipelineBindCount / frameCount
+			<< ", descriptor binds: " << stats._descriptorBindCount / frameCount
+			<< ", uploaded bytes: " << stats._uploadedBytes / frameCount);
+	}
+	// </LoopStats>
+
+	// <RenderThread>
+	void StartRenderThread()
+	{
+		if (_renderThread.joinable())
+			return;
+		_stopRenderThread = false;
+		_drawRequested = false;
+		_renderThread = std::thread(&Pimpl::RenderThreadProc, this);
+	}
+
+	void StopRenderThread()
+	{
+		if (!_renderThread.joinable())
+			return;
+
+		// Can be called by destructor, so exceptions are not rethrown here:
+		{
+			std::unique_lock<std::mutex> lock(_renderMutex);
+			_renderCV.wait(lock, [this]() { return !_drawRequested; });
+			_stopRenderThread = true;
+		}
+		_renderCV.notify_all();
+		_renderThread.join();
+		_renderException = nullptr;
+	}
+
+	void RequestDraw()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_renderMutex);
+			_drawRequested = true;
+		}
+		_renderCV.notify_all();
+	}
+
+	// Sync point, after it the render thread doesn't use anything:
+	void WaitForDraw()
+	{
+		{
+			std::unique_lock<std::mutex> lock(_renderMutex);
+			_renderCV.wait(lock, [this]() { return !_drawRequested; });
+		}
+
+		if (_renderException)
+		{
+			std::exception_ptr ex = _renderException;
+			_renderException = nullptr;
+			std::rethrow_exception(ex);
+		}
+	}
+
+	void RenderThreadProc()
+	{
+		VERUS_QREF_RENDERER;
+		VERUS_PROFILE_THREAD("Render");
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(_renderMutex);
+				_renderCV.wait(lock, [this]() { return _drawRequested || _stopRenderThread; });
+				if (_stopRenderThread)
+					break;
+			}
+
+			try
+			{
+				VERUS_PROFILE_SCOPE("Renderer::Draw");
+				renderer.Draw();
+				renderer.EndFrame();
+			}
+			catch (...)
+			{
+				_renderException = std::current_exception();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(_renderMutex);
+				_drawRequested = false;
+			}
+			_renderCV.notify_all();
+		}
+	}
+	// </RenderThread>
 };
 
 BaseGame::BaseGame()
@@ -66,15 +327,18 @@ BaseGame::~BaseGame()
 
 void BaseGame::Initialize(VERUS_MAIN_DEFAULT_ARGS, App::Window::RcDesc windowDesc)
 {
-	const int ret = SDL_Init(SDL_INIT_EVERYTHING);
-	if (ret)
-		throw VERUS_RUNTIME_ERROR << "SDL_Init(); " << ret;
-
 	Utils::I().InitPaths();
 
 	App::Settings::Make();
 	VERUS_QREF_SETTINGS;
 	settings.ParseCommandLineArgs(argc, argv);
+
+	// Headless mode doesn't create a window, build agents can have no display:
+	const Uint32 flags = settings._commandLine._headless ? (SDL_INIT_TIMER | SDL_INIT_EVENTS) : SDL_INIT_EVERYTHING;
+	const int ret = SDL_Init(flags);
+	if (ret)
+		throw VERUS_RUNTIME_ERROR << "SDL_Init(); " << ret;
+
 	settings.Load();
 	settings.HandleHighDpi();
 	settings.HandleCommandLineArgs();
@@ -88,18 +352,27 @@ void BaseGame::Initialize(VERUS_MAIN_DEFAULT_ARGS, App::Window::RcDesc windowDes
 	// Allocate memory:
 	_engineInit.Make();
 
+	// Window and renderer:
+	if (!settings._headless)
+	{
+		_window.Init(updatedWindowDesc);
+		SDL_GetWindowSize(_window.GetSDL(),
+			&settings._displaySizeWidth,
+			&settings._displaySizeHeight); // Display size, window size and swap chain size must match.
+		CGI::Renderer::I().SetMainWindow(&_window);
+	}
+	_engineInit.Init(new MyRendererDelegate(this));
+
+	// Tests use engine's systems, like Jobs:
 #if defined(_DEBUG) || defined(VERUS_RELEASE_DEBUG)
 	Utils::TestAll();
+	if (settings._commandLine._test)
+	{
+		Utils::TestSlow();
+		Utils::PushQuitEvent();
+	}
 #endif
 
-	// Window and renderer:
-	_window.Init(updatedWindowDesc);
-	SDL_GetWindowSize(_window.GetSDL(),
-		&settings._displaySizeWidth,
-		&settings._displaySizeHeight); // Display size, window size and swap chain size must match.
-	CGI::Renderer::I().SetMainWindow(&_window);
-	_engineInit.Init(new MyRendererDelegate(this));
-
 	VERUS_QREF_IM;
 	const int focus = im.GainFocus(this);
 	VERUS_RT_ASSERT(0 == focus);
@@ -121,6 +394,20 @@ void BaseGame::Initialize(VERUS_MAIN_DEFAULT_ARGS, App::Window::RcDesc windowDes
 	auto pExtReality = renderer->GetExtReality();
 	if (pExtReality->IsInitialized())
 		pExtReality->CreateActions();
+
+	// After content is loaded, some benchmarks use the world:
+	if (settings._commandLine._benchmark)
+	{
+		Utils::BenchmarkAll();
+		Utils::PushQuitEvent();
+	}
+
+	// All shaders are loaded, compile the rest of them into the cache and quit:
+	if (settings._commandLine._prewarmShaders)
+	{
+		renderer.PrewarmShaderCache();
+		Utils::PushQuitEvent();
+	}
 }
 
 void BaseGame::Loop(bool relativeMouseMode)
@@ -128,8 +415,14 @@ void BaseGame::Loop(bool relativeMouseMode)
 	VERUS_QREF_ASYNC;
 	VERUS_QREF_IM;
 	VERUS_QREF_RENDERER;
+	VERUS_QREF_CONST_SETTINGS;
 	VERUS_QREF_TIMER;
 
+	if (settings._headless)
+		relativeMouseMode = false;
+
+	VERUS_PROFILE_THREAD("Main");
+
 	if (relativeMouseMode)
 	{
 		if (SDL_SetRelativeMouseMode(SDL_TRUE))
@@ -138,20 +431,29 @@ void BaseGame::Loop(bool relativeMouseMode)
 
 	timer.Update();
 
+	_p->BeginLoop();
+
 	SDL_Event event;
 	bool quit = false;
 
 	do // The Game Loop.
 	{
+		if (_p->_pipelinedFrames)
+			_p->WaitForDraw(); // Previous frame was drawn and submitted.
+
 		im.ResetInputState(); // Prepare for event polling.
 
 		while (SDL_PollEvent(&event))
 		{
-			ImGui_ImplSDL2_ProcessEvent(&event);
+			if (!settings._headless)
+				ImGui_ImplSDL2_ProcessEvent(&event);
 
 			// Toggle fullscreen (Alt+Enter):
 			if ((SDL_KEYDOWN == event.type) && (SDLK_RETURN == event.key.keysym.sym) && (event.key.keysym.mod & KMOD_ALT))
 				ToggleFullscreen();
+			// Toggle profiler (Alt+P):
+			if ((SDL_KEYDOWN == event.type) && (SDLK_p == event.key.keysym.sym) && (event.key.keysym.mod & KMOD_ALT))
+				_p->_showProfiler = !_p->_showProfiler;
 
 			// <RawInput>
 			bool keyboardShortcut = false;
@@ -260,6 +562,79 @@ void BaseGame::Loop(bool relativeMouseMode)
 		if (_p->_minimized || _restartApp)
 			continue;
 
+		if (_p->_pipelinedFrames)
+		{
+			//
+			// PREPARE CURRENT FRAME (render thread is idle)
+			//
+
+			renderer.BeginFrame();
+
+			async.Update();
+
+			BaseGame_EnterRequestedState();
+
+			// Content, which was just loaded, could make pipelined frames unsafe, this frame is drawn here:
+			if (CSZ content = _p->FindUnpipelinedContent())
+			{
+				VERUS_LOG_WARN("Loop(); Draw doesn't use a copy of " << content << ", frames are no longer pipelined");
+				EnablePipelinedFrames(false);
+			}
+
+			_p->UpdateDefaultCamera();
+			_p->ExtractRenderState();
+
+			timer.Update(); // Render thread reads it.
+
+			if (Physics::Bullet::IsValidSingleton()) // Step physics on it's thread, while drawing.
+				Physics::Bullet::I().StartAsyncStep();
+
+			_p->ShowFPS();
+			_p->DrawProfiler();
+
+			if (!_p->_pipelinedFrames) // Fell back, next frame is updated as usual.
+			{
+				VERUS_PROFILE_SCOPE("Renderer::Draw");
+				renderer.Draw();
+				renderer.EndFrame();
+				_p->CountFrame();
+				continue;
+			}
+
+			// Draw current frame on the render thread:
+			_p->RequestDraw();
+
+			//
+			// UPDATE NEXT FRAME
+			//
+
+			_p->HandleCameraInput();
+			im.HandleInput();
+			if (_restartApp)
+				continue;
+
+			if (Physics::Bullet::IsValidSingleton())
+				Physics::Bullet::I().Simulate();
+
+			_p->UpdateCameraSpirit();
+
+			{
+				VERUS_PROFILE_SCOPE("BaseGame_Update");
+				BaseGame_Update(); // Between physics and audio update.
+			}
+			if (_restartApp)
+				continue;
+
+			if (LotManager::IsValidSingleton()) // Systems see what the game has just spawned or changed.
+				LotManager::I().Update(timer.GetDeltaTime());
+
+			if (Audio::AudioSystem::IsValidSingleton())
+				Audio::AudioSystem::I().Update();
+
+			_p->CountFrame();
+			continue;
+		}
+
 		//
 		// UPDATE
 		//
@@ -272,18 +647,7 @@ void BaseGame::Loop(bool relativeMouseMode)
 
 		BaseGame_EnterRequestedState();
 
-		if (_p->_defaultCameraMovement) // Handle input:
-		{
-			const float speed = im.IsKeyPressed(SDL_SCANCODE_SPACE) ? 20.f : 2.f;
-			if (im.IsKeyPressed(SDL_SCANCODE_W))
-				_p->_cameraSpirit.MoveFront(speed);
-			if (im.IsKeyPressed(SDL_SCANCODE_S))
-				_p->_cameraSpirit.MoveFront(-speed);
-			if (im.IsKeyPressed(SDL_SCANCODE_A))
-				_p->_cameraSpirit.MoveSide(-speed);
-			if (im.IsKeyPressed(SDL_SCANCODE_D))
-				_p->_cameraSpirit.MoveSide(speed);
-		}
+		_p->HandleCameraInput();
 		im.HandleInput();
 		if (_restartApp)
 			continue;
@@ -291,55 +655,46 @@ void BaseGame::Loop(bool relativeMouseMode)
 		if (Physics::Bullet::IsValidSingleton())
 			Physics::Bullet::I().Simulate();
 
-		if (_p->_defaultCameraMovement)
-		{
-			_p->_cameraSpirit.HandleActions();
-			_p->_cameraSpirit.Update();
-			_p->_camera.MoveEyeTo(_p->_cameraSpirit.GetPosition());
-			_p->_camera.MoveAtTo(_p->_cameraSpirit.GetPosition() + _p->_cameraSpirit.GetFrontDirection());
-			if (World::Water::IsValidSingleton())
-			{
-				VERUS_QREF_WATER;
-				if (water.IsInitialized())
-					_p->_camera.ExcludeWaterLine();
-			}
-			_p->_camera.Update();
-			if (World::WorldManager::IsValidSingleton())
-				World::WorldManager::I().SetAllCameras(&_p->_camera);
-		}
-		else
+		_p->UpdateCameraSpirit();
+		_p->UpdateDefaultCamera();
+
 		{
-			if (World::WorldManager::IsValidSingleton())
-				World::WorldManager::I().SetAllCameras(nullptr);
+			VERUS_PROFILE_SCOPE("BaseGame_Update");
+			BaseGame_Update(); // Between physics and audio update.
 		}
-
-		BaseGame_Update(); // Between physics and audio update.
 		if (_restartApp)
 			continue;
 
+		if (LotManager::IsValidSingleton()) // Systems see what the game has just spawned or changed.
+			LotManager::I().Update(timer.GetDeltaTime());
+
 		if (Audio::AudioSystem::IsValidSingleton())
 			Audio::AudioSystem::I().Update();
 
-		// Draw current frame:
-		renderer.Draw();
-		renderer.EndFrame();
+		_p->ExtractRenderState();
+		_p->DrawProfiler();
 
-		// Show FPS:
-		if (_p->_showFPS && timer.IsEventEvery(500))
+		if (Physics::Bullet::IsValidSingleton()) // Step physics on it's thread, while drawing.
+			Physics::Bullet::I().StartAsyncStep();
+
+		// Draw current frame:
 		{
-			char title[40];
-			CSZ gapi = "";
-			switch (renderer->GetGapi())
-			{
-			case CGI::Gapi::vulkan:     gapi = "Vulkan"; break;
-			case CGI::Gapi::direct3D11: gapi = "Direct3D 11"; break;
-			case CGI::Gapi::direct3D12: gapi = "Direct3D 12"; break;
-			}
-			sprintf_s(title, "GAPI: %s, FPS: %.1f", gapi, renderer.GetFps());
-			SDL_SetWindowTitle(renderer.GetMainWindow()->GetSDL(), title);
+			VERUS_PROFILE_SCOPE("Renderer::Draw");
+			renderer.Draw();
+			renderer.EndFrame();
 		}
+
+		_p->ShowFPS();
+
+		_p->CountFrame();
 	} while (!quit); // The Game Loop.
 
+	if (_p->_pipelinedFrames)
+		_p->WaitForDraw();
+
+	if (settings._headless)
+		_p->LogLoopStats();
+
 	BaseGame_UnloadContent();
 
 	if (relativeMouseMode)
@@ -380,9 +735,15 @@ void BaseGame::ToggleFullscreen()
 
 World::RCamera BaseGame::GetDefaultCamera()
 {
+	VERUS_RT_ASSERT(std::this_thread::get_id() != _p->_renderThread.get_id()); // Use GetDrawCamera().
 	return _p->_camera;
 }
 
+World::RCamera BaseGame::GetDrawCamera()
+{
+	return _p->_pipelinedFrames ? _p->_drawCamera : _p->_camera;
+}
+
 RSpirit BaseGame::GetCameraSpirit()
 {
 	return _p->_cameraSpirit;
@@ -408,6 +769,61 @@ void BaseGame::ShowFPS(bool b)
 	_p->_showFPS = b;
 }
 
+void BaseGame::ShowProfiler(bool b)
+{
+	_p->_showProfiler = b;
+}
+
+void BaseGame::EnablePipelinedFrames(bool b)
+{
+	if (b)
+	{
+		if (CSZ content = _p->FindUnpipelinedContent())
+		{
+			VERUS_LOG_WARN("EnablePipelinedFrames(); Draw doesn't use a copy of " << content << ", frames are not pipelined");
+			b = false;
+		}
+	}
+	if (b)
+	{
+		_p->StartRenderThread();
+	}
+	else
+	{
+		if (_p->_pipelinedFrames)
+			_p->WaitForDraw();
+		_p->StopRenderThread();
+		if (World::WorldManager::IsValidSingleton())
+		{
+			VERUS_QREF_WM;
+			if (wm.IsRenderStatePublished())
+				wm.UnpublishRenderState();
+			if (wm.GetHeadCamera() == &_p->_drawCamera)
+				wm.SetAllCameras(&_p->_camera);
+		}
+	}
+	_p->_pipelinedFrames = b;
+}
+
+bool BaseGame::IsPipelinedFramesEnabled() const
+{
+	return _p->_pipelinedFrames;
+}
+
+void BaseGame::DeclareRenderState(RBaseRenderState state)
+{
+	if (std::find(_p->_vRenderStates.begin(), _p->_vRenderStates.end(), &state) == _p->_vRenderStates.end())
+		_p->_vRenderStates.push_back(&state);
+}
+
+void BaseGame::UndeclareRenderState(RBaseRenderState state)
+{
+	// Draw could still use it:
+	if (_p->_pipelinedFrames)
+		_p->WaitForDraw();
+	_p->_vRenderStates.erase(std::remove(_p->_vRenderStates.begin(), _p->_vRenderStates.end(), &state), _p->_vRenderStates.end());
+}
+
 void BaseGame::BulletDebugDraw()
 {
 	VERUS_QREF_BULLET;
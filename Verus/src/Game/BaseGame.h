@@ -27,6 +27,8 @@ namespace verus
 			virtual void BaseGame_UnloadContent() = 0;
 			virtual void BaseGame_EnterRequestedState() {}
 			virtual void BaseGame_Update() = 0;
+			// Called after update, before the frame is drawn. Copy render-visible state and update GPU resources here:
+			virtual void BaseGame_ExtractRenderState() {}
 			virtual void BaseGame_Draw() = 0;
 			virtual void BaseGame_DrawView(CGI::RcViewDesc viewDesc) = 0;
 			virtual void BaseGame_OnWindowMoved() {}
@@ -53,6 +55,8 @@ namespace verus
 
 			// Camera:
 			World::RCamera GetDefaultCamera();
+			// Use this in BaseGame_Draw() and BaseGame_DrawView(), with pipelined frames it's a copy made at the sync point:
+			World::RCamera GetDrawCamera();
 			RSpirit GetCameraSpirit();
 
 			// Configuration:
@@ -60,6 +64,18 @@ namespace verus
 			void EnableEscapeKeyExitGame(bool b = true);
 			void EnableRawInputEvents(bool b = true);
 			void ShowFPS(bool b);
+			// Profiler window, which can also be toggled with Alt+P, only in builds with VERUS_ENABLE_PROFILER:
+			void ShowProfiler(bool b = true);
+
+			// Pipelined frames: update of the next frame runs on the main thread, while the current frame is drawn
+			// and submitted on the render thread. BaseGame_Update() must not touch GPU resources and state, which is
+			// used by draw; such work belongs to BaseGame_ExtractRenderState(), which runs when the render thread is idle.
+			// Default camera and WorldManager's visible blocks and lights are copied for draw after it. Terrain, forest, water,
+			// atmosphere and particles are drawn from their live state, so frames, which use them, are not pipelined.
+			void EnablePipelinedFrames(bool b = true);
+			bool IsPipelinedFramesEnabled() const;
+			void DeclareRenderState(RBaseRenderState state);
+			void UndeclareRenderState(RBaseRenderState state);
 
 			void BulletDebugDraw();
 
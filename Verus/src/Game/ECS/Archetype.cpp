@@ -0,0 +1,99 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "verus.h"
+
+using namespace verus;
+using namespace verus::Game;
+
+Archetype::Archetype(UINT64 mask) :
+	_mask(mask)
+{
+	VERUS_FOR(i, Component::s_maxTypeCount)
+	{
+		_offsets[i] = -1;
+		if (mask & (1ULL << i))
+			_vComponentIDs.push_back(i);
+	}
+
+	// Each array can have up to 15 bytes of padding:
+	int rowSize = static_cast<int>(sizeof(Entity));
+	for (int id : _vComponentIDs)
+		rowSize += Component::GetInfo(id)._size;
+	const int padding = 16 * Utils::Cast32(_vComponentIDs.size());
+	_capacity = Math::Max(1, (s_chunkSize - padding) / rowSize);
+
+	int offset = static_cast<int>(sizeof(Entity)) * _capacity;
+	for (int id : _vComponentIDs)
+	{
+		Component::RcInfo info = Component::GetInfo(id);
+		offset = Math::AlignUp(offset, info._alignment);
+		_offsets[id] = offset;
+		offset += info._size * _capacity;
+	}
+	_chunkBytes = Math::Max(s_chunkSize, offset);
+}
+
+Archetype::~Archetype()
+{
+	DestroyAll();
+}
+
+void* Archetype::GetComponent(int id, int chunk, int row)
+{
+	VERUS_RT_ASSERT(_offsets[id] >= 0);
+	return _vChunks[chunk]->_pData.get() + _offsets[id] + row * Component::GetInfo(id)._size;
+}
+
+void Archetype::PushBack(Entity entity, int& chunk, int& row)
+{
+	if (_vChunks.empty() || _vChunks.back()->_count == _capacity)
+	{
+		std::unique_ptr<Chunk> pChunk(new Chunk);
+		pChunk->_pData.reset(new BYTE[_chunkBytes]);
+		_vChunks.push_back(std::move(pChunk));
+	}
+	RChunk lastChunk = *_vChunks.back();
+	chunk = GetChunkCount() - 1;
+	row = lastChunk._count++;
+	reinterpret_cast<Entity*>(lastChunk._pData.get())[row] = entity;
+	_entityCount++;
+}
+
+Entity Archetype::Erase(int chunk, int row)
+{
+	const int lastChunkIndex = GetChunkCount() - 1;
+	RChunk lastChunk = *_vChunks[lastChunkIndex];
+	const int lastRow = lastChunk._count - 1;
+
+	Entity moved;
+	if (chunk != lastChunkIndex || row != lastRow)
+	{
+		for (int id : _vComponentIDs)
+			Component::GetInfo(id)._pfnMove(GetComponent(id, chunk, row), GetComponent(id, lastChunkIndex, lastRow));
+		Entity* pEntities = reinterpret_cast<Entity*>(_vChunks[chunk]->_pData.get());
+		moved = reinterpret_cast<Entity*>(lastChunk._pData.get())[lastRow];
+		pEntities[row] = moved;
+	}
+
+	lastChunk._count--;
+	_entityCount--;
+	if (!lastChunk._count)
+		_vChunks.pop_back();
+	return moved;
+}
+
+void Archetype::DestroyComponents(int chunk, int row)
+{
+	for (int id : _vComponentIDs)
+		Component::GetInfo(id)._pfnDestroy(GetComponent(id, chunk, row));
+}
+
+void Archetype::DestroyAll()
+{
+	VERUS_FOR(chunk, GetChunkCount())
+	{
+		VERUS_FOR(row, _vChunks[chunk]->_count)
+			DestroyComponents(chunk, row);
+	}
+	_vChunks.clear();
+	_entityCount = 0;
+}
@@ -0,0 +1,71 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace Game
+	{
+		// Stores entities, which have the same set of components. Entities are packed into chunks,
+		// each chunk has an array of handles followed by one array per component type (SoA).
+		// All chunks are full except the last one, removing an entity moves the last one into its place.
+		class Archetype
+		{
+			friend class Lot;
+
+		public:
+			static const int s_chunkSize = 16 * 1024;
+
+			struct Chunk
+			{
+				std::unique_ptr<BYTE[]> _pData;
+				int                     _count = 0;
+			};
+			VERUS_TYPEDEFS(Chunk);
+
+		private:
+			Vector<std::unique_ptr<Chunk>> _vChunks;
+			Vector<int>                    _vComponentIDs;
+			int                            _offsets[Component::s_maxTypeCount]; // Offset of array in chunk or -1.
+			UINT64                         _mask = 0;
+			int                            _chunkBytes = 0;
+			int                            _capacity = 0; // Entities per chunk.
+			int                            _entityCount = 0;
+
+		public:
+			Archetype(UINT64 mask);
+			~Archetype();
+
+			UINT64 GetMask() const { return _mask; }
+			bool Has(int id) const { return _offsets[id] >= 0; }
+
+			int GetEntityCount() const { return _entityCount; }
+			int GetChunkCount() const { return Utils::Cast32(_vChunks.size()); }
+			int GetChunkCapacity() const { return _capacity; }
+			int GetChunkEntityCount(int chunk) const { return _vChunks[chunk]->_count; }
+
+			const Entity* GetEntities(int chunk) const
+			{
+				return reinterpret_cast<const Entity*>(_vChunks[chunk]->_pData.get());
+			}
+
+			// Returns nullptr if there is no such component:
+			template<typename T>
+			T* GetComponents(int chunk)
+			{
+				const int offset = _offsets[Component::GetID<T>()];
+				return (offset >= 0) ? reinterpret_cast<T*>(_vChunks[chunk]->_pData.get() + offset) : nullptr;
+			}
+
+		private:
+			void* GetComponent(int id, int chunk, int row);
+			// Adds a row for the entity, components are not constructed:
+			void PushBack(Entity entity, int& chunk, int& row);
+			// Fills the hole with the last row and returns the entity, which was moved, if any.
+			// Components must be destroyed or moved out before this call.
+			Entity Erase(int chunk, int row);
+			void DestroyComponents(int chunk, int row);
+			void DestroyAll();
+		};
+		VERUS_TYPEDEFS(Archetype);
+	}
+}
@@ -3,3 +3,58 @@
 
 using namespace verus;
 using namespace verus::Game;
+
+namespace verus
+{
+	namespace Game
+	{
+		struct ComponentRegistry
+		{
+			Component::Info _infos[Component::s_maxTypeCount];
+			std::mutex      _mutex;
+			std::atomic_int _count;
+
+			ComponentRegistry()
+			{
+				_count = 0;
+			}
+		};
+
+		static ComponentRegistry& GetComponentRegistry()
+		{
+			static ComponentRegistry registry;
+			return registry;
+		}
+	}
+}
+
+Component::RcInfo Component::GetInfo(int id)
+{
+	VERUS_RT_ASSERT(id >= 0 && id < GetTypeCount());
+	return GetComponentRegistry()._infos[id];
+}
+
+int Component::GetTypeCount()
+{
+	return GetComponentRegistry()._count;
+}
+
+int Component::CountTypes(UINT64 mask)
+{
+	int count = 0;
+	for (; mask; mask &= mask - 1)
+		count++;
+	return count;
+}
+
+int Component::Register(RcInfo info)
+{
+	ComponentRegistry& registry = GetComponentRegistry();
+	std::lock_guard<std::mutex> lock(registry._mutex);
+	const int id = registry._count;
+	if (id >= s_maxTypeCount)
+		throw VERUS_RUNTIME_ERROR << "Register(); Too many component types, " << info._name;
+	registry._infos[id] = info;
+	registry._count = id + 1;
+	return id;
+}
@@ -5,9 +5,79 @@ namespace verus
 {
 	namespace Game
 	{
+		// Any struct can be a component. Each type gets an ID, when it is used for the first time.
+		// Set of component types is a bit mask, so there can be up to 64 types.
 		class Component
 		{
+		public:
+			static const int s_maxTypeCount = 64;
+
+			typedef void(*PFNCONSTRUCT)(void* p);
+			typedef void(*PFNMOVE)(void* pDest, void* pSrc); // Constructs dest and destroys src.
+			typedef void(*PFNDESTROY)(void* p);
+
+			struct Info
+			{
+				CSZ          _name = nullptr;
+				int          _size = 0;
+				int          _alignment = 0;
+				PFNCONSTRUCT _pfnConstruct = nullptr;
+				PFNMOVE      _pfnMove = nullptr;
+				PFNDESTROY   _pfnDestroy = nullptr;
+			};
+			VERUS_TYPEDEFS(Info);
+
+			template<typename T>
+			static int GetID()
+			{
+				return GetTypeID<std::remove_cv_t<T>>();
+			}
+
+			template<typename... Ts>
+			static UINT64 GetMask()
+			{
+				const int ids[] = { -1, GetID<Ts>()... };
+				UINT64 mask = 0;
+				for (int id : ids)
+				{
+					if (id >= 0)
+						mask |= 1ULL << id;
+				}
+				return mask;
+			}
+
+			static RcInfo GetInfo(int id);
+			static int GetTypeCount();
+			static int CountTypes(UINT64 mask);
+
+		private:
+			template<typename T>
+			static int GetTypeID()
+			{
+				static const int id = Register(Describe<T>());
+				return id;
+			}
+
+			template<typename T>
+			static Info Describe()
+			{
+				static_assert(alignof(T) <= 16, "Component alignment is too big");
+				Info info;
+				info._name = typeid(T).name();
+				info._size = sizeof(T);
+				info._alignment = alignof(T);
+				info._pfnConstruct = [](void* p) { new(p) T(); };
+				info._pfnMove = [](void* pDest, void* pSrc)
+				{
+					T* pT = static_cast<T*>(pSrc);
+					new(pDest) T(std::move(*pT));
+					pT->~T();
+				};
+				info._pfnDestroy = [](void* p) { static_cast<T*>(p)->~T(); };
+				return info;
+			}
+
+			static int Register(RcInfo info);
 		};
-		VERUS_TYPEDEFS(Component);
 	}
 }
@@ -5,19 +5,23 @@ namespace verus
 {
 	namespace Game
 	{
-		class Entity : public Object
+		// Handle of an entity in a Lot. Index can be reused, generation tells if it still refers to the same entity.
+		class Entity
 		{
-			int _refCount = 0;
+			UINT32 _index = UINT32_MAX;
+			UINT32 _generation = 0;
 
 		public:
-			Entity();
-			~Entity();
+			Entity() {}
+			Entity(UINT32 index, UINT32 generation) : _index(index), _generation(generation) {}
 
-			void Init();
-			bool Done();
+			UINT32 GetIndex() const { return _index; }
+			UINT32 GetGeneration() const { return _generation; }
 
-			void AddRef() { _refCount++; }
-			int GetRefCount() const { return _refCount; }
+			bool IsSet() const { return UINT32_MAX != _index; }
+
+			bool operator==(const Entity& that) const { return _index == that._index && _generation == that._generation; }
+			bool operator!=(const Entity& that) const { return !(*this == that); }
 		};
 		VERUS_TYPEDEFS(Entity);
 	}
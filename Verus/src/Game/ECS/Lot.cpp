@@ -4,8 +4,21 @@
 using namespace verus;
 using namespace verus::Game;
 
+// Query:
+
+int Query::GetEntityCount() const
+{
+	int count = 0;
+	for (PArchetype pArchetype : _vArchetypes)
+		count += pArchetype->GetEntityCount();
+	return count;
+}
+
+// Lot:
+
 Lot::Lot()
 {
+	_iterationCount = 0;
 }
 
 Lot::~Lot()
@@ -33,22 +46,166 @@ bool Lot::Done()
 	return false;
 }
 
-PEntity Lot::InsertEntity(CSZ uid)
+void Lot::DestroyEntity(Entity entity)
 {
-	return TStoreEntities::Insert(uid);
+	VERUS_RT_ASSERT(!_iterationCount);
+	if (!IsAlive(entity))
+		return;
+
+	RRecord record = _vRecords[entity.GetIndex()];
+	PArchetype pArchetype = record._pArchetype;
+	const int chunk = record._chunk;
+	const int row = record._row;
+	pArchetype->DestroyComponents(chunk, row);
+	OnErased(pArchetype->Erase(chunk, row), chunk, row);
+
+	record._pArchetype = nullptr;
+	record._generation++;
+	_vFreeIndices.push_back(entity.GetIndex());
 }
 
-PEntity Lot::FindEntity(CSZ uid)
+void Lot::DeleteAllEntities()
 {
-	return TStoreEntities::Find(uid);
+	VERUS_RT_ASSERT(!_iterationCount);
+	for (auto& pArchetype : _vArchetypes)
+		pArchetype->DestroyAll();
+	_vFreeIndices.clear();
+	const int count = Utils::Cast32(_vRecords.size());
+	VERUS_FOR(i, count)
+	{
+		RRecord record = _vRecords[i];
+		if (record._pArchetype)
+		{
+			record._pArchetype = nullptr;
+			record._generation++;
+		}
+		_vFreeIndices.push_back(i);
+	}
+	_vDeferred.clear();
 }
 
-void Lot::DeleteEntity(CSZ uid)
+bool Lot::IsAlive(Entity entity) const
 {
-	TStoreEntities::Delete(uid);
+	if (entity.GetIndex() >= _vRecords.size())
+		return false;
+	RcRecord record = _vRecords[entity.GetIndex()];
+	return record._pArchetype && record._generation == entity.GetGeneration();
 }
 
-void Lot::DeleteAllEntities()
+int Lot::GetEntityCount() const
+{
+	return Utils::Cast32(_vRecords.size() - _vFreeIndices.size());
+}
+
+RQuery Lot::GetQuery(UINT64 all, UINT64 none)
+{
+	std::lock_guard<std::mutex> lock(_mutexQueries);
+	for (auto& pQuery : _vQueries)
+	{
+		if (pQuery->_all == all && pQuery->_none == none)
+			return *pQuery;
+	}
+
+	std::unique_ptr<Query> pQuery(new Query(all, none));
+	for (auto& pArchetype : _vArchetypes)
+	{
+		if (pQuery->Matches(pArchetype->GetMask()))
+			pQuery->_vArchetypes.push_back(pArchetype.get());
+	}
+	_vQueries.push_back(std::move(pQuery));
+	return *_vQueries.back();
+}
+
+void Lot::Defer(TDeferredFunc func)
+{
+	std::lock_guard<std::mutex> lock(_mutexDeferred);
+	_vDeferred.push_back(std::move(func));
+}
+
+void Lot::ApplyDeferred()
+{
+	VERUS_RT_ASSERT(!_iterationCount);
+	Vector<TDeferredFunc> vDeferred;
+	{
+		std::lock_guard<std::mutex> lock(_mutexDeferred);
+		vDeferred.swap(_vDeferred);
+	}
+	for (auto& func : vDeferred)
+		func(*this);
+}
+
+RArchetype Lot::FindOrCreateArchetype(UINT64 mask)
+{
+	auto it = _mapArchetypes.find(mask);
+	if (it != _mapArchetypes.end())
+		return *it->second;
+
+	_vArchetypes.push_back(std::unique_ptr<Archetype>(new Archetype(mask)));
+	PArchetype pArchetype = _vArchetypes.back().get();
+	_mapArchetypes[mask] = pArchetype;
+
+	std::lock_guard<std::mutex> lock(_mutexQueries);
+	for (auto& pQuery : _vQueries)
+	{
+		if (pQuery->Matches(mask))
+			pQuery->_vArchetypes.push_back(pArchetype);
+	}
+	return *pArchetype;
+}
+
+Entity Lot::AllocateEntity(UINT64 mask)
 {
-	TStoreEntities::DeleteAll();
+	VERUS_RT_ASSERT(!_iterationCount);
+	UINT32 index;
+	if (_vFreeIndices.empty())
+	{
+		index = Utils::Cast32(_vRecords.size());
+		_vRecords.resize(index + 1);
+	}
+	else
+	{
+		index = _vFreeIndices.back();
+		_vFreeIndices.pop_back();
+	}
+
+	RRecord record = _vRecords[index];
+	const Entity entity(index, record._generation);
+	record._pArchetype = &FindOrCreateArchetype(mask);
+	record._pArchetype->PushBack(entity, record._chunk, record._row);
+	return entity;
+}
+
+void Lot::ChangeArchetype(Entity entity, UINT64 mask)
+{
+	VERUS_RT_ASSERT(!_iterationCount);
+	RRecord record = _vRecords[entity.GetIndex()];
+	PArchetype pFrom = record._pArchetype;
+	const int chunk = record._chunk;
+	const int row = record._row;
+	RArchetype to = FindOrCreateArchetype(mask);
+
+	int newChunk = 0, newRow = 0;
+	to.PushBack(entity, newChunk, newRow);
+	for (int id : pFrom->_vComponentIDs)
+	{
+		void* pSrc = pFrom->GetComponent(id, chunk, row);
+		if (to.Has(id))
+			Component::GetInfo(id)._pfnMove(to.GetComponent(id, newChunk, newRow), pSrc);
+		else
+			Component::GetInfo(id)._pfnDestroy(pSrc);
+	}
+	OnErased(pFrom->Erase(chunk, row), chunk, row);
+
+	record._pArchetype = &to;
+	record._chunk = newChunk;
+	record._row = newRow;
+}
+
+void Lot::OnErased(Entity moved, int chunk, int row)
+{
+	if (!moved.IsSet())
+		return;
+	RRecord record = _vRecords[moved.GetIndex()];
+	record._chunk = chunk;
+	record._row = row;
 }
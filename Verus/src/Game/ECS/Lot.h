@@ -5,10 +5,53 @@ namespace verus
 {
 	namespace Game
 	{
-		typedef StoreUnique<String, Entity> TStoreEntities;
-		class Lot : public Object, private TStoreEntities
+		// List of archetypes, which have all required components and none of excluded ones.
+		// Lot keeps it up to date, when new archetypes are created.
+		class Query
 		{
-			int _refCount = 0;
+			friend class Lot;
+
+			Vector<PArchetype> _vArchetypes;
+			UINT64             _all = 0;
+			UINT64             _none = 0;
+
+		public:
+			Query(UINT64 all, UINT64 none) : _all(all), _none(none) {}
+
+			bool Matches(UINT64 mask) const { return (mask & _all) == _all && !(mask & _none); }
+			const Vector<PArchetype>& GetArchetypes() const { return _vArchetypes; }
+			int GetEntityCount() const;
+		};
+		VERUS_TYPEDEFS(Query);
+
+		// Set of entities, for example a level. Entities are grouped by archetype.
+		// Structural changes (create, destroy, add or remove component) are not allowed during iteration,
+		// systems, which run in parallel, should use Defer() for them.
+		class Lot : public Object
+		{
+		public:
+			typedef std::function<void(Lot&)> TDeferredFunc;
+
+		private:
+			struct Record
+			{
+				PArchetype _pArchetype = nullptr;
+				int        _chunk = 0;
+				int        _row = 0;
+				UINT32     _generation = 0;
+			};
+			VERUS_TYPEDEFS(Record);
+
+			Vector<Record>                     _vRecords;
+			Vector<UINT32>                     _vFreeIndices;
+			Vector<std::unique_ptr<Archetype>> _vArchetypes;
+			HashMap<UINT64, PArchetype>        _mapArchetypes;
+			Vector<std::unique_ptr<Query>>     _vQueries;
+			Vector<TDeferredFunc>              _vDeferred;
+			std::mutex                         _mutexQueries;
+			std::mutex                         _mutexDeferred;
+			std::atomic_int                    _iterationCount;
+			int                                _refCount = 0;
 
 		public:
 			Lot();
@@ -20,21 +63,167 @@ namespace verus
 			void AddRef() { _refCount++; }
 			int GetRefCount() const { return _refCount; }
 
-			// Entities:
-			PEntity InsertEntity(CSZ uid);
-			PEntity FindEntity(CSZ uid);
-			void DeleteEntity(CSZ uid);
+			// <Entities>
+			template<typename... Ts>
+			Entity CreateEntity(Ts&&... components)
+			{
+				const UINT64 mask = Component::GetMask<std::decay_t<Ts>...>();
+				VERUS_RT_ASSERT(Component::CountTypes(mask) == static_cast<int>(sizeof...(Ts))); // No duplicates.
+				const Entity entity = AllocateEntity(mask);
+				ConstructComponents(_vRecords[entity.GetIndex()], std::forward<Ts>(components)...);
+				return entity;
+			}
+			void DestroyEntity(Entity entity);
 			void DeleteAllEntities();
+			bool IsAlive(Entity entity) const;
+			int GetEntityCount() const;
+			// </Entities>
+
+			// <Components>
+			// Returns nullptr if the entity is dead or doesn't have such component:
+			template<typename T>
+			T* Get(Entity entity)
+			{
+				if (!IsAlive(entity))
+					return nullptr;
+				RcRecord record = _vRecords[entity.GetIndex()];
+				const int id = Component::GetID<T>();
+				if (!record._pArchetype->Has(id))
+					return nullptr;
+				return static_cast<T*>(record._pArchetype->GetComponent(id, record._chunk, record._row));
+			}
+
+			template<typename T>
+			bool Has(Entity entity) const
+			{
+				return IsAlive(entity) && _vRecords[entity.GetIndex()]._pArchetype->Has(Component::GetID<T>());
+			}
+
+			// Moves the entity to another archetype. Existing component is replaced:
+			template<typename T>
+			T& AddComponent(Entity entity, T component = T())
+			{
+				VERUS_RT_ASSERT(IsAlive(entity));
+				const int id = Component::GetID<T>();
+				if (!Has<T>(entity))
+				{
+					ChangeArchetype(entity, _vRecords[entity.GetIndex()]._pArchetype->GetMask() | (1ULL << id));
+					RcRecord record = _vRecords[entity.GetIndex()];
+					return *new(record._pArchetype->GetComponent(id, record._chunk, record._row)) T(std::move(component));
+				}
+				T& existing = *Get<T>(entity);
+				existing = std::move(component);
+				return existing;
+			}
+
 			template<typename T>
-			void ForEachEntity(const T& fn)
+			void RemoveComponent(Entity entity)
 			{
-				VERUS_FOREACH_X(TStoreEntities::TMap, TStoreEntities::_map, it)
+				if (!Has<T>(entity))
+					return;
+				ChangeArchetype(entity, _vRecords[entity.GetIndex()]._pArchetype->GetMask() & ~(1ULL << Component::GetID<T>()));
+			}
+			// </Components>
+
+			// <Queries>
+			// Query is cached and stays valid until the lot is destroyed:
+			RQuery GetQuery(UINT64 all, UINT64 none = 0);
+
+			// Calls func(Entity, Ts&...) for each entity, which has all listed components.
+			// Use const types for components, which are only read:
+			template<typename... Ts, typename TFunc>
+			void ForEach(TFunc func, UINT64 none = 0)
+			{
+				ForEachChunk<Ts...>([&func](int count, const Entity* pEntities, Ts*... p)
+					{
+						ForEachInChunk(func, count, pEntities, p...);
+					}, none);
+			}
+
+			// Calls func(count, const Entity*, Ts*...) for each chunk, arrays can be processed with SIMD:
+			template<typename... Ts, typename TFunc>
+			void ForEachChunk(TFunc func, UINT64 none = 0)
+			{
+				RcQuery query = GetQuery(Component::GetMask<Ts...>(), none);
+				IterationScope scope(*this);
+				for (PArchetype pArchetype : query.GetArchetypes())
+				{
+					VERUS_FOR(chunk, pArchetype->GetChunkCount())
+					{
+						func(pArchetype->GetChunkEntityCount(chunk), pArchetype->GetEntities(chunk),
+							pArchetype->template GetComponents<Ts>(chunk)...);
+					}
+				}
+			}
+
+			// Same as ForEach, but chunks are split between Jobs. Func must be thread-safe:
+			template<typename... Ts, typename TFunc>
+			void ParallelForEach(TFunc func, UINT64 none = 0)
+			{
+				RcQuery query = GetQuery(Component::GetMask<Ts...>(), none);
+				Vector<std::pair<PArchetype, int>> vChunks;
+				for (PArchetype pArchetype : query.GetArchetypes())
+				{
+					VERUS_FOR(chunk, pArchetype->GetChunkCount())
+						vChunks.push_back(std::make_pair(pArchetype, chunk));
+				}
+				IterationScope scope(*this);
+				auto ProcessChunk = [&vChunks, &func](int i)
 				{
-					auto& entity = *it++;
-					if (Continue::no == fn(entity.second))
-						return;
+					PArchetype pArchetype = vChunks[i].first;
+					const int chunk = vChunks[i].second;
+					ForEachInChunk(func, pArchetype->GetChunkEntityCount(chunk), pArchetype->GetEntities(chunk),
+						pArchetype->template GetComponents<Ts>(chunk)...);
+				};
+				const int count = Utils::Cast32(vChunks.size());
+				if (Jobs::IsValidSingleton() && Jobs::I().IsInitialized())
+				{
+					Jobs::I().ParallelFor(0, count, ProcessChunk);
+				}
+				else
+				{
+					VERUS_FOR(i, count)
+						ProcessChunk(i);
 				}
 			}
+			// </Queries>
+
+			// <Deferred>
+			// Thread-safe, changes are applied in order by ApplyDeferred():
+			void Defer(TDeferredFunc func);
+			void ApplyDeferred();
+			// </Deferred>
+
+		private:
+			class IterationScope
+			{
+				Lot& _lot;
+
+			public:
+				IterationScope(Lot& lot) : _lot(lot) { _lot._iterationCount++; }
+				~IterationScope() { _lot._iterationCount--; }
+			};
+
+			template<typename T, typename... Ts>
+			static void ConstructComponents(RcRecord record, T&& component, Ts&&... components)
+			{
+				typedef std::decay_t<T> TT;
+				new(record._pArchetype->GetComponent(Component::GetID<TT>(), record._chunk, record._row)) TT(std::forward<T>(component));
+				ConstructComponents(record, std::forward<Ts>(components)...);
+			}
+			static void ConstructComponents(RcRecord record) {}
+
+			template<typename TFunc, typename... Ts>
+			static void ForEachInChunk(TFunc& func, int count, const Entity* pEntities, Ts*... p)
+			{
+				VERUS_FOR(i, count)
+					func(pEntities[i], p[i]...);
+			}
+
+			RArchetype FindOrCreateArchetype(UINT64 mask);
+			Entity AllocateEntity(UINT64 mask);
+			void ChangeArchetype(Entity entity, UINT64 mask);
+			void OnErased(Entity moved, int chunk, int row);
 		};
 		VERUS_TYPEDEFS(Lot);
 	}
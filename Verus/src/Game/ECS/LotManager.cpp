@@ -42,3 +42,336 @@ void LotManager::DeleteAllLots()
 {
 	TStoreLots::DeleteAll();
 }
+
+void LotManager::AddSystem(PBaseSystem pSystem)
+{
+	VERUS_RT_ASSERT(std::find(_vSystems.begin(), _vSystems.end(), pSystem) == _vSystems.end());
+	_vSystems.push_back(pSystem);
+	_phasesValid = false;
+}
+
+void LotManager::RemoveSystem(PBaseSystem pSystem)
+{
+	_vSystems.erase(std::remove(_vSystems.begin(), _vSystems.end(), pSystem), _vSystems.end());
+	_phasesValid = false;
+}
+
+const LotManager::TPhases& LotManager::GetPhases()
+{
+	if (!_phasesValid)
+	{
+		BuildPhases(_vSystems, _phases);
+		_phasesValid = true;
+	}
+	return _phases;
+}
+
+void LotManager::Update(float dt)
+{
+	VERUS_PROFILE_SCOPE("LotManager::Update");
+	const TPhases& phases = GetPhases();
+	ForEachLot([&phases, dt](RLot lot)
+		{
+			RunPhases(phases, lot, dt);
+			return Continue::yes;
+		});
+}
+
+void LotManager::BuildPhases(const Vector<PBaseSystem>& vSystems, TPhases& phases)
+{
+	// Each system goes to the first phase after all earlier systems, which it conflicts with:
+	phases.clear();
+	Vector<int> vPhaseOf(vSystems.size());
+	const int count = Utils::Cast32(vSystems.size());
+	VERUS_FOR(i, count)
+	{
+		int phase = 0;
+		VERUS_FOR(j, i)
+		{
+			if (vSystems[i]->ConflictsWith(*vSystems[j]))
+				phase = Math::Max(phase, vPhaseOf[j] + 1);
+		}
+		vPhaseOf[i] = phase;
+		if (phase >= static_cast<int>(phases.size()))
+			phases.resize(phase + 1);
+		phases[phase].push_back(vSystems[i]);
+	}
+}
+
+void LotManager::RunPhases(const TPhases& phases, RLot lot, float dt)
+{
+	const bool parallel = Jobs::IsValidSingleton() && Jobs::I().IsInitialized();
+	for (const auto& vPhase : phases)
+	{
+		if (!parallel || vPhase.size() <= 1)
+		{
+			for (PBaseSystem pSystem : vPhase)
+				pSystem->BaseSystem_Update(lot, dt);
+			continue;
+		}
+
+		RJobs jobs = Jobs::I();
+		JobCounter counter;
+		const int count = Utils::Cast32(vPhase.size());
+		for (int i = 1; i < count; ++i)
+		{
+			PBaseSystem pSystem = vPhase[i];
+			jobs.Run([pSystem, &lot, dt]()
+				{
+					pSystem->BaseSystem_Update(lot, dt);
+				}, counter);
+		}
+		try
+		{
+			vPhase.front()->BaseSystem_Update(lot, dt);
+		}
+		catch (...)
+		{
+			jobs.Wait(counter); // Jobs use this lot, stop them before leaving.
+			throw;
+		}
+		jobs.Wait(counter);
+	}
+	lot.ApplyDeferred();
+}
+
+namespace
+{
+	struct TestPosition
+	{
+		glm::vec3 _v;
+	};
+
+	struct TestVelocity
+	{
+		glm::vec3 _v;
+	};
+
+	struct TestLifetime
+	{
+		float _time = 0;
+	};
+
+	struct TestName
+	{
+		String _s;
+	};
+
+	class TestMoveSystem : public BaseSystem
+	{
+	public:
+		TestMoveSystem() : BaseSystem("TestMove")
+		{
+			Reads<TestVelocity>();
+			Writes<TestPosition>();
+		}
+
+		virtual void BaseSystem_Update(Lot& lot, float dt) override
+		{
+			lot.ParallelForEach<TestPosition, const TestVelocity>([dt](Entity, TestPosition& pos, const TestVelocity& vel)
+				{
+					pos._v += vel._v * dt;
+				});
+		}
+	};
+
+	class TestAgeSystem : public BaseSystem
+	{
+	public:
+		TestAgeSystem() : BaseSystem("TestAge")
+		{
+			Writes<TestLifetime>();
+		}
+
+		virtual void BaseSystem_Update(Lot& lot, float dt) override
+		{
+			lot.ForEach<TestLifetime>([&lot, dt](Entity entity, TestLifetime& lifetime)
+				{
+					lifetime._time -= dt;
+					if (lifetime._time <= 0)
+						lot.Defer([entity](Lot& lot) { lot.DestroyEntity(entity); });
+				});
+		}
+	};
+
+	class TestReadPositionSystem : public BaseSystem
+	{
+	public:
+		float _sum = 0;
+
+		TestReadPositionSystem() : BaseSystem("TestReadPosition")
+		{
+			Reads<TestPosition>();
+		}
+
+		virtual void BaseSystem_Update(Lot& lot, float dt) override
+		{
+			_sum = 0;
+			lot.ForEach<const TestPosition>([this](Entity, const TestPosition& pos)
+				{
+					_sum += pos._v.x;
+				});
+		}
+	};
+}
+
+void LotManager::Test()
+{
+	Lot lot;
+	lot.Init();
+
+	// Create, get and destroy:
+	const int count = 1000; // Several chunks.
+	Vector<Entity> vEntities;
+	VERUS_FOR(i, count)
+	{
+		const float x = static_cast<float>(i);
+		if (i & 0x1)
+			vEntities.push_back(lot.CreateEntity(TestPosition{ glm::vec3(x, 0, 0) }, TestVelocity{ glm::vec3(1, 0, 0) }));
+		else
+			vEntities.push_back(lot.CreateEntity(TestPosition{ glm::vec3(x, 0, 0) }));
+	}
+	VERUS_RT_ASSERT(lot.GetEntityCount() == count);
+	VERUS_RT_ASSERT(lot.GetQuery(Component::GetMask<TestPosition>()).GetEntityCount() == count);
+	VERUS_RT_ASSERT(lot.GetQuery(Component::GetMask<TestPosition>(), Component::GetMask<TestVelocity>()).GetEntityCount() == count / 2);
+
+	// Removing from the middle moves the last entity, handles must still work:
+	for (int i = 0; i < count; i += 3)
+		lot.DestroyEntity(vEntities[i]);
+	VERUS_FOR(i, count)
+	{
+		if (i % 3)
+		{
+			VERUS_RT_ASSERT(lot.IsAlive(vEntities[i]));
+			VERUS_RT_ASSERT(lot.Get<TestPosition>(vEntities[i])->_v.x == static_cast<float>(i));
+			VERUS_RT_ASSERT(lot.Has<TestVelocity>(vEntities[i]) == !!(i & 0x1));
+		}
+		else
+		{
+			VERUS_RT_ASSERT(!lot.IsAlive(vEntities[i]));
+			VERUS_RT_ASSERT(!lot.Get<TestPosition>(vEntities[i]));
+		}
+	}
+
+	// Reused index gets new generation:
+	const Entity reused = lot.CreateEntity(TestLifetime());
+	VERUS_RT_ASSERT(lot.IsAlive(reused));
+	VERUS_RT_ASSERT(std::find(vEntities.begin(), vEntities.end(), reused) == vEntities.end());
+	lot.DestroyEntity(reused);
+
+	// Adding and removing components keeps values:
+	const Entity entity = vEntities[1];
+	lot.AddComponent(entity, TestName{ "Name" });
+	lot.AddComponent(entity, TestLifetime{ 5 });
+	VERUS_RT_ASSERT(lot.Get<TestName>(entity)->_s == "Name");
+	VERUS_RT_ASSERT(lot.Get<TestPosition>(entity)->_v.x == 1);
+	lot.RemoveComponent<TestVelocity>(entity);
+	VERUS_RT_ASSERT(!lot.Has<TestVelocity>(entity));
+	VERUS_RT_ASSERT(lot.Get<TestName>(entity)->_s == "Name");
+	VERUS_RT_ASSERT(lot.Get<TestLifetime>(entity)->_time == 5);
+
+	// Phases follow conflicts:
+	TestMoveSystem moveSystem;
+	TestAgeSystem ageSystem;
+	TestReadPositionSystem readSystem;
+	Vector<PBaseSystem> vSystems;
+	vSystems.push_back(&moveSystem);
+	vSystems.push_back(&ageSystem);
+	vSystems.push_back(&readSystem);
+	TPhases phases;
+	BuildPhases(vSystems, phases);
+	VERUS_RT_ASSERT(phases.size() == 2);
+	VERUS_RT_ASSERT(phases[0].size() == 2 && phases[0][0] == &moveSystem && phases[0][1] == &ageSystem);
+	VERUS_RT_ASSERT(phases[1].size() == 1 && phases[1][0] == &readSystem);
+
+	// Deferred destruction is applied after all phases:
+	const int aliveCount = lot.GetEntityCount();
+	RunPhases(phases, lot, 1);
+	VERUS_RT_ASSERT(lot.GetEntityCount() == aliveCount);
+	VERUS_RT_ASSERT(lot.Get<TestPosition>(vEntities[5])->_v.x == 6);
+	RunPhases(phases, lot, 4);
+	VERUS_RT_ASSERT(lot.GetEntityCount() == aliveCount - 1);
+	VERUS_RT_ASSERT(!lot.IsAlive(entity));
+
+	lot.Done();
+}
+
+void LotManager::Benchmark()
+{
+	const int count = 100000;
+	const int frameCount = 100;
+	const float dt = 1 / 60.f;
+
+	auto Measure = [frameCount](std::function<void()> func)
+	{
+		return Utils::MeasureBestTime([frameCount, &func]()
+			{
+				VERUS_FOR(i, frameCount)
+					func();
+			}) / frameCount;
+	};
+
+	// Entities with components:
+	Lot lot;
+	lot.Init();
+	VERUS_FOR(i, count)
+	{
+		const glm::vec3 v(static_cast<float>(i % 7), 0, static_cast<float>(i % 5));
+		if (i & 0x1)
+			lot.CreateEntity(TestPosition{ glm::vec3(0) }, TestVelocity{ v }, TestLifetime{ 1e6f });
+		else
+			lot.CreateEntity(TestPosition{ glm::vec3(0) }, TestVelocity{ v });
+	}
+	TestMoveSystem moveSystem;
+	TestAgeSystem ageSystem;
+	TestReadPositionSystem readSystem;
+	Vector<PBaseSystem> vSystems;
+	vSystems.push_back(&moveSystem);
+	vSystems.push_back(&ageSystem);
+	vSystems.push_back(&readSystem);
+	TPhases phases;
+	BuildPhases(vSystems, phases);
+	const double ecsMs = Measure([&phases, &lot, dt]() { RunPhases(phases, lot, dt); });
+	lot.Done();
+
+	// Objects with virtual update:
+	class BaseObject
+	{
+	public:
+		glm::vec3 _pos;
+		glm::vec3 _vel;
+
+		virtual ~BaseObject() {}
+		virtual void Update(float dt) { _pos += _vel * dt; }
+	};
+	class MortalObject : public BaseObject
+	{
+	public:
+		float _time = 1e6f;
+
+		virtual void Update(float dt) override
+		{
+			BaseObject::Update(dt);
+			_time -= dt;
+		}
+	};
+	Vector<std::unique_ptr<BaseObject>> vObjects;
+	vObjects.reserve(count);
+	VERUS_FOR(i, count)
+	{
+		vObjects.push_back(std::unique_ptr<BaseObject>((i & 0x1) ? new MortalObject : new BaseObject));
+		vObjects.back()->_pos = glm::vec3(0);
+		vObjects.back()->_vel = glm::vec3(static_cast<float>(i % 7), 0, static_cast<float>(i % 5));
+	}
+	float sum = 0;
+	const double objectsMs = Measure([&vObjects, &sum, dt]()
+		{
+			for (auto& pObject : vObjects)
+				pObject->Update(dt);
+			sum = 0;
+			for (auto& pObject : vObjects)
+				sum += pObject->_pos.x;
+		});
+
+	VERUS_LOG_INFO("Benchmark(); " << count << " entities, ECS: " << ecsMs << " ms, objects: " << objectsMs << " ms (" << sum << ")");
+}
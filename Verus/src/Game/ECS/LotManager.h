@@ -8,6 +8,15 @@ namespace verus
 		typedef StoreUnique<String, Lot> TStoreLots;
 		class LotManager : public Singleton<LotManager>, public Object, private TStoreLots
 		{
+		public:
+			// Systems in one phase don't conflict and run in parallel, phases run one after another:
+			typedef Vector<Vector<PBaseSystem>> TPhases;
+
+		private:
+			Vector<PBaseSystem> _vSystems;
+			TPhases             _phases;
+			bool                _phasesValid = false;
+
 		public:
 			LotManager();
 			virtual ~LotManager();
@@ -30,6 +39,21 @@ namespace verus
 						return;
 				}
 			}
+
+			// Systems are not owned, conflicting systems run in the order of adding:
+			void AddSystem(PBaseSystem pSystem);
+			void RemoveSystem(PBaseSystem pSystem);
+			const TPhases& GetPhases();
+
+			// Runs systems for each lot, then applies deferred changes:
+			void Update(float dt);
+
+			static void BuildPhases(const Vector<PBaseSystem>& vSystems, TPhases& phases);
+			static void RunPhases(const TPhases& phases, RLot lot, float dt);
+
+			static void Test();
+			// Updates 100k entities per frame and compares with virtual method per object, results are written to log:
+			static void Benchmark();
 		};
 		VERUS_TYPEDEFS(LotManager);
 	}
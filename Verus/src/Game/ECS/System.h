@@ -0,0 +1,41 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace Game
+	{
+		// Logic, which runs for each lot. Components, which are read or written, must be declared
+		// in the constructor, so that LotManager can run systems, which don't conflict, in parallel.
+		class BaseSystem
+		{
+			CSZ    _name = nullptr;
+			UINT64 _readMask = 0;
+			UINT64 _writeMask = 0;
+
+		public:
+			BaseSystem(CSZ name) : _name(name) {}
+			virtual ~BaseSystem() {}
+
+			CSZ GetName() const { return _name; }
+			UINT64 GetReadMask() const { return _readMask; }
+			UINT64 GetWriteMask() const { return _writeMask; }
+
+			// Systems conflict if one of them writes what the other one reads or writes:
+			bool ConflictsWith(const BaseSystem& that) const
+			{
+				return (_writeMask & (that._readMask | that._writeMask)) || (that._writeMask & _readMask);
+			}
+
+			// Structural changes must go through Lot::Defer():
+			virtual void BaseSystem_Update(Lot& lot, float dt) = 0;
+
+		protected:
+			template<typename... Ts>
+			void Reads() { _readMask |= Component::GetMask<Ts...>(); }
+			template<typename... Ts>
+			void Writes() { _writeMask |= Component::GetMask<Ts...>(); }
+		};
+		VERUS_TYPEDEFS(BaseSystem);
+	}
+}
@@ -0,0 +1,14 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "verus.h"
+
+namespace verus
+{
+	void Make_Game()
+	{
+		Game::LotManager::Make();
+	}
+	void Free_Game()
+	{
+		Game::LotManager::Free();
+	}
+}
@@ -4,15 +4,24 @@
 #include "State.h"
 #include "StateMachine.h"
 #include "Spirit.h"
+#include "RenderState.h"
 #include "BaseCharacter.h"
 #include "BaseGame.h"
 #include "ChainAward.h"
 #include "ECS/Component.h"
 #include "ECS/Entity.h"
+#include "ECS/Archetype.h"
 #include "ECS/Lot.h"
+#include "ECS/System.h"
 #include "ECS/LotManager.h"
 #include "Mechanics/Mechanics.h"
 #include "Mechanics/ActiveMechanics.h"
 #include "Mechanics/Driving.h"
 #include "Mechanics/Cutscene.h"
 #include "QuestSystem.h"
+
+namespace verus
+{
+	void Make_Game();
+	void Free_Game();
+}
@@ -0,0 +1,38 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace Game
+	{
+		// State, which is written by update and read by draw. It must be declared using BaseGame::DeclareRenderState().
+		// BaseGame publishes all declared states at the sync point, after BaseGame_ExtractRenderState().
+		class BaseRenderState
+		{
+		public:
+			virtual void BaseRenderState_Publish() = 0;
+		};
+		VERUS_TYPEDEFS(BaseRenderState);
+
+		// With pipelined frames update of the next frame runs, while the current frame is drawn,
+		// so draw gets its own copy of the value.
+		template<typename T>
+		class RenderState : public BaseRenderState
+		{
+			T _update;
+			T _draw;
+
+		public:
+			RenderState() {}
+			RenderState(const T& value) : _update(value), _draw(value) {}
+
+			// Use this in BaseGame_Update():
+			T& GetForUpdate() { return _update; }
+			const T& GetForUpdate() const { return _update; }
+			// Use this in BaseGame_Draw() and BaseGame_DrawView():
+			const T& GetForDraw() const { return _draw; }
+
+			virtual void BaseRenderState_Publish() override { _draw = _update; }
+		};
+	}
+}
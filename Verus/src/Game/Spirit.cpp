@@ -179,6 +179,21 @@ bool Spirit::FitRemotePosition()
 	return warp;
 }
 
+void Spirit::SetRemoteState(RcPoint3 pos, RcVector3 velocity, float pitch, float yaw)
+{
+	_prevPosition = _position;
+	_smoothPrevPosition = _smoothPosition;
+	_position = pos;
+	_remotePosition = pos;
+	_smoothPosition.ForceTarget(pos);
+	SetVelocity(velocity);
+	SetPitch(pitch);
+	SetYaw(yaw);
+	_pitch.ForceTarget();
+	_yaw.ForceTarget();
+	ComputeDerivedVars();
+}
+
 void Spirit::Rotate(RcVector3 front, float speed)
 {
 	VERUS_QREF_TIMER;
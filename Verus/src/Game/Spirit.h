@@ -77,6 +77,8 @@ namespace verus
 			virtual void MoveTo(RcPoint3 pos);
 			void         SetRemotePosition(RcPoint3 pos);
 			virtual bool FitRemotePosition();
+			// State, which is already smooth, like the one from Net::SnapshotClient:
+			void         SetRemoteState(RcPoint3 pos, RcVector3 velocity, float pitch, float yaw);
 
 			RcVector3 GetVelocity() const { return _avgVelocity; }
 			void      SetVelocity(RcVector3 v) { _avgVelocity = _endVelocity = v; }
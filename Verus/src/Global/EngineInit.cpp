@@ -27,11 +27,15 @@ void EngineInit::Make()
 		Make_World();
 	if (_makeGUI)
 		Make_GUI();
+	if (_makeGame)
+		Make_Game();
 }
 
 void EngineInit::Free()
 {
 	// Some object must outlive others, so the order is important:
+	if (_makeGame)
+		Free_Game();
 	if (_makeGUI)
 		Free_GUI();
 	if (_makeWorld)
@@ -60,6 +64,9 @@ void EngineInit::Init(CGI::RendererDelegate* pRendererDelegate)
 {
 	Timer::I().Init();
 
+	if (_makeGlobal)
+		Jobs::I().Init();
+
 	if (_makeIO)
 		IO::Async::I().Init();
 
@@ -112,6 +119,9 @@ void EngineInit::Init(CGI::RendererDelegate* pRendererDelegate)
 
 	if (_makeGUI)
 		GUI::ViewManager::I().Init();
+
+	if (_makeGame)
+		Game::LotManager::I().Init();
 }
 
 void EngineInit::InitCmd()
@@ -125,6 +135,7 @@ void EngineInit::ReducedFeatureSet()
 	_makeAudio = false;
 	_makeEffects = false;
 	_makeExtra = false;
+	_makeGame = false;
 	_makeGUI = false;
 	_makeNet = false;
 	_makePhysics = false;
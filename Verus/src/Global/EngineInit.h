@@ -18,6 +18,7 @@ namespace verus
 		bool _makeCGI = true;
 		bool _makeEffects = true;
 		bool _makeExtra = false;
+		bool _makeGame = true;
 		bool _makeGlobal = true;
 		bool _makeGUI = true;
 		bool _makeInput = true;
@@ -8,9 +8,13 @@ namespace verus
 	void Make_Global()
 	{
 		Timer::Make();
+		Profiler::Make();
+		Jobs::Make();
 	}
 	void Free_Global()
 	{
+		Jobs::Free();
+		Profiler::Free();
 		Timer::Free();
 	}
 }
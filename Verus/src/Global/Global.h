@@ -11,14 +11,16 @@
 #include "Random.h"
 #include "Str.h"
 #include "Utils.h"
-#include "Parallel.h"
 #include "Interval.h"
 #include "Range.h"
 #include "Object.h"
 #include "Lockable.h"
+#include "Jobs.h"
+#include "Parallel.h"
 #include "Linear.h"
 #include "Convert.h"
 #include "Timer.h"
+#include "Profiler.h"
 #include "Cooldown.h"
 #include "EngineInit.h"
 #include "GlobalVarsClipboard.h"
@@ -26,6 +28,7 @@
 #include "Pool.h"
 #include "LocalPtr.h"
 #include "BaseCircularBuffer.h"
+#include "LockFreeQueue.h"
 
 namespace verus
 {
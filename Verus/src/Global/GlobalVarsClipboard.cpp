@@ -5,7 +5,7 @@ using namespace verus;
 
 void GlobalVarsClipboard::Copy()
 {
-	_vPairs.reserve(8);
+	_vPairs.reserve(9);
 
 	_vPairs.push_back(Pair(0, Utils::P()));
 	_vPairs.push_back(Pair(1, D::Log::P()));
@@ -13,6 +13,9 @@ void GlobalVarsClipboard::Copy()
 	_vPairs.push_back(Pair(3, CGI::Renderer::P()));
 	_vPairs.push_back(Pair(4, IO::Async::P()));
 	_vPairs.push_back(Pair(5, Input::InputManager::P()));
+	_vPairs.push_back(Pair(6, IO::FileSystem::P()));
+	_vPairs.push_back(Pair(7, Jobs::P()));
+	_vPairs.push_back(Pair(8, Profiler::P()));
 }
 
 void GlobalVarsClipboard::Paste()
@@ -23,4 +26,7 @@ void GlobalVarsClipboard::Paste()
 	CGI::Renderer::Assign(static_cast<CGI::Renderer*>(_vPairs[3]._p));
 	IO::Async::Assign(static_cast<IO::Async*>(_vPairs[4]._p));
 	Input::InputManager::Assign(static_cast<Input::InputManager*>(_vPairs[5]._p));
+	IO::FileSystem::Assign(static_cast<IO::FileSystem*>(_vPairs[6]._p));
+	Jobs::Assign(static_cast<Jobs*>(_vPairs[7]._p));
+	Profiler::Assign(static_cast<Profiler*>(_vPairs[8]._p));
 }
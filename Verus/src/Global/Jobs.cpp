@@ -0,0 +1,301 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "verus.h"
+
+using namespace verus;
+
+namespace
+{
+	thread_local int g_workerIndex = -1; // Other threads have -1.
+}
+
+Jobs::Jobs()
+{
+	_queuedJobCount = 0;
+	_sleepingCount = 0;
+	_nextWorker = 0;
+	_stopThreads = false;
+}
+
+Jobs::~Jobs()
+{
+	Done();
+}
+
+void Jobs::Init(int workerCount)
+{
+	VERUS_INIT();
+
+	if (workerCount <= 0)
+		workerCount = Math::Max<int>(std::thread::hardware_concurrency(), 1) - 1;
+
+	_workerCount = workerCount;
+	_stopThreads = false;
+	_pWorkers.reset(new Worker[Math::Max(_workerCount, 1)]);
+	VERUS_FOR(i, _workerCount)
+		_pWorkers[i]._thread = std::thread(&Jobs::ThreadProc, this, i);
+}
+
+void Jobs::Done()
+{
+	if (_pWorkers)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutexSleep);
+			_stopThreads = true;
+		}
+		_cvSleep.notify_all();
+		VERUS_FOR(i, _workerCount)
+		{
+			if (_pWorkers[i]._thread.joinable())
+				_pWorkers[i]._thread.join();
+		}
+		_pWorkers.reset();
+	}
+	VERUS_DONE(Jobs);
+}
+
+void Jobs::Run(TJobFunc func, RJobCounter counter)
+{
+	VERUS_RT_ASSERT(IsInitialized());
+
+	Job job;
+	job._func = std::move(func);
+	job._pCounter = &counter;
+	counter._count++;
+	if (!_workerCount) // Nobody to help?
+	{
+		Execute(job);
+		return;
+	}
+	Push(std::move(job));
+}
+
+void Jobs::Wait(RJobCounter counter)
+{
+	// Help other threads instead of sleeping:
+	while (counter._count > 0)
+	{
+		Job job;
+		if (Pop(job))
+			Execute(job);
+		else
+			std::this_thread::yield();
+	}
+
+	if (counter._failed)
+	{
+		counter._failed = false;
+		std::rethrow_exception(counter._ex);
+	}
+}
+
+int Jobs::GetCurrentWorkerIndex()
+{
+	return g_workerIndex;
+}
+
+void Jobs::Push(Job&& job)
+{
+	const int index = (g_workerIndex >= 0) ? g_workerIndex : (_nextWorker++ % _workerCount);
+	RWorker worker = _pWorkers[index];
+	{
+		std::lock_guard<std::mutex> lock(worker._mutex);
+		worker._deque.push_back(std::move(job));
+	}
+	_queuedJobCount++;
+
+	if (_sleepingCount > 0) // Don't miss the wake-up, the thread could be just about to wait.
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutexSleep);
+		}
+		_cvSleep.notify_one();
+	}
+}
+
+bool Jobs::Pop(Job& job)
+{
+	if (!_queuedJobCount)
+		return false;
+
+	// Own jobs are taken from the back, they are likely still in cache:
+	if (g_workerIndex >= 0)
+	{
+		RWorker worker = _pWorkers[g_workerIndex];
+		std::lock_guard<std::mutex> lock(worker._mutex);
+		if (!worker._deque.empty())
+		{
+			job = std::move(worker._deque.back());
+			worker._deque.pop_back();
+			_queuedJobCount--;
+			return true;
+		}
+	}
+
+	// Steal the oldest job, it's likely to be the biggest:
+	const int start = (g_workerIndex >= 0) ? g_workerIndex : 0;
+	for (int i = 1; i <= _workerCount; ++i)
+	{
+		RWorker victim = _pWorkers[(start + i) % _workerCount];
+		std::lock_guard<std::mutex> lock(victim._mutex);
+		if (!victim._deque.empty())
+		{
+			job = std::move(victim._deque.front());
+			victim._deque.pop_front();
+			_queuedJobCount--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void Jobs::Execute(Job& job)
+{
+	RJobCounter counter = *job._pCounter;
+	try
+	{
+		job._func();
+	}
+	catch (...)
+	{
+		if (!counter._failed.exchange(true))
+			counter._ex = std::current_exception();
+	}
+	job._func = nullptr; // Release captures before signaling.
+	counter._count--;
+}
+
+void Jobs::ThreadProc(int index)
+{
+	g_workerIndex = index;
+	VERUS_PROFILE_THREAD(_C("Jobs " + std::to_string(index)));
+	const int spinCount = 64;
+	int idle = 0;
+	while (!_stopThreads)
+	{
+		Job job;
+		if (Pop(job))
+		{
+			Execute(job);
+			idle = 0;
+			continue;
+		}
+
+		if (++idle < spinCount)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// If there are no jobs, wait:
+		std::unique_lock<std::mutex> lock(_mutexSleep);
+		_sleepingCount++;
+		_cvSleep.wait(lock, [this]() { return _queuedJobCount > 0 || _stopThreads; });
+		_sleepingCount--;
+		idle = 0;
+	}
+}
+
+void Jobs::Test()
+{
+	// Create a temporary pool if the engine has not initialized one yet, ParallelFor must not run serially:
+	const bool make = !IsValidSingleton();
+	if (make)
+		Make();
+	RJobs jobs = I();
+	const bool init = !jobs.IsInitialized();
+	if (init)
+		jobs.Init(3);
+	VERUS_RT_ASSERT(jobs.GetWorkerCount() > 0);
+
+	// All indices must be visited exactly once:
+	Vector<int> v(10007);
+	jobs.ParallelFor(0, Utils::Cast32(v.size()), [&v](int i)
+		{
+			v[i]++;
+		});
+	VERUS_RT_ASSERT(std::all_of(v.begin(), v.end(), [](int x) { return 1 == x; }));
+
+	// Nested jobs with dependencies:
+	std::atomic_int sum;
+	sum = 0;
+	JobCounter counter;
+	VERUS_FOR(i, 16)
+	{
+		jobs.Run([&jobs, &sum]()
+			{
+				jobs.ParallelFor(0, 100, [&sum](int i) { sum += i; });
+			}, counter);
+	}
+	jobs.Wait(counter);
+	VERUS_RT_ASSERT(sum == 16 * 4950);
+
+	// Exception is delivered to the waiting thread:
+	bool caught = false;
+	try
+	{
+		jobs.ParallelFor(0, 1000, [](int i)
+			{
+				if (777 == i)
+					throw VERUS_RUNTIME_ERROR << "Test";
+			});
+	}
+	catch (D::RcRuntimeError)
+	{
+		caught = true;
+	}
+	VERUS_RT_ASSERT(caught);
+
+	if (init)
+		jobs.Done();
+	if (make)
+		Free();
+}
+
+void Jobs::Benchmark()
+{
+	if (!IsValidSingleton() || !I().IsInitialized())
+		return;
+	RJobs jobs = I();
+
+	// Real callers of Parallel::For, rows have uneven cost. Uses the terrain of the loaded world or generates one:
+	World::PTerrain pTerrain = nullptr;
+	if (World::WorldManager::IsValidSingleton() && World::WorldManager::I().IsInitialized())
+	{
+		World::WorldManager::Query query;
+		query._type = World::NodeType::terrain;
+		World::WorldManager::I().ForEachNode(query, [&pTerrain](World::RBaseNode node)
+			{
+				pTerrain = &static_cast<World::RTerrainNode>(node).GetTerrain();
+				return Continue::no;
+			});
+	}
+	World::Terrain terrain;
+	if (!pTerrain)
+	{
+		if (!World::Atmosphere::IsValidSingleton() || !World::Atmosphere::I().IsInitialized()) // Required by Terrain::Init().
+		{
+			VERUS_LOG_INFO("Benchmark(); Skipped, no world systems");
+			return;
+		}
+		World::Terrain::Desc desc;
+		desc._mapSide = 512;
+		desc._debugHills = 64;
+		terrain.Init(desc);
+		pTerrain = &terrain;
+	}
+
+	auto Run = [pTerrain]()
+	{
+		pTerrain->UpdateHeightBuffer();
+		pTerrain->ComputeOcclusion(); // Does nothing in debug build.
+	};
+	const double jobsMs = Utils::MeasureBestTime(Run, 3);
+	// Without jobs Parallel::For creates a thread per core:
+	const int workerCount = jobs.GetWorkerCount();
+	jobs.Done();
+	const double threadsMs = Utils::MeasureBestTime(Run, 3);
+	jobs.Init(workerCount);
+
+	VERUS_LOG_INFO("Benchmark(); Terrain " << pTerrain->GetMapSide() << ", thread per core: " << threadsMs << " ms, jobs: " << jobsMs << " ms, workers: " << workerCount);
+}
@@ -0,0 +1,136 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	// Counts unfinished jobs. Jobs::Wait() returns when it reaches zero.
+	// If some job throws, the first exception is rethrown by Jobs::Wait().
+	class JobCounter
+	{
+		friend class Jobs;
+
+		std::atomic_int    _count;
+		std::atomic_bool   _failed;
+		std::exception_ptr _ex;
+
+	public:
+		JobCounter()
+		{
+			_count = 0;
+			_failed = false;
+		}
+
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		bool IsDone() const { return !_count; }
+	};
+	VERUS_TYPEDEFS(JobCounter);
+
+	// Engine-wide pool of worker threads, which is created once.
+	// Each worker has its own deque: it takes new jobs from the back, other threads steal from the front.
+	// Threads, which wait for a counter, run jobs instead of sleeping, so jobs can wait for other jobs.
+	class Jobs : public Singleton<Jobs>, public Object
+	{
+	public:
+		typedef std::function<void()> TJobFunc;
+
+	private:
+		struct Job
+		{
+			TJobFunc    _func;
+			PJobCounter _pCounter = nullptr;
+		};
+
+		struct Worker
+		{
+			std::mutex      _mutex;
+			std::deque<Job> _deque;
+			std::thread     _thread;
+		};
+		VERUS_TYPEDEFS(Worker);
+
+		std::unique_ptr<Worker[]> _pWorkers;
+		std::mutex                _mutexSleep;
+		std::condition_variable   _cvSleep;
+		std::atomic_int           _queuedJobCount;
+		std::atomic_int           _sleepingCount;
+		std::atomic_uint          _nextWorker;
+		std::atomic_bool          _stopThreads;
+		int                       _workerCount = 0;
+
+	public:
+		Jobs();
+		~Jobs();
+
+		// Zero worker count means one less than the number of cores:
+		void Init(int workerCount = 0);
+		void Done();
+
+		// Not counting the calling thread:
+		int GetWorkerCount() const { return _workerCount; }
+		// Index of worker thread, which is calling this method, or -1 for other threads:
+		static int GetCurrentWorkerIndex();
+
+		void Run(TJobFunc func, RJobCounter counter);
+		void Wait(RJobCounter counter);
+
+		// Range is split into small parts, which are taken by threads one by one, so that
+		// one slow part doesn't stall others. The calling thread also takes part.
+		template<typename TFunc>
+		void ParallelFor(int from, int to, TFunc func, int minGrainSize = 1)
+		{
+			const int total = to - from;
+			if (total <= 0)
+				return;
+			const int grainSize = Math::Max(minGrainSize, total / ((_workerCount + 1) * 8));
+			const int rangeCount = (total + grainSize - 1) / grainSize;
+			if (!_workerCount || rangeCount <= 1)
+			{
+				for (int i = from; i < to; ++i)
+					func(i);
+				return;
+			}
+
+			std::atomic_int next(from);
+			auto RunRanges = [&next, &func, to, grainSize]()
+			{
+				int i;
+				while ((i = next.fetch_add(grainSize)) < to)
+				{
+					const int end = Math::Min(i + grainSize, to);
+					for (; i < end; ++i)
+						func(i);
+				}
+			};
+
+			JobCounter counter;
+			const int jobCount = Math::Min(_workerCount, rangeCount - 1);
+			VERUS_FOR(i, jobCount)
+				Run(RunRanges, counter);
+			try
+			{
+				RunRanges();
+			}
+			catch (...)
+			{
+				next = to; // Jobs use this stack frame, stop them before leaving.
+				Wait(counter);
+				throw;
+			}
+			Wait(counter);
+		}
+
+		static void Test();
+		// Compares ParallelFor with thread per core approach on terrain, results are written to log:
+		static void Benchmark();
+
+	private:
+		void Push(Job&& job);
+		bool Pop(Job& job);
+		void Execute(Job& job);
+
+		void ThreadProc(int index);
+	};
+	VERUS_TYPEDEFS(Jobs);
+}
@@ -0,0 +1,111 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	// Bounded multi-producer multi-consumer queue, which doesn't use locks.
+	// Capacity must be power of two. Push and Pop fail instead of blocking.
+	// See: https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+	template<typename T>
+	class LockFreeQueue
+	{
+		struct Cell
+		{
+			std::atomic<size_t> _sequence;
+			T                   _data;
+		};
+
+		std::unique_ptr<Cell[]>          _pCells;
+		size_t                           _mask = 0;
+		alignas(64) std::atomic<size_t> _pushPos;
+		alignas(64) std::atomic<size_t> _popPos;
+
+	public:
+		LockFreeQueue()
+		{
+			_pushPos = 0;
+			_popPos = 0;
+		}
+
+		LockFreeQueue(const LockFreeQueue&) = delete;
+		LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+		// Not thread-safe, call before using the queue:
+		void Init(size_t capacity)
+		{
+			VERUS_RT_ASSERT(capacity >= 2 && !(capacity & (capacity - 1)));
+			_pCells.reset(new Cell[capacity]);
+			_mask = capacity - 1;
+			for (size_t i = 0; i < capacity; ++i)
+				_pCells[i]._sequence.store(i, std::memory_order_relaxed);
+			_pushPos.store(0, std::memory_order_relaxed);
+			_popPos.store(0, std::memory_order_relaxed);
+		}
+
+		bool Push(const T& x)
+		{
+			Cell* pCell;
+			size_t pos = _pushPos.load(std::memory_order_relaxed);
+			while (true)
+			{
+				pCell = &_pCells[pos & _mask];
+				const size_t seq = pCell->_sequence.load(std::memory_order_acquire);
+				const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+				if (!diff)
+				{
+					if (_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (diff < 0)
+				{
+					return false; // Full.
+				}
+				else
+				{
+					pos = _pushPos.load(std::memory_order_relaxed);
+				}
+			}
+			pCell->_data = x;
+			pCell->_sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool Pop(T& x)
+		{
+			Cell* pCell;
+			size_t pos = _popPos.load(std::memory_order_relaxed);
+			while (true)
+			{
+				pCell = &_pCells[pos & _mask];
+				const size_t seq = pCell->_sequence.load(std::memory_order_acquire);
+				const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+				if (!diff)
+				{
+					if (_popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (diff < 0)
+				{
+					return false; // Empty.
+				}
+				else
+				{
+					pos = _popPos.load(std::memory_order_relaxed);
+				}
+			}
+			x = pCell->_data;
+			pCell->_sequence.store(pos + _mask + 1, std::memory_order_release);
+			return true;
+		}
+
+		size_t GetCapacity() const { return _mask + 1; }
+
+		// Approximate, other threads can change it at any time:
+		size_t GetSize() const
+		{
+			const size_t pushPos = _pushPos.load(std::memory_order_relaxed);
+			const size_t popPos = _popPos.load(std::memory_order_relaxed);
+			return pushPos > popPos ? pushPos - popPos : 0;
+		}
+	};
+}
@@ -12,8 +12,23 @@ namespace verus
 	class Parallel
 	{
 	public:
+		// Uses engine's job system if it's available:
 		template<typename TFunc>
 		static void For(int from, int to, TFunc func, int minTime = 0, int minShare = 1)
+		{
+			if (!Jobs::IsValidSingleton() || !Jobs::I().IsInitialized())
+				return ForEachThread(from, to, func, minTime, minShare);
+
+			const std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+			Jobs::I().ParallelFor(from, to, func, minShare);
+			const std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+			const std::chrono::milliseconds d = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0);
+			VERUS_RT_ASSERT(!minTime || d.count() >= minTime);
+		}
+
+		// Creates a thread per core, each thread gets an equal share:
+		template<typename TFunc>
+		static void ForEachThread(int from, int to, TFunc func, int minTime = 0, int minShare = 1)
 		{
 			const int total = to - from;
 			VERUS_RT_ASSERT(minShare <= total);
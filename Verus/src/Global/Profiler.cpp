@@ -0,0 +1,414 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "verus.h"
+
+using namespace verus;
+
+namespace
+{
+	std::atomic<UINT64> g_profilerGeneration(0);
+	thread_local Profiler::PThreadBuffer g_pProfilerThreadBuffer = nullptr;
+	thread_local UINT64 g_profilerThreadGeneration = 0; // Buffer belongs to this instance of Profiler.
+}
+
+// Profiler::ThreadBuffer:
+
+Profiler::ThreadBuffer::ThreadBuffer()
+{
+	_pEvents.reset(new Event[s_bufferCapacity]);
+	_writeCount = 0;
+}
+
+// Profiler:
+
+Profiler::Profiler()
+{
+	_enabled = true;
+	_generation = ++g_profilerGeneration;
+	_prevEndFrame = GetTimestamp();
+}
+
+Profiler::~Profiler()
+{
+}
+
+INT64 Profiler::GetTimestamp()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+INT64 Profiler::Begin()
+{
+	if (!IsValidSingleton() || !I()._enabled)
+		return 0;
+	return GetTimestamp();
+}
+
+void Profiler::End(CSZ name, INT64 begin)
+{
+	if (!begin || !IsValidSingleton())
+		return;
+	const INT64 end = GetTimestamp();
+	PThreadBuffer pBuffer = I().GetThreadBuffer();
+	// Only the owner thread writes, the counter tells the reader which events are complete:
+	const UINT64 writeCount = pBuffer->_writeCount.load(std::memory_order_relaxed);
+	REvent e = pBuffer->_pEvents[writeCount & (s_bufferCapacity - 1)];
+	e._name = name;
+	e._begin = begin;
+	e._end = end;
+	e._threadIndex = pBuffer->_index;
+	pBuffer->_writeCount.store(writeCount + 1, std::memory_order_release);
+}
+
+void Profiler::SetThreadName(CSZ name)
+{
+	if (!IsValidSingleton())
+		return;
+	RProfiler profiler = I();
+	PThreadBuffer pBuffer = profiler.GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(profiler._mutex);
+	pBuffer->_name = name;
+}
+
+void Profiler::EndFrame()
+{
+	if (!IsValidSingleton())
+		return;
+	RProfiler profiler = I();
+
+	const INT64 now = GetTimestamp();
+	profiler._frameMs = (now - profiler._prevEndFrame) * 0.000001;
+	profiler._prevEndFrame = now;
+
+	profiler.CollectEvents();
+	profiler.UpdateZones();
+
+	if (profiler._capture)
+	{
+		const size_t room = s_maxCapturedEvents - Math::Min<size_t>(s_maxCapturedEvents, profiler._vCapturedEvents.size());
+		const size_t count = Math::Min(room, profiler._vFrameEvents.size());
+		profiler._vCapturedEvents.insert(profiler._vCapturedEvents.end(),
+			profiler._vFrameEvents.begin(), profiler._vFrameEvents.begin() + count);
+	}
+}
+
+Profiler::PThreadBuffer Profiler::GetThreadBuffer()
+{
+	if (g_pProfilerThreadBuffer && g_profilerThreadGeneration == _generation)
+		return g_pProfilerThreadBuffer;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	const int index = Utils::Cast32(_vBuffers.size());
+	_vBuffers.push_back(std::make_unique<ThreadBuffer>());
+	PThreadBuffer pBuffer = _vBuffers.back().get();
+	pBuffer->_index = index;
+	pBuffer->_name = "Thread " + std::to_string(index);
+	g_pProfilerThreadBuffer = pBuffer;
+	g_profilerThreadGeneration = _generation;
+	return pBuffer;
+}
+
+void Profiler::CollectEvents()
+{
+	_vFrameEvents.clear();
+
+	// Buffers are never removed, so only the list itself must be protected:
+	Vector<PThreadBuffer> vBuffers;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		vBuffers.reserve(_vBuffers.size());
+		for (const auto& x : _vBuffers)
+			vBuffers.push_back(x.get());
+	}
+
+	for (auto pBuffer : vBuffers)
+	{
+		const UINT64 writeCount = pBuffer->_writeCount.load(std::memory_order_acquire);
+		if (writeCount - pBuffer->_readCount > s_bufferCapacity)
+		{
+			_lostEventCount += writeCount - pBuffer->_readCount - s_bufferCapacity;
+			pBuffer->_readCount = writeCount - s_bufferCapacity;
+		}
+		const size_t start = _vFrameEvents.size();
+		for (UINT64 i = pBuffer->_readCount; i < writeCount; ++i)
+			_vFrameEvents.push_back(pBuffer->_pEvents[i & (s_bufferCapacity - 1)]);
+
+		// Owner thread could have overwritten the oldest events while they were copied:
+		const UINT64 writeCountAfter = pBuffer->_writeCount.load(std::memory_order_acquire);
+		if (writeCountAfter - pBuffer->_readCount > s_bufferCapacity)
+		{
+			const UINT64 overwritten = Math::Min(writeCountAfter - pBuffer->_readCount - s_bufferCapacity, writeCount - pBuffer->_readCount);
+			_vFrameEvents.erase(_vFrameEvents.begin() + start, _vFrameEvents.begin() + start + overwritten);
+			_lostEventCount += overwritten;
+		}
+		pBuffer->_readCount = writeCount;
+	}
+}
+
+void Profiler::UpdateZones()
+{
+	// Parent begins earlier and ends later, so it must go first:
+	std::sort(_vFrameEvents.begin(), _vFrameEvents.end(), [](RcEvent a, RcEvent b)
+		{
+			if (a._threadIndex != b._threadIndex)
+				return a._threadIndex < b._threadIndex;
+			if (a._begin != b._begin)
+				return a._begin < b._begin;
+			return a._end > b._end;
+		});
+
+	_vNewZones.clear();
+	Vector<std::pair<INT64, int>> vStack; // End time and zone index of open parents.
+	int threadIndex = -1;
+	for (const auto& e : _vFrameEvents)
+	{
+		if (e._threadIndex != threadIndex)
+		{
+			threadIndex = e._threadIndex;
+			vStack.clear();
+			_mapNewZones.clear(); // Root zones of each thread are separate.
+		}
+		while (!vStack.empty() && vStack.back().first <= e._begin)
+			vStack.pop_back();
+		const int parent = vStack.empty() ? -1 : vStack.back().second;
+
+		ZoneKey key;
+		key._name = e._name;
+		key._parent = parent;
+		auto it = _mapNewZones.find(key);
+		int zoneIndex = -1;
+		if (it != _mapNewZones.end())
+		{
+			zoneIndex = it->second;
+		}
+		else
+		{
+			zoneIndex = Utils::Cast32(_vNewZones.size());
+			Zone zone;
+			zone._name = e._name;
+			zone._parent = parent;
+			zone._threadIndex = threadIndex;
+			_vNewZones.push_back(zone);
+			_mapNewZones[key] = zoneIndex;
+		}
+		RZone zone = _vNewZones[zoneIndex];
+		zone._ms += (e._end - e._begin) * 0.000001;
+		zone._count++;
+
+		vStack.push_back(std::make_pair(e._end, zoneIndex));
+	}
+
+	_vZones.clear();
+	_vZones.reserve(_vNewZones.size());
+	VERUS_FOR(i, Utils::Cast32(_vNewZones.size()))
+	{
+		if (_vNewZones[i]._parent < 0)
+			AppendZone(i, 0);
+	}
+}
+
+void Profiler::AppendZone(int index, int depth)
+{
+	const int parent = Utils::Cast32(_vZones.size());
+	_vZones.push_back(_vNewZones[index]);
+	_vZones.back()._parent = -1;
+	_vZones.back()._depth = depth;
+	// Children are always created after their parent:
+	for (int i = index + 1; i < Utils::Cast32(_vNewZones.size()); ++i)
+	{
+		if (_vNewZones[i]._parent == index)
+		{
+			const int child = Utils::Cast32(_vZones.size());
+			AppendZone(i, depth + 1);
+			_vZones[child]._parent = parent;
+		}
+	}
+}
+
+void Profiler::BeginCapture()
+{
+	_vCapturedEvents.clear();
+	_capture = true;
+}
+
+void Profiler::EndCapture()
+{
+	_capture = false;
+}
+
+bool Profiler::ExportChromeTrace(CSZ pathname)
+{
+	String path;
+	if (!pathname)
+	{
+		path = _C(Utils::I().GetWritablePath());
+		path += "Trace.json";
+		pathname = _C(path);
+	}
+
+	auto Escape = [](CSZ name)
+	{
+		String s;
+		for (CSZ p = name; *p; ++p)
+		{
+			if ('\"' == *p || '\\' == *p)
+				s += '\\';
+			if (static_cast<BYTE>(*p) >= 0x20)
+				s += *p;
+		}
+		return s;
+	};
+
+	const INT64 origin = _vCapturedEvents.empty() ? 0 : std::min_element(_vCapturedEvents.begin(), _vCapturedEvents.end(),
+		[](RcEvent a, RcEvent b) { return a._begin < b._begin; })->_begin;
+
+	StringStream ss;
+	ss << std::fixed << std::setprecision(3);
+	ss << "{\"traceEvents\":[\n";
+	bool first = true;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (const auto& x : _vBuffers)
+		{
+			if (!first)
+				ss << ",\n";
+			first = false;
+			ss << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << x->_index;
+			ss << ",\"args\":{\"name\":\"" << Escape(_C(x->_name)) << "\"}}";
+		}
+	}
+	for (const auto& e : _vCapturedEvents)
+	{
+		if (!first)
+			ss << ",\n";
+		first = false;
+		ss << "{\"name\":\"" << Escape(e._name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e._threadIndex;
+		ss << ",\"ts\":" << (e._begin - origin) * 0.001 << ",\"dur\":" << (e._end - e._begin) * 0.001 << "}";
+	}
+	ss << "\n]}\n";
+
+	const String json = ss.str();
+	IO::File file;
+	if (!file.Open(pathname, "w"))
+	{
+		VERUS_LOG_ERROR("ExportChromeTrace(), failed to open file: " << pathname);
+		return false;
+	}
+	file.Write(_C(json), json.size());
+	VERUS_LOG_INFO("ExportChromeTrace(), " << _vCapturedEvents.size() << " events written to " << pathname);
+	return true;
+}
+
+void Profiler::DrawImGui(bool* pOpen)
+{
+	if (!ImGui::Begin("Profiler", pOpen))
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Text("Frame: %.3f ms", _frameMs);
+	if (_lostEventCount)
+	{
+		ImGui::SameLine();
+		ImGui::Text("(%llu events lost)", _lostEventCount);
+	}
+
+	bool enabled = _enabled;
+	if (ImGui::Checkbox("Enabled", &enabled))
+		_enabled = enabled;
+	ImGui::SameLine();
+	if (_capture)
+	{
+		if (ImGui::Button("Stop capture"))
+			EndCapture();
+		ImGui::SameLine();
+		ImGui::Text("%d events", Utils::Cast32(_vCapturedEvents.size()));
+	}
+	else
+	{
+		if (ImGui::Button("Capture"))
+			BeginCapture();
+		if (!_vCapturedEvents.empty())
+		{
+			ImGui::SameLine();
+			if (ImGui::Button("Export Trace.json"))
+				ExportChromeTrace(nullptr);
+		}
+	}
+
+	if (ImGui::BeginTable("Zones", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingStretchProp))
+	{
+		ImGui::TableSetupColumn("Zone", ImGuiTableColumnFlags_WidthStretch);
+		ImGui::TableSetupColumn("ms", ImGuiTableColumnFlags_WidthFixed);
+		ImGui::TableSetupColumn("Count", ImGuiTableColumnFlags_WidthFixed);
+		ImGui::TableHeadersRow();
+
+		int threadIndex = -1;
+		for (const auto& zone : _vZones)
+		{
+			if (zone._threadIndex != threadIndex)
+			{
+				threadIndex = zone._threadIndex;
+				String name;
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					name = _vBuffers[threadIndex]->_name;
+				}
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextDisabled("%s", _C(name));
+			}
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::Text("%*s%s", (zone._depth + 1) * 2, "", zone._name);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", zone._ms);
+			ImGui::TableNextColumn();
+			ImGui::Text("%d", zone._count);
+		}
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
+
+void Profiler::Test()
+{
+	if (!IsValidSingleton())
+		return;
+	RProfiler profiler = I();
+	const bool enabled = profiler.IsEnabled();
+	profiler.SetEnabled();
+	EndFrame(); // Flush older events.
+
+	{
+		ProfilerScope outer("ProfilerTest_Outer");
+		VERUS_FOR(i, 2)
+		{
+			ProfilerScope inner("ProfilerTest_Inner");
+		}
+	}
+	EndFrame();
+
+	int outer = -1;
+	int inner = -1;
+	VERUS_FOR(i, Utils::Cast32(profiler._vZones.size()))
+	{
+		RcZone zone = profiler._vZones[i];
+		if (!strcmp(zone._name, "ProfilerTest_Outer"))
+			outer = i;
+		if (!strcmp(zone._name, "ProfilerTest_Inner"))
+			inner = i;
+	}
+	VERUS_RT_ASSERT(outer >= 0 && inner >= 0);
+	if (outer >= 0 && inner >= 0)
+	{
+		VERUS_RT_ASSERT(1 == profiler._vZones[outer]._count);
+		VERUS_RT_ASSERT(2 == profiler._vZones[inner]._count);
+		VERUS_RT_ASSERT(outer == profiler._vZones[inner]._parent);
+		VERUS_RT_ASSERT(profiler._vZones[outer]._depth + 1 == profiler._vZones[inner]._depth);
+	}
+
+	profiler.SetEnabled(enabled);
+}
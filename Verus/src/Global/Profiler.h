@@ -0,0 +1,149 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+#if defined(_DEBUG) || defined(VERUS_RELEASE_DEBUG)
+#	define VERUS_ENABLE_PROFILER
+#endif
+
+#define VERUS_PROFILE_CONCAT_(a, b) a##b
+#define VERUS_PROFILE_CONCAT(a, b)  VERUS_PROFILE_CONCAT_(a, b)
+
+#ifdef VERUS_ENABLE_PROFILER
+// Name must be a string literal, only the pointer is stored:
+#	define VERUS_PROFILE_SCOPE(name) verus::ProfilerScope VERUS_PROFILE_CONCAT(profilerScope_, __LINE__)(name)
+#	define VERUS_PROFILE_THREAD(name) verus::Profiler::SetThreadName(name)
+#	define VERUS_PROFILE_END_FRAME() verus::Profiler::EndFrame()
+#else
+#	define VERUS_PROFILE_SCOPE(name)
+#	define VERUS_PROFILE_THREAD(name)
+#	define VERUS_PROFILE_END_FRAME()
+#endif
+
+namespace verus
+{
+	// Collects timings of scopes, which are marked with VERUS_PROFILE_SCOPE.
+	// Each thread writes to its own ring buffer without locks, the main thread reads all buffers once per frame.
+	// Last frame is shown by ImGui, captured frames can be exported to Chrome trace (chrome://tracing or Perfetto).
+	class Profiler : public Singleton<Profiler>
+	{
+	public:
+		struct Event
+		{
+			CSZ   _name = nullptr;
+			INT64 _begin = 0; // In nanoseconds.
+			INT64 _end = 0;
+			int   _threadIndex = 0;
+		};
+		VERUS_TYPEDEFS(Event);
+
+		// Events with the same name and parent are added up:
+		struct Zone
+		{
+			CSZ    _name = nullptr;
+			double _ms = 0;
+			int    _count = 0;
+			int    _parent = -1;
+			int    _depth = 0;
+			int    _threadIndex = 0;
+		};
+		VERUS_TYPEDEFS(Zone);
+
+		class ThreadBuffer
+		{
+			friend class Profiler;
+
+			std::unique_ptr<Event[]> _pEvents;
+			std::atomic<UINT64>      _writeCount;
+			UINT64                   _readCount = 0; // Used by the main thread.
+			String                   _name;
+			int                      _index = 0;
+
+		public:
+			ThreadBuffer();
+		};
+		VERUS_TYPEDEFS(ThreadBuffer);
+
+	private:
+		static const int s_bufferCapacity = 1 << 14; // Power of two.
+		static const int s_maxCapturedEvents = 1 << 20;
+
+		// Names are string literals, so the pointer identifies the name:
+		struct ZoneKey
+		{
+			CSZ _name = nullptr;
+			int _parent = -1;
+
+			bool operator==(const ZoneKey& that) const { return _name == that._name && _parent == that._parent; }
+		};
+		struct ZoneKeyHash
+		{
+			size_t operator()(const ZoneKey& key) const { return std::hash<CSZ>()(key._name) ^ (std::hash<int>()(key._parent) * 31); }
+		};
+		typedef std::unordered_map<ZoneKey, int, ZoneKeyHash> TMapZones;
+
+		Vector<std::unique_ptr<ThreadBuffer>> _vBuffers;
+		Vector<Event>                         _vFrameEvents;
+		Vector<Zone>                          _vZones; // Depth-first order.
+		Vector<Zone>                          _vNewZones;
+		TMapZones                             _mapNewZones; // Zone index for name and parent, in current thread.
+		Vector<Event>                         _vCapturedEvents;
+		std::mutex                            _mutex;
+		INT64                                 _prevEndFrame = 0;
+		double                                _frameMs = 0;
+		UINT64                                _lostEventCount = 0;
+		UINT64                                _generation = 0;
+		std::atomic_bool                      _enabled;
+		bool                                  _capture = false;
+
+	public:
+		Profiler();
+		~Profiler();
+
+		static INT64 GetTimestamp();
+
+		// <Recording>
+		static INT64 Begin();
+		static void End(CSZ name, INT64 begin);
+		static void SetThreadName(CSZ name);
+		static void EndFrame();
+		// </Recording>
+
+		bool IsEnabled() const { return _enabled; }
+		void SetEnabled(bool b = true) { _enabled = b; }
+
+		bool IsCapturing() const { return _capture; }
+		void BeginCapture();
+		void EndCapture();
+		// Writes captured events as JSON, which is understood by chrome://tracing and Perfetto:
+		bool ExportChromeTrace(CSZ pathname);
+
+		const Vector<Zone>& GetZones() const { return _vZones; }
+		double GetFrameTime() const { return _frameMs; }
+
+		// Call this between ImGui::NewFrame() and rendering:
+		void DrawImGui(bool* pOpen = nullptr);
+
+		static void Test();
+
+	private:
+		PThreadBuffer GetThreadBuffer();
+		void CollectEvents();
+		void UpdateZones();
+		void AppendZone(int index, int depth);
+	};
+	VERUS_TYPEDEFS(Profiler);
+
+	class ProfilerScope
+	{
+		CSZ   _name;
+		INT64 _begin;
+
+	public:
+		ProfilerScope(CSZ name) : _name(name), _begin(Profiler::Begin()) {}
+		~ProfilerScope() { Profiler::End(_name, _begin); }
+
+		ProfilerScope(const ProfilerScope&) = delete;
+		ProfilerScope& operator=(const ProfilerScope&) = delete;
+	};
+	VERUS_TYPEDEFS(ProfilerScope);
+}
@@ -24,6 +24,12 @@ namespace verus
 		{
 		}
 
+	protected:
+		// For an extra instance, which must not replace the singleton, e.g. in tests:
+		struct NoAssign {};
+		Singleton(NoAssign) {}
+
+	public:
 		static inline void Make()
 		{
 			if (s_pSingleton)
@@ -169,5 +169,62 @@ void Utils::TestAll()
 	Convert::Test();
 	Str::Test();
 	Math::Test();
+	Math::Octree::Test();
+	Math::TangentSpaceTools::Test();
 	Security::CipherRC4::Test();
+	IO::Codec::Test();
+	Net::ReportQueue::Test();
+	Profiler::Test();
+	Anim::CompiledMotion::Test();
+	Anim::Skeleton::Test();
+	Anim::Crowd::Test();
+}
+
+void Utils::TestSlow()
+{
+	VERUS_LOG_INFO("TestSlow()");
+	IO::FileSystem::Test();
+	Net::Channel::Test();
+	Net::SnapshotClient::Test();
+	Jobs::Test();
+	D::Log::Test();
+	Game::LotManager::Test();
+	Extra::MeshOptimizer::Test();
+	VERUS_LOG_INFO("TestSlow(); Passed");
+}
+
+void Utils::BenchmarkAll()
+{
+	VERUS_LOG_INFO("BenchmarkAll()");
+	Math::Octree::Benchmark();
+	Jobs::Benchmark();
+	Anim::CompiledMotion::Benchmark();
+	Anim::Skeleton::Benchmark();
+	Anim::Crowd::Benchmark();
+	Extra::MeshOptimizer::Benchmark();
+	World::BaseMesh::Benchmark();
+	Physics::Bullet::Benchmark();
+	Effects::Particles::Benchmark();
+	Game::LotManager::Benchmark();
+	Net::Channel::Benchmark();
+	if (Net::Multiplayer::IsValidSingleton()) // Sockets are ready.
+		Net::Multiplayer::Benchmark();
+	Net::SnapshotClient::Benchmark();
+	D::Log::Benchmark();
+	World::WorldManager::BenchmarkSortVisibleNodes();
+	if (World::WorldManager::IsValidSingleton() && World::WorldManager::I().IsInitialized())
+		World::WorldManager::I().BenchmarkSortWorldNodes();
+}
+
+double Utils::MeasureBestTime(std::function<void()> func, int runCount)
+{
+	double best = std::numeric_limits<double>::max();
+	VERUS_FOR(i, runCount)
+	{
+		const auto t0 = std::chrono::high_resolution_clock::now();
+		func();
+		const auto t1 = std::chrono::high_resolution_clock::now();
+		best = Math::Min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+	}
+	return best;
 }
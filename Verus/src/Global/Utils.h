@@ -68,7 +68,14 @@ namespace verus
 		static void ComputeEdgePadding(BYTE* pData, int dataPixelStride, const BYTE* pAlpha, int alphaPixelStride,
 			int width, int height, int radius = 0, int channelCount = 3);
 
+		// Quick tests, which run on every start of debug build:
 		static void TestAll();
+		// Tests, which use threads, files or big data sets. Use --test command line argument:
+		static void TestSlow();
+		// Runs all benchmarks, results are written to log. Use --benchmark command line argument:
+		static void BenchmarkAll();
+		// Best time of several runs in milliseconds, used by benchmarks:
+		static double MeasureBestTime(std::function<void()> func, int runCount = 5);
 
 		template<typename T>
 		static T* Swap(T*& pDst, T*& pSrc)
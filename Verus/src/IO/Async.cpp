@@ -6,8 +6,12 @@ using namespace verus::IO;
 
 Async::Async()
 {
-	_stopThread = false;
-	VERUS_ZERO_MEM(_queue);
+	_queuedItemCount = 0;
+	_pendingTaskCount = 0;
+	_idleThreadCount = 0;
+	_spaceWaiterCount = 0;
+	_stopThreads = false;
+	_failed = false;
 }
 
 Async::~Async()
@@ -15,21 +19,40 @@ Async::~Async()
 	Done();
 }
 
-void Async::Init()
+void Async::Init(int threadCount)
 {
 	VERUS_INIT();
 
-	_stopThread = false;
-	_thread = std::thread(&Async::ThreadProc, this);
+	if (threadCount <= 0) // Loading is mostly IO-bound, a few threads are enough:
+		threadCount = Math::Clamp<int>(std::thread::hardware_concurrency() / 2, 1, 4);
+
+	for (auto& queue : _queues)
+		queue.Init(s_queueCapacity);
+
+	_stopThreads = false;
+	_failed = false;
+	_vThreads.reserve(threadCount);
+	VERUS_FOR(i, threadCount)
+		_vThreads.push_back(std::thread(&Async::ThreadProc, this));
 }
 
 void Async::Done()
 {
-	if (_thread.joinable())
+	if (!_vThreads.empty())
 	{
-		_stopThread = true;
-		_cv.notify_one();
-		_thread.join();
+		{
+			std::lock_guard<std::mutex> lock(_mutexWork);
+			_stopThreads = true;
+		}
+		_cvWork.notify_all();
+		_cvSpace.notify_all();
+		_cvFlush.notify_all();
+		for (auto& t : _vThreads)
+		{
+			if (t.joinable())
+				t.join();
+		}
+		_vThreads.clear();
 	}
 	VERUS_DONE(Async);
 }
@@ -40,68 +63,78 @@ void Async::Load(CSZ url, PAsyncDelegate pDelegate, RcTaskDesc desc)
 	VERUS_RT_ASSERT(!_inUpdate); // Not allowed to call Load() in Update().
 	VERUS_RT_ASSERT(url && *url);
 
-	// If the queue is full we must block until something gets processed:
-	bool full = false;
-	do
+	const int priority = Math::Clamp<int>(desc._priority, 0, Priority::count - 1);
+	const bool ordered = desc._ordered && desc._runOnMainThread;
+	QueueItem item;
 	{
-		{
-			VERUS_LOCK(*this);
-
-			for (auto& kv : _mapTasks)
-			{
-				if (!strcmp(url, _C(kv.first) + s_orderLength))
-				{
-					// This resource is already scheduled.
-					// Just add a new owner, if it's not already there.
-					RTask task = kv.second;
-					if (std::find(task._vOwners.begin(), task._vOwners.end(), pDelegate) == task._vOwners.end())
-						task._vOwners.push_back(pDelegate);
-					return;
-				}
-			}
-
-			full = VERUS_CIRCULAR_IS_FULL(_cursorRead, _cursorWrite, VERUS_COUNT_OF(_queue));
-
-			if (!full)
-			{
-				char order[16];
-				sprintf_s(order, "%08X", _order); // The order of Load() and delegates is preserved.
-				_order++;
-				String key = order;
-				key += url;
+		VERUS_LOCK(*this);
 
-				RTask task = _mapTasks[key];
+		auto it = _mapTasks.find(url);
+		if (it != _mapTasks.end())
+		{
+			// This resource is already scheduled.
+			// Just add a new owner, if it's not already there.
+			RTask task = *it->second;
+			if (std::find(task._vOwners.begin(), task._vOwners.end(), pDelegate) == task._vOwners.end())
 				task._vOwners.push_back(pDelegate);
-				task._desc = desc;
-				_queue[_cursorWrite] = _C(_mapTasks.find(key)->first);
-				VERUS_CIRCULAR_ADD(_cursorWrite, VERUS_COUNT_OF(_queue));
+			if (ordered && !task._desc._ordered && task._desc._runOnMainThread && GetState(task._ticket) != TaskState::loaded)
+			{
+				task._desc._ordered = true;
+				_dequeOrdered.push_back(&task);
 			}
+			if (priority >= task._priority)
+				return;
+			lock.unlock();
+			SetPriority(url, priority);
+			return;
 		}
 
-		if (full)
+		PTask pTask = nullptr;
+		if (_vFreeTasks.empty())
 		{
-			std::this_thread::sleep_for(std::chrono::milliseconds(290));
-			Update();
+			_listTasks.emplace_back();
+			pTask = &_listTasks.back();
 		}
-	} while (full);
+		else
+		{
+			pTask = _vFreeTasks.back();
+			_vFreeTasks.pop_back();
+		}
+		pTask->_vOwners.push_back(pDelegate);
+		pTask->_url = url;
+		pTask->_desc = desc;
+		pTask->_desc._ordered = ordered;
+		pTask->_priority = priority;
+		item._pTask = pTask;
+		item._generation = GetGeneration(pTask->_ticket);
+		pTask->_ticket = MakeTicket(item._generation, TaskState::queued);
 
-	_cv.notify_one();
+		_mapTasks[pTask->_url] = pTask;
+		if (ordered)
+			_dequeOrdered.push_back(pTask);
+		_pendingTaskCount++;
+	}
+
+	// If the queue is full we must block until some loader thread takes an item:
+	PushItem(item, priority, true);
 }
 
 void Async::_Cancel(PAsyncDelegate pDelegate)
 {
 	VERUS_RT_ASSERT(IsInitialized());
 	VERUS_LOCK(*this);
+
+	// Delegate can be destroyed after this call, so wait for Async_Process to return:
+	_cvProcess.wait(lock, [this, pDelegate]()
+		{
+			return std::find(_vProcessingOwners.begin(), _vProcessingOwners.end(), pDelegate) == _vProcessingOwners.end();
+		});
+
 	for (auto& kv : _mapTasks)
 	{
-		RTask task = kv.second;
-		VERUS_WHILE(Vector<PAsyncDelegate>, task._vOwners, it)
-		{
-			if (*it == pDelegate)
-				it = task._vOwners.erase(it);
-			else
-				++it;
-		}
+		RTask task = *kv.second;
+		task._vOwners.erase(std::remove(task._vOwners.begin(), task._vOwners.end(), pDelegate), task._vOwners.end());
+		task._vProcessed.erase(std::remove(task._vProcessed.begin(), task._vProcessed.end(), pDelegate), task._vProcessed.end());
 	}
 }
 
@@ -111,39 +144,80 @@ void Async::Cancel(PAsyncDelegate pDelegate)
 		I()._Cancel(pDelegate);
 }
 
+void Async::SetPriority(CSZ url, int priority)
+{
+	VERUS_RT_ASSERT(IsInitialized());
+
+	priority = Math::Clamp<int>(priority, 0, Priority::count - 1);
+	QueueItem item;
+	{
+		VERUS_LOCK(*this);
+
+		auto it = _mapTasks.find(url);
+		if (it == _mapTasks.end())
+			return;
+
+		PTask pTask = it->second;
+		const int prevPriority = pTask->_priority.exchange(priority);
+		const UINT64 ticket = pTask->_ticket;
+		if (priority >= prevPriority || GetState(ticket) != TaskState::queued)
+			return; // Lowering is handled by loader threads, when they pop the old item.
+
+		item._pTask = pTask;
+		item._generation = GetGeneration(ticket);
+	}
+
+	// Put a copy into more urgent queue, the old item will be skipped:
+	PushItem(item, priority, false);
+}
+
 void Async::Update()
 {
 	VERUS_RT_ASSERT(IsInitialized());
+	VERUS_PROFILE_SCOPE("Async::Update");
 	VERUS_LOCK(*this);
 
 	if (_ex.IsRaised())
 		throw _ex;
 
-	_inUpdate = true;
-	VERUS_WHILE(TMapTasks, _mapTasks, itTask)
 	{
-		RTask task = itTask->second;
-		if (task._loaded) // Only loaded task can be processed:
+		std::lock_guard<std::mutex> lockCompleted(_mutexCompleted);
+		for (const auto& pTask : _vCompleted)
 		{
-#ifdef VERUS_RELEASE_DEBUG
-			VERUS_LOG_DEBUG("Update(); task=" << itTask->first);
-#endif
-			VERUS_RT_ASSERT(task._desc._runOnMainThread);
-			if (!task._v.empty())
-			{
-				for (const auto& pOwner : task._vOwners)
-					pOwner->Async_WhenLoaded(_C(itTask->first) + s_orderLength, Blob(task._v.data(), task._v.size()));
-			}
-			itTask = _mapTasks.erase(itTask);
-			// Task complete.
-			if (_onePerUpdateMode)
-				break;
+			if (!pTask->_desc._ordered) // Ordered tasks are delivered from their own queue.
+				_vDeliver.push_back(pTask);
 		}
-		else
-			++itTask;
+		_vCompleted.clear();
 	}
-	if (_mapTasks.empty())
-		_order = 0;
+
+	_inUpdate = true;
+	bool delivered = false;
+
+	// Ordered tasks must wait for all previous ordered tasks:
+	while (!_dequeOrdered.empty() && !(_onePerUpdateMode && delivered))
+	{
+		PTask pTask = _dequeOrdered.front();
+		if (GetState(pTask->_ticket) != TaskState::loaded)
+			break;
+		_dequeOrdered.pop_front();
+		DeliverTask(pTask);
+		RetireTask(pTask);
+		delivered = true;
+	}
+
+	// Other tasks are delivered in the order of completion:
+	size_t deliveredCount = 0;
+	for (const auto& pTask : _vDeliver)
+	{
+		if (_onePerUpdateMode && delivered)
+			break;
+		DeliverTask(pTask);
+		RetireTask(pTask);
+		deliveredCount++;
+		delivered = true;
+	}
+	_vDeliver.erase(_vDeliver.begin(), _vDeliver.begin() + deliveredCount);
+
 	_inUpdate = false;
 
 	if (_flush) // Reset timer after flushing (update can take a long time):
@@ -157,58 +231,222 @@ void Async::Update()
 
 void Async::Flush()
 {
-	while (true)
+	{
+		VERUS_LOCK(*this);
+		if (_ex.IsRaised())
+			throw _ex;
+	}
+
+	if (!_pendingTaskCount)
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(_mutexWork);
+		_cvFlush.wait(lock, [this]() { return !_pendingTaskCount || _failed || _stopThreads; });
+	}
+
+	VERUS_LOCK(*this);
+	if (_ex.IsRaised())
+		throw _ex;
+	_flush = true;
+}
+
+bool Async::PushItem(const QueueItem& item, int priority, bool wait)
+{
+	LockFreeQueue<QueueItem>& queue = _queues[priority];
+	if (queue.Push(item))
+	{
+		_queuedItemCount++;
+	}
+	else
+	{
+		if (!wait)
+			return false;
+
+		// Block until some loader thread makes space:
+		std::unique_lock<std::mutex> lock(_mutexWork);
+		_spaceWaiterCount++;
+		_cvSpace.wait(lock, [&]() { return _stopThreads || queue.Push(item); });
+		_spaceWaiterCount--;
+		if (_stopThreads)
+			return false;
+		_queuedItemCount++;
+	}
+
+	if (_idleThreadCount > 0) // Don't miss the wake-up, the thread could be just about to wait.
+	{
+		std::lock_guard<std::mutex> lock(_mutexWork);
+	}
+	_cvWork.notify_one();
+	return true;
+}
+
+bool Async::PopItem(QueueItem& item, int& priority)
+{
+	VERUS_FOR(i, Priority::count) // Most urgent first.
+	{
+		if (_queues[i].Pop(item))
+		{
+			priority = i;
+			_queuedItemCount--;
+			if (_spaceWaiterCount > 0)
+			{
+				{
+					std::lock_guard<std::mutex> lock(_mutexWork);
+				}
+				_cvSpace.notify_all();
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void Async::ProcessTask(PTask pTask)
+{
+	if (pTask->_v.empty())
+		return;
+
+	Vector<PAsyncDelegate> vOwners;
+	{
+		VERUS_LOCK(*this);
+		vOwners = pTask->_vOwners;
+		_vProcessingOwners.insert(_vProcessingOwners.end(), vOwners.begin(), vOwners.end());
+	}
+
+	const Blob blob(pTask->_v.data(), pTask->_v.size());
+	try
+	{
+		for (const auto& pOwner : vOwners)
+			pOwner->Async_Process(_C(pTask->_url), blob);
+	}
+	catch (...)
 	{
 		{
 			VERUS_LOCK(*this);
-			if (_ex.IsRaised())
-				throw _ex;
-			if (_cursorRead == _cursorWrite)
-				return;
-			_flush = true;
+			for (const auto& pOwner : vOwners)
+				_vProcessingOwners.erase(std::find(_vProcessingOwners.begin(), _vProcessingOwners.end(), pOwner));
+		}
+		_cvProcess.notify_all();
+		throw;
+	}
+
+	{
+		VERUS_LOCK(*this);
+		for (const auto& pOwner : vOwners)
+		{
+			_vProcessingOwners.erase(std::find(_vProcessingOwners.begin(), _vProcessingOwners.end(), pOwner));
+			// Skip owners, which were canceled in the meantime:
+			if (std::find(pTask->_vOwners.begin(), pTask->_vOwners.end(), pOwner) != pTask->_vOwners.end())
+				pTask->_vProcessed.push_back(pOwner);
+		}
+	}
+	_cvProcess.notify_all();
+}
+
+void Async::CompleteTask(PTask pTask)
+{
+	pTask->_ticket = MakeTicket(GetGeneration(pTask->_ticket), TaskState::loaded);
+
+	// Is it safe to call a delegate on this loader thread?
+	if (!pTask->_desc._runOnMainThread)
+	{
+#ifdef VERUS_RELEASE_DEBUG
+		VERUS_LOG_DEBUG("CompleteTask(); runOnMainThread url=" << pTask->_url);
+#endif
+		VERUS_LOCK(*this);
+		DeliverTask(pTask);
+		RetireTask(pTask);
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(_mutexCompleted);
+		_vCompleted.push_back(pTask);
+	}
+
+	if (!--_pendingTaskCount)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutexWork);
 		}
-		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		_cvFlush.notify_all();
 	}
 }
 
+void Async::DeliverTask(PTask pTask)
+{
+#ifdef VERUS_RELEASE_DEBUG
+	VERUS_LOG_DEBUG("DeliverTask(); url=" << pTask->_url);
+#endif
+	if (!pTask->_v.empty())
+	{
+		const Blob blob(pTask->_v.data(), pTask->_v.size());
+		for (const auto& pOwner : pTask->_vOwners)
+		{
+			// Owners, which were added after processing, are processed here:
+			if (std::find(pTask->_vProcessed.begin(), pTask->_vProcessed.end(), pOwner) == pTask->_vProcessed.end())
+				pOwner->Async_Process(_C(pTask->_url), blob);
+			pOwner->Async_Commit(_C(pTask->_url), blob);
+		}
+	}
+}
+
+void Async::RetireTask(PTask pTask)
+{
+	_mapTasks.erase(pTask->_url);
+	pTask->_vOwners.clear();
+	pTask->_vProcessed.clear();
+	Vector<BYTE>().swap(pTask->_v); // Loaded data can be big, release it.
+	pTask->_url.clear();
+	pTask->_ticket = MakeTicket(GetGeneration(pTask->_ticket) + 1, TaskState::free);
+	_vFreeTasks.push_back(pTask);
+	// Task complete.
+}
+
 void Async::ThreadProc()
 {
 	VERUS_RT_ASSERT(IsInitialized());
+	VERUS_PROFILE_THREAD("Async");
 	try
 	{
 		SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
-		while (true)
+		while (!_stopThreads)
 		{
-			CSZ key = nullptr;
-			PTask pTask = nullptr; // Assume that this address will not change in the map.
-			TMapTasks::iterator itTask;
-
+			QueueItem item;
+			int itemPriority = 0;
+			if (!PopItem(item, itemPriority))
 			{
-				// Get the next task:
-				VERUS_LOCK(*this);
+				// If there are no items, wait:
+				std::unique_lock<std::mutex> lock(_mutexWork);
+				_idleThreadCount++;
+				_cvWork.wait(lock, [this]() { return _queuedItemCount > 0 || _stopThreads; });
+				_idleThreadCount--;
+				continue;
+			}
 
-				// If there are no tasks, unlock and wait:
-				_cv.wait(lock, [=]() {return (_cursorRead != _cursorWrite) || _stopThread; });
+			PTask pTask = item._pTask;
+			const UINT64 queuedTicket = MakeTicket(item._generation, TaskState::queued);
 
-				if (_stopThread)
-					break; // Quit.
+			// Priority was lowered after this item was queued?
+			const int priority = pTask->_priority;
+			if (priority > itemPriority && pTask->_ticket == queuedTicket && PushItem(item, priority, false))
+				continue;
 
-				// Locked and should have a task:
-				itTask = _mapTasks.end();
-				key = _queue[_cursorRead];
-				if (key)
-				{
-					itTask = _mapTasks.find(key);
-					if (itTask != _mapTasks.end())
-						pTask = &_mapTasks[key];
-				}
-			}
+			// Claim this task, other items for it become stale:
+			UINT64 expected = queuedTicket;
+			if (!pTask->_ticket.compare_exchange_strong(expected, MakeTicket(item._generation, TaskState::loading)))
+				continue;
 
-			if (key && (!pTask->_desc._checkExist || FileSystem::FileExist(key + s_orderLength)))
+			VERUS_PROFILE_SCOPE("Async::LoadTask");
+			CSZ url = _C(pTask->_url);
+#ifdef VERUS_RELEASE_DEBUG
+			VERUS_LOG_DEBUG("ThreadProc(); url=" << url);
+#endif
+			if (!pTask->_desc._checkExist || FileSystem::FileExist(url))
 			{
 				try
 				{
-					FileSystem::LoadResource(key + s_orderLength, pTask->_v,
+					FileSystem::LoadResource(url, pTask->_v,
 						FileSystem::LoadDesc(pTask->_desc._nullTerm, pTask->_desc._texturePart));
 				}
 				catch (D::RcRuntimeError)
@@ -218,42 +456,33 @@ void Async::ThreadProc()
 				}
 			}
 
-#ifdef VERUS_RELEASE_DEBUG
-			VERUS_LOG_DEBUG("ThreadProc(); key=" << key);
-#endif
-
-			{
-				// Finalize this task:
-				VERUS_LOCK(*this);
-				pTask->_loaded = true;
-				// Is it safe to call a delegate on this loader thread?
-				if (!pTask->_desc._runOnMainThread)
-				{
-#ifdef VERUS_RELEASE_DEBUG
-					VERUS_LOG_DEBUG("ThreadProc(); runOnMainThread key=" << key);
-#endif
-					if (!pTask->_v.empty())
-					{
-						for (const auto& pOwner : pTask->_vOwners)
-							pOwner->Async_WhenLoaded(key + s_orderLength, Blob(pTask->_v.data(), pTask->_v.size()));
-					}
-					_mapTasks.erase(itTask);
-					// Task complete.
-					if (_mapTasks.empty())
-						_order = 0;
-				}
-				VERUS_CIRCULAR_ADD(_cursorRead, VERUS_COUNT_OF(_queue));
-			}
+			if (pTask->_desc._runOnMainThread)
+				ProcessTask(pTask);
+			CompleteTask(pTask);
 		}
 	}
 	catch (D::RcRuntimeError e)
 	{
-		VERUS_LOCK(*this);
-		_ex = e;
+		{
+			VERUS_LOCK(*this);
+			_ex = e;
+		}
+		_failed = true;
+		{
+			std::lock_guard<std::mutex> lock(_mutexWork);
+		}
+		_cvFlush.notify_all();
 	}
 	catch (const std::exception& e)
 	{
-		VERUS_LOCK(*this);
-		_ex = VERUS_RUNTIME_ERROR << e.what();
+		{
+			VERUS_LOCK(*this);
+			_ex = VERUS_RUNTIME_ERROR << e.what();
+		}
+		_failed = true;
+		{
+			std::lock_guard<std::mutex> lock(_mutexWork);
+		}
+		_cvFlush.notify_all();
 	}
 }
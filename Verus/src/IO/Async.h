@@ -5,25 +5,45 @@ namespace verus
 {
 	namespace IO
 	{
+		// Async_Process is called on a loader thread, it should turn bytes into ready-to-use data,
+		// but it must not touch anything shared, like GPU resources or other objects.
+		// Async_Commit is called later on the main thread with the same blob, it should be quick.
+		// Delegates, which don't need the split, just implement Async_WhenLoaded.
 		struct AsyncDelegate
 		{
 			virtual void Async_WhenLoaded(CSZ url, RcBlob blob) = 0;
+			virtual void Async_Process(CSZ url, RcBlob blob) {}
+			virtual void Async_Commit(CSZ url, RcBlob blob) { Async_WhenLoaded(url, blob); }
 		};
 		VERUS_TYPEDEFS(AsyncDelegate);
 
 		// Load resources asynchronously.
-		// Load method just adds the url to a queue.
+		// Load method just adds the url to a queue, which is processed by a pool of loader threads.
+		// Requests with higher priority (lower value) are loaded first, priority can be changed later.
+		// Delegates are called in the order of completion, unless the request is ordered.
+		// Heavy parsing can be done by loader threads, see Async_Process.
 		// Load and Cancel are virtual so that they can be safely called from another DLL.
 		// Internally they can allocate and free memory.
 		class Async : public Singleton<Async>, public Object, public Lockable
 		{
 		public:
+			enum Priority : int
+			{
+				high,
+				normal,
+				low,
+				background,
+				count
+			};
+
 			struct TaskDesc
 			{
 				int  _texturePart = 0;
+				int  _priority = Priority::normal;
 				bool _nullTerm = false;
 				bool _checkExist = false;
 				bool _runOnMainThread = true;
+				bool _ordered = false; // Call delegate after all previous ordered requests.
 
 				TaskDesc(bool nullTerm = false, bool checkExist = false, int texturePart = 0, bool runOnMainThread = true) :
 					_nullTerm(nullTerm),
@@ -34,49 +54,104 @@ namespace verus
 			VERUS_TYPEDEFS(TaskDesc);
 
 		private:
+			enum class TaskState : UINT32
+			{
+				free,
+				queued,
+				loading,
+				loaded
+			};
+
 			struct Task
 			{
 				Vector<PAsyncDelegate> _vOwners;
+				Vector<PAsyncDelegate> _vProcessed; // Owners, which already had Async_Process called.
 				Vector<BYTE>           _v;
+				String                 _url;
 				TaskDesc               _desc;
-				bool                   _loaded = false;
+				std::atomic<UINT64>    _ticket; // Generation and state, see MakeTicket().
+				std::atomic_int        _priority;
+
+				Task()
+				{
+					_ticket = 0;
+					_priority = Priority::normal;
+				}
 			};
 			VERUS_TYPEDEFS(Task);
 
-			static const int s_orderLength = 8;
+			// Queues can have stale items, the ticket tells if the item is still valid:
+			struct QueueItem
+			{
+				PTask  _pTask = nullptr;
+				UINT32 _generation = 0;
+			};
+
+			static const int s_queueCapacity = 4096;
 
-			typedef Map<String, Task> TMapTasks;
+			typedef HashMap<String, PTask> TMapTasks;
 
-			TMapTasks               _mapTasks;
-			std::thread             _thread;
-			std::condition_variable _cv;
-			D::RuntimeError         _ex;
-			CSZ                     _queue[256];
-			int                     _cursorRead = 0;
-			int                     _cursorWrite = 0;
-			UINT32                  _order = 0;
-			std::atomic_bool        _stopThread;
-			bool                    _inUpdate = false;
-			bool                    _flush = false;
-			bool                    _onePerUpdateMode = false;
+			List<Task>                   _listTasks; // Stable addresses, tasks are reused.
+			Vector<PTask>                _vFreeTasks;
+			TMapTasks                    _mapTasks;
+			std::deque<PTask>            _dequeOrdered;
+			LockFreeQueue<QueueItem>     _queues[Priority::count];
+			Vector<std::thread>          _vThreads;
+			std::mutex                   _mutexWork;
+			std::condition_variable      _cvWork;
+			std::condition_variable      _cvSpace;
+			std::condition_variable      _cvFlush;
+			std::condition_variable      _cvProcess; // Used with the main lock.
+			Vector<PAsyncDelegate>       _vProcessingOwners;
+			std::mutex                   _mutexCompleted;
+			Vector<PTask>                _vCompleted;
+			Vector<PTask>                _vDeliver;
+			D::RuntimeError              _ex;
+			std::atomic_int              _queuedItemCount;
+			std::atomic_int              _pendingTaskCount;
+			std::atomic_int              _idleThreadCount;
+			std::atomic_int              _spaceWaiterCount;
+			std::atomic_bool             _stopThreads;
+			std::atomic_bool             _failed;
+			bool                         _inUpdate = false;
+			bool                         _flush = false;
+			bool                         _onePerUpdateMode = false;
 
 		public:
 			Async();
 			~Async();
 
-			void Init();
+			// Zero thread count means automatic:
+			void Init(int threadCount = 0);
 			void Done();
 
 			virtual void Load(CSZ url, PAsyncDelegate pDelegate, RcTaskDesc desc = TaskDesc());
 			VERUS_P(virtual void _Cancel(PAsyncDelegate pDelegate));
 			static void Cancel(PAsyncDelegate pDelegate);
 
+			// For example based on distance to camera, has no effect if loading has already started:
+			virtual void SetPriority(CSZ url, int priority);
+
 			virtual void Update();
 
 			void Flush();
 			void SetOnePerUpdateMode(bool b) { _onePerUpdateMode = b; }
 
-			VERUS_P(void ThreadProc());
+			int GetPendingTaskCount() const { return _pendingTaskCount; }
+
+		private:
+			static UINT64 MakeTicket(UINT32 generation, TaskState state) { return (static_cast<UINT64>(generation) << 32) | static_cast<UINT32>(state); }
+			static UINT32 GetGeneration(UINT64 ticket) { return static_cast<UINT32>(ticket >> 32); }
+			static TaskState GetState(UINT64 ticket) { return static_cast<TaskState>(ticket & UINT_MAX); }
+
+			bool PushItem(const QueueItem& item, int priority, bool wait);
+			bool PopItem(QueueItem& item, int& priority);
+			void ProcessTask(PTask pTask);
+			void CompleteTask(PTask pTask);
+			void DeliverTask(PTask pTask);
+			void RetireTask(PTask pTask);
+
+			void ThreadProc();
 		};
 		VERUS_TYPEDEFS(Async);
 	}
@@ -0,0 +1,279 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "verus.h"
+
+using namespace verus;
+using namespace verus::IO;
+
+namespace
+{
+	// LZ4 block format rules:
+	const int s_minMatch = 4;
+	const int s_lastLiterals = 5;
+	const int s_matchFindLimit = 12;
+	const int s_maxOffset = USHRT_MAX;
+	const int s_hashBits = 12;
+
+	inline UINT32 Read32(const BYTE* p)
+	{
+		UINT32 x;
+		memcpy(&x, p, sizeof(x));
+		return x;
+	}
+
+	inline UINT32 HashLZ(UINT32 x)
+	{
+		return (x * 2654435761U) >> (32 - s_hashBits);
+	}
+
+	inline bool WriteLength(BYTE*& pOut, const BYTE* pOutEnd, INT64 len)
+	{
+		while (len >= UCHAR_MAX)
+		{
+			if (pOut >= pOutEnd)
+				return false;
+			*pOut++ = UCHAR_MAX;
+			len -= UCHAR_MAX;
+		}
+		if (pOut >= pOutEnd)
+			return false;
+		*pOut++ = static_cast<BYTE>(len);
+		return true;
+	}
+
+	inline bool ReadLength(const BYTE*& pIn, const BYTE* pInEnd, INT64& len)
+	{
+		BYTE x;
+		do
+		{
+			if (pIn >= pInEnd)
+				return false;
+			x = *pIn++;
+			len += x;
+		} while (UCHAR_MAX == x);
+		return true;
+	}
+
+	bool EmitSequence(BYTE*& pOut, const BYTE* pOutEnd, const BYTE* pLiterals, INT64 literalCount, int offset, INT64 matchLen)
+	{
+		if (pOut >= pOutEnd)
+			return false;
+		BYTE* pToken = pOut++;
+		const INT64 matchCode = offset ? matchLen - s_minMatch : 0;
+		*pToken = static_cast<BYTE>((Math::Min<INT64>(literalCount, 15) << 4) | Math::Min<INT64>(matchCode, 15));
+		if (literalCount >= 15 && !WriteLength(pOut, pOutEnd, literalCount - 15))
+			return false;
+		if (pOutEnd - pOut < literalCount)
+			return false;
+		if (literalCount)
+			memcpy(pOut, pLiterals, static_cast<size_t>(literalCount));
+		pOut += literalCount;
+		if (!offset) // Last sequence?
+			return true;
+		if (pOutEnd - pOut < 2)
+			return false;
+		*pOut++ = static_cast<BYTE>(offset);
+		*pOut++ = static_cast<BYTE>(offset >> 8);
+		if (matchCode >= 15 && !WriteLength(pOut, pOutEnd, matchCode - 15))
+			return false;
+		return true;
+	}
+}
+
+INT64 Codec::ComputeBound(CodecType type, INT64 size)
+{
+	switch (type)
+	{
+	case CodecType::none: return size;
+	case CodecType::zlib: return compressBound(static_cast<uLong>(size));
+	case CodecType::lz: return size + size / UCHAR_MAX + 16;
+	}
+	return size;
+}
+
+INT64 Codec::Compress(CodecType type, const BYTE* pSrc, INT64 srcSize, BYTE* pDst, INT64 dstCapacity)
+{
+	switch (type)
+	{
+	case CodecType::none:
+	{
+		if (dstCapacity < srcSize)
+			return 0;
+		memcpy(pDst, pSrc, static_cast<size_t>(srcSize));
+		return srcSize;
+	}
+	break;
+	case CodecType::zlib:
+	{
+		uLongf zipSize = static_cast<uLongf>(dstCapacity);
+		const int ret = compress(pDst, &zipSize, pSrc, static_cast<uLong>(srcSize));
+		if (ret == Z_BUF_ERROR)
+			return 0;
+		if (ret != Z_OK)
+			throw VERUS_RUNTIME_ERROR << "compress(); " << ret;
+		return zipSize;
+	}
+	break;
+	case CodecType::lz:
+	{
+		return CompressLZ(pSrc, srcSize, pDst, dstCapacity);
+	}
+	break;
+	}
+	throw VERUS_RUNTIME_ERROR << "Compress(); Unknown codec: " << static_cast<int>(type);
+}
+
+void Codec::Decompress(CodecType type, const BYTE* pSrc, INT64 srcSize, BYTE* pDst, INT64 dstSize)
+{
+	switch (type)
+	{
+	case CodecType::none:
+	{
+		if (srcSize != dstSize)
+			throw VERUS_RUNTIME_ERROR << "Decompress(); Invalid size";
+		memcpy(pDst, pSrc, static_cast<size_t>(srcSize));
+	}
+	break;
+	case CodecType::zlib:
+	{
+		uLongf destLen = Utils::Cast32(dstSize);
+		const int ret = uncompress(pDst, &destLen, pSrc, Utils::Cast32(srcSize));
+		if (ret != Z_OK)
+			throw VERUS_RUNTIME_ERROR << "uncompress(); " << ret;
+		if (destLen != dstSize)
+			throw VERUS_RUNTIME_ERROR << "Decompress(); Invalid size";
+	}
+	break;
+	case CodecType::lz:
+	{
+		if (!DecompressLZ(pSrc, srcSize, pDst, dstSize))
+			throw VERUS_RUNTIME_ERROR << "DecompressLZ(); Corrupted data";
+	}
+	break;
+	default:
+		throw VERUS_RUNTIME_ERROR << "Decompress(); Unknown codec: " << static_cast<int>(type);
+	}
+}
+
+INT64 Codec::CompressLZ(const BYTE* pSrc, INT64 srcSize, BYTE* pDst, INT64 dstCapacity)
+{
+	BYTE* pOut = pDst;
+	const BYTE* pOutEnd = pDst + dstCapacity;
+	INT64 anchor = 0;
+
+	if (srcSize > s_matchFindLimit)
+	{
+		INT32 table[1 << s_hashBits];
+		std::fill(std::begin(table), std::end(table), -1);
+
+		const INT64 matchFindLimit = srcSize - s_matchFindLimit;
+		const INT64 matchLimit = srcSize - s_lastLiterals;
+		INT64 pos = 0;
+		while (pos < matchFindLimit)
+		{
+			const UINT32 seq = Read32(pSrc + pos);
+			const UINT32 h = HashLZ(seq);
+			const INT64 ref = table[h];
+			table[h] = static_cast<INT32>(pos);
+			if (ref >= 0 && pos - ref <= s_maxOffset && Read32(pSrc + ref) == seq)
+			{
+				INT64 matchLen = s_minMatch;
+				while (pos + matchLen < matchLimit && pSrc[ref + matchLen] == pSrc[pos + matchLen])
+					matchLen++;
+				if (!EmitSequence(pOut, pOutEnd, pSrc + anchor, pos - anchor, static_cast<int>(pos - ref), matchLen))
+					return 0;
+				pos += matchLen;
+				anchor = pos;
+				if (pos - 2 < matchFindLimit)
+					table[HashLZ(Read32(pSrc + pos - 2))] = static_cast<INT32>(pos - 2);
+			}
+			else
+			{
+				pos += 1 + ((pos - anchor) >> 6); // Skip faster through incompressible data.
+			}
+		}
+	}
+
+	if (!EmitSequence(pOut, pOutEnd, pSrc + anchor, srcSize - anchor, 0, 0))
+		return 0;
+	return pOut - pDst;
+}
+
+bool Codec::DecompressLZ(const BYTE* pSrc, INT64 srcSize, BYTE* pDst, INT64 dstSize)
+{
+	const BYTE* pIn = pSrc;
+	const BYTE* pInEnd = pSrc + srcSize;
+	BYTE* pOut = pDst;
+	const BYTE* pOutEnd = pDst + dstSize;
+	while (pIn < pInEnd)
+	{
+		const BYTE token = *pIn++;
+
+		INT64 literalCount = token >> 4;
+		if (15 == literalCount && !ReadLength(pIn, pInEnd, literalCount))
+			return false;
+		if (pInEnd - pIn < literalCount || pOutEnd - pOut < literalCount)
+			return false;
+		if (literalCount)
+			memcpy(pOut, pIn, static_cast<size_t>(literalCount));
+		pIn += literalCount;
+		pOut += literalCount;
+
+		if (pIn == pInEnd) // Last sequence has no match.
+			break;
+
+		if (pInEnd - pIn < 2)
+			return false;
+		const INT64 offset = pIn[0] | (pIn[1] << 8);
+		pIn += 2;
+		if (!offset || offset > pOut - pDst)
+			return false;
+
+		INT64 matchLen = token & 0xF;
+		if (15 == matchLen && !ReadLength(pIn, pInEnd, matchLen))
+			return false;
+		matchLen += s_minMatch;
+		if (pOutEnd - pOut < matchLen)
+			return false;
+
+		const BYTE* pMatch = pOut - offset;
+		if (offset >= matchLen)
+		{
+			memcpy(pOut, pMatch, static_cast<size_t>(matchLen));
+			pOut += matchLen;
+		}
+		else // Overlapping copy repeats the pattern:
+		{
+			for (INT64 i = 0; i < matchLen; ++i)
+				*pOut++ = *pMatch++;
+		}
+	}
+	return pOut == pOutEnd;
+}
+
+void Codec::Test()
+{
+	Vector<BYTE> vData(100000);
+	VERUS_FOR(i, static_cast<int>(vData.size()))
+		vData[i] = static_cast<BYTE>((i % 251) ^ (i / 1000));
+	memset(vData.data() + 40000, 'A', 5000);
+
+	const CodecType types[] = { CodecType::none, CodecType::zlib, CodecType::lz };
+	for (CodecType type : types)
+	{
+		Vector<BYTE> vZip(ComputeBound(type, vData.size()));
+		const INT64 zipSize = Compress(type, vData.data(), vData.size(), vZip.data(), vZip.size());
+		VERUS_RT_ASSERT(zipSize > 0);
+		Vector<BYTE> vOut(vData.size());
+		Decompress(type, vZip.data(), zipSize, vOut.data(), vOut.size());
+		VERUS_RT_ASSERT(vOut == vData);
+	}
+
+	const BYTE tiny[] = { 1, 2, 3 };
+	BYTE tinyZip[16];
+	BYTE tinyOut[3];
+	const INT64 tinyZipSize = CompressLZ(tiny, sizeof(tiny), tinyZip, sizeof(tinyZip));
+	VERUS_RT_ASSERT(tinyZipSize == 4);
+	VERUS_RT_ASSERT(DecompressLZ(tinyZip, tinyZipSize, tinyOut, sizeof(tinyOut)));
+	VERUS_RT_ASSERT(!memcmp(tiny, tinyOut, sizeof(tiny)));
+	VERUS_RT_ASSERT(!DecompressLZ(tinyZip, tinyZipSize - 1, tinyOut, sizeof(tinyOut)));
+}
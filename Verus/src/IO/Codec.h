@@ -0,0 +1,34 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace IO
+	{
+		enum class CodecType : BYTE
+		{
+			none, // Stored as is.
+			zlib, // Good ratio, slow to decompress.
+			lz    // LZ77 with LZ4 block layout, very fast to decompress.
+		};
+
+		// Block compression. Each call handles one independent block,
+		// so different blocks can be processed on different threads.
+		class Codec
+		{
+		public:
+			// Maximum compressed size for some input size:
+			static INT64 ComputeBound(CodecType type, INT64 size);
+
+			// Returns compressed size or 0 if the output didn't fit:
+			static INT64 Compress(CodecType type, const BYTE* pSrc, INT64 srcSize, BYTE* pDst, INT64 dstCapacity);
+			// Throws if the data is corrupted or the size doesn't match:
+			static void Decompress(CodecType type, const BYTE* pSrc, INT64 srcSize, BYTE* pDst, INT64 dstSize);
+
+			static INT64 CompressLZ(const BYTE* pSrc, INT64 srcSize, BYTE* pDst, INT64 dstCapacity);
+			static bool DecompressLZ(const BYTE* pSrc, INT64 srcSize, BYTE* pDst, INT64 dstSize);
+
+			static void Test();
+		};
+	}
+}
@@ -7,12 +7,43 @@ using namespace verus::IO;
 CSZ FileSystem::s_dataFolder = "/Data/";
 CSZ FileSystem::s_shaderPAK = "[Shaders]:";
 
+// FileSystem::PakPtr:
+
+FileSystem::PakPtr::PakPtr(PcPakArchive p, FileSystem* pFileSystem) :
+	_p(p),
+	_pFileSystem(pFileSystem)
+{
+	_pFileSystem->_pakUseCount++; // OpenPAK() holds the lock.
+}
+
+FileSystem::PakPtr::PakPtr(PakPtr&& that) :
+	_p(that._p),
+	_pFileSystem(that._pFileSystem)
+{
+	that._p = nullptr;
+	that._pFileSystem = nullptr;
+}
+
+FileSystem::PakPtr::~PakPtr()
+{
+	if (!_pFileSystem)
+		return;
+	{
+		VERUS_LOCK(*_pFileSystem);
+		_pFileSystem->_pakUseCount--;
+	}
+	_pFileSystem->_pakReleased.notify_all();
+}
+
+// FileSystem:
+
 FileSystem::FileSystem()
 {
 }
 
 FileSystem::~FileSystem()
 {
+	ClosePAKs();
 }
 
 size_t FileSystem::FindPosForPAK(CSZ url)
@@ -31,7 +62,7 @@ size_t FileSystem::FindPosForPAK(CSZ url)
 void FileSystem::ReadPakHeader(RFile file, UINT32& magic, INT64& entriesOffset, INT64& entriesSize)
 {
 	file >> magic;
-	if (magic != 'KAP2')
+	if (magic != PakArchive::s_magicV2 && magic != PakArchive::s_magicV3)
 		throw VERUS_RUNTIME_ERROR << "ReadPakHeader(); Invalid magic number in PAK";
 
 	file >> entriesOffset;
@@ -44,14 +75,10 @@ void FileSystem::PreloadCache(CSZ pak, CSZ types[])
 {
 	StringStream ss;
 	ss << _C(Utils::I().GetModulePath()) << s_dataFolder << pak;
-	File file;
-	if (!file.Open(_C(ss.str())))
+	const PakPtr pPak = OpenPAK(_C(ss.str()));
+	if (!pPak)
 		return;
 
-	UINT32 magic;
-	INT64 entriesOffset, entriesSize;
-	ReadPakHeader(file, magic, entriesOffset, entriesSize);
-
 	char value[s_querySize];
 
 	auto LoadThisFile = [types](CSZ value)
@@ -66,50 +93,32 @@ void FileSystem::PreloadCache(CSZ pak, CSZ types[])
 		return false;
 	};
 
-	char fileEntry[s_entrySize] = {};
-	INT64 entriesCount = entriesSize / s_entrySize;
-	INT64 pakDataOffset, pakDataSize;
-	file.Seek(entriesOffset, SEEK_SET);
-	while (entriesCount)
+	const INT64 entryCount = pPak->GetEntryCount();
+	VERUS_FOR(i, entryCount)
 	{
-		file >> fileEntry;
+		const PakArchive::Entry entry = pPak->GetEntryAt(i);
 
-		strcpy(value, fileEntry);
+		strcpy(value, entry._name);
 		Str::CyrillicToUppercase(value);
 
 		if (LoadThisFile(value))
 		{
-			memcpy(&pakDataOffset, fileEntry + s_querySize, sizeof(INT64));
-			memcpy(&pakDataSize, fileEntry + s_querySize + sizeof(INT64), sizeof(INT64));
+			const String password = ConvertFilenameToPassword(entry._name);
 
-			const String password = ConvertFilenameToPassword(fileEntry);
-
-			Vector<BYTE> vCip, vZip, vData;
-			const INT64 entryOffset = file.GetPosition();
-			file.Seek(pakDataOffset, SEEK_SET); // [unzipped size][encrypted data].
+			const Blob blob = pPak->GetBlob(entry._offset, entry._size); // [unzipped size][encoded data].
 			INT64 size;
-			file >> size;
+			memcpy(&size, blob._p, sizeof(INT64));
+			Vector<BYTE> vData;
 			vData.resize(size + 1); // For null-terminated string.
-			vCip.resize(pakDataSize - sizeof(INT64));
-			vZip.resize(pakDataSize - sizeof(INT64));
-			file.Read(vCip.data(), vCip.size());
-			Security::CipherRC4::Decrypt(password, vCip, vZip);
-			uLongf destLen = Utils::Cast32(size);
-			const int ret = uncompress(vData.data(), &destLen, vZip.data(), Utils::Cast32(vZip.size()));
-			if (ret != Z_OK)
-				throw VERUS_RUNTIME_ERROR << "uncompress(); " << ret;
+			DecodePakData(pPak->GetMagic(), password, blob, vData.data(), size);
 
 			_cacheSize += vData.size();
 			String key("[");
 			key += pak;
 			Str::ReplaceExtension(key, "]:");
-			key += fileEntry;
+			key += entry._name;
 			_mapCache[key] = std::move(vData);
-
-			file.Seek(entryOffset, SEEK_SET); // Go back to entries.
 		}
-
-		entriesCount--;
 	}
 }
 
@@ -131,6 +140,34 @@ void FileSystem::PreloadDefaultCache()
 	PreloadCache("Textures.pak", types);
 }
 
+FileSystem::PakPtr FileSystem::OpenPAK(CSZ pathname)
+{
+	VERUS_LOCK(*this);
+	RPakArchive pak = _mapPaks[pathname];
+	if (!pak.IsInitialized())
+	{
+		try
+		{
+			if (!pak.Init(pathname))
+				return PakPtr();
+		}
+		catch (D::RcRuntimeError)
+		{
+			pak.Done(); // Try again next time.
+			throw;
+		}
+	}
+	return PakPtr(&pak, this); // Counted under the lock, so that ClosePAKs() sees it.
+}
+
+void FileSystem::ClosePAKs()
+{
+	// Other threads can still read from PAKs, which they have opened before. Waiting releases the lock:
+	VERUS_LOCK(*this);
+	_pakReleased.wait(lock, [this]() { return !_pakUseCount; });
+	_mapPaks.clear();
+}
+
 void FileSystem::LoadResource(CSZ url, Vector<BYTE>& vData, RcLoadDesc desc)
 {
 	String pakPathname, pakEntry;
@@ -149,11 +186,18 @@ void FileSystem::LoadResource(CSZ url, Vector<BYTE>& vData, RcLoadDesc desc)
 
 	if (pakPathname.empty() || pakEntry.empty()) // System file name?
 		return LoadResourceFromFile(url, vData, desc);
-	File pakFile;
-	if (!pakFile.Open(_C(pakPathname))) // PAK not found? Try system file.
+	if (!IsValidSingleton()) // Called from a library without FileSystem?
+	{
+		PakArchive pak;
+		if (!pak.Init(_C(pakPathname)))
+			return LoadResourceFromFile(url, vData, desc);
+		return LoadResourceFromPAK(url, vData, desc, pak, _C(pakEntry));
+	}
+	const PakPtr pPak = I().OpenPAK(_C(pakPathname));
+	if (!pPak) // PAK not found? Try system file.
 		return LoadResourceFromFile(url, vData, desc);
 
-	LoadResourceFromPAK(url, vData, desc, pakFile, _C(pakEntry));
+	LoadResourceFromPAK(url, vData, desc, *pPak, _C(pakEntry));
 }
 
 void FileSystem::LoadResourceFromFile(CSZ url, Vector<BYTE>& vData, RcLoadDesc desc)
@@ -216,63 +260,34 @@ void FileSystem::LoadResourceFromCache(CSZ url, Vector<BYTE>& vData, bool mandat
 		throw VERUS_RUNTIME_ERROR << "LoadResourceFromCache(); File not found in cache: " << url;
 }
 
-void FileSystem::LoadResourceFromPAK(CSZ url, Vector<BYTE>& vData, RcLoadDesc desc, RFile file, CSZ pakEntry)
+void FileSystem::LoadResourceFromPAK(CSZ url, Vector<BYTE>& vData, RcLoadDesc desc, RcPakArchive pak, CSZ pakEntry)
 {
-	UINT32 magic;
-	INT64 entriesOffset, entriesSize;
-	ReadPakHeader(file, magic, entriesOffset, entriesSize);
-
-	char query[s_querySize];
-	char value[s_querySize];
-	strcpy(query, pakEntry);
-	Str::CyrillicToUppercase(query);
-
-	bool found = false;
-	char fileEntry[s_entrySize] = {};
-	INT64 entriesCount = entriesSize / s_entrySize;
-	INT64 pakDataOffset, pakDataSize;
-	file.Seek(entriesOffset, SEEK_SET);
-	while (entriesCount)
-	{
-		file >> fileEntry;
-
-		strcpy(value, fileEntry);
-		Str::CyrillicToUppercase(value);
-
-		if (!_stricmp(query, value))
-		{
-			memcpy(&pakDataOffset, fileEntry + s_querySize, sizeof(INT64));
-			memcpy(&pakDataSize, fileEntry + s_querySize + sizeof(INT64), sizeof(INT64));
-			found = true;
-			break;
-		}
-		entriesCount--;
-	}
-	if (!found) // Resource is not in PAK file?
+	PakArchive::Entry entry;
+	if (!pak.FindEntry(pakEntry, entry)) // Resource is not in PAK file?
 	{
 		if (Str::EndsWith(pakEntry, ".primary"))
 			return;
 		return LoadResourceFromFile(url, vData, desc);
 	}
 
-	const String password = ConvertFilenameToPassword(fileEntry);
+	const String password = ConvertFilenameToPassword(entry._name);
 
-	Vector<BYTE> vCip, vZip;
-	file.Seek(pakDataOffset, SEEK_SET);
-	if (Str::EndsWith(query, ".dds", false))
+	const Blob blob = pak.GetBlob(entry._offset, entry._size);
+	StreamPtr sp(blob);
+	if (Str::EndsWith(pakEntry, ".dds", false))
 	{
 		const int maxParts = 8;
 		INT64 partEntries[maxParts * 3] = {};
 
 		int headerSize = sizeof(DDSHeader);
 		DDSHeader header;
-		file >> header;
+		sp >> header;
 		if (!header.Validate())
 			throw VERUS_RUNTIME_ERROR << "LoadResourceFromPAK(); Invalid DDS header: " << url;
 		DDSHeaderDXT10 header10;
 		if (header.IsDXT10())
 		{
-			file >> header10;
+			sp >> header10;
 			headerSize += sizeof(DDSHeaderDXT10);
 		}
 		const int partCount = header.GetPartCount();
@@ -284,9 +299,9 @@ void FileSystem::LoadResourceFromPAK(CSZ url, Vector<BYTE>& vData, RcLoadDesc de
 		INT64 totalSize = headerSize;
 		VERUS_FOR(part, partCount)
 		{
-			file >> partEntries[part * 3 + 0];
-			file >> partEntries[part * 3 + 1];
-			file >> partEntries[part * 3 + 2];
+			sp >> partEntries[part * 3 + 0];
+			sp >> partEntries[part * 3 + 1];
+			sp >> partEntries[part * 3 + 2];
 			if (part >= skipPartCount)
 				totalSize += partEntries[part * 3 + 1];
 		}
@@ -306,18 +321,11 @@ void FileSystem::LoadResourceFromPAK(CSZ url, Vector<BYTE>& vData, RcLoadDesc de
 			INT64 size = 0;
 			if (part >= skipPartCount)
 			{
-				file.Seek(pakDataOffset + partOffset, SEEK_SET);
-				file >> size;
+				const Blob partBlob = pak.GetBlob(entry._offset + partOffset, partZipSize);
+				memcpy(&size, partBlob._p, sizeof(INT64));
 				if (size != partSize)
 					throw VERUS_RUNTIME_ERROR << "LoadResourceFromPAK(); Invalid size in PAK";
-				vCip.resize(partZipSize - sizeof(INT64));
-				vZip.resize(partZipSize - sizeof(INT64));
-				file.Read(vCip.data(), vCip.size());
-				Security::CipherRC4::Decrypt(password, vCip, vZip);
-				uLongf destLen = Utils::Cast32(size);
-				const int ret = uncompress(vData.data() + dataPos, &destLen, vZip.data(), Utils::Cast32(vZip.size()));
-				if (ret != Z_OK)
-					throw VERUS_RUNTIME_ERROR << "uncompress(); " << ret;
+				DecodePakData(pak.GetMagic(), password, partBlob, vData.data() + dataPos, size, part);
 			}
 			dataPos += size;
 		}
@@ -325,18 +333,172 @@ void FileSystem::LoadResourceFromPAK(CSZ url, Vector<BYTE>& vData, RcLoadDesc de
 	else
 	{
 		INT64 size;
-		file >> size;
+		sp >> size;
 		const INT64 vsize = desc._nullTerm ? size + 1 : size;
 		vData.resize(vsize);
-		vCip.resize(pakDataSize - sizeof(INT64));
-		vZip.resize(pakDataSize - sizeof(INT64));
-		file.Read(vCip.data(), vCip.size());
-		Security::CipherRC4::Decrypt(password, vCip, vZip);
-		uLongf destLen = Utils::Cast32(size);
-		const int ret = uncompress(vData.data(), &destLen, vZip.data(), Utils::Cast32(vZip.size()));
-		if (ret != Z_OK)
-			throw VERUS_RUNTIME_ERROR << "uncompress(); " << ret;
+		DecodePakData(pak.GetMagic(), password, blob, vData.data(), size);
+	}
+}
+
+void FileSystem::DecodePakData(UINT32 magic, RcString password, RcBlob blob, BYTE* pDest, INT64 destSize, int part)
+{
+	if (blob._size < static_cast<INT64>(sizeof(INT64)))
+		throw VERUS_RUNTIME_ERROR << "DecodePakData(); Invalid size in PAK";
+	const BYTE* pData = blob._p + sizeof(INT64);
+	const INT64 dataSize = blob._size - sizeof(INT64);
+
+	if (PakArchive::s_magicV2 == magic) // Single zlib stream:
+	{
+		Vector<BYTE> vZip(dataSize);
+		Security::CipherRC4::Decrypt(password, pData, vZip.data(), vZip.size());
+		Codec::Decompress(CodecType::zlib, vZip.data(), vZip.size(), pDest, destSize);
+		return;
+	}
+
+	PakBlockHeader blockHeader;
+	if (dataSize < static_cast<INT64>(sizeof(blockHeader)))
+		throw VERUS_RUNTIME_ERROR << "DecodePakData(); Invalid size in PAK";
+	memcpy(&blockHeader, pData, sizeof(blockHeader));
+	if (!blockHeader._chunkSize)
+		throw VERUS_RUNTIME_ERROR << "DecodePakData(); Invalid chunk size in PAK";
+	const INT64 chunkSize = blockHeader._chunkSize;
+	const int chunkCount = static_cast<int>(Math::DivideByMultiple<INT64>(destSize, chunkSize));
+	const INT64 headerSize = sizeof(blockHeader) + chunkCount * sizeof(UINT32);
+	if (dataSize < headerSize)
+		throw VERUS_RUNTIME_ERROR << "DecodePakData(); Invalid size in PAK";
+
+	Vector<INT64> vOffsets(chunkCount + 1);
+	vOffsets[0] = headerSize;
+	VERUS_FOR(i, chunkCount)
+	{
+		UINT32 zipSize;
+		memcpy(&zipSize, pData + sizeof(blockHeader) + i * sizeof(UINT32), sizeof(UINT32));
+		vOffsets[i + 1] = vOffsets[i] + zipSize;
+	}
+	if (vOffsets[chunkCount] > dataSize)
+		throw VERUS_RUNTIME_ERROR << "DecodePakData(); Invalid size in PAK";
+
+	const bool cipher = !!(blockHeader._flags & PakBlockHeader::cipher);
+	std::atomic_bool failed(false);
+	auto DecodeChunk = [&](int i)
+	{
+		const INT64 offset = i * chunkSize;
+		const INT64 size = Math::Min(chunkSize, destSize - offset);
+		const BYTE* pZip = pData + vOffsets[i];
+		const INT64 zipSize = vOffsets[i + 1] - vOffsets[i];
+		try
+		{
+			if (zipSize == size) // Stored?
+			{
+				if (cipher)
+					Security::CipherRC4::Decrypt(MakeChunkPassword(password, part, i), pZip, pDest + offset, static_cast<size_t>(size));
+				else
+					memcpy(pDest + offset, pZip, static_cast<size_t>(size));
+			}
+			else if (cipher)
+			{
+				Vector<BYTE> vZip(zipSize);
+				Security::CipherRC4::Decrypt(MakeChunkPassword(password, part, i), pZip, vZip.data(), vZip.size());
+				Codec::Decompress(blockHeader._codec, vZip.data(), zipSize, pDest + offset, size);
+			}
+			else
+			{
+				Codec::Decompress(blockHeader._codec, pZip, zipSize, pDest + offset, size);
+			}
+		}
+		catch (D::RcRuntimeError)
+		{
+			failed = true;
+		}
+	};
+	if (chunkCount >= s_minParallelChunkCount)
+	{
+		Parallel::For(0, chunkCount, DecodeChunk);
 	}
+	else
+	{
+		VERUS_FOR(i, chunkCount)
+			DecodeChunk(i);
+	}
+	if (failed)
+		throw VERUS_RUNTIME_ERROR << "DecodePakData(); Corrupted chunk in PAK";
+}
+
+bool FileSystem::EncodePakData(CodecType codec, bool cipher, RcString password, const BYTE* p, INT64 size, Vector<BYTE>& vBlock, int part)
+{
+	PakBlockHeader blockHeader;
+	blockHeader._chunkSize = PakArchive::s_defaultChunkSize;
+	blockHeader._codec = codec;
+	blockHeader._flags = cipher ? PakBlockHeader::cipher : 0;
+
+	const INT64 chunkSize = blockHeader._chunkSize;
+	const int chunkCount = static_cast<int>(Math::DivideByMultiple<INT64>(size, chunkSize));
+	Vector<Vector<BYTE>> vChunks(chunkCount);
+	std::atomic_bool failed(false);
+	auto EncodeChunk = [&](int i)
+	{
+		const INT64 offset = i * chunkSize;
+		const INT64 chunkDataSize = Math::Min(chunkSize, size - offset);
+		Vector<BYTE>& vChunk = vChunks[i];
+		vChunk.resize(Codec::ComputeBound(codec, chunkDataSize));
+		INT64 zipSize = 0;
+		try
+		{
+			zipSize = Codec::Compress(codec, p + offset, chunkDataSize, vChunk.data(), vChunk.size());
+		}
+		catch (D::RcRuntimeError)
+		{
+			failed = true;
+			return;
+		}
+		if (!zipSize || zipSize >= chunkDataSize) // Incompressible? Store it.
+		{
+			zipSize = chunkDataSize;
+			memcpy(vChunk.data(), p + offset, chunkDataSize);
+		}
+		vChunk.resize(zipSize);
+		if (cipher)
+			Security::CipherRC4::Encrypt(MakeChunkPassword(password, part, i), vChunk.data(), vChunk.data(), vChunk.size());
+	};
+	if (chunkCount >= s_minParallelChunkCount)
+	{
+		Parallel::For(0, chunkCount, EncodeChunk);
+	}
+	else
+	{
+		VERUS_FOR(i, chunkCount)
+			EncodeChunk(i);
+	}
+	if (failed)
+		return false;
+
+	size_t blockSize = sizeof(blockHeader) + chunkCount * sizeof(UINT32);
+	for (const auto& vChunk : vChunks)
+		blockSize += vChunk.size();
+	vBlock.resize(blockSize);
+	BYTE* pBlock = vBlock.data();
+	memcpy(pBlock, &blockHeader, sizeof(blockHeader));
+	pBlock += sizeof(blockHeader);
+	for (const auto& vChunk : vChunks)
+	{
+		const UINT32 zipSize = Utils::Cast32(vChunk.size());
+		memcpy(pBlock, &zipSize, sizeof(zipSize));
+		pBlock += sizeof(zipSize);
+	}
+	for (const auto& vChunk : vChunks)
+	{
+		memcpy(pBlock, vChunk.data(), vChunk.size());
+		pBlock += vChunk.size();
+	}
+	return true;
+}
+
+String FileSystem::MakeChunkPassword(RcString password, int part, int chunk)
+{
+	// Prefix, because RC4 uses only the first 256 characters:
+	char prefix[32];
+	sprintf_s(prefix, "%d.%d:", part, chunk);
+	return String(prefix) + password;
 }
 
 void FileSystem::LoadTextureParts(RFile file, CSZ url, int texturePart, Vector<BYTE>& vData)
@@ -388,6 +550,54 @@ String FileSystem::ConvertFilenameToPassword(CSZ fileEntry)
 	return password;
 }
 
+void FileSystem::Test()
+{
+	// More than one chunk, first two chunks are equal and incompressible, so they are stored as is:
+	const INT64 chunkSize = PakArchive::s_defaultChunkSize;
+	const INT64 size = chunkSize * 2 + chunkSize / 2;
+	Vector<BYTE> vData(size);
+	UINT32 seed = 1;
+	VERUS_FOR(i, static_cast<int>(chunkSize))
+	{
+		seed = seed * 1664525 + 1013904223;
+		vData[i] = vData[i + chunkSize] = static_cast<BYTE>(seed >> 24);
+	}
+	VERUS_FOR(i, static_cast<int>(size - chunkSize * 2))
+		vData[i + chunkSize * 2] = static_cast<BYTE>(i % 7);
+
+	const String password = ConvertFilenameToPassword("Test/Test.bin");
+	const CodecType types[] = { CodecType::none, CodecType::zlib, CodecType::lz };
+	for (CodecType type : types)
+	{
+		Vector<BYTE> vBlock;
+		const bool encoded = EncodePakData(type, true, password, vData.data(), size, vBlock, 1);
+		VERUS_RT_ASSERT(encoded);
+
+		// Same plaintext must not give the same ciphertext:
+		const BYTE* pChunks = vBlock.data() + sizeof(PakBlockHeader) + 3 * sizeof(UINT32);
+		VERUS_RT_ASSERT(memcmp(pChunks, pChunks + chunkSize, static_cast<size_t>(chunkSize)));
+
+		Vector<BYTE> vPak(sizeof(INT64) + vBlock.size());
+		memcpy(vPak.data(), &size, sizeof(size));
+		memcpy(vPak.data() + sizeof(size), vBlock.data(), vBlock.size());
+		Vector<BYTE> vOut(size);
+		DecodePakData(PakArchive::s_magicV3, password, Blob(vPak.data(), vPak.size()), vOut.data(), size, 1);
+		VERUS_RT_ASSERT(vOut == vData);
+
+		// Other part uses other keys:
+		bool failed = false;
+		try
+		{
+			DecodePakData(PakArchive::s_magicV3, password, Blob(vPak.data(), vPak.size()), vOut.data(), size, 0);
+		}
+		catch (D::RcRuntimeError)
+		{
+			failed = true;
+		}
+		VERUS_RT_ASSERT(failed || vOut != vData);
+	}
+}
+
 bool FileSystem::FileExist(CSZ url)
 {
 	String pathname(url), pakPathname, projectPathname;
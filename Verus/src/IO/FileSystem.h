@@ -13,17 +13,41 @@ namespace verus
 			jpg
 		};
 
-		class FileSystem : public Singleton<FileSystem>
+		class FileSystem : public Singleton<FileSystem>, public Lockable
 		{
 			typedef Map<String, Vector<BYTE>> TMapCache;
+			typedef Map<String, PakArchive> TMapPaks;
 
 			static CSZ s_dataFolder;
 			static CSZ s_shaderPAK;
 
-			TMapCache _mapCache;
-			INT64     _cacheSize = 0;
+			TMapCache               _mapCache;
+			TMapPaks                _mapPaks;
+			std::condition_variable _pakReleased;
+			INT64                   _cacheSize = 0;
+			int                     _pakUseCount = 0; // Guarded by the lock.
 
 		public:
+			// PAK file stays open while this object exists:
+			class PakPtr
+			{
+				PcPakArchive _p = nullptr;
+				FileSystem*  _pFileSystem = nullptr;
+
+				PakPtr(const PakPtr&) = delete;
+				PakPtr& operator=(const PakPtr&) = delete;
+
+			public:
+				PakPtr() {}
+				PakPtr(PcPakArchive p, FileSystem* pFileSystem);
+				PakPtr(PakPtr&& that);
+				~PakPtr();
+
+				PcPakArchive operator->() const { return _p; }
+				RcPakArchive operator*() const { return *_p; }
+				explicit operator bool() const { return !!_p; }
+			};
+
 			struct LoadDesc
 			{
 				int  _texturePart = 0;
@@ -37,6 +61,7 @@ namespace verus
 
 			static const int s_querySize = 240;
 			static const int s_entrySize = 256;
+			static const int s_minParallelChunkCount = 4;
 
 			FileSystem();
 			~FileSystem();
@@ -47,16 +72,29 @@ namespace verus
 			void PreloadCache(CSZ pak, CSZ types[]);
 			void PreloadDefaultCache();
 
+			// PAK files are opened once and stay mapped until closed:
+			PakPtr OpenPAK(CSZ pathname);
+			// Waits without the lock until all PakPtr objects are destroyed, so their owners can still call OpenPAK():
+			void ClosePAKs();
+
 			static void LoadResource			/**/(CSZ url, Vector<BYTE>& vData, RcLoadDesc desc = LoadDesc());
 			static void LoadResourceFromFile	/**/(CSZ url, Vector<BYTE>& vData, RcLoadDesc desc = LoadDesc());
 
 			void LoadResourceFromCache(CSZ url, Vector<BYTE>& vData, bool mandatory = true);
 
-			VERUS_P(static void LoadResourceFromPAK(CSZ url, Vector<BYTE>& vData, RcLoadDesc desc, RFile file, CSZ pakEntry));
+			static void LoadResourceFromPAK(CSZ url, Vector<BYTE>& vData, RcLoadDesc desc, RcPakArchive pak, CSZ pakEntry);
+			// Blob must start with uncompressed size, chunks of 3PAK are decoded in parallel. Part is texture's part index:
+			static void DecodePakData(UINT32 magic, RcString password, RcBlob blob, BYTE* pDest, INT64 destSize, int part = 0);
+			// Creates 3PAK data block without uncompressed size, see PakBlockHeader. Returns false if some chunk failed:
+			static bool EncodePakData(CodecType codec, bool cipher, RcString password, const BYTE* p, INT64 size, Vector<BYTE>& vBlock, int part = 0);
+			// Each chunk is encrypted with it's own key, so that chunks never share RC4 keystream:
+			static String MakeChunkPassword(RcString password, int part, int chunk);
 
 			static void LoadTextureParts(RFile file, CSZ url, int texturePart, Vector<BYTE>& vData);
 			static String ConvertFilenameToPassword(CSZ fileEntry);
 
+			static void Test();
+
 			static bool FileExist(CSZ url);
 			static bool Delete(CSZ pathname);
 
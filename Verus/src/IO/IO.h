@@ -5,6 +5,8 @@
 #include "Stream.h"
 #include "StreamPtr.h"
 #include "File.h"
+#include "Codec.h"
+#include "PakArchive.h"
 #include "FileSystem.h"
 #include "Async.h"
 #include "Json.h"
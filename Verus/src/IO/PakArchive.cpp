@@ -0,0 +1,196 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "verus.h"
+
+using namespace verus;
+using namespace verus::IO;
+
+PakArchive::PakArchive()
+{
+}
+
+PakArchive::~PakArchive()
+{
+	Done();
+}
+
+bool PakArchive::Init(CSZ pathname)
+{
+	VERUS_INIT();
+
+#ifdef _WIN32
+	const WideString pathnameW = Str::Utf8ToWide(pathname);
+	_hFile = CreateFile(_C(pathnameW), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (INVALID_HANDLE_VALUE == _hFile)
+	{
+		Done();
+		return false;
+	}
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(_hFile, &fileSize) || !fileSize.QuadPart)
+	{
+		Done();
+		return false;
+	}
+	_viewSize = fileSize.QuadPart;
+	_hMapping = CreateFileMapping(_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!_hMapping)
+	{
+		Done();
+		return false;
+	}
+	_pView = static_cast<const BYTE*>(MapViewOfFile(_hMapping, FILE_MAP_READ, 0, 0, 0));
+#else
+	_fd = open(pathname, O_RDONLY);
+	if (-1 == _fd)
+	{
+		Done();
+		return false;
+	}
+	struct stat st;
+	if (fstat(_fd, &st) || !st.st_size)
+	{
+		Done();
+		return false;
+	}
+	_viewSize = st.st_size;
+	void* p = mmap(nullptr, static_cast<size_t>(_viewSize), PROT_READ, MAP_PRIVATE, _fd, 0);
+	_pView = (MAP_FAILED != p) ? static_cast<const BYTE*>(p) : nullptr;
+#endif
+	if (!_pView)
+	{
+		Done();
+		return false;
+	}
+
+	// Header:
+	const INT64 headerSize = sizeof(UINT32) + sizeof(INT64) * 2;
+	if (_viewSize < headerSize)
+		throw VERUS_RUNTIME_ERROR << "Init(); Invalid PAK size: " << pathname;
+	INT64 entriesSize = 0;
+	memcpy(&_magic, _pView, sizeof(UINT32));
+	memcpy(&_entriesOffset, _pView + sizeof(UINT32), sizeof(INT64));
+	memcpy(&entriesSize, _pView + sizeof(UINT32) + sizeof(INT64), sizeof(INT64));
+	if (_magic != s_magicV2 && _magic != s_magicV3)
+		throw VERUS_RUNTIME_ERROR << "Init(); Invalid magic number in PAK: " << pathname;
+	if (entriesSize % FileSystem::s_entrySize)
+		throw VERUS_RUNTIME_ERROR << "Init(); Invalid size of entries in PAK: " << pathname;
+	if (_entriesOffset < headerSize || _entriesOffset + entriesSize > _viewSize)
+		throw VERUS_RUNTIME_ERROR << "Init(); Invalid entries offset in PAK: " << pathname;
+	_entryCount = entriesSize / FileSystem::s_entrySize;
+
+	// Build hash table, load factor is at most 0.5:
+	UINT32 slotCount = 16;
+	while (slotCount < _entryCount * 2)
+		slotCount <<= 1;
+	const UINT32 mask = slotCount - 1;
+	_vHashes.resize(_entryCount);
+	_vSlots.resize(slotCount);
+	VERUS_FOR(i, _entryCount)
+	{
+		CSZ name = reinterpret_cast<CSZ>(_pView + _entriesOffset + i * FileSystem::s_entrySize);
+		if (strnlen(name, FileSystem::s_querySize) == FileSystem::s_querySize)
+			throw VERUS_RUNTIME_ERROR << "Init(); Invalid entry name in PAK: " << pathname;
+		const UINT64 hash = ComputeHash(name);
+		_vHashes[i] = hash;
+		UINT32 slot = static_cast<UINT32>(hash) & mask;
+		while (_vSlots[slot])
+			slot = (slot + 1) & mask;
+		_vSlots[slot] = i + 1;
+	}
+
+	return true;
+}
+
+void PakArchive::Done()
+{
+#ifdef _WIN32
+	if (_pView)
+		UnmapViewOfFile(_pView);
+	if (_hMapping)
+		CloseHandle(_hMapping);
+	if (INVALID_HANDLE_VALUE != _hFile)
+		CloseHandle(_hFile);
+#else
+	if (_pView)
+		munmap(const_cast<BYTE*>(_pView), static_cast<size_t>(_viewSize));
+	if (-1 != _fd)
+		close(_fd);
+#endif
+	VERUS_DONE(PakArchive);
+}
+
+PakArchive::Entry PakArchive::GetEntryAt(INT64 index) const
+{
+	VERUS_RT_ASSERT(index >= 0 && index < _entryCount);
+	const BYTE* p = _pView + _entriesOffset + index * FileSystem::s_entrySize;
+	Entry entry;
+	entry._name = reinterpret_cast<CSZ>(p);
+	memcpy(&entry._offset, p + FileSystem::s_querySize, sizeof(INT64));
+	memcpy(&entry._size, p + FileSystem::s_querySize + sizeof(INT64), sizeof(INT64));
+	return entry;
+}
+
+bool PakArchive::FindEntry(CSZ name, REntry entry) const
+{
+	if (!_entryCount)
+		return false;
+
+	char query[FileSystem::s_querySize];
+	char value[FileSystem::s_querySize];
+	FoldName(name, query);
+	const UINT64 hash = ComputeFoldedHash(query);
+
+	const UINT32 mask = Utils::Cast32(_vSlots.size() - 1);
+	UINT32 slot = static_cast<UINT32>(hash) & mask;
+	while (_vSlots[slot])
+	{
+		const UINT32 index = _vSlots[slot] - 1;
+		if (_vHashes[index] == hash)
+		{
+			entry = GetEntryAt(index);
+			FoldName(entry._name, value);
+			if (!strcmp(query, value))
+				return true;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return false;
+}
+
+Blob PakArchive::GetBlob(INT64 offset, INT64 size) const
+{
+	if (offset < 0 || size < 0 || offset + size > _viewSize)
+		throw VERUS_RUNTIME_ERROR << "GetBlob(); Invalid range in PAK";
+	return Blob(_pView + offset, size);
+}
+
+UINT64 PakArchive::ComputeHash(CSZ name)
+{
+	char folded[FileSystem::s_querySize];
+	FoldName(name, folded);
+	return ComputeFoldedHash(folded);
+}
+
+UINT64 PakArchive::ComputeFoldedHash(CSZ folded)
+{
+	// FNV-1a:
+	UINT64 hash = 14695981039346656037ULL;
+	for (CSZ p = folded; *p; ++p)
+	{
+		hash ^= static_cast<BYTE>(*p);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+void PakArchive::FoldName(CSZ name, SZ folded)
+{
+	strncpy(folded, name, FileSystem::s_querySize - 1);
+	folded[FileSystem::s_querySize - 1] = 0;
+	Str::CyrillicToUppercase(folded);
+	for (SZ p = folded; *p; ++p)
+	{
+		if (*p >= 'a' && *p <= 'z')
+			*p -= 'a' - 'A';
+	}
+}
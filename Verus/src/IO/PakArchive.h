@@ -0,0 +1,84 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace IO
+	{
+		// PAK v3 data block follows the uncompressed size and contains:
+		// header, compressed size of each chunk (UINT32), chunks.
+		// Chunks are compressed independently, so they can be decompressed in parallel.
+		// Chunk with compressed size equal to it's uncompressed size is stored as is.
+		struct PakBlockHeader
+		{
+			enum Flags : BYTE
+			{
+				cipher = (1 << 0)
+			};
+
+			UINT32    _chunkSize = 0;
+			CodecType _codec = CodecType::lz;
+			BYTE      _flags = 0;
+			UINT16    _reserved = 0;
+		};
+		VERUS_TYPEDEFS(PakBlockHeader);
+
+		// Read-only view of a PAK file. The whole file is memory-mapped once and
+		// the entry table is indexed by a case-folded hash, so finding an entry
+		// is O(1) and doesn't allocate. Data can be read concurrently.
+		class PakArchive : public Object
+		{
+		public:
+			static const UINT32 s_magicV2 = 'KAP2'; // "2PAK", RC4 & zlib.
+			static const UINT32 s_magicV3 = 'KAP3'; // "3PAK", chunks, see PakBlockHeader.
+			static const UINT32 s_defaultChunkSize = 256 * 1024;
+
+			struct Entry
+			{
+				CSZ   _name = nullptr; // Points into the mapped entry table.
+				INT64 _offset = 0;
+				INT64 _size = 0;
+			};
+			VERUS_TYPEDEFS(Entry);
+
+		private:
+			Vector<UINT64> _vHashes;
+			Vector<UINT32> _vSlots; // Open addressing, stores entry index + 1.
+			const BYTE*    _pView = nullptr;
+			INT64          _viewSize = 0;
+			INT64          _entriesOffset = 0;
+			INT64          _entryCount = 0;
+			UINT32         _magic = 0;
+#ifdef _WIN32
+			HANDLE         _hFile = INVALID_HANDLE_VALUE;
+			HANDLE         _hMapping = nullptr;
+#else
+			int            _fd = -1;
+#endif
+
+		public:
+			PakArchive();
+			~PakArchive();
+
+			// Returns false if the file doesn't exist or cannot be mapped.
+			bool Init(CSZ pathname);
+			void Done();
+
+			UINT32 GetMagic() const { return _magic; }
+			INT64 GetEntryCount() const { return _entryCount; }
+			Entry GetEntryAt(INT64 index) const;
+
+			// Entry name is expected to be in ANSI encoding, same as in PAK file.
+			bool FindEntry(CSZ name, REntry entry) const;
+
+			// Returns the mapped bytes at some offset, checks the range:
+			Blob GetBlob(INT64 offset, INT64 size) const;
+
+			static UINT64 ComputeHash(CSZ name);
+			static UINT64 ComputeFoldedHash(CSZ folded);
+			// Same rules as CyrillicToUppercase() + _stricmp():
+			static void FoldName(CSZ name, SZ folded);
+		};
+		VERUS_TYPEDEFS(PakArchive);
+	}
+}
@@ -32,6 +32,7 @@ namespace verus
 			Relation ContainsAabb(RcBounds bounds) const;
 			void Draw();
 
+			RcPlane GetPlane(int index) const { return _planes[index]; }
 			RcPoint3 GetCorner(int index) const { return _corners[index]; }
 			RcPoint3 GetZNearPosition() const { return _corners[8]; }
 			RcPoint3 GetZFarPosition() const { return _corners[9]; }
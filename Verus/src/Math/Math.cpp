@@ -100,6 +100,56 @@ bool Math::IsNaN(float x)
 	return y != y;
 }
 
+void Math::RadixSort(UINT64* pKeys, UINT32* pValues, UINT64* pTempKeys, UINT32* pTempValues, int count)
+{
+	if (count < 2)
+		return;
+
+	// Histograms for all eight bytes in one pass:
+	UINT32 histograms[8][256] = {};
+	VERUS_FOR(i, count)
+	{
+		const UINT64 key = pKeys[i];
+		VERUS_FOR(b, 8)
+			histograms[b][(key >> (b << 3)) & 0xFF]++;
+	}
+
+	UINT64* pSrcKeys = pKeys;
+	UINT32* pSrcValues = pValues;
+	UINT64* pDstKeys = pTempKeys;
+	UINT32* pDstValues = pTempValues;
+	VERUS_FOR(b, 8)
+	{
+		const int shift = b << 3;
+		UINT32* pHistogram = histograms[b];
+		if (pHistogram[(pSrcKeys[0] >> shift) & 0xFF] == static_cast<UINT32>(count))
+			continue; // Nothing to sort by.
+
+		UINT32 offset = 0;
+		VERUS_FOR(i, 256)
+		{
+			const UINT32 n = pHistogram[i];
+			pHistogram[i] = offset;
+			offset += n;
+		}
+		VERUS_FOR(i, count)
+		{
+			const UINT64 key = pSrcKeys[i];
+			const UINT32 pos = pHistogram[(key >> shift) & 0xFF]++;
+			pDstKeys[pos] = key;
+			pDstValues[pos] = pSrcValues[i];
+		}
+		std::swap(pSrcKeys, pDstKeys);
+		std::swap(pSrcValues, pDstValues);
+	}
+
+	if (pSrcKeys != pKeys)
+	{
+		memcpy(pKeys, pSrcKeys, count * sizeof(UINT64));
+		memcpy(pValues, pSrcValues, count * sizeof(UINT32));
+	}
+}
+
 float Math::ToRadians(float deg)
 {
 	return deg * (VERUS_PI * (1 / 180.f));
@@ -501,6 +551,30 @@ void Math::Test()
 	const glm::vec3 eps(0.1f, 0.1f, 0.1f);
 	const glm::vec4 eps4(0.1f, 0.1f, 0.1f, 0.1f);
 
+	{
+		Random random(1234);
+		const int count = 5000;
+		Vector<UINT64> vKeys(count), vTempKeys(count);
+		Vector<UINT32> vValues(count), vTempValues(count);
+		Vector<std::pair<UINT64, UINT32>> vRef(count);
+		VERUS_FOR(i, count)
+		{
+			// Many duplicates, some bytes are the same for all keys:
+			vKeys[i] = (static_cast<UINT64>(random.Next(0, 7)) << 56) | (static_cast<UINT64>(random.Next(0, 255)) << 16) | random.Next(0, 3);
+			vValues[i] = i;
+			vRef[i] = std::make_pair(vKeys[i], i);
+		}
+		RadixSort(vKeys.data(), vValues.data(), vTempKeys.data(), vTempValues.data(), count);
+		std::stable_sort(vRef.begin(), vRef.end(), [](const std::pair<UINT64, UINT32>& a, const std::pair<UINT64, UINT32>& b)
+			{
+				return a.first < b.first;
+			});
+		VERUS_FOR(i, count)
+		{
+			VERUS_RT_ASSERT(vKeys[i] == vRef[i].first && vValues[i] == vRef[i].second);
+		}
+	}
+
 	{
 		Vector3 zeroV3(0), nonZeroV3(2, 3, 4);
 		Vector4 zeroV4(0), nonZeroV4(3, 4, 5, 6);
@@ -108,6 +108,11 @@ namespace verus
 		int LowestBit(int x);
 		bool IsNaN(float x);
 
+		// Sorting:
+		// Stable LSD radix sort, sorted keys and values end up in pKeys and pValues.
+		// Bytes, which are the same for all keys, are skipped.
+		void RadixSort(UINT64* pKeys, UINT32* pValues, UINT64* pTempKeys, UINT32* pTempValues, int count);
+
 		// Angles:
 		float ToRadians(float deg);
 		float ToDegrees(float rad);
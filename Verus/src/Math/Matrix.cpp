@@ -290,6 +290,20 @@ mataff Transform3::UniformBufferFormat() const
 	return mataff(m);
 }
 
+void Transform3::UniformBufferFormat(mataff& dst) const
+{
+	// Same result without temporary matrices, rows are stored directly:
+	__m128 col0 = getCol0().get128();
+	__m128 col1 = getCol1().get128();
+	__m128 col2 = getCol2().get128();
+	__m128 col3 = getCol3().get128();
+	_MM_TRANSPOSE4_PS(col0, col1, col2, col3);
+	float* p = &dst[0][0];
+	_mm_storeu_ps(p + 0, col0);
+	_mm_storeu_ps(p + 4, col1);
+	_mm_storeu_ps(p + 8, col2);
+}
+
 mataff Transform3::UniformBufferFormatIdentity()
 {
 	Matrix4 m2(Matrix4::identity());
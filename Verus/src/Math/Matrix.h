@@ -84,6 +84,7 @@ namespace verus
 		glm::mat4x3 GLM4x3() const;
 
 		mataff UniformBufferFormat() const;
+		void UniformBufferFormat(mataff& dst) const;
 		static mataff UniformBufferFormatIdentity();
 		void InstFormat(VMath::Vector4* p) const;
 		float4 ToSpriteMat() const;
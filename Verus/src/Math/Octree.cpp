@@ -26,30 +26,87 @@ bool Octree::Node::HasChildren(int currentNode, int nodeCount)
 
 void Octree::Node::BindElement(RcElement element)
 {
-	_vElements.push_back(element);
+	if (!(_elementCount & 0x3))
+		_vBlocks.push_back(ElementBlock());
+	SetElementAt(_elementCount, element);
+	_elementCount++;
 }
 
-void Octree::Node::UnbindElement(void* pToken)
+bool Octree::Node::UnbindElement(void* pToken)
 {
-	VERUS_WHILE(Vector<Element>, _vElements, it)
+	const int index = FindElement(pToken);
+	if (index < 0)
+		return false;
+
+	// Fill the gap with the last element:
+	const int last = _elementCount - 1;
+	if (index != last)
 	{
-		if (pToken == (*it)._pToken)
-			it = _vElements.erase(it);
-		else
-			it++;
+		RcElementBlock src = _vBlocks[last >> 2];
+		RElementBlock dst = _vBlocks[index >> 2];
+		const int i = last & 0x3;
+		const int j = index & 0x3;
+		dst._centerX[j] = src._centerX[i];
+		dst._centerY[j] = src._centerY[i];
+		dst._centerZ[j] = src._centerZ[i];
+		dst._extentX[j] = src._extentX[i];
+		dst._extentY[j] = src._extentY[i];
+		dst._extentZ[j] = src._extentZ[i];
+		dst._radius[j] = src._radius[i];
+		dst._pTokens[j] = src._pTokens[i];
 	}
+	_elementCount--;
+	if (!(_elementCount & 0x3))
+		_vBlocks.pop_back();
+	return true;
+}
+
+bool Octree::Node::UpdateDynamicElement(RcElement element)
+{
+	const int index = FindElement(element._pToken);
+	if (index < 0)
+		return false;
+	SetElementAt(index, element);
+	return true;
+}
+
+Octree::Element Octree::Node::GetElementAt(int i) const
+{
+	RcElementBlock block = _vBlocks[i >> 2];
+	const int lane = i & 0x3;
+	const Point3 center(block._centerX[lane], block._centerY[lane], block._centerZ[lane]);
+	const Vector3 extents(block._extentX[lane], block._extentY[lane], block._extentZ[lane]);
+	Element element;
+	element._bounds = Bounds(center - extents, center + extents);
+	element._sphere = Sphere(center, block._radius[lane]);
+	element._pToken = block._pTokens[lane];
+	return element;
 }
 
-void Octree::Node::UpdateDynamicElement(RcElement element)
+void Octree::Node::SetElementAt(int i, RcElement element)
 {
-	for (auto& x : _vElements)
+	RElementBlock block = _vBlocks[i >> 2];
+	const int lane = i & 0x3;
+	const Point3 center = element._bounds.GetCenter();
+	const Vector3 extents = element._bounds.GetExtents();
+	block._centerX[lane] = center.getX();
+	block._centerY[lane] = center.getY();
+	block._centerZ[lane] = center.getZ();
+	block._extentX[lane] = extents.getX();
+	block._extentY[lane] = extents.getY();
+	block._extentZ[lane] = extents.getZ();
+	block._radius[lane] = element._sphere.GetRadius();
+	block._pTokens[lane] = element._pToken;
+}
+
+int Octree::Node::FindElement(void* pToken) const
+{
+	VERUS_FOR(i, _elementCount)
 	{
-		if (x._pToken == element._pToken)
-		{
-			x = element;
-			return;
-		}
+		if (_vBlocks[i >> 2]._pTokens[i & 0x3] == pToken)
+			return i;
 	}
+	return -1;
 }
 
 // Octree:
@@ -155,6 +212,7 @@ bool Octree::BindElement(RcElement element, bool forceRoot, int currentNode)
 	if (MustBind(currentNode, elementEx._bounds))
 	{
 		_vNodes[currentNode].BindElement(elementEx);
+		_mapTokenNodes[elementEx._pToken] = currentNode;
 		return true;
 	}
 	else if (Node::HasChildren(currentNode, Utils::Cast32(_vNodes.size())))
@@ -162,6 +220,8 @@ bool Octree::BindElement(RcElement element, bool forceRoot, int currentNode)
 		VERUS_FOR(i, 8)
 		{
 			const int childIndex = Node::GetChildIndex(currentNode, i);
+			if (!_vNodes[childIndex].GetBounds().IsOverlappingWith(elementEx._bounds))
+				continue; // Nothing inside can overlap.
 			if (BindElement(element, false, childIndex))
 				return true;
 		}
@@ -171,8 +231,11 @@ bool Octree::BindElement(RcElement element, bool forceRoot, int currentNode)
 
 void Octree::UnbindElement(void* pToken)
 {
-	for (auto& node : _vNodes)
-		node.UnbindElement(pToken);
+	auto it = _mapTokenNodes.find(pToken);
+	if (it == _mapTokenNodes.end())
+		return;
+	_vNodes[it->second].UnbindElement(pToken);
+	_mapTokenNodes.erase(it);
 }
 
 void Octree::UpdateDynamicBounds(RcElement element)
@@ -206,63 +269,20 @@ Continue Octree::TraverseVisible(RcFrustum frustum, PResult pResult, int current
 	if (_vNodes.empty())
 		return Continue::no;
 
-	if (!currentNode)
-	{
-		_defaultResult = Result();
-		if (!pResult)
-			pResult = &_defaultResult;
-		pResult->_testCount = 0;
-		pResult->_passedTestCount = 0;
-		pResult->_pLastFoundToken = nullptr;
-		pResult->_depth = World::WorldManager::IsDrawingDepth(World::DrawDepth::automatic);
-	}
+	_defaultResult = Result();
+	if (!pResult)
+		pResult = &_defaultResult;
+	pResult->_testCount = 0;
+	pResult->_passedTestCount = 0;
+	pResult->_pLastFoundToken = nullptr;
+	pResult->_depth = World::WorldManager::IsValidSingleton() && World::WorldManager::IsDrawingDepth(World::DrawDepth::automatic);
 
-	pResult->_testCount++;
-	const float onePixel = Math::ComputeOnePixelDistance(
-		_vNodes[currentNode].GetSphere().GetRadius());
-	const bool notTooSmall = pResult->_depth || VMath::distSqr(
-		frustum.GetZNearPosition(), _vNodes[currentNode].GetSphere().GetCenter()) < onePixel * onePixel;
+	CollectVisible(frustum, *pResult, currentNode);
 
-	if (notTooSmall &&
-		Relation::outside != frustum.ContainsSphere(_vNodes[currentNode].GetSphere()) &&
-		Relation::outside != frustum.ContainsAabb(_vNodes[currentNode].GetBounds()))
-	{
-		{
-			RcNode node = _vNodes[currentNode];
-			const int count = node.GetElementCount();
-			VERUS_FOR(i, count)
-			{
-				RcElement element = node.GetElementAt(i);
-
-				pResult->_testCount++;
-				const float onePixel = Math::ComputeOnePixelDistance(
-					element._sphere.GetRadius());
-				const bool notTooSmall = pResult->_depth || VMath::distSqr(
-					frustum.GetZNearPosition(), element._sphere.GetCenter()) < onePixel * onePixel;
-
-				if (notTooSmall &&
-					Relation::outside != frustum.ContainsSphere(element._sphere) &&
-					Relation::outside != frustum.ContainsAabb(element._bounds))
-				{
-					pResult->_passedTestCount++;
-					pResult->_pLastFoundToken = element._pToken;
-					if (Continue::no == _pDelegate->Octree_ProcessNode(element._pToken, pUser))
-						return Continue::no;
-				}
-			}
-		}
-
-		if (Node::HasChildren(currentNode, Utils::Cast32(_vNodes.size())))
-		{
-			VERUS_FOR(i, 8)
-			{
-				const int childIndex = Node::GetChildIndex(currentNode, i);
-				if (Continue::no == TraverseVisible(frustum, pResult, childIndex, pUser))
-					return Continue::no;
-			}
-		}
-	}
-	return Continue::yes;
+	if (_vVisibleTokens.empty())
+		return Continue::yes;
+	pResult->_pLastFoundToken = _vVisibleTokens.back();
+	return _pDelegate->Octree_ProcessNodes(_vVisibleTokens.data(), Utils::Cast32(_vVisibleTokens.size()), pUser);
 }
 
 Continue Octree::TraverseVisible(RcPoint3 point, PResult pResult, int currentNode, void* pUser)
@@ -284,17 +304,26 @@ Continue Octree::TraverseVisible(RcPoint3 point, PResult pResult, int currentNod
 	if (_vNodes[currentNode].GetBounds().IsInside(point))
 	{
 		{
+			const float x = point.getX();
+			const float y = point.getY();
+			const float z = point.getZ();
 			RcNode node = _vNodes[currentNode];
 			const int count = node.GetElementCount();
 			VERUS_FOR(i, count)
 			{
-				RcElement element = node.GetElementAt(i);
+				RcElementBlock block = node.GetBlockAt(i >> 2);
+				const int lane = i & 0x3;
 				pResult->_testCount++;
-				if (element._bounds.IsInside(point))
+				const float dx = x - block._centerX[lane];
+				const float dy = y - block._centerY[lane];
+				const float dz = z - block._centerZ[lane];
+				if (dx >= -block._extentX[lane] && dx < block._extentX[lane] &&
+					dy >= -block._extentY[lane] && dy < block._extentY[lane] &&
+					dz >= -block._extentZ[lane] && dz < block._extentZ[lane])
 				{
 					pResult->_passedTestCount++;
-					pResult->_pLastFoundToken = element._pToken;
-					if (Continue::no == _pDelegate->Octree_ProcessNode(element._pToken, pUser))
+					pResult->_pLastFoundToken = block._pTokens[lane];
+					if (Continue::no == _pDelegate->Octree_ProcessNode(block._pTokens[lane], pUser))
 						return Continue::no;
 				}
 			}
@@ -331,3 +360,282 @@ void Octree::RemapChildIndices(RcPoint3 point, RcPoint3 center, BYTE childIndice
 	childIndices[6] = i ^ 0x4;
 	childIndices[7] = i;
 }
+
+void Octree::CollectVisible(RcFrustum frustum, RResult result, int startNode)
+{
+	_vVisibleTokens.clear();
+
+	// Planes for nodes and for SIMD element tests:
+	float planes[6][4];
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	__m128 planeAbsX[6], planeAbsY[6], planeAbsZ[6];
+	VERUS_FOR(i, 6)
+	{
+		RcPlane plane = frustum.GetPlane(i);
+		planes[i][0] = plane.getX();
+		planes[i][1] = plane.getY();
+		planes[i][2] = plane.getZ();
+		planes[i][3] = plane.getW();
+		planeX[i] = _mm_set1_ps(planes[i][0]);
+		planeY[i] = _mm_set1_ps(planes[i][1]);
+		planeZ[i] = _mm_set1_ps(planes[i][2]);
+		planeW[i] = _mm_set1_ps(planes[i][3]);
+		planeAbsX[i] = _mm_set1_ps(abs(planes[i][0]));
+		planeAbsY[i] = _mm_set1_ps(abs(planes[i][1]));
+		planeAbsZ[i] = _mm_set1_ps(abs(planes[i][2]));
+	}
+
+	// Objects smaller than one pixel are skipped:
+	const Point3 zNear = frustum.GetZNearPosition();
+	const float onePixelScale = Math::ComputeOnePixelDistance(1);
+	const float onePixelScaleSq = onePixelScale * onePixelScale;
+	const __m128 zNearX = _mm_set1_ps(zNear.getX());
+	const __m128 zNearY = _mm_set1_ps(zNear.getY());
+	const __m128 zNearZ = _mm_set1_ps(zNear.getZ());
+	const __m128 scaleSq = _mm_set1_ps(onePixelScaleSq);
+	const __m128 zero = _mm_setzero_ps();
+
+	const int nodeCount = Utils::Cast32(_vNodes.size());
+	_vStack.clear();
+	_vStack.push_back({ startNode, 0x3F });
+	while (!_vStack.empty())
+	{
+		const StackItem item = _vStack.back();
+		_vStack.pop_back();
+		RcNode node = _vNodes[item._node];
+
+		result._testCount++;
+		if (!result._depth)
+		{
+			const float radius = node.GetSphere().GetRadius();
+			if (VMath::distSqr(zNear, node.GetSphere().GetCenter()) >= radius * radius * onePixelScaleSq)
+				continue;
+		}
+
+		// Node which is fully inside some plane doesn't need to be tested against it again, same for children:
+		int planeMask = item._planeMask;
+		if (planeMask)
+		{
+			const Point3 center = node.GetBounds().GetCenter();
+			const Vector3 extents = node.GetBounds().GetExtents();
+			bool outside = false;
+			VERUS_FOR(i, 6)
+			{
+				if (!((planeMask >> i) & 0x1))
+					continue;
+				const float dist =
+					planes[i][0] * center.getX() +
+					planes[i][1] * center.getY() +
+					planes[i][2] * center.getZ() + planes[i][3];
+				const float radius =
+					abs(planes[i][0]) * extents.getX() +
+					abs(planes[i][1]) * extents.getY() +
+					abs(planes[i][2]) * extents.getZ();
+				if (dist + radius < 0)
+				{
+					outside = true;
+					break;
+				}
+				if (dist - radius >= 0)
+					planeMask &= ~(1 << i);
+			}
+			if (outside)
+				continue;
+		}
+
+		// Elements, four at a time:
+		const int elementCount = node.GetElementCount();
+		const int blockCount = node.GetBlockCount();
+		VERUS_FOR(b, blockCount)
+		{
+			RcElementBlock block = node.GetBlockAt(b);
+			const int laneCount = Math::Min(4, elementCount - (b << 2));
+			result._testCount += laneCount;
+			int visibleMask = (1 << laneCount) - 1;
+
+			const __m128 centerX = _mm_loadu_ps(block._centerX);
+			const __m128 centerY = _mm_loadu_ps(block._centerY);
+			const __m128 centerZ = _mm_loadu_ps(block._centerZ);
+
+			if (!result._depth)
+			{
+				const __m128 dx = _mm_sub_ps(centerX, zNearX);
+				const __m128 dy = _mm_sub_ps(centerY, zNearY);
+				const __m128 dz = _mm_sub_ps(centerZ, zNearZ);
+				const __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+				const __m128 radius = _mm_loadu_ps(block._radius);
+				const __m128 limitSq = _mm_mul_ps(_mm_mul_ps(radius, radius), scaleSq);
+				visibleMask &= _mm_movemask_ps(_mm_cmplt_ps(distSq, limitSq));
+			}
+
+			if (planeMask && visibleMask)
+			{
+				const __m128 extentX = _mm_loadu_ps(block._extentX);
+				const __m128 extentY = _mm_loadu_ps(block._extentY);
+				const __m128 extentZ = _mm_loadu_ps(block._extentZ);
+				VERUS_FOR(i, 6)
+				{
+					if (!((planeMask >> i) & 0x1))
+						continue;
+					const __m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+						_mm_mul_ps(planeX[i], centerX),
+						_mm_mul_ps(planeY[i], centerY)),
+						_mm_mul_ps(planeZ[i], centerZ)),
+						planeW[i]);
+					const __m128 radius = _mm_add_ps(_mm_add_ps(
+						_mm_mul_ps(planeAbsX[i], extentX),
+						_mm_mul_ps(planeAbsY[i], extentY)),
+						_mm_mul_ps(planeAbsZ[i], extentZ));
+					visibleMask &= _mm_movemask_ps(_mm_cmpge_ps(_mm_add_ps(dist, radius), zero));
+					if (!visibleMask)
+						break;
+				}
+			}
+
+			while (visibleMask)
+			{
+				const int lane = Math::LowestBit(visibleMask);
+				visibleMask &= visibleMask - 1;
+				result._passedTestCount++;
+				_vVisibleTokens.push_back(block._pTokens[lane]);
+			}
+		}
+
+		// Reverse order, so that children are processed in order:
+		if (Node::HasChildren(item._node, nodeCount))
+		{
+			for (int i = 7; i >= 0; --i)
+				_vStack.push_back({ Node::GetChildIndex(item._node, i), planeMask });
+		}
+	}
+}
+
+void Octree::CollectVisibleRecursive(RcFrustum frustum, RResult result, int currentNode)
+{
+	if (!currentNode)
+		_vVisibleTokens.clear();
+
+	result._testCount++;
+	const float onePixel = Math::ComputeOnePixelDistance(
+		_vNodes[currentNode].GetSphere().GetRadius());
+	const bool notTooSmall = result._depth || VMath::distSqr(
+		frustum.GetZNearPosition(), _vNodes[currentNode].GetSphere().GetCenter()) < onePixel * onePixel;
+
+	if (notTooSmall &&
+		Relation::outside != frustum.ContainsSphere(_vNodes[currentNode].GetSphere()) &&
+		Relation::outside != frustum.ContainsAabb(_vNodes[currentNode].GetBounds()))
+	{
+		RcNode node = _vNodes[currentNode];
+		const int count = node.GetElementCount();
+		VERUS_FOR(i, count)
+		{
+			const Element element = node.GetElementAt(i);
+
+			result._testCount++;
+			const float onePixel = Math::ComputeOnePixelDistance(
+				element._sphere.GetRadius());
+			const bool notTooSmall = result._depth || VMath::distSqr(
+				frustum.GetZNearPosition(), element._sphere.GetCenter()) < onePixel * onePixel;
+
+			if (notTooSmall &&
+				Relation::outside != frustum.ContainsSphere(element._sphere) &&
+				Relation::outside != frustum.ContainsAabb(element._bounds))
+			{
+				result._passedTestCount++;
+				_vVisibleTokens.push_back(element._pToken);
+			}
+		}
+
+		if (Node::HasChildren(currentNode, Utils::Cast32(_vNodes.size())))
+		{
+			VERUS_FOR(i, 8)
+				CollectVisibleRecursive(frustum, result, Node::GetChildIndex(currentNode, i));
+		}
+	}
+}
+
+void Octree::Test()
+{
+	Random random(1234);
+	Octree octree;
+	octree.Init(Bounds(Point3(-512, -512, -512), Point3(512, 512, 512)), Vector3(32, 32, 32));
+	VERUS_FOR(i, 3000)
+	{
+		const Point3 pos(random.NextFloat(-500, 500), random.NextFloat(-60, 60), random.NextFloat(-500, 500));
+		const Vector3 size(random.NextFloat(0.1f, 20), random.NextFloat(0.1f, 20), random.NextFloat(0.1f, 20));
+		octree.BindElement(Element(Bounds(pos - size, pos + size), reinterpret_cast<void*>(static_cast<INT64>(i + 1))));
+	}
+	VERUS_FOR(i, 1000) // Rebind some elements, unbind others:
+	{
+		void* pToken = reinterpret_cast<void*>(static_cast<INT64>(random.Next(1, 3000)));
+		if (i & 0x1)
+		{
+			const Point3 pos(random.NextFloat(-500, 500), 0, random.NextFloat(-500, 500));
+			octree.BindElement(Element(Bounds(pos - Vector3(1, 1, 1), pos + Vector3(1, 1, 1)), pToken));
+		}
+		else
+		{
+			octree.UnbindElement(pToken);
+		}
+	}
+
+	const Matrix4 matP = Matrix4::MakePerspective(VERUS_PI / 4, 16 / 9.f, 0.5f, 800);
+	VERUS_FOR(i, 16)
+	{
+		const float angle = i * (VERUS_2PI / 16);
+		const Point3 eye(sin(angle) * 100, 10, cos(angle) * 100);
+		const Matrix4 matV = Matrix4::lookAt(eye, Point3(0), Vector3(0, 1, 0));
+		const Frustum frustum = Frustum::MakeFromMatrix(matP * matV);
+		VERUS_FOR(depth, 2)
+		{
+			Result result;
+			result._depth = !!depth;
+			octree.CollectVisible(frustum, result, 0);
+			Vector<void*> vTokens = octree._vVisibleTokens;
+			octree.CollectVisibleRecursive(frustum, result, 0);
+			Vector<void*> vTokensRef = octree._vVisibleTokens;
+			std::sort(vTokens.begin(), vTokens.end());
+			std::sort(vTokensRef.begin(), vTokensRef.end());
+			VERUS_RT_ASSERT(vTokens == vTokensRef);
+		}
+	}
+}
+
+void Octree::Benchmark()
+{
+	Random random(1234);
+	Octree octree;
+	octree.Init(Bounds(Point3(-2048, -2048, -2048), Point3(2048, 2048, 2048)), Vector3(128, 128, 128));
+	VERUS_FOR(i, 100000)
+	{
+		const Point3 pos(random.NextFloat(-2000, 2000), random.NextFloat(-100, 100), random.NextFloat(-2000, 2000));
+		const Vector3 size(random.NextFloat(0.5f, 8), random.NextFloat(0.5f, 8), random.NextFloat(0.5f, 8));
+		octree.BindElement(Element(Bounds(pos - size, pos + size), reinterpret_cast<void*>(static_cast<INT64>(i + 1))));
+	}
+
+	const Matrix4 matP = Matrix4::MakePerspective(VERUS_PI / 4, 16 / 9.f, 0.5f, 1000);
+	const int frameCount = 64;
+	auto Collect = [&](bool recursive, int& visibleCount)
+	{
+		visibleCount = 0;
+		VERUS_FOR(i, frameCount)
+		{
+			const float angle = i * (VERUS_2PI / frameCount);
+			const Point3 eye(sin(angle) * 500, 20, cos(angle) * 500);
+			const Matrix4 matV = Matrix4::lookAt(eye, Point3(0), Vector3(0, 1, 0));
+			const Frustum frustum = Frustum::MakeFromMatrix(matP * matV);
+			Result result;
+			if (recursive)
+				octree.CollectVisibleRecursive(frustum, result, 0);
+			else
+				octree.CollectVisible(frustum, result, 0);
+			visibleCount += Utils::Cast32(octree._vVisibleTokens.size());
+		}
+	};
+
+	int visibleCountRef = 0, visibleCount = 0;
+	const double recursiveMs = Utils::MeasureBestTime([&]() { Collect(true, visibleCountRef); }) / frameCount;
+	const double linearMs = Utils::MeasureBestTime([&]() { Collect(false, visibleCount); }) / frameCount;
+	VERUS_LOG_INFO("Benchmark(); Recursive: " << recursiveMs << " ms (" << visibleCountRef / frameCount <<
+		" visible), SIMD: " << linearMs << " ms (" << visibleCount / frameCount << " visible)");
+}
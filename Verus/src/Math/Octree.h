@@ -9,6 +9,16 @@ namespace verus
 		{
 		public:
 			virtual Continue Octree_ProcessNode(void* pToken, void* pUser) = 0;
+			// Frustum traversal calls this once with all visible tokens:
+			virtual Continue Octree_ProcessNodes(void* const* ppTokens, int count, void* pUser)
+			{
+				VERUS_FOR(i, count)
+				{
+					if (Continue::no == Octree_ProcessNode(ppTokens[i], pUser))
+						return Continue::no;
+				}
+				return Continue::yes;
+			}
 		};
 		VERUS_TYPEDEFS(OctreeDelegate);
 
@@ -42,11 +52,26 @@ namespace verus
 			VERUS_TYPEDEFS(Result);
 
 		private:
+			// Elements are stored in blocks of four (SoA), so that they can be tested using SIMD:
+			struct ElementBlock
+			{
+				float _centerX[4];
+				float _centerY[4];
+				float _centerZ[4];
+				float _extentX[4];
+				float _extentY[4];
+				float _extentZ[4];
+				float _radius[4];
+				void* _pTokens[4];
+			};
+			VERUS_TYPEDEFS(ElementBlock);
+
 			class Node : public AllocatorAware
 			{
-				Bounds          _bounds;
-				Sphere          _sphere;
-				Vector<Element> _vElements;
+				Bounds               _bounds;
+				Sphere               _sphere;
+				Vector<ElementBlock> _vBlocks;
+				int                  _elementCount = 0;
 
 			public:
 				Node();
@@ -60,19 +85,34 @@ namespace verus
 				void     SetBounds(RcBounds b) { _bounds = b; _sphere = b.GetSphere(); }
 
 				void BindElement(RcElement element);
-				void UnbindElement(void* pToken);
-				void UpdateDynamicElement(RcElement element);
+				bool UnbindElement(void* pToken);
+				bool UpdateDynamicElement(RcElement element);
+
+				int GetElementCount() const { return _elementCount; }
+				Element GetElementAt(int i) const;
+				int GetBlockCount() const { return Utils::Cast32(_vBlocks.size()); }
+				RcElementBlock GetBlockAt(int i) const { return _vBlocks[i]; }
 
-				int GetElementCount() const { return Utils::Cast32(_vElements.size()); }
-				RcElement GetElementAt(int i) const { return _vElements[i]; }
+			private:
+				void SetElementAt(int i, RcElement element);
+				int FindElement(void* pToken) const;
 			};
 			VERUS_TYPEDEFS(Node);
 
-			Bounds          _bounds;
-			Vector3         _limit = Vector3(0);
-			Vector<Node>    _vNodes;
-			POctreeDelegate _pDelegate = nullptr;
-			Result          _defaultResult;
+			struct StackItem
+			{
+				int _node;
+				int _planeMask; // Planes, which still intersect the node.
+			};
+
+			Bounds              _bounds;
+			Vector3             _limit = Vector3(0);
+			Vector<Node>        _vNodes;
+			HashMap<void*, int> _mapTokenNodes; // Which node has this element.
+			Vector<void*>       _vVisibleTokens;
+			Vector<StackItem>   _vStack;
+			POctreeDelegate     _pDelegate = nullptr;
+			Result              _defaultResult;
 
 		public:
 			Octree();
@@ -90,9 +130,20 @@ namespace verus
 			void UpdateDynamicBounds(RcElement element);
 			VERUS_P(bool MustBind(int currentNode, RcBounds bounds) const);
 
+			// Visible tokens are passed to Octree_ProcessNodes in one call:
 			Continue TraverseVisible(RcFrustum frustum, PResult pResult = nullptr, int currentNode = 0, void* pUser = nullptr);
 			Continue TraverseVisible(RcPoint3 point, PResult pResult = nullptr, int currentNode = 0, void* pUser = nullptr);
 
+			// Tokens found by the last frustum traversal:
+			const Vector<void*>& GetVisibleTokens() const { return _vVisibleTokens; }
+
+			static void Test();
+			// Compares frustum traversal with simple recursive traversal, results are written to log:
+			static void Benchmark();
+
+		private:
+			void CollectVisible(RcFrustum frustum, RResult result, int startNode);
+			void CollectVisibleRecursive(RcFrustum frustum, RResult result, int currentNode);
 			VERUS_P(static void RemapChildIndices(RcPoint3 point, RcPoint3 center, BYTE childIndices[8]));
 
 			RcBounds GetBounds() const { return _bounds; }
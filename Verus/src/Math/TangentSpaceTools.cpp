@@ -4,8 +4,26 @@
 using namespace verus;
 using namespace verus::Math;
 
+void TangentSpaceTools::BuildAdjacency(
+	const Vector<UINT32>& vIndices,
+	int vertCount,
+	Vector<int>& vOffsets,
+	Vector<int>& vFaces)
+{
+	const int indexCount = Utils::Cast32(vIndices.size());
+	vOffsets.assign(vertCount + 1, 0);
+	for (UINT32 index : vIndices)
+		vOffsets[index + 1]++;
+	VERUS_FOR(i, vertCount)
+		vOffsets[i + 1] += vOffsets[i];
+	vFaces.resize(indexCount);
+	Vector<int> vFill(vOffsets.begin(), vOffsets.end() - 1);
+	VERUS_FOR(i, indexCount) // Faces of each vertex are sorted.
+		vFaces[vFill[vIndices[i]]++] = i / 3;
+}
+
 void TangentSpaceTools::RecalculateNormals(
-	const Vector<UINT16>& vIndices,
+	const Vector<UINT32>& vIndices,
 	const Vector<glm::vec3>& vPositions,
 	Vector<glm::vec3>& vNormals,
 	float areaBasedNormals)
@@ -13,6 +31,8 @@ void TangentSpaceTools::RecalculateNormals(
 	const int vertCount = Utils::Cast32(vPositions.size());
 	const int faceCount = Utils::Cast32(vIndices.size() / 3);
 	vNormals.resize(vertCount);
+	if (!vertCount || !faceCount)
+		return;
 
 	Vector<glm::vec3> vFaceNormals;
 	vFaceNormals.resize(faceCount);
@@ -37,43 +57,82 @@ void TangentSpaceTools::RecalculateNormals(
 		vFaceNormals[i] = glm::normalize(n) * vFaceAreas[i];
 	});
 
+	Vector<int> vOffsets, vFaces;
+	BuildAdjacency(vIndices, vertCount, vOffsets, vFaces);
+
+	// Spatial hash, vertices closer than 1 mm are coincident, so their faces are shared.
+	// Cell is twice as big as threshold, so only one neighbor on each axis must be checked:
+	const float threshold = 0.001f; // 1 mm.
+	const float scale = 0.5f / threshold;
+	auto MakeKey = [](const glm::ivec3& cell)
+	{
+		return
+			(static_cast<UINT64>(cell.x & 0x1FFFFF) << 42) |
+			(static_cast<UINT64>(cell.y & 0x1FFFFF) << 21) |
+			(static_cast<UINT64>(cell.z & 0x1FFFFF));
+	};
+	HashMap<UINT64, int> mapCells; // Head of the list of vertices in each cell.
+	Vector<int> vNext(vertCount, -1);
+	mapCells.reserve(vertCount);
+	VERUS_FOR(i, vertCount)
+	{
+		const auto ret = mapCells.emplace(MakeKey(glm::ivec3(glm::floor(vPositions[i] * scale))), i);
+		if (!ret.second)
+		{
+			vNext[i] = ret.first->second;
+			ret.first->second = i;
+		}
+	}
+
 	VERUS_P_FOR(i, vertCount)
 	{
-		const int faceCount = Utils::Cast32(vIndices.size() / 3);
-		const float threshold = 0.001f * 0.001f; // 1 mm.
-		VERUS_FOR(j, faceCount)
+		const glm::vec3 pos = vPositions[i] * scale;
+		const glm::vec3 cell = glm::floor(pos);
+		const glm::ivec3 c(cell);
+		const glm::ivec3 n = glm::ivec3(glm::greaterThanEqual(pos - cell, glm::vec3(0.5f))) * 2 - 1;
+
+		// Faces of this vertex and of coincident vertices:
+		Vector<int> vNearFaces;
+		vNearFaces.reserve(32);
+		VERUS_FOR(j, 8)
 		{
-			const int a = vIndices[j * 3 + 0];
-			const int b = vIndices[j * 3 + 1];
-			const int c = vIndices[j * 3 + 2];
+			const glm::ivec3 offset((j & 0x1) ? n.x : 0, (j & 0x2) ? n.y : 0, (j & 0x4) ? n.z : 0);
+			const auto it = mapCells.find(MakeKey(c + offset));
+			if (it == mapCells.end())
+				continue;
+			for (int k = it->second; k >= 0; k = vNext[k])
+			{
+				if (k == i || glm::distance2(vPositions[i], vPositions[k]) < threshold * threshold)
+					vNearFaces.insert(vNearFaces.end(), vFaces.begin() + vOffsets[k], vFaces.begin() + vOffsets[k + 1]);
+			}
+		}
+		// Same order as in index buffer, coplanar fix depends on it:
+		std::sort(vNearFaces.begin(), vNearFaces.end());
+		vNearFaces.erase(std::unique(vNearFaces.begin(), vNearFaces.end()), vNearFaces.end());
 
-			if (a == i ||
-				b == i ||
-				c == i)
+		glm::vec3 normal(0);
+		for (int face : vNearFaces)
+		{
+			if (vIndices[face * 3 + 0] == i ||
+				vIndices[face * 3 + 1] == i ||
+				vIndices[face * 3 + 2] == i)
 			{
-				vNormals[i] += vFaceNormals[j];
+				normal += vFaceNormals[face];
 			}
 			else
 			{
-				const glm::vec3 prevNormal = vNormals[i];
-				const float d0 = glm::distance2(vPositions[i], vPositions[a]);
-				const float d1 = glm::distance2(vPositions[i], vPositions[b]);
-				const float d2 = glm::distance2(vPositions[i], vPositions[c]);
-
-				if (d0 < threshold || d1 < threshold || d2 < threshold)
-				{
-					vNormals[i] += vFaceNormals[j];
-					if (glm::length2(vNormals[i]) < 0.01f * 0.01f) // Coplanar surface fix (1% of unit length):
-						vNormals[i] = prevNormal;
-				}
+				const glm::vec3 prevNormal = normal;
+				normal += vFaceNormals[face];
+				if (glm::length2(normal) < 0.01f * 0.01f) // Coplanar surface fix (1% of unit length):
+					normal = prevNormal;
 			}
 		}
-		vNormals[i] = glm::normalize(vNormals[i]);
+		vNormals[i] = glm::normalize(normal);
 	});
 }
 
 void TangentSpaceTools::RecalculateTangentSpace(
-	const Vector<UINT16>& vIndices,
+	const Vector<UINT32>& vIndices,
 	const Vector<glm::vec3>& vPositions,
 	const Vector<glm::vec3>& vNormals,
 	const Vector<glm::vec2>& vTexCoords,
@@ -87,7 +146,7 @@ void TangentSpaceTools::RecalculateTangentSpace(
 		{
 			int _vertCount;
 			int _faceCount;
-			const UINT16* _pIndices;
+			const UINT32* _pIndices;
 			const glm::vec3* _pVerts;
 			const glm::vec3* _pNormals;
 			const glm::vec2* _pTexCoords;
@@ -160,9 +219,12 @@ void TangentSpaceTools::RecalculateTangentSpace(
 		const int faceCount = Utils::Cast32(vIndices.size() / 3);
 		vTan.resize(vertCount);
 		vBin.resize(vertCount);
-		std::mutex m;
 		const float degree = cos(glm::radians(1.f));
 
+		Vector<glm::vec3> vFaceTan, vFaceBin;
+		vFaceTan.resize(faceCount);
+		vFaceBin.resize(faceCount);
+
 		VERUS_P_FOR(i, faceCount)
 		{
 			const int a = vIndices[i * 3 + 0];
@@ -188,17 +250,19 @@ void TangentSpaceTools::RecalculateTangentSpace(
 			else
 				tmp = 1 / det;
 
-			const glm::vec3 tan = glm::normalize((e1 * et2.y - e2 * et1.y) * tmp);
-			const glm::vec3 bin = glm::normalize((e2 * et1.x - e1 * et2.x) * tmp);
+			vFaceTan[i] = glm::normalize((e1 * et2.y - e2 * et1.y) * tmp);
+			vFaceBin[i] = glm::normalize((e2 * et1.x - e1 * et2.x) * tmp);
+		});
 
+		// Each vertex sums it's own faces, no locking:
+		Vector<int> vOffsets, vFaces;
+		BuildAdjacency(vIndices, vertCount, vOffsets, vFaces);
+		VERUS_P_FOR(i, vertCount)
+		{
+			for (int j = vOffsets[i]; j < vOffsets[i + 1]; ++j)
 			{
-				std::lock_guard<std::mutex> lock(m);
-				vTan[a] += tan;
-				vTan[b] += tan;
-				vTan[c] += tan;
-				vBin[a] += bin;
-				vBin[b] += bin;
-				vBin[c] += bin;
+				vTan[i] += vFaceTan[vFaces[j]];
+				vBin[i] += vFaceBin[vFaces[j]];
 			}
 		});
 
@@ -226,3 +290,143 @@ void TangentSpaceTools::RecalculateTangentSpace(
 		});
 	}
 }
+
+void TangentSpaceTools::RecalculateNormals(
+	const Vector<UINT16>& vIndices,
+	const Vector<glm::vec3>& vPositions,
+	Vector<glm::vec3>& vNormals,
+	float areaBasedNormals)
+{
+	const Vector<UINT32> vIndices32(vIndices.begin(), vIndices.end());
+	RecalculateNormals(vIndices32, vPositions, vNormals, areaBasedNormals);
+}
+
+void TangentSpaceTools::RecalculateTangentSpace(
+	const Vector<UINT16>& vIndices,
+	const Vector<glm::vec3>& vPositions,
+	const Vector<glm::vec3>& vNormals,
+	const Vector<glm::vec2>& vTexCoords,
+	Vector<glm::vec3>& vTan,
+	Vector<glm::vec3>& vBin,
+	bool useMikkTSpace)
+{
+	const Vector<UINT32> vIndices32(vIndices.begin(), vIndices.end());
+	RecalculateTangentSpace(vIndices32, vPositions, vNormals, vTexCoords, vTan, vBin, useMikkTSpace);
+}
+
+void TangentSpaceTools::Test()
+{
+	// The original O(V*F) version, used as reference:
+	auto RecalculateNormalsRef = [](const Vector<UINT16>& vIndices, const Vector<glm::vec3>& vPositions, Vector<glm::vec3>& vNormals, float areaBasedNormals)
+	{
+		const int vertCount = Utils::Cast32(vPositions.size());
+		const int faceCount = Utils::Cast32(vIndices.size() / 3);
+		const float threshold = 0.001f * 0.001f;
+		vNormals.assign(vertCount, glm::vec3(0));
+		VERUS_FOR(i, vertCount)
+		{
+			VERUS_FOR(j, faceCount)
+			{
+				const int a = vIndices[j * 3 + 0];
+				const int b = vIndices[j * 3 + 1];
+				const int c = vIndices[j * 3 + 2];
+				const float area = glm::mix(1.f, TriangleArea(vPositions[a], vPositions[b], vPositions[c]), areaBasedNormals);
+				const glm::vec3 faceNormal = glm::normalize(glm::triangleNormal(vPositions[a], vPositions[b], vPositions[c])) * area;
+				if (a == i || b == i || c == i)
+				{
+					vNormals[i] += faceNormal;
+				}
+				else if (
+					glm::distance2(vPositions[i], vPositions[a]) < threshold ||
+					glm::distance2(vPositions[i], vPositions[b]) < threshold ||
+					glm::distance2(vPositions[i], vPositions[c]) < threshold)
+				{
+					const glm::vec3 prevNormal = vNormals[i];
+					vNormals[i] += faceNormal;
+					if (glm::length2(vNormals[i]) < 0.01f * 0.01f)
+						vNormals[i] = prevNormal;
+				}
+			}
+			vNormals[i] = glm::normalize(vNormals[i]);
+		}
+	};
+
+	Vector<UINT16> vIndices;
+	Vector<glm::vec3> vPositions;
+	Vector<glm::vec2> vTexCoords;
+	auto AddQuad = [&vIndices, &vPositions, &vTexCoords](const glm::vec3& p, const glm::vec3& du, const glm::vec3& dv)
+	{
+		const UINT16 base = static_cast<UINT16>(vPositions.size());
+		vPositions.push_back(p);
+		vPositions.push_back(p + du);
+		vPositions.push_back(p + dv);
+		vPositions.push_back(p + du + dv);
+		vTexCoords.push_back(glm::vec2(0, 0));
+		vTexCoords.push_back(glm::vec2(1, 0));
+		vTexCoords.push_back(glm::vec2(0, 1));
+		vTexCoords.push_back(glm::vec2(1, 1));
+		const UINT16 indices[] = { 0, 2, 1, 1, 2, 3 };
+		for (UINT16 index : indices)
+			vIndices.push_back(base + index);
+	};
+
+	// Sphere without poles, each band has it's own vertices:
+	const int segments = 16;
+	VERUS_FOR(i, segments / 2)
+	{
+		const float theta0 = 0.1f + (VERUS_PI - 0.2f) * i / (segments / 2);
+		const float theta1 = 0.1f + (VERUS_PI - 0.2f) * (i + 1) / (segments / 2);
+		VERUS_FOR(j, segments)
+		{
+			const float phi0 = VERUS_2PI * j / segments;
+			const float phi1 = VERUS_2PI * (j + 1) / segments;
+			auto Point = [](float theta, float phi)
+			{
+				return glm::vec3(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi));
+			};
+			const glm::vec3 p00 = Point(theta0, phi0);
+			AddQuad(p00, Point(theta0, phi1) - p00, Point(theta1, phi0) - p00);
+			vPositions.back() = Point(theta1, phi1);
+		}
+	}
+	// Cube with hard edges, vertices are coincident within 1 mm:
+	const glm::vec3 center(5, 0, 0);
+	AddQuad(center + glm::vec3(-1, -1, -1), glm::vec3(2, 0, 0), glm::vec3(0, 2, 0));
+	AddQuad(center + glm::vec3(-1, -1, 1.0004f), glm::vec3(0, 2, 0), glm::vec3(2, 0, 0));
+	AddQuad(center + glm::vec3(-1, -1, -1), glm::vec3(0, 0, 2), glm::vec3(2, 0, 0));
+	AddQuad(center + glm::vec3(-1, 1, -1), glm::vec3(2, 0, 0), glm::vec3(0, 0, 2));
+	AddQuad(center + glm::vec3(-1, -1, -1), glm::vec3(0, 2, 0), glm::vec3(0, 0, 2));
+	AddQuad(center + glm::vec3(1, -1, -1), glm::vec3(0, 0, 2), glm::vec3(0, 2, 0));
+	// Double-sided plane, needs coplanar fix:
+	AddQuad(glm::vec3(0, 0, 5), glm::vec3(1, 0, 0), glm::vec3(0, 1, 0));
+	AddQuad(glm::vec3(0, 0, 5), glm::vec3(0, 1, 0), glm::vec3(1, 0, 0));
+
+	const float e = 1e-4f;
+	Vector<glm::vec3> vNormals, vNormalsRef;
+	VERUS_FOR(areaBased, 2)
+	{
+		vNormals.clear();
+		RecalculateNormals(vIndices, vPositions, vNormals, static_cast<float>(areaBased));
+		RecalculateNormalsRef(vIndices, vPositions, vNormalsRef, static_cast<float>(areaBased));
+		VERUS_FOR(i, vPositions.size())
+		{
+			// Back side's own faces come after the front ones, so the fix doesn't help it, that is expected:
+			if (glm::any(glm::isnan(vNormalsRef[i])))
+				VERUS_RT_ASSERT(i >= vPositions.size() - 4 && glm::any(glm::isnan(vNormals[i])));
+			else
+				VERUS_RT_ASSERT(glm::all(glm::epsilonEqual(vNormals[i], vNormalsRef[i], e)));
+		}
+	}
+	const glm::vec3 frontNormal = vNormals[vPositions.size() - 5];
+	VERUS_RT_ASSERT(glm::all(glm::epsilonEqual(frontNormal, glm::vec3(0, 0, -1), e)));
+
+	// Tangent space must be orthogonal to normals:
+	Vector<glm::vec3> vTan, vBin;
+	RecalculateTangentSpace(vIndices, vPositions, vNormals, vTexCoords, vTan, vBin, false);
+	VERUS_FOR(i, vPositions.size() - 4)
+	{
+		VERUS_RT_ASSERT(abs(glm::dot(vTan[i], vNormals[i])) < e);
+		VERUS_RT_ASSERT(abs(glm::dot(vBin[i], vNormals[i])) < e);
+	}
+	VERUS_RT_ASSERT(glm::all(glm::epsilonEqual(vTan[vTan.size() - 5], glm::vec3(1, 0, 0), e)));
+}
@@ -8,6 +8,22 @@ namespace verus
 		class TangentSpaceTools
 		{
 		public:
+			static void RecalculateNormals(
+				const Vector<UINT32>& vIndices,
+				const Vector<glm::vec3>& vPositions,
+				Vector<glm::vec3>& vNormals,
+				float areaBasedNormals);
+
+			static void RecalculateTangentSpace(
+				const Vector<UINT32>& vIndices,
+				const Vector<glm::vec3>& vPositions,
+				const Vector<glm::vec3>& vNormals,
+				const Vector<glm::vec2>& vTexCoords,
+				Vector<glm::vec3>& vTan,
+				Vector<glm::vec3>& vBin,
+				bool useMikkTSpace = true);
+
+			// 16-bit indices are converted:
 			static void RecalculateNormals(
 				const Vector<UINT16>& vIndices,
 				const Vector<glm::vec3>& vPositions,
@@ -22,6 +38,16 @@ namespace verus
 				Vector<glm::vec3>& vTan,
 				Vector<glm::vec3>& vBin,
 				bool useMikkTSpace = true);
+
+			static void Test();
+
+		private:
+			// For each vertex gives the list of it's faces, faces are sorted:
+			static void BuildAdjacency(
+				const Vector<UINT32>& vIndices,
+				int vertCount,
+				Vector<int>& vOffsets,
+				Vector<int>& vFaces);
 		};
 		VERUS_TYPEDEFS(TangentSpaceTools);
 	}
@@ -0,0 +1,82 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "verus.h"
+
+using namespace verus;
+using namespace verus::Net;
+
+// BitWriter:
+
+BitWriter::BitWriter(BYTE* p, int size) :
+	_p(p),
+	_capacity(size * 8)
+{
+}
+
+void BitWriter::Write(UINT32 value, int bits)
+{
+	VERUS_RT_ASSERT(bits >= 0 && bits <= 32);
+	if (_pos + bits > _capacity)
+	{
+		_overflow = true;
+		_pos = _capacity;
+		return;
+	}
+	while (bits > 0)
+	{
+		const int byteIndex = _pos >> 3;
+		const int bitOffset = _pos & 0x7;
+		const int count = Math::Min(8 - bitOffset, bits);
+		const UINT32 chunk = (value >> (bits - count)) & ((1U << count) - 1);
+		if (!bitOffset)
+			_p[byteIndex] = 0;
+		_p[byteIndex] |= static_cast<BYTE>(chunk << (8 - bitOffset - count));
+		_pos += count;
+		bits -= count;
+	}
+}
+
+void BitWriter::WriteSigned(INT32 value, int bits)
+{
+	VERUS_RT_ASSERT(bits >= 32 || (value >= -(1 << (bits - 1)) && value < (1 << (bits - 1))));
+	Write(static_cast<UINT32>(value), bits);
+}
+
+// BitReader:
+
+BitReader::BitReader(const BYTE* p, int size) :
+	_p(p),
+	_size(size * 8)
+{
+}
+
+UINT32 BitReader::Read(int bits)
+{
+	VERUS_RT_ASSERT(bits >= 0 && bits <= 32);
+	if (_pos + bits > _size)
+	{
+		_overflow = true;
+		_pos = _size;
+		return 0;
+	}
+	UINT32 value = 0;
+	while (bits > 0)
+	{
+		const int byteIndex = _pos >> 3;
+		const int bitOffset = _pos & 0x7;
+		const int count = Math::Min(8 - bitOffset, bits);
+		const UINT32 chunk = (_p[byteIndex] >> (8 - bitOffset - count)) & ((1U << count) - 1);
+		value = (value << count) | chunk;
+		_pos += count;
+		bits -= count;
+	}
+	return value;
+}
+
+INT32 BitReader::ReadSigned(int bits)
+{
+	const UINT32 value = Read(bits);
+	if (bits >= 32)
+		return static_cast<INT32>(value);
+	const UINT32 sign = 1U << (bits - 1);
+	return static_cast<INT32>(value ^ sign) - static_cast<INT32>(sign); // Sign extension.
+}
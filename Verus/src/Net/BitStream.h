@@ -0,0 +1,51 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace Net
+	{
+		// Writes values with arbitrary number of bits into a byte buffer, most significant bit first.
+		// Overflow is not an error, it is reported by IsOverflow() and the rest is ignored.
+		class BitWriter
+		{
+			BYTE* _p = nullptr;
+			int   _capacity = 0; // In bits.
+			int   _pos = 0;
+			bool  _overflow = false;
+
+		public:
+			BitWriter(BYTE* p, int size);
+
+			void Write(UINT32 value, int bits);
+			void WriteSigned(INT32 value, int bits);
+			void WriteBool(bool value) { Write(value ? 1 : 0, 1); }
+
+			int GetBitCount() const { return _pos; }
+			int GetCapacity() const { return _capacity; }
+			int GetSize() const { return (_pos + 7) >> 3; }
+			bool IsOverflow() const { return _overflow; }
+		};
+		VERUS_TYPEDEFS(BitWriter);
+
+		// Reads values, which were written by BitWriter. Reading past the end returns zeros and sets the overflow flag.
+		class BitReader
+		{
+			const BYTE* _p = nullptr;
+			int         _size = 0; // In bits.
+			int         _pos = 0;
+			bool        _overflow = false;
+
+		public:
+			BitReader(const BYTE* p, int size);
+
+			UINT32 Read(int bits);
+			INT32 ReadSigned(int bits);
+			bool ReadBool() { return !!Read(1); }
+
+			int GetBitCount() const { return _pos; }
+			bool IsOverflow() const { return _overflow; }
+		};
+		VERUS_TYPEDEFS(BitReader);
+	}
+}
@@ -0,0 +1,613 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "verus.h"
+
+using namespace verus;
+using namespace verus::Net;
+
+Channel::Channel()
+{
+	VERUS_CT_ASSERT(s_headerSize == sizeof(PacketHeader));
+	Reset();
+}
+
+Channel::~Channel()
+{
+}
+
+void Channel::Init(int maxReportSize, int maxReports)
+{
+	VERUS_RT_ASSERT(maxReportSize >= s_internalReportSize && maxReportSize + s_headerSize <= s_mtu);
+	VERUS_RT_ASSERT(maxReports > 0 && maxReports <= SHRT_MAX);
+	_maxReportSize = maxReportSize;
+	_maxReports = maxReports;
+	_vSendReliable.resize(_maxReportSize * _maxReports);
+	_vSendSlots.resize(_maxReports);
+	_vSendUnreliable.resize(_maxReportSize * _maxReports);
+	_vRecvReliable.resize(_maxReportSize * _maxReports);
+	_vRecvSlots.resize(_maxReports);
+	_vRecvUnreliable.resize(_maxReportSize * _maxReports);
+	_vPacket.resize(s_mtu);
+	Reset();
+}
+
+void Channel::Reset()
+{
+	for (auto& slot : _vSendSlots)
+		slot = Slot();
+	for (auto& slot : _vRecvSlots)
+		slot = Slot();
+	for (auto& sentPacket : _sentPackets)
+		sentPacket = SentPacket();
+	for (auto& index : _unreliableIndex)
+		index = -1;
+	_stats = Stats();
+	_srtt = 0;
+	_rttVar = 0;
+	_sendPacketSeq = 1;
+	_recvPacketSeq = 0;
+	_recvPacketBits = 0;
+	_sendUnreliableCount = 0;
+	_recvUnreliableCount = 0;
+	_sendHead = 0;
+	_recvHead = 0;
+	_packetSize = s_headerSize;
+	_sendSeq = +Seq::reliableBase;
+	_sendHeadSeq = +Seq::reliableBase;
+	_recvSeq = +Seq::reliableBase;
+	_ackPendingTime = 0;
+	_ackPending = false;
+}
+
+int Channel::GetReportSize(const BYTE* p)
+{
+	if (p[0] < REPORT_USER)
+		return s_internalReportSize;
+	UINT16 size;
+	memcpy(&size, p + REPORT_ID_SIZE + 2, 2);
+	return size;
+}
+
+int Channel::SeqDistance(UINT16 from, UINT16 to)
+{
+	const int range = USHRT_MAX + 1 - +Seq::reliableBase;
+	int distance = (to - from) % range;
+	if (distance > range / 2)
+		distance -= range;
+	else if (distance < -range / 2)
+		distance += range;
+	return distance;
+}
+
+void Channel::NextSeq(UINT16& seq)
+{
+	seq++;
+	if (seq < +Seq::reliableBase)
+		seq = +Seq::reliableBase;
+}
+
+bool Channel::PushReliable(const BYTE* p)
+{
+	const int size = GetReportSize(p);
+	if (!IsValidReportSize(size))
+	{
+		_stats._reportsLost++;
+		return false;
+	}
+	const int count = SeqDistance(_sendHeadSeq, _sendSeq);
+	if (count >= _maxReports)
+	{
+		_stats._reportsLost++;
+		return false;
+	}
+	const int slot = (_sendHead + count) % _maxReports;
+	BYTE* pDest = &_vSendReliable[slot * _maxReportSize];
+	memcpy(pDest, p, size);
+	memcpy(pDest + REPORT_ID_SIZE, &_sendSeq, 2);
+	RSlot s = _vSendSlots[slot];
+	s = Slot();
+	s._seq = _sendSeq;
+	s._used = true;
+	NextSeq(_sendSeq);
+	return true;
+}
+
+bool Channel::PushUnreliable(const BYTE* p)
+{
+	const int size = GetReportSize(p);
+	if (!IsValidReportSize(size))
+	{
+		_stats._reportsLost++;
+		return false;
+	}
+	int index = _unreliableIndex[p[0]];
+	if (index < 0)
+	{
+		if (_sendUnreliableCount == _maxReports)
+		{
+			_stats._reportsLost++;
+			return false;
+		}
+		index = _sendUnreliableCount++;
+		_unreliableIndex[p[0]] = index;
+	}
+	BYTE* pDest = &_vSendUnreliable[index * _maxReportSize];
+	memcpy(pDest, p, size);
+	const UINT16 seq = +Seq::unreliable;
+	memcpy(pDest + REPORT_ID_SIZE, &seq, 2);
+	return true;
+}
+
+void Channel::Flush(INT64 now, const TSendFunc& send)
+{
+	VERUS_FOR(i, _sendUnreliableCount)
+	{
+		const BYTE* p = &_vSendUnreliable[i * _maxReportSize];
+		_unreliableIndex[p[0]] = -1;
+		Append(p, GetReportSize(p), now, send);
+	}
+	_sendUnreliableCount = 0;
+
+	const INT64 resendTimeout = GetResendTimeout();
+	const int count = SeqDistance(_sendHeadSeq, _sendSeq);
+	VERUS_FOR(i, count)
+	{
+		const int slot = (_sendHead + i) % _maxReports;
+		RSlot s = _vSendSlots[slot];
+		if (!s._used || (s._sent && now - s._sentTime < resendTimeout))
+			continue;
+		if (s._sent)
+			_stats._reportsResent++;
+		const BYTE* p = &_vSendReliable[slot * _maxReportSize];
+		Append(p, GetReportSize(p), now, send);
+		s._sentTime = now;
+		s._packetSeq = _sendPacketSeq; // Packet, which is being filled.
+		s._sent = true;
+	}
+
+	if (_packetSize > s_headerSize || _ackPending)
+		EmitPacket(now, send);
+}
+
+INT64 Channel::GetResendTimeout() const
+{
+	const INT64 minTimeout = 20 * 1000;
+	const INT64 maxTimeout = 1000 * 1000;
+	if (!_srtt)
+		return 250 * 1000;
+	return Math::Clamp<INT64>(_srtt + 4 * _rttVar, minTimeout, maxTimeout);
+}
+
+INT64 Channel::GetNextFlushTime() const
+{
+	if (_sendUnreliableCount)
+		return 0;
+	INT64 next = LLONG_MAX;
+	if (_ackPending)
+		next = _ackPendingTime + s_ackDelay;
+	const INT64 resendTimeout = GetResendTimeout();
+	const int count = SeqDistance(_sendHeadSeq, _sendSeq);
+	VERUS_FOR(i, count)
+	{
+		RcSlot s = _vSendSlots[(_sendHead + i) % _maxReports];
+		if (!s._used)
+			continue;
+		if (!s._sent)
+			return 0;
+		next = Math::Min(next, s._sentTime + resendTimeout);
+	}
+	return next;
+}
+
+bool Channel::OnDatagram(const BYTE* p, int size, INT64 now)
+{
+	if (size < s_headerSize)
+		return false;
+	PacketHeader header;
+	memcpy(&header, p, sizeof(header));
+	_stats._packetsReceived++;
+	_stats._bytesReceived += size;
+
+	OnAcks(header, now);
+
+	// Duplicate or too old?
+	if (!header._seq)
+		return false;
+	const INT32 diff = static_cast<INT32>(header._seq - _recvPacketSeq);
+	if (_recvPacketSeq && diff <= 0)
+	{
+		if (!diff || -diff > 32 || (_recvPacketBits & (1U << (-diff - 1))))
+			return false;
+	}
+
+	// Validate reports. If some reliable report cannot be stored, the datagram is not acked and will be sent again:
+	int pos = s_headerSize;
+	while (pos < size)
+	{
+		if (size - pos < s_internalReportSize)
+			return false;
+		const BYTE* pReport = p + pos;
+		const int reportSize = GetReportSize(pReport);
+		if (!IsValidReportSize(reportSize) || pos + reportSize > size)
+			return false;
+		UINT16 seq;
+		memcpy(&seq, pReport + REPORT_ID_SIZE, 2);
+		if (seq >= +Seq::reliableBase && SeqDistance(_recvSeq, seq) >= _maxReports)
+			return false;
+		pos += reportSize;
+	}
+
+	// Store reports:
+	pos = s_headerSize;
+	while (pos < size)
+	{
+		const BYTE* pReport = p + pos;
+		const int reportSize = GetReportSize(pReport);
+		UINT16 seq;
+		memcpy(&seq, pReport + REPORT_ID_SIZE, 2);
+		if (seq >= +Seq::reliableBase)
+		{
+			const int distance = SeqDistance(_recvSeq, seq);
+			if (distance >= 0) // Not delivered yet?
+			{
+				const int slot = (_recvHead + distance) % _maxReports;
+				RSlot s = _vRecvSlots[slot];
+				if (!s._used)
+				{
+					memcpy(&_vRecvReliable[slot * _maxReportSize], pReport, reportSize);
+					s._seq = seq;
+					s._used = true;
+				}
+			}
+		}
+		else if (+Seq::unreliable == seq)
+		{
+			if (_recvUnreliableCount < _maxReports)
+				memcpy(&_vRecvUnreliable[_recvUnreliableCount++ * _maxReportSize], pReport, reportSize);
+			else
+				_stats._reportsLost++;
+		}
+		pos += reportSize;
+	}
+
+	// Remember this datagram for acks:
+	if (!_recvPacketSeq)
+	{
+		_recvPacketSeq = header._seq;
+	}
+	else if (diff > 0)
+	{
+		_recvPacketBits = (diff < 32) ? (_recvPacketBits << diff) | (1U << (diff - 1)) : ((32 == diff) ? 0x80000000 : 0);
+		_recvPacketSeq = header._seq;
+	}
+	else
+	{
+		_recvPacketBits |= 1U << (-diff - 1);
+	}
+	if (size > s_headerSize && !_ackPending) // Datagrams with just acks are not acked.
+	{
+		_ackPending = true;
+		_ackPendingTime = now;
+	}
+	return true;
+}
+
+bool Channel::PushReceived(const BYTE* p)
+{
+	const int size = GetReportSize(p);
+	if (_recvUnreliableCount == _maxReports || !IsValidReportSize(size))
+		return false;
+	memcpy(&_vRecvUnreliable[_recvUnreliableCount++ * _maxReportSize], p, size);
+	return true;
+}
+
+void Channel::ClearReceived()
+{
+	_recvUnreliableCount = 0;
+	for (auto& slot : _vRecvSlots)
+		slot._used = false;
+}
+
+void Channel::Append(const BYTE* p, int size, INT64 now, const TSendFunc& send)
+{
+	if (_packetSize + size > s_mtu)
+		EmitPacket(now, send);
+	memcpy(&_vPacket[_packetSize], p, size);
+	_packetSize += size;
+}
+
+void Channel::EmitPacket(INT64 now, const TSendFunc& send)
+{
+	PacketHeader header;
+	header._seq = _sendPacketSeq;
+	header._ack = _recvPacketSeq;
+	header._ackBits = _recvPacketBits;
+	memcpy(_vPacket.data(), &header, sizeof(header));
+
+	RSentPacket sentPacket = _sentPackets[_sendPacketSeq % s_sentPacketCount];
+	sentPacket._time = now;
+	sentPacket._seq = _sendPacketSeq;
+	sentPacket._acked = false;
+
+	send(_vPacket.data(), _packetSize);
+	_stats._packetsSent++;
+	_stats._bytesSent += _packetSize;
+
+	_packetSize = s_headerSize;
+	_ackPending = false;
+	_sendPacketSeq++;
+	if (!_sendPacketSeq)
+		_sendPacketSeq = 1;
+}
+
+void Channel::OnAcks(RcPacketHeader header, INT64 now)
+{
+	if (!header._ack)
+		return;
+
+	// Update RTT using datagrams, which are acked for the first time:
+	for (int i = 0; i <= 32; ++i)
+	{
+		const UINT32 packetSeq = header._ack - i;
+		if (i && !(header._ackBits & (1U << (i - 1))))
+			continue;
+		RSentPacket sentPacket = _sentPackets[packetSeq % s_sentPacketCount];
+		if (sentPacket._seq != packetSeq || sentPacket._acked)
+			continue;
+		sentPacket._acked = true;
+		const INT64 sample = now - sentPacket._time;
+		if (!_srtt)
+		{
+			_srtt = Math::Max<INT64>(sample, 1);
+			_rttVar = sample / 2;
+		}
+		else
+		{
+			const INT64 delta = sample - _srtt;
+			_srtt = Math::Max<INT64>(_srtt + delta / 8, 1);
+			_rttVar += (std::abs(delta) - _rttVar) / 4;
+		}
+	}
+
+	// Reliable reports from acked datagrams are delivered:
+	const int count = SeqDistance(_sendHeadSeq, _sendSeq);
+	VERUS_FOR(i, count)
+	{
+		RSlot s = _vSendSlots[(_sendHead + i) % _maxReports];
+		if (s._used && s._sent && IsAcked(header, s._packetSeq))
+			s._used = false;
+	}
+	while (_sendHeadSeq != _sendSeq && !_vSendSlots[_sendHead]._used)
+	{
+		_sendHead = (_sendHead + 1) % _maxReports;
+		NextSeq(_sendHeadSeq);
+	}
+}
+
+bool Channel::IsAcked(RcPacketHeader header, UINT32 packetSeq)
+{
+	const UINT32 diff = header._ack - packetSeq;
+	if (!diff)
+		return true;
+	return diff <= 32 && (header._ackBits & (1U << (diff - 1)));
+}
+
+namespace
+{
+	// Delivers datagrams with some delay and loss:
+	class SimulatedLink
+	{
+		typedef std::pair<int, Vector<BYTE>> TDatagram;
+
+		std::multimap<INT64, TDatagram> _mapInFlight;
+		Random                          _random;
+		float                           _loss = 0;
+		INT64                           _latency = 0;
+		INT64                           _jitter = 0;
+
+	public:
+		UINT64 _datagramCount = 0;
+		UINT64 _wireBytes = 0; // With UDP/IPv4 headers.
+
+		SimulatedLink(UINT32 seed, float loss, INT64 latency, INT64 jitter) :
+			_random(seed), _loss(loss), _latency(latency), _jitter(jitter) {}
+
+		void Send(int to, const BYTE* p, int size, INT64 now)
+		{
+			_datagramCount++;
+			_wireBytes += size + 28;
+			if (_random.NextFloat() < _loss)
+				return;
+			const INT64 time = now + _latency + static_cast<INT64>(_random.NextFloat() * _jitter);
+			_mapInFlight.insert(std::make_pair(time, TDatagram(to, Vector<BYTE>(p, p + size))));
+		}
+
+		template<typename TFunc>
+		void Deliver(INT64 now, TFunc func)
+		{
+			while (!_mapInFlight.empty() && _mapInFlight.begin()->first <= now)
+			{
+				const TDatagram datagram = std::move(_mapInFlight.begin()->second);
+				_mapInFlight.erase(_mapInFlight.begin());
+				func(datagram.first, datagram.second.data(), Utils::Cast32(datagram.second.size()));
+			}
+		}
+	};
+
+	void MakeTestReport(BYTE* p, int id, int size, UINT32 value)
+	{
+		memset(p, 0, size);
+		p[0] = static_cast<BYTE>(id);
+		const UINT16 size16 = static_cast<UINT16>(size);
+		memcpy(p + REPORT_ID_SIZE + 2, &size16, 2);
+		memcpy(p + REPORT_ID_SIZE + 4, &value, 4);
+	}
+}
+
+void Channel::Test()
+{
+	// Reliable reports must arrive once and in order despite loss and reordering:
+	Channel channels[2];
+	for (auto& channel : channels)
+		channel.Init(64, 32);
+	SimulatedLink link(1, 0.2f, 20 * 1000, 20 * 1000);
+	BYTE report[16];
+	UINT32 sentCount = 0;
+	UINT32 recvCount = 0;
+	int unreliableCount = 0;
+	INT64 now = 0;
+	VERUS_FOR(tick, 3000)
+	{
+		if (tick < 2000)
+		{
+			VERUS_FOR(i, 2)
+			{
+				MakeTestReport(report, REPORT_USER, sizeof(report), sentCount);
+				if (channels[0].PushReliable(report))
+					sentCount++;
+			}
+			MakeTestReport(report, REPORT_USER + 1, sizeof(report), 0);
+			channels[0].PushUnreliable(report);
+			channels[0].PushUnreliable(report); // Replaces the first one.
+		}
+		VERUS_FOR(i, 2)
+		{
+			channels[i].Flush(now, [&link, i, now](const BYTE* p, int size)
+				{
+					link.Send(1 - i, p, size, now);
+				});
+		}
+		link.Deliver(now, [&channels, now](int to, const BYTE* p, int size)
+			{
+				channels[to].OnDatagram(p, size, now);
+			});
+		channels[1].ProcessReports([&recvCount, &unreliableCount](const BYTE* p)
+			{
+				if (REPORT_USER == p[0])
+				{
+					UINT32 value;
+					memcpy(&value, p + REPORT_ID_SIZE + 4, 4);
+					VERUS_RT_ASSERT(value == recvCount);
+					recvCount++;
+				}
+				else
+				{
+					unreliableCount++;
+				}
+				return Continue::yes;
+			});
+		now += 10 * 1000;
+	}
+	VERUS_RT_ASSERT(sentCount > 1000 && recvCount == sentCount);
+	VERUS_RT_ASSERT(unreliableCount > 1000 && unreliableCount <= 2000);
+	VERUS_RT_ASSERT(channels[0].GetRTT() >= 40 * 1000 && channels[0].GetRTT() <= 100 * 1000);
+
+	// Event-driven thread sleeps until the next flush time:
+	Channel channel;
+	channel.Init(64, 32);
+	VERUS_RT_ASSERT(LLONG_MAX == channel.GetNextFlushTime());
+	MakeTestReport(report, REPORT_USER, sizeof(report), 0);
+	channel.PushReliable(report);
+	VERUS_RT_ASSERT(!channel.GetNextFlushTime());
+	channel.Flush(now, [](const BYTE*, int) {});
+	VERUS_RT_ASSERT(channel.GetNextFlushTime() == now + channel.GetResendTimeout());
+
+	// Reports, which don't fit into a slot or are shorter than the header, are rejected and counted as lost:
+	BYTE bigReport[65];
+	MakeTestReport(bigReport, REPORT_USER, sizeof(bigReport), 0);
+	VERUS_RT_ASSERT(!channel.PushReliable(bigReport));
+	VERUS_RT_ASSERT(!channel.PushUnreliable(bigReport));
+	MakeTestReport(report, REPORT_USER, s_internalReportSize - 1, 0);
+	VERUS_RT_ASSERT(!channel.PushReliable(report));
+	VERUS_RT_ASSERT(!channel.PushUnreliable(report));
+	VERUS_RT_ASSERT(4 == channel.GetStats()._reportsLost);
+	VERUS_RT_ASSERT(!channel.IsPending(REPORT_USER));
+}
+
+void Channel::Benchmark()
+{
+	const int playerCount = 32;
+	const int tickCount = 60 * 10;
+	const INT64 tickTime = 1000 * 1000 / 60;
+	const int inputSize = 24;
+	const int stateSize = 40;
+	const int eventSize = 16;
+
+	Vector<Channel> server(playerCount);
+	Vector<Channel> clients(playerCount);
+	VERUS_FOR(i, playerCount)
+	{
+		server[i].Init(64, 64);
+		clients[i].Init(64, 64);
+	}
+	SimulatedLink link(1, 0.05f, 40 * 1000, 10 * 1000);
+	BYTE report[64];
+	UINT64 reportCount = 0;
+	UINT64 reportBytes = 0;
+	INT64 now = 0;
+	VERUS_FOR(tick, tickCount)
+	{
+		// Client sends input each tick and an event twice per second, server sends state of other players:
+		VERUS_FOR(i, playerCount)
+		{
+			MakeTestReport(report, REPORT_USER, inputSize, tick);
+			clients[i].PushUnreliable(report);
+			reportCount++;
+			reportBytes += inputSize;
+			VERUS_FOR(j, playerCount)
+			{
+				if (i == j)
+					continue;
+				MakeTestReport(report, REPORT_USER + 1 + j, stateSize, tick);
+				server[i].PushUnreliable(report);
+				reportCount++;
+				reportBytes += stateSize;
+			}
+			if (!(tick % 30))
+			{
+				MakeTestReport(report, REPORT_USER + 100, eventSize, tick);
+				clients[i].PushReliable(report);
+				server[i].PushReliable(report);
+				reportCount += 2;
+				reportBytes += 2 * eventSize;
+			}
+		}
+
+		VERUS_FOR(i, playerCount)
+		{
+			server[i].Flush(now, [&link, i, now](const BYTE* p, int size) { link.Send(playerCount + i, p, size, now); });
+			clients[i].Flush(now, [&link, i, now](const BYTE* p, int size) { link.Send(i, p, size, now); });
+		}
+		link.Deliver(now, [&server, &clients, now](int to, const BYTE* p, int size)
+			{
+				if (to < playerCount)
+					server[to].OnDatagram(p, size, now);
+				else
+					clients[to - playerCount].OnDatagram(p, size, now);
+			});
+		VERUS_FOR(i, playerCount)
+		{
+			server[i].ProcessReports([](const BYTE*) { return Continue::yes; });
+			clients[i].ProcessReports([](const BYTE*) { return Continue::yes; });
+		}
+		now += tickTime;
+	}
+
+	// One datagram per report, plus acks for reliable ones:
+	const UINT64 reliableCount = (tickCount + 29) / 30 * 2 * playerCount;
+	const UINT64 oldDatagramCount = reportCount + reliableCount;
+	const UINT64 oldWireBytes = reportBytes + reportCount * 28 + reliableCount * (4 + 28);
+
+	UINT32 resentCount = 0;
+	INT64 rtt = 0;
+	VERUS_FOR(i, playerCount)
+	{
+		resentCount += server[i].GetStats()._reportsResent + clients[i].GetStats()._reportsResent;
+		rtt += server[i].GetRTT();
+	}
+	const double seconds = tickCount * tickTime * 0.000001;
+	const double perPlayer = 1 / (seconds * playerCount);
+	VERUS_LOG_INFO("Benchmark(); " << playerCount << " players, per player per second: "
+		<< link._datagramCount * perPlayer << " datagrams (one per report: " << oldDatagramCount * perPlayer << "), "
+		<< link._wireBytes * perPlayer << " bytes (one per report: " << oldWireBytes * perPlayer << "), resent: "
+		<< resentCount << ", RTT: " << rtt / playerCount * 0.001 << " ms");
+}
@@ -0,0 +1,182 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace Net
+	{
+		enum { REPORT_ID_SIZE = 1 };
+
+		enum REPORT_ID
+		{
+			REPORT_NOOP,
+			REPORT_RNAT,
+			REPORT_RACK, // Not used, acks are in datagram header.
+			REPORT_PADD,
+			REPORT_PREM,
+			REPORT_KICK,
+			REPORT_USER
+		};
+
+		// Reports for one peer. Report has this layout: {id, seq, size, data}, size includes the header.
+		// Internal reports (id < REPORT_USER) are just {id, seq}. Seq is set by the channel.
+		// Reports, which are queued during one tick, are packed into datagrams of up to MTU size.
+		// Each datagram starts with its sequence number and acks for the last 33 received datagrams.
+		// Reliable reports are sent again, if the datagram, which had them, is not acked in time (based on RTT).
+		class Channel
+		{
+		public:
+			enum class Seq : UINT16
+			{
+				skip,
+				unreliable,
+				reliableBase
+			};
+
+			static const int s_mtu = 1200; // Safe payload size for most networks.
+			static const int s_internalReportSize = REPORT_ID_SIZE + 2;
+
+			struct PacketHeader
+			{
+				UINT32 _seq = 0;
+				UINT32 _ack = 0; // Latest received datagram, zero means none.
+				UINT32 _ackBits = 0; // Bit N means that datagram (ack-N-1) was received.
+			};
+			VERUS_TYPEDEFS(PacketHeader);
+			static const int s_headerSize = 12;
+
+			struct Stats
+			{
+				UINT64 _packetsSent = 0;
+				UINT64 _bytesSent = 0;
+				UINT64 _packetsReceived = 0;
+				UINT64 _bytesReceived = 0;
+				UINT32 _reportsResent = 0;
+				UINT32 _reportsLost = 0; // Send window or recv queue was full, or report's size was invalid.
+			};
+			VERUS_TYPEDEFS(Stats);
+
+			typedef std::function<void(const BYTE*, int)> TSendFunc;
+
+		private:
+			struct Slot
+			{
+				INT64  _sentTime = 0;
+				UINT32 _packetSeq = 0;
+				UINT16 _seq = 0;
+				bool   _used = false; // Send: waiting for ack. Recv: waiting for delivery.
+				bool   _sent = false;
+			};
+			VERUS_TYPEDEFS(Slot);
+
+			struct SentPacket
+			{
+				INT64  _time = 0;
+				UINT32 _seq = 0;
+				bool   _acked = true;
+			};
+			VERUS_TYPEDEFS(SentPacket);
+
+			static const int s_sentPacketCount = 256;
+			static const INT64 s_ackDelay = 5 * 1000; // Acks can wait for outgoing reports this long.
+
+			Vector<BYTE> _vSendReliable; // Window of reliable reports, which are not acked yet.
+			Vector<Slot> _vSendSlots;
+			Vector<BYTE> _vSendUnreliable;
+			Vector<BYTE> _vRecvReliable; // Window of reliable reports, which can arrive out of order.
+			Vector<Slot> _vRecvSlots;
+			Vector<BYTE> _vRecvUnreliable;
+			Vector<BYTE> _vPacket;
+			SentPacket   _sentPackets[s_sentPacketCount];
+			short        _unreliableIndex[256]; // Position of queued unreliable report by report ID or -1.
+			Stats        _stats;
+			INT64        _srtt = 0; // Smoothed RTT in microseconds.
+			INT64        _rttVar = 0;
+			INT64        _ackPendingTime = 0;
+			UINT32       _sendPacketSeq = 1;
+			UINT32       _recvPacketSeq = 0;
+			UINT32       _recvPacketBits = 0;
+			int          _maxReportSize = 0;
+			int          _maxReports = 0;
+			int          _sendUnreliableCount = 0;
+			int          _recvUnreliableCount = 0;
+			int          _sendHead = 0; // Slot of the oldest report, which is not acked.
+			int          _recvHead = 0; // Slot of the next report to deliver.
+			int          _packetSize = 0;
+			UINT16       _sendSeq = +Seq::reliableBase;
+			UINT16       _sendHeadSeq = +Seq::reliableBase;
+			UINT16       _recvSeq = +Seq::reliableBase;
+			bool         _ackPending = false;
+
+		public:
+			Channel();
+			~Channel();
+
+			void Init(int maxReportSize, int maxReports);
+			void Reset();
+
+			static int GetReportSize(const BYTE* p);
+			bool IsValidReportSize(int size) const { return size >= s_internalReportSize && size <= _maxReportSize; }
+			// Number of NextSeq() calls to get from one reliable seq to another, can be negative:
+			static int SeqDistance(UINT16 from, UINT16 to);
+			static void NextSeq(UINT16& seq);
+
+			// <Send>
+			// Returns false if the window is full or report's size is invalid, which means that the report is lost:
+			bool PushReliable(const BYTE* p);
+			// Replaces queued report with the same ID, returns false like PushReliable():
+			bool PushUnreliable(const BYTE* p);
+			bool IsPending(BYTE reportID) const { return _unreliableIndex[reportID] >= 0; }
+			// Packs queued reports, reliable reports, which must be resent, and acks into datagrams:
+			void Flush(INT64 now, const TSendFunc& send);
+			// Microseconds:
+			INT64 GetRTT() const { return _srtt; }
+			INT64 GetResendTimeout() const;
+			// When Flush() should be called next, zero means now, LLONG_MAX means nothing to send:
+			INT64 GetNextFlushTime() const;
+			// </Send>
+
+			// <Recv>
+			// Returns false if the datagram is invalid, a duplicate or cannot be stored yet:
+			bool OnDatagram(const BYTE* p, int size, INT64 now);
+			// For internal reports, returns false if the queue is full or report's size is invalid:
+			bool PushReceived(const BYTE* p);
+			void ClearReceived();
+			// Calls func(const BYTE*) for unreliable reports, then for reliable reports in order.
+			// Func should return Continue::no if it resets the channel.
+			template<typename TFunc>
+			void ProcessReports(TFunc func)
+			{
+				VERUS_FOR(i, _recvUnreliableCount)
+				{
+					if (Continue::no == func(&_vRecvUnreliable[i * _maxReportSize]))
+						return;
+				}
+				_recvUnreliableCount = 0;
+				while (!_vRecvSlots.empty() && _vRecvSlots[_recvHead]._used)
+				{
+					_vRecvSlots[_recvHead]._used = false;
+					const int slot = _recvHead;
+					_recvHead = (_recvHead + 1) % _maxReports;
+					NextSeq(_recvSeq);
+					if (Continue::no == func(&_vRecvReliable[slot * _maxReportSize]))
+						return;
+				}
+			}
+			// </Recv>
+
+			RcStats GetStats() const { return _stats; }
+
+			static void Test();
+			// Simulates a server with 32 clients over a link with loss and latency, results are written to log:
+			static void Benchmark();
+
+		private:
+			void Append(const BYTE* p, int size, INT64 now, const TSendFunc& send);
+			void EmitPacket(INT64 now, const TSendFunc& send);
+			void OnAcks(RcPacketHeader header, INT64 now);
+			static bool IsAcked(RcPacketHeader header, UINT32 packetSeq);
+		};
+		VERUS_TYPEDEFS(Channel);
+	}
+}
@@ -21,15 +21,12 @@ void Multiplayer::Player::Reset()
 {
 	_log.clear();
 	_log.reserve(s_logSize);
-	_statSendBufferFullCount = 0;
-	_statRecvBufferFullCount = 0;
-	_sendSeq = +Seq::reliableBase;
-	_sendSeqResend = +Seq::reliableBase;
-	_recvSeq = +Seq::reliableBase;
-	_sendBuffer.Clear();
-	_recvBuffer.Clear();
+	_channel.Reset();
+	_stats = Channel::Stats();
 	_addr = Addr();
 	_reserved = false;
+	_kicked = false;
+	_removing = false;
 }
 
 void Multiplayer::Player::Log(CSZ msg)
@@ -58,29 +55,11 @@ void Multiplayer::Player::SaveLog(int id, bool server)
 
 // Multiplayer:
 
-bool Multiplayer::IsLessThan(UINT16 a, UINT16 b)
-{
-	const int diff = a - b;
-	return (diff < 0 && diff > -SHRT_MAX) || diff > SHRT_MAX;
-}
-
-bool Multiplayer::IsGreaterThan(UINT16 a, UINT16 b)
-{
-	const int diff = a - b;
-	return (diff > 0 && diff < SHRT_MAX) || diff < -SHRT_MAX;
-}
-
-void Multiplayer::NextSeq(UINT16& seq)
-{
-	seq++;
-	if (seq < +Seq::reliableBase)
-		seq = +Seq::reliableBase;
-}
-
 Multiplayer::Multiplayer()
 {
 	VERUS_CT_ASSERT(1 == REPORT_ID_SIZE);
 	SetFlag(MultiplayerFlags::activeGamesReady);
+	_stopThread = false;
 }
 
 Multiplayer::~Multiplayer()
@@ -96,23 +75,14 @@ void Multiplayer::Init(RcAddr addr, int maxPlayers, int maxReportSize, int maxRe
 	_maxPlayers = maxPlayers;
 	_maxReportSize = maxReportSize;
 	_maxReports = maxReports;
-	const int cacheBytesPerPlayer = _maxReportSize * _maxReports;
-	_vMasterBuffer.resize(cacheBytesPerPlayer * _maxPlayers * 2); // 2x for send + receive.
-	_vReportBuffer.resize(_maxReportSize);
+	_vPacketBuffer.resize(Channel::s_mtu * 2); // Bigger datagrams are invalid.
 	_vPlayers.resize(_maxPlayers);
-	//VERUS_OUTPUT_DEBUG_STRING(_C(String("MP: master = ") + std::to_string(_vMasterBuffer.size()) +
-	//	", report = " + std::to_string(_vReportBuffer.size()) + ", players = " + std::to_string(_vPlayers.size())));
-	int id = 0;
 	for (auto& player : _vPlayers)
-	{
-		const int offsetS = (2 * id + 0) * cacheBytesPerPlayer;
-		const int offsetR = (2 * id + 1) * cacheBytesPerPlayer;
-		player._sendBuffer = BaseCircularBuffer(_vMasterBuffer.data() + offsetS, _maxReports, _maxReportSize);
-		player._recvBuffer = BaseCircularBuffer(_vMasterBuffer.data() + offsetR, _maxReports, _maxReportSize);
-		//VERUS_OUTPUT_DEBUG_STRING(_C(String("MP: ID=") + std::to_string(id) +
-		//	" layout: send @ " + std::to_string(offsetS) + ", recv @ " + std::to_string(offsetR)));
-		id++;
-	}
+		player._channel.Init(_maxReportSize, _maxReports);
+	// Enough to hold what all channels can have at once:
+	const int queueCapacity = Math::Max(256, 2 * _maxPlayers * _maxReports);
+	_outgoing.Init(_maxReportSize, queueCapacity);
+	_incoming.Init(_maxReportSize, queueCapacity);
 	_vNat.reserve(8);
 	int port = _serverAddr._port;
 	if (!_serverAddr.IsLocalhost()) // Use port N+1, if client:
@@ -120,6 +90,10 @@ void Multiplayer::Init(RcAddr addr, int maxPlayers, int maxReportSize, int maxRe
 	_vPlayers[0]._addr = _serverAddr;
 	_vPlayers[0]._tpLast = std::chrono::steady_clock::now();
 	_socket.Udp(port);
+	_hWakeEvent = WSACreateEvent();
+	if (WSA_INVALID_EVENT == _hWakeEvent)
+		throw VERUS_RUNTIME_ERROR << "WSACreateEvent(); " << WSAGetLastError();
+	_stopThread = false;
 	_thread = std::thread(&Multiplayer::ThreadProc, this);
 }
 
@@ -127,20 +101,15 @@ void Multiplayer::Done()
 {
 	if (_thread.joinable())
 	{
-		// Send kick to localhost:
-		Addr addr = Addr::Localhost();
-		addr._port = _serverAddr._port;
-		if (!_serverAddr.IsLocalhost()) // Use port N+1, if client:
-			addr._port++;
-		const BYTE kick = REPORT_KICK;
-		_socket.SendTo(&kick, 1, addr);
-
-		_cv.notify_one();
+		_stopThread = true;
+		WSASetEvent(_hWakeEvent);
 		_thread.join();
 	}
 	if (_threadWeb.joinable())
 		_threadWeb.join();
 	_socket.Close();
+	if (_hWakeEvent != WSA_INVALID_EVENT)
+		WSACloseEvent(_hWakeEvent);
 	VERUS_DONE(Multiplayer);
 }
 
@@ -162,6 +131,12 @@ bool Multiplayer::IsActivePlayer(int id)
 	return !_vPlayers[id]._addr.IsNull();
 }
 
+Channel::Stats Multiplayer::GetStats(int id)
+{
+	VERUS_LOCK(*this);
+	return _vPlayers[id]._stats;
+}
+
 int Multiplayer::ReservePlayer()
 {
 	VERUS_LOCK(*this);
@@ -187,162 +162,46 @@ void Multiplayer::CancelReservation(int id)
 
 void Multiplayer::SendReportAsync(int id, BYTE* p, bool deferred)
 {
+	const int size = Channel::GetReportSize(p);
+	if (size < Channel::s_internalReportSize || size > _outgoing.GetMaxReportSize())
 	{
-		VERUS_LOCK_EX(*this, IsFlagSet(MultiplayerFlags::noLock));
-		const bool reliable = _pDelegate->Multiplayer_IsReliable(p);
-		VERUS_FOR(i, _maxPlayers)
-		{
-			PPlayer pPlayer = &_vPlayers[i];
-
-			if (id >= 0)
-				pPlayer = &_vPlayers[id];
-			else if (!IsServer())
-				pPlayer = &_vPlayers[0];
-			else if (IsServer())
-			{
-				if (0 == i)
-					continue; // Do not send message to localhost.
-			}
-
-			if (pPlayer->_addr.IsNull())
-				continue;
-
-			if (pPlayer->_sendBuffer.IsFull()) // Full? Remove unreliable:
-			{
-				pPlayer->_statSendBufferFullCount++;
-				pPlayer->Log("Send buffer is full, cleaning");
-				UINT16 seq = +Seq::unreliable;
-				BYTE* p = pPlayer->_sendBuffer.FindItem(&seq, 2, REPORT_ID_SIZE);
-				while (p)
-				{
-					pPlayer->_sendBuffer.MoveToFront(p);
-					pPlayer->_sendBuffer.Pop(nullptr);
-					p = pPlayer->_sendBuffer.FindItem(&seq, 2, REPORT_ID_SIZE);
-					if (!p)
-					{
-						seq = +Seq::skip; // Now clean 'skip'...
-						p = pPlayer->_sendBuffer.FindItem(&seq, 2, REPORT_ID_SIZE);
-					}
-				}
-			}
-
-			if (!reliable) // Send it and forget it?
-			{
-				const UINT16 seq = +Seq::unreliable;
-				memcpy(p + REPORT_ID_SIZE, &seq, 2);
-				BYTE* pMatch = pPlayer->_sendBuffer.FindItem(p, REPORT_ID_SIZE);
-				if (pMatch) // Just overwrite existing report?
-				{
-					memcpy(pMatch, p, pPlayer->_sendBuffer.GetMaxItemSize());
-					continue;
-				}
-			}
-			else
-			{
-				if (pPlayer->_sendBuffer.IsFull())
-				{
-					pPlayer->Log("Send buffer is full, report is lost");
-					continue; // Next player...
-				}
-				memcpy(p + REPORT_ID_SIZE, &pPlayer->_sendSeq, 2);
-				NextSeq(pPlayer->_sendSeq);
-			}
-			pPlayer->_sendBuffer.Push(p);
-
-			if (id >= 0 || !IsServer())
-				break;
-		}
-		SetFlag(MultiplayerFlags::sendReports); // ThreadProc() should know about the new report.
+		VERUS_LOG_WARN("SendReportAsync(); Report's size is " << size << ", max is " << _outgoing.GetMaxReportSize() << ", report is lost");
+		return;
 	}
+	const int flags = _pDelegate->Multiplayer_IsReliable(p) ? QueueFlags::reliable : 0;
+	if (!_outgoing.Push(id, flags, p, size))
+		VERUS_LOG_WARN("SendReportAsync(); Outgoing queue is full, report is lost");
 	if (!deferred)
-		_cv.notify_one(); // Wake up!
+		WSASetEvent(_hWakeEvent); // Wake up!
 }
 
 void Multiplayer::ProcessRecvBuffers()
 {
-	VERUS_LOCK(*this);
 	int id = 0;
-	for (auto& player : _vPlayers)
+	int flags = 0;
+	while (const BYTE* p = _incoming.Peek(id, flags))
 	{
-		if (!player._addr.IsNull())
+		RPlayer player = _vPlayers[id];
+		if (flags & QueueFlags::connect)
 		{
-			UINT16 seq;
-			BYTE* p;
-
-			SetFlag(MultiplayerFlags::noLock);
-
-			// 1) Remove all 'skip':
-			seq = +Seq::skip;
-			while (p = player._recvBuffer.FindItem(&seq, sizeof(seq), REPORT_ID_SIZE))
+			player._dropReports = false;
+			if (!_pDelegate->Multiplayer_OnConnect(id, p, player._addr))
 			{
-				player._recvBuffer.MoveToFront(p);
-				player._recvBuffer.Pop(nullptr);
-			}
-
-			// 2) Get & remove all 'unreliable':
-			seq = +Seq::unreliable;
-			while (p = player._recvBuffer.FindItem(&seq, sizeof(seq), REPORT_ID_SIZE))
-			{
-				player._recvBuffer.MoveToFront(p);
-				player._recvBuffer.Pop(_vReportBuffer.data());
-				switch (_vReportBuffer[0])
-				{
-				case REPORT_PADD:
-				{
-					player._recvBuffer.Pop(_vReportBuffer.data(), true); // JOIN?
-					if (!_pDelegate->Multiplayer_OnConnect(id, _vReportBuffer.data(), player._addr))
-					{
-						player.SaveLog(id, IsServer());
-						player.Reset(); // App rejects this player?
-					}
-				}
-				break;
-				case REPORT_PREM:
-				{
-					_pDelegate->Multiplayer_OnDisconnect(id);
-					player.SaveLog(id, IsServer());
-					player.Reset(); // Forget this player.
-				}
-				break;
-				default:
-				{
-					_pDelegate->Multiplayer_OnReportFrom(id, _vReportBuffer.data());
-				}
-				}
-			}
-
-			// 3) Get 'reliable':
-			seq = player._recvSeq;
-			while (p = player._recvBuffer.FindItem(&seq, sizeof(seq), REPORT_ID_SIZE))
-			{
-				player._recvBuffer.MoveToFront(p);
-				player._recvBuffer.Pop(_vReportBuffer.data());
-				_pDelegate->Multiplayer_OnReportFrom(id, _vReportBuffer.data());
-				NextSeq(player._recvSeq); // Expect next sequence number.
-				seq = player._recvSeq;
-			}
-
-			ResetFlag(MultiplayerFlags::noLock);
-
-			if (player._recvBuffer.IsFull()) // Bad condition: no space for the expected sequence number!
-			{
-				int count = player._recvBuffer.GetItemCount();
-				bool detected = false;
-				while (count && player._recvBuffer.Pop(_vReportBuffer.data()))
-				{
-					memcpy(&seq, &_vReportBuffer[REPORT_ID_SIZE], 2);
-					if (!IsLessThan(seq, player._recvSeq))
-						player._recvBuffer.Push(_vReportBuffer.data());
-					else
-						detected = true;
-					count--;
-				}
-				if (detected)
-					player.Log("Invalid sequence number detected in recv buffer");
-				NextSeq(player._recvSeq); // Expect next sequence number (data loss!).
+				player._dropReports = true; // App rejects this player?
+				ResetPlayerAsync(id);
 			}
 		}
-		id++;
+		else if (REPORT_PREM == p[0])
+		{
+			_pDelegate->Multiplayer_OnDisconnect(id);
+			player._dropReports = true;
+			ResetPlayerAsync(id); // Forget this player.
+		}
+		else if (!player._dropReports)
+		{
+			_pDelegate->Multiplayer_OnReportFrom(id, p);
+		}
+		_incoming.Pop();
 	}
 }
 
@@ -350,7 +209,7 @@ void Multiplayer::Kick(int id)
 {
 	BYTE kick[3];
 	kick[0] = REPORT_KICK;
-	const UINT16 seq = +Seq::unreliable;
+	const UINT16 seq = +Channel::Seq::unreliable;
 	memcpy(kick + REPORT_ID_SIZE, &seq, 2);
 	SendReportAsync(id, kick);
 	// Now the ThreadProc() should send the KICK report and push PREM report.
@@ -380,239 +239,241 @@ int Multiplayer::FindFreeID() const
 	return -1;
 }
 
+void Multiplayer::ResetPlayerAsync(int id)
+{
+	// Player's state belongs to ThreadProc(), so it should do the reset:
+	const BYTE noop = REPORT_NOOP;
+	if (!_outgoing.Push(id, QueueFlags::reset, &noop, sizeof(noop)))
+		VERUS_LOG_WARN("ResetPlayerAsync(); Outgoing queue is full");
+	WSASetEvent(_hWakeEvent);
+}
+
 void Multiplayer::ThreadProc()
 {
 	VERUS_RT_ASSERT(IsInitialized());
-	VERUS_LOCK(*this);
-	Addr addr;
-	int res;
-	BYTE* p;
-	UINT16 seq;
-	UINT16 size;
-	std::chrono::steady_clock::time_point tpResend = std::chrono::steady_clock::now();
-	std::chrono::steady_clock::time_point tpNat = std::chrono::steady_clock::now();
+	VERUS_PROFILE_THREAD("Multiplayer");
+	const std::chrono::steady_clock::time_point tpStart = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point tpNat = tpStart;
+	INT64 nextHousekeeping = 0;
+	int timeoutMs = 0;
 	while (true)
 	{
-		_cv.wait_for(lock, std::chrono::milliseconds(10)); // ~100 times per second.
-
-		bool resend = false;
-		if (std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - tpResend).count() >= 3)
+		// Sleep until a datagram arrives, reports are queued or some channel must send something:
+		_socket.WaitForRead(_hWakeEvent, timeoutMs);
+		WSAResetEvent(_hWakeEvent);
+		if (_stopThread)
+			break;
+
+		VERUS_PROFILE_SCOPE("Multiplayer::Tick");
+		const std::chrono::steady_clock::time_point tpNow = std::chrono::steady_clock::now();
+		const INT64 now = std::chrono::duration_cast<std::chrono::microseconds>(tpNow - tpStart).count();
+
+		RouteOutgoingReports();
+		RecvDatagrams(now);
+
+		// Send queued reports, resend lost reliable reports and acks, one or more datagrams per player:
+		INT64 nextFlush = nextHousekeeping;
+		int id = 0;
+		for (auto& player : _vPlayers)
 		{
-			tpResend = std::chrono::steady_clock::now();
-			resend = true;
+			if (!player._addr.IsNull())
+			{
+				if (player._channel.GetNextFlushTime() <= now)
+				{
+					player._channel.Flush(now, [this, &player](const BYTE* p, int size)
+						{
+#ifdef VERUS_MP_BAD_CONNECTION // Emulate lost and duplicate datagrams:
+							if (!(Utils::I().GetRandom().Next() % 2))
+								return;
+							_socket.SendTo(p, size, player._addr);
+#endif
+							_socket.SendTo(p, size, player._addr);
+						});
+				}
+				nextFlush = Math::Min(nextFlush, player._channel.GetNextFlushTime());
+
+				if (player._kicked && !player._removing) // Disconnect right after KICK report was sent:
+					DisconnectPlayer(id, "Kicked");
+			}
+			id++;
 		}
 
-		bool nat = false;
-		if (std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - tpNat).count() >= 5)
+		if (now >= nextHousekeeping)
 		{
-			tpNat = std::chrono::steady_clock::now();
-			nat = true;
+			nextHousekeeping = now + s_housekeepingTime;
+			nextFlush = Math::Min(nextFlush, nextHousekeeping);
+
+			if (std::chrono::duration_cast<std::chrono::seconds>(tpNow - tpNat).count() >= 5)
+			{
+				tpNat = tpNow;
+				// Send data to the clients which will allow them to send data to the server:
+				const BYTE report = REPORT_RNAT;
+				VERUS_LOCK(*this);
+				for (const auto& natAddr : _vNat)
+					_socket.SendTo(&report, sizeof(report), natAddr);
+			}
+
+			// Disconnect idle:
+			if (IsServer())
+			{
+#ifdef _DEBUG
+				const int deadline = 3600;
+#else
+				const int deadline = 101;
+#endif
+				VERUS_FOR(i, _maxPlayers)
+				{
+					RcPlayer player = _vPlayers[i];
+					if (player._addr.IsNull() || player._addr.IsLocalhost() || player._removing)
+						continue;
+					if (std::chrono::duration_cast<std::chrono::seconds>(tpNow - player._tpLast).count() >= deadline)
+						DisconnectPlayer(i, "Timeout");
+				}
+			}
+
+			VERUS_LOCK(*this);
+			for (auto& player : _vPlayers)
+				player._stats = player._channel.GetStats();
 		}
 
-		if (nat) // Send data to the clients which will allow them to send data to the server:
+		// Undelivered reports wait for free space in the incoming queue:
+		if (_incoming.GetFreeCount() < 2 * _maxReports)
+			nextFlush = Math::Min(nextFlush, now + 1000);
+
+		timeoutMs = static_cast<int>(Math::Clamp<INT64>((nextFlush - now + 999) / 1000, 0, s_housekeepingTime / 1000));
+	}
+}
+
+void Multiplayer::RouteOutgoingReports()
+{
+	int id = 0;
+	int flags = 0;
+	while (const BYTE* p = _outgoing.Peek(id, flags))
+	{
+		if (flags & QueueFlags::reset)
 		{
-			const BYTE report = REPORT_RNAT;
-			for (const auto& natAddr : _vNat)
-				_socket.SendTo(&report, sizeof(report), natAddr);
-			//VERUS_OUTPUT_DEBUG_STRING(_C(String("MP: NAT Punch-through addresses: " + std::to_string(_vNat.size()))));
+			VERUS_LOCK(*this);
+			RPlayer player = _vPlayers[id];
+			player.SaveLog(id, IsServer());
+			player.Reset();
 		}
-
-		// Need to send/resend some reports?
-		if (IsFlagSet(MultiplayerFlags::sendReports) || resend)
+		else
 		{
-			for (auto& player : _vPlayers)
+			VERUS_FOR(i, _maxPlayers)
 			{
-				if (player._addr.IsNull())
-					continue;
-
-				bool remove = false;
+				PPlayer pPlayer = &_vPlayers[i];
 
-				// 1) Remove all 'skip' (acknowledged reports):
-				seq = +Seq::skip;
-				while (p = player._sendBuffer.FindItem(&seq, sizeof(seq), REPORT_ID_SIZE))
+				if (id >= 0)
+					pPlayer = &_vPlayers[id];
+				else if (!IsServer())
+					pPlayer = &_vPlayers[0];
+				else if (IsServer())
 				{
-					player._sendBuffer.MoveToFront(p);
-					player._sendBuffer.Pop(nullptr);
+					if (0 == i)
+						continue; // Do not send message to localhost.
 				}
 
-				// 2) Send & remove all 'unreliable':
-				seq = +Seq::unreliable;
-				while (p = player._sendBuffer.FindItem(&seq, sizeof(seq), REPORT_ID_SIZE))
+				if (!pPlayer->_addr.IsNull() && !pPlayer->_removing)
 				{
-					player._sendBuffer.MoveToFront(p);
-					player._sendBuffer.Pop(_vReportBuffer.data());
-					if (REPORT_KICK == _vReportBuffer[0]) // Player was kicked?
+					if (flags & QueueFlags::reliable)
 					{
-						size = 3;
-						remove = true;
+						if (!pPlayer->_channel.PushReliable(p))
+							pPlayer->Log("Send window is full, report is lost");
 					}
 					else
-						memcpy(&size, &_vReportBuffer[3], 2);
-					res = _socket.SendTo(_vReportBuffer.data(), size, player._addr);
-					player.Log(_C("Sending unreliable report " + std::to_string(_vReportBuffer[0])));
-				}
-
-				// 3) Send 'reliable', do not remove:
-				int count = player._sendBuffer.GetItemCount();
-				while (count && player._sendBuffer.Pop(_vReportBuffer.data()))
-				{
-					memcpy(&seq, &_vReportBuffer[REPORT_ID_SIZE], 2);
-					if (seq == player._sendSeqResend || IsGreaterThan(seq, player._sendSeqResend) || resend)
 					{
-						memcpy(&size, &_vReportBuffer[3], 2);
-#ifdef VERUS_MP_BAD_CONNECTION // Emulate lost report condition:
-						if (!(Utils::I().GetRandom().Next() % 2))
-#endif
-						{
-							res = _socket.SendTo(_vReportBuffer.data(), size, player._addr);
-#ifdef VERUS_MP_BAD_CONNECTION // Emulate duplicate report condition:
-							res = _socket.SendTo(_vReportBuffer.data(), size, player._addr);
-#endif
-							player.Log(_C("Sending reliable report " + std::to_string(_vReportBuffer[0])));
-						}
+						pPlayer->_channel.PushUnreliable(p); // Replaces queued report with the same ID.
 					}
-					player._sendBuffer.Push(_vReportBuffer.data()); // Push it back in!
-					count--;
+					if (REPORT_KICK == p[0])
+						pPlayer->_kicked = true;
 				}
-				player._sendSeqResend = player._sendSeq;
 
-				// Disconnect idle / kicked:
-				if (IsServer() && !player._addr.IsLocalhost())
-				{
-#ifdef _DEBUG
-					const int deadline = 3600;
-#else
-					const int deadline = 101;
-#endif
-					if (std::chrono::duration_cast<std::chrono::seconds>(
-						std::chrono::steady_clock::now() - player._tpLast).count() >= deadline ||
-						remove)
-					{
-						BYTE prem[3];
-						prem[0] = REPORT_PREM;
-						seq = +Seq::unreliable;
-						memcpy(prem + REPORT_ID_SIZE, &seq, 2);
-						player._recvBuffer.Clear();
-						player._recvBuffer.Push(prem, sizeof(prem));
-						if (remove)
-							player.Log("Kicked");
-						else
-							player.Log("Timeout");
-						continue;
-					}
-				}
+				if (id >= 0 || !IsServer())
+					break;
 			}
-			ResetFlag(MultiplayerFlags::sendReports);
 		}
+		_outgoing.Pop();
+	}
+}
 
-		// Receive reports from the net?
-		while ((res = _socket.RecvFrom(_vReportBuffer.data(), static_cast<int>(_vReportBuffer.size()), addr)) > 0)
-		{
-			// Start analyzing incoming traffic...
-
-			if (addr.IsLocalhost())
-				return; // A report from myself means it is time to exit.
+void Multiplayer::RecvDatagrams(INT64 now)
+{
+	const std::chrono::steady_clock::time_point tpNow = std::chrono::steady_clock::now();
+	Addr addr;
+	int res;
+	while ((res = _socket.RecvFrom(_vPacketBuffer.data(), Utils::Cast32(_vPacketBuffer.size()), addr)) > 0)
+	{
+		// Start analyzing incoming traffic...
 
-			int id = GetIdByAddr(addr);
+		if (addr.IsLocalhost())
+			continue;
 
-			if (id < 0) // Unknown IP. Register new player?
-			{
-				id = FindFreeID();
-				if (id >= 0)
-				{
-					//VERUS_OUTPUT_DEBUG_STRING(_C(String("MP: new player " + std::to_string(id))));
-
-					_vPlayers[id].Reset();
-					_vPlayers[id]._addr = addr;
-
-					// This will call OnConnect() in ProcessRecvBuffers():
-					BYTE padd[3];
-					padd[0] = REPORT_PADD;
-					seq = +Seq::unreliable;
-					memcpy(padd + REPORT_ID_SIZE, &seq, 2);
-					_vPlayers[id]._recvBuffer.Push(padd, sizeof(padd));
-					_vPlayers[id].Log("Registered");
-				}
-			}
+		int id = GetIdByAddr(addr);
 
+		if (id < 0 && res > Channel::s_headerSize) // Unknown IP, which sends reports. Register new player?
+		{
+			VERUS_LOCK(*this);
+			id = FindFreeID();
 			if (id >= 0)
 			{
-				RPlayer player = _vPlayers[id];
-				player._tpLast = std::chrono::steady_clock::now(); // Connection is not lost!
+				//VERUS_OUTPUT_DEBUG_STRING(_C(String("MP: new player " + std::to_string(id))));
 
-				if (player._recvBuffer.IsFull()) // Full? Remove unreliable:
-				{
-					player._statRecvBufferFullCount++;
-					player.Log("Recv buffer is full, cleaning");
-					seq = +Seq::unreliable;
-					p = player._recvBuffer.FindItem(&seq, 2, REPORT_ID_SIZE);
-					while (p)
-					{
-						player._recvBuffer.MoveToFront(p);
-						player._recvBuffer.Pop(nullptr);
-						p = player._recvBuffer.FindItem(&seq, 2, REPORT_ID_SIZE);
-						if (!p)
-						{
-							seq = +Seq::skip; // Now clean 'skip'...
-							p = player._recvBuffer.FindItem(&seq, 2, REPORT_ID_SIZE);
-						}
-					}
-				}
-
-				bool push = false;
-				if (_pDelegate->Multiplayer_IsReliable(_vReportBuffer.data()))
+				RPlayer player = _vPlayers[id];
+				player.Reset();
+				player._addr = addr;
+				player.Log("Registered");
+
+				// This will call OnConnect() in ProcessRecvBuffers(), first report is passed to it:
+				const BYTE* pJoinReport = &_vPacketBuffer[Channel::s_headerSize];
+				const int joinReportSize = Math::Min(res - Channel::s_headerSize, _maxReportSize);
+				if (!_incoming.Push(id, QueueFlags::connect, pJoinReport, joinReportSize))
 				{
-					memcpy(&seq, &_vReportBuffer[REPORT_ID_SIZE], 2); // Check sequence number.
-					p = player._recvBuffer.FindItem(&seq, 2, REPORT_ID_SIZE);
-					push = !p && (seq == player._recvSeq || IsGreaterThan(seq, player._recvSeq)); // Do not push old reports & duplicates.
-
-					if (!player._recvBuffer.IsFull()) // Send RACK if we can store this report right now:
-					{
-						//VERUS_OUTPUT_DEBUG_STRING(_C(String("MP: reliable report " + std::to_string(_vReportBuffer[0]) + " from " + std::to_string(id))));
-						BYTE rack[4]; // {REPORT_RACK, seq, id}.
-						rack[0] = REPORT_RACK;
-						memcpy(rack + REPORT_ID_SIZE, &_vReportBuffer[REPORT_ID_SIZE], 2);
-						rack[3] = _vReportBuffer[0];
-						_socket.SendTo(rack, sizeof(rack), addr); // Send report acknowledgment. Yes, report is received!
-						player.Log(_C("Sending RACK for " + std::to_string(_vReportBuffer[0])));
-					}
-					else
-						push = false;
+					player.Log("Incoming queue is full");
+					player.Reset();
+					continue;
 				}
-				else
-					push = player._recvBuffer.GetItemCount() * 100 / player._recvBuffer.GetMaxItems() < 75; // App will handle the sequence of unreliable reports.
-
-				if (4 == res && REPORT_RACK == _vReportBuffer[0]) // Is this a report acknowledgment? Update send buffer.
-				{
-					//VERUS_OUTPUT_DEBUG_STRING(_C(String("MP: report ACK " + std::to_string(_vReportBuffer[3]) + " from " + std::to_string(id))));
+			}
+		}
 
-					BYTE key[3];
-					key[0] = _vReportBuffer[3];
-					memcpy(key + REPORT_ID_SIZE, &_vReportBuffer[REPORT_ID_SIZE], 2);
-					p = player._sendBuffer.FindItem(key, sizeof(key));
-					if (p)
-					{
-						seq = +Seq::skip;
-						memcpy(p + REPORT_ID_SIZE, &seq, 2); // Stop sending this report.
-					}
-					push = false; // RACK should never be seen by the app.
-					player.Log(_C("Received RACK for " + std::to_string(key[0])));
-				}
+		if (id >= 0)
+		{
+			RPlayer player = _vPlayers[id];
+			player._tpLast = tpNow; // Connection is not lost!
+			player._channel.OnDatagram(_vPacketBuffer.data(), res, now); // Duplicates and invalid datagrams are ignored.
+		}
+	}
 
-				if (push && res >= 5) // Send it to app only if it is unreliable or with proper sequence number:
+	// Pass received reports to the game thread, channel keeps them while there is no space:
+	int id = 0;
+	for (auto& player : _vPlayers)
+	{
+		if (!player._addr.IsNull() && !player._removing && _incoming.GetFreeCount() >= 2 * _maxReports)
+		{
+			player._channel.ProcessReports([this, id](const BYTE* p)
 				{
-					memcpy(&size, &_vReportBuffer[3], 2);
-					if (res == size) // Valid size?
-					{
-						player._recvBuffer.Push(_vReportBuffer.data());
-						player.Log(_C("Received report " + std::to_string(_vReportBuffer[0]) + " for ProcessRecvBuffers()"));
-					}
-				}
-			}
+					_incoming.Push(id, 0, p, Channel::GetReportSize(p));
+					return Continue::yes;
+				});
 		}
+		id++;
 	}
 }
 
+void Multiplayer::DisconnectPlayer(int id, CSZ reason)
+{
+	RPlayer player = _vPlayers[id];
+	BYTE prem[3];
+	prem[0] = REPORT_PREM;
+	const UINT16 seq = +Channel::Seq::unreliable;
+	memcpy(prem + REPORT_ID_SIZE, &seq, 2);
+	// This will call OnDisconnect() in ProcessRecvBuffers(), which will reset the player:
+	if (!_incoming.Push(id, 0, prem, sizeof(prem)))
+		return; // Try again later.
+	player._channel.ClearReceived();
+	player._removing = true;
+	player.Log(reason);
+}
+
 String Multiplayer::GetDebug()
 {
 	StringStream ss;
@@ -813,3 +674,109 @@ void Multiplayer::ThreadProcWeb()
 		// No internet?
 	}
 }
+
+void Multiplayer::Benchmark()
+{
+	const int port = 27015;
+	const int latencyCount = 500;
+	const int throughputCount = 100 * 1000;
+	const int reportSize = 64;
+	const std::chrono::steady_clock::time_point tpStart = std::chrono::steady_clock::now();
+	auto GetTime = [tpStart]()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tpStart).count();
+	};
+
+	// Receiving thread either polls the socket every 10 ms (old way) or waits for it (new way).
+	// Latency is the time between sendto() and the moment, when the report can be passed to the game thread.
+	auto Run = [&](bool polling, int count, bool burst, Vector<INT64>& vLatency, double& reportsPerSecond)
+	{
+		Socket receiver;
+		Socket sender;
+		receiver.Udp(port);
+		sender.Udp(port + 1);
+		const Addr addr = Addr::Localhost(port);
+		const WSAEVENT hWakeEvent = WSACreateEvent();
+		std::atomic<bool> stop(false);
+		std::mutex mutex;
+		std::condition_variable cv;
+		INT64 lastRecvTime = 0;
+		vLatency.clear();
+		vLatency.reserve(count);
+
+		std::thread thread([&]()
+			{
+				BYTE buffer[Channel::s_mtu];
+				Addr from;
+				while (!stop)
+				{
+					if (polling)
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						cv.wait_for(lock, std::chrono::milliseconds(10));
+					}
+					else
+					{
+						receiver.WaitForRead(hWakeEvent, s_housekeepingTime / 1000);
+					}
+					int res;
+					while ((res = receiver.RecvFrom(buffer, sizeof(buffer), from)) > 0)
+					{
+						INT64 sentTime;
+						memcpy(&sentTime, buffer, sizeof(sentTime));
+						lastRecvTime = GetTime();
+						vLatency.push_back(lastRecvTime - sentTime);
+					}
+				}
+			});
+
+		Random random(count);
+		BYTE report[reportSize] = {};
+		const INT64 firstSendTime = GetTime();
+		VERUS_FOR(i, count)
+		{
+			if (!burst) // Reports are sent at random moments:
+				std::this_thread::sleep_for(std::chrono::microseconds(500 + random.Next() % 2000));
+			const INT64 sentTime = GetTime();
+			memcpy(report, &sentTime, sizeof(sentTime));
+			while (sender.SendTo(report, reportSize, addr) < 0) // Send buffer is full?
+				std::this_thread::yield();
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		stop = true;
+		cv.notify_one();
+		WSASetEvent(hWakeEvent);
+		thread.join();
+		WSACloseEvent(hWakeEvent);
+
+		reportsPerSecond = (lastRecvTime > firstSendTime) ? vLatency.size() * 1000000.0 / (lastRecvTime - firstSendTime) : 0;
+		std::sort(vLatency.begin(), vLatency.end());
+	};
+
+	auto Report = [](CSZ name, const Vector<INT64>& vLatency, int count)
+	{
+		if (vLatency.empty())
+			return;
+		INT64 total = 0;
+		for (auto x : vLatency)
+			total += x;
+		VERUS_LOG_INFO("Benchmark(); " << name << ", latency: average " << total / static_cast<double>(vLatency.size()) * 0.001
+			<< " ms, 99th percentile " << vLatency[vLatency.size() * 99 / 100] * 0.001
+			<< " ms, received: " << vLatency.size() << "/" << count);
+	};
+
+	Vector<INT64> vLatency;
+	double reportsPerSecond = 0;
+	double pollingReportsPerSecond = 0;
+
+	Run(true, latencyCount, false, vLatency, reportsPerSecond);
+	Report("polling", vLatency, latencyCount);
+	Run(false, latencyCount, false, vLatency, reportsPerSecond);
+	Report("event-driven", vLatency, latencyCount);
+
+	Run(true, throughputCount, true, vLatency, pollingReportsPerSecond);
+	const size_t pollingReceived = vLatency.size();
+	Run(false, throughputCount, true, vLatency, reportsPerSecond);
+	VERUS_LOG_INFO("Benchmark(); throughput, polling: " << pollingReportsPerSecond << " reports/s (received: " << pollingReceived << "/" << throughputCount
+		<< "), event-driven: " << reportsPerSecond << " reports/s (received: " << vLatency.size() << "/" << throughputCount << ")");
+}
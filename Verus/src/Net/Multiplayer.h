@@ -15,19 +15,6 @@ namespace verus
 		};
 		VERUS_TYPEDEFS(GameDesc);
 
-		enum { REPORT_ID_SIZE = 1 };
-
-		enum REPORT_ID
-		{
-			REPORT_NOOP,
-			REPORT_RNAT,
-			REPORT_RACK,
-			REPORT_PADD,
-			REPORT_PREM,
-			REPORT_KICK,
-			REPORT_USER
-		};
-
 		struct MultiplayerDelegate
 		{
 			virtual void Multiplayer_OnReportFrom/**/(int id, const BYTE* p) = 0;
@@ -41,37 +28,26 @@ namespace verus
 		{
 			enum
 			{
-				sendReports = (ObjectFlags::user << 0),
-				activeGamesReady = (ObjectFlags::user << 1),
-				noLock = (ObjectFlags::user << 2),
-				running = (ObjectFlags::user << 3)
+				activeGamesReady = (ObjectFlags::user << 0),
+				running = (ObjectFlags::user << 1)
 			};
 		};
 
 		class Multiplayer : public Singleton<Multiplayer>, public Object, public Lockable
 		{
-			enum class Seq : UINT16
-			{
-				skip,
-				unreliable,
-				reliableBase
-			};
-
 			class Player
 			{
 				friend class Multiplayer;
 
 				std::chrono::steady_clock::time_point _tpLast;
 				String                                _log;
-				BaseCircularBuffer                    _sendBuffer;
-				BaseCircularBuffer                    _recvBuffer;
+				Channel                               _channel; // Used only by ThreadProc().
+				Channel::Stats                        _stats; // Copy of channel's stats for GetStats().
 				Addr                                  _addr; // Not null means active player.
-				UINT32                                _statSendBufferFullCount = 0;
-				UINT32                                _statRecvBufferFullCount = 0;
-				UINT16                                _sendSeq = +Seq::reliableBase;
-				UINT16                                _sendSeqResend = +Seq::reliableBase;
-				UINT16                                _recvSeq = +Seq::reliableBase;
 				bool                                  _reserved = false; // Taken by app for bot, etc.
+				bool                                  _kicked = false;
+				bool                                  _removing = false; // PREM report was queued, waiting for reset.
+				bool                                  _dropReports = false; // Used only by ProcessRecvBuffers().
 
 			public:
 				Player();
@@ -82,32 +58,42 @@ namespace verus
 			};
 			VERUS_TYPEDEFS(Player);
 
+			// Flags for items in report queues:
+			struct QueueFlags
+			{
+				enum
+				{
+					reliable = (1 << 0), // Outgoing report should be reliable.
+					reset = (1 << 1), // Outgoing command to forget the player.
+					connect = (1 << 2) // Incoming join report for OnConnect().
+				};
+			};
+
 			static const int s_bufferSize = 256;
 			static const int s_logSize = 20 * 1024;
+			static const int s_housekeepingTime = 100 * 1000; // NAT, timeouts and stats, microseconds.
 
 			PMultiplayerDelegate    _pDelegate = nullptr;
 			Vector<Player>          _vPlayers;
-			Vector<BYTE>            _vMasterBuffer;
-			Vector<BYTE>            _vReportBuffer;
+			Vector<BYTE>            _vPacketBuffer;
 			Vector<GameDesc>        _vGameDesc;
 			Vector<Addr>            _vNat;
 			String                  _lobbyWebsite;
 			String                  _lobbyGameID;
 			GameDesc                _lobbyGameDesc;
 			Socket                  _socket;
+			ReportQueue             _outgoing; // Game thread -> ThreadProc().
+			ReportQueue             _incoming; // ThreadProc() -> game thread.
+			WSAEVENT                _hWakeEvent = WSA_INVALID_EVENT; // Signaled when outgoing reports are queued.
 			std::thread             _thread;
 			std::thread             _threadWeb;
-			std::condition_variable _cv;
+			std::atomic<bool>       _stopThread;
 			int                     _maxPlayers = 0;
 			int                     _maxReportSize = 0;
 			int                     _maxReports = 0;
 			int                     _myPlayer = -1;
 			Addr                    _serverAddr; // Localhost means that this machine is the server.
 
-			static bool IsLessThan(UINT16 a, UINT16 b);
-			static bool IsGreaterThan(UINT16 a, UINT16 b);
-			static void NextSeq(UINT16& seq);
-
 		public:
 			Multiplayer();
 			~Multiplayer();
@@ -123,27 +109,37 @@ namespace verus
 			void SetMyPlayer(int id) { _myPlayer = id; }
 			int GetPlayerCount();
 			int GetMaxPlayers() const { return _maxPlayers; }
+			int GetMaxReportSize() const { return _maxReportSize; }
 			bool IsActivePlayer(int id);
+			Channel::Stats GetStats(int id);
 
 			int ReservePlayer();
 			void CancelReservation(int id);
 
-			// Writes the report into the send buffer for some or all players. This will eventually send this report.
+			// Writes the report into the outgoing queue for some or all players. This will eventually send this report.
+			// Must be called from the game thread only.
 			// id = Player's ID. Use -1 to send the report to all players. Server cannot send the report to itself.
 			// p = Pointer to report's data. Must not be less than the size of the report.
-			// deferred = Will send it as soon as possible if false.
+			// deferred = Will send it as soon as possible if false, otherwise with the next report, which is not deferred.
 			void SendReportAsync(int id, BYTE* p, bool deferred = false);
-			// Reads reports from recv buffers, cleans them, calls MultiplayerDelegate's callbacks.
+			// Reads reports from the incoming queue, calls MultiplayerDelegate's callbacks. Must be called from the game thread only.
 			void ProcessRecvBuffers();
 			// Writes the KICK report to the player's send buffer. This will eventually kick the specified player.
 			void Kick(int id);
 
 			VERUS_P(int GetIdByAddr(RcAddr addr) const);
 			VERUS_P(int FindFreeID() const);
+			VERUS_P(void ResetPlayerAsync(int id));
 			VERUS_P(void ThreadProc());
+			VERUS_P(void RouteOutgoingReports());
+			VERUS_P(void RecvDatagrams(INT64 now));
+			VERUS_P(void DisconnectPlayer(int id, CSZ reason));
 
 			String GetDebug();
 
+			// Compares the old polling network thread with the event-driven one over UDP loopback, results are written to log:
+			static void Benchmark();
+
 			void UploadActiveGameAsync(RcGameDesc gd, CSZ gameID, CSZ website = "swiborg.com");
 			void DownloadActiveGamesAsync(CSZ gameID, int version, CSZ website = "swiborg.com");
 			bool AreActiveGamesReady();
@@ -4,7 +4,11 @@
 #include "Addr.h"
 #include "Socket.h"
 #include "HttpFile.h"
+#include "BitStream.h"
+#include "Channel.h"
+#include "ReportQueue.h"
 #include "Multiplayer.h"
+#include "Snapshot.h"
 
 namespace verus
 {
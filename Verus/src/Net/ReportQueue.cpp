@@ -0,0 +1,104 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "verus.h"
+
+using namespace verus;
+using namespace verus::Net;
+
+ReportQueue::ReportQueue()
+{
+	_writeCount = 0;
+	_readCount = 0;
+}
+
+ReportQueue::~ReportQueue()
+{
+}
+
+void ReportQueue::Init(int maxReportSize, int capacity)
+{
+	_itemSize = Math::AlignUp<int>(sizeof(Header) + maxReportSize, 8);
+	_maxReportSize = maxReportSize;
+	_capacity = capacity;
+	_vData.resize(_itemSize * _capacity);
+	_writeCount = 0;
+	_readCount = 0;
+}
+
+bool ReportQueue::Push(int id, int flags, const BYTE* p, int size)
+{
+	if (size < 0 || size > _maxReportSize)
+		return false;
+	const UINT32 writeCount = _writeCount.load(std::memory_order_relaxed);
+	if (static_cast<int>(writeCount - _readCount.load(std::memory_order_acquire)) >= _capacity)
+		return false;
+	BYTE* pItem = &_vData[(writeCount % _capacity) * _itemSize];
+	Header header;
+	header._id = id;
+	header._flags = flags;
+	memcpy(pItem, &header, sizeof(header));
+	if (size)
+		memcpy(pItem + sizeof(Header), p, size);
+	_writeCount.store(writeCount + 1, std::memory_order_release);
+	return true;
+}
+
+const BYTE* ReportQueue::Peek(int& id, int& flags) const
+{
+	const UINT32 readCount = _readCount.load(std::memory_order_relaxed);
+	if (readCount == _writeCount.load(std::memory_order_acquire))
+		return nullptr;
+	const BYTE* pItem = &_vData[(readCount % _capacity) * _itemSize];
+	Header header;
+	memcpy(&header, pItem, sizeof(header));
+	id = header._id;
+	flags = header._flags;
+	return pItem + sizeof(Header);
+}
+
+void ReportQueue::Pop()
+{
+	const UINT32 readCount = _readCount.load(std::memory_order_relaxed);
+	VERUS_RT_ASSERT(readCount != _writeCount.load(std::memory_order_acquire));
+	_readCount.store(readCount + 1, std::memory_order_release);
+}
+
+void ReportQueue::Test()
+{
+	// Values must arrive in order, when the queue is often full or empty:
+	ReportQueue queue;
+	queue.Init(16, 8);
+	const UINT32 count = 100000;
+	std::thread producer([&queue, count]()
+		{
+			for (UINT32 i = 0; i < count;)
+			{
+				if (queue.Push(i % 7, 0, reinterpret_cast<const BYTE*>(&i), sizeof(i)))
+					i++;
+				else
+					std::this_thread::yield();
+			}
+		});
+	UINT32 expected = 0;
+	while (expected < count)
+	{
+		int id = 0, flags = 0;
+		const BYTE* p = queue.Peek(id, flags);
+		if (!p)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		UINT32 value;
+		memcpy(&value, p, sizeof(value));
+		VERUS_RT_ASSERT(value == expected && id == static_cast<int>(expected % 7));
+		queue.Pop();
+		expected++;
+	}
+	producer.join();
+	VERUS_RT_ASSERT(!queue.GetCount());
+
+	// Oversized reports are rejected:
+	BYTE big[17] = {};
+	VERUS_RT_ASSERT(!queue.Push(0, 0, big, sizeof(big)));
+	VERUS_RT_ASSERT(queue.Push(0, 0, big, 16) && 1 == queue.GetCount());
+}
@@ -0,0 +1,51 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace Net
+	{
+		// Fixed-size queue of reports, which is used to pass them between two threads without locks.
+		// Only one thread can push and only one thread can pop. Each report has an ID (player's ID) and some flags.
+		class ReportQueue
+		{
+			struct Header
+			{
+				INT32 _id = 0;
+				INT32 _flags = 0;
+			};
+
+			Vector<BYTE>        _vData;
+			std::atomic<UINT32> _writeCount;
+			std::atomic<UINT32> _readCount;
+			int                 _itemSize = 0;
+			int                 _maxReportSize = 0;
+			int                 _capacity = 0;
+
+		public:
+			ReportQueue();
+			~ReportQueue();
+
+			void Init(int maxReportSize, int capacity);
+
+			// <Producer>
+			// Returns false if the queue is full or the report is bigger than maxReportSize:
+			bool Push(int id, int flags, const BYTE* p, int size);
+			// </Producer>
+
+			// <Consumer>
+			// Returns nullptr if the queue is empty. Pointer is valid until Pop():
+			const BYTE* Peek(int& id, int& flags) const;
+			void Pop();
+			// </Consumer>
+
+			int GetCount() const { return static_cast<int>(_writeCount.load(std::memory_order_acquire) - _readCount.load(std::memory_order_acquire)); }
+			int GetFreeCount() const { return _capacity - GetCount(); }
+			int GetCapacity() const { return _capacity; }
+			int GetMaxReportSize() const { return _maxReportSize; }
+
+			static void Test();
+		};
+		VERUS_TYPEDEFS(ReportQueue);
+	}
+}
@@ -0,0 +1,903 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#include "verus.h"
+
+using namespace verus;
+using namespace verus::Net;
+
+namespace
+{
+	const float s_positionScale = 256; // Units per meter.
+	const float s_velocityScale = 64;
+	const float s_angleScale = 65536 / VERUS_2PI;
+	const int s_smallPositionBits = 12; // Delta of up to 8 meters.
+	const int s_smallVelocityBits = 8; // Delta of up to 2 m/s.
+	const int s_smallIndexBits = 4;
+
+	INT32 QuantizeFloat(float x, float scale, int bits)
+	{
+		const INT32 limit = (1 << (bits - 1)) - 1;
+		return Math::Clamp<INT32>(static_cast<INT32>(floor(x * scale + 0.5f)), -limit, limit);
+	}
+
+	UINT16 QuantizeAngle(float rad)
+	{
+		return static_cast<UINT16>(static_cast<INT32>(floor(Math::WrapAngle(rad) * s_angleScale + 0.5f)));
+	}
+
+	float DequantizeAngle(UINT16 x)
+	{
+		return static_cast<INT16>(x) / s_angleScale;
+	}
+
+	bool IsSmall(INT32 delta, int bits)
+	{
+		const INT32 half = 1 << (bits - 1);
+		return delta >= -half && delta < half;
+	}
+
+	// Delivers datagrams or reports with some delay and loss:
+	class TestLink
+	{
+		typedef std::pair<int, Vector<BYTE>> TPacket;
+
+		std::multimap<INT64, TPacket> _mapInFlight;
+		Random                        _random;
+		INT64                         _latency = 0;
+		INT64                         _jitter = 0;
+
+	public:
+		float  _loss = 0;
+
+		TestLink(UINT32 seed, float loss, INT64 latency, INT64 jitter) :
+			_random(seed), _latency(latency), _jitter(jitter), _loss(loss) {}
+
+		void Send(int to, const BYTE* p, int size, INT64 now)
+		{
+			if (_random.NextFloat() < _loss)
+				return;
+			const INT64 time = now + _latency + static_cast<INT64>(_random.NextFloat() * _jitter);
+			_mapInFlight.insert(std::make_pair(time, TPacket(to, Vector<BYTE>(p, p + size))));
+		}
+
+		template<typename TFunc>
+		void Deliver(INT64 now, TFunc func)
+		{
+			while (!_mapInFlight.empty() && _mapInFlight.begin()->first <= now)
+			{
+				const TPacket packet = std::move(_mapInFlight.begin()->second);
+				_mapInFlight.erase(_mapInFlight.begin());
+				func(packet.first, packet.second.data(), Utils::Cast32(packet.second.size()));
+			}
+		}
+	};
+}
+
+// SpiritState:
+
+void SpiritState::Quantize(RcPoint3 pos, RcVector3 velocity, float pitch, float yaw)
+{
+	const float p[3] = { pos.getX(), pos.getY(), pos.getZ() };
+	const float v[3] = { velocity.getX(), velocity.getY(), velocity.getZ() };
+	VERUS_FOR(i, 3)
+	{
+		_position[i] = QuantizeFloat(p[i], s_positionScale, s_positionBits);
+		_velocity[i] = static_cast<INT16>(QuantizeFloat(v[i], s_velocityScale, s_velocityBits));
+	}
+	_pitch = QuantizeAngle(pitch);
+	_yaw = QuantizeAngle(yaw);
+}
+
+void SpiritState::FromSpirit(Game::RSpirit spirit)
+{
+	Quantize(spirit.GetPosition(false), spirit.GetVelocity(), spirit.GetPitch(), spirit.GetYaw());
+}
+
+Point3 SpiritState::GetPosition() const
+{
+	return Point3(
+		_position[0] / s_positionScale,
+		_position[1] / s_positionScale,
+		_position[2] / s_positionScale);
+}
+
+Vector3 SpiritState::GetVelocity() const
+{
+	return Vector3(
+		_velocity[0] / s_velocityScale,
+		_velocity[1] / s_velocityScale,
+		_velocity[2] / s_velocityScale);
+}
+
+float SpiritState::GetPitch() const
+{
+	return DequantizeAngle(_pitch);
+}
+
+float SpiritState::GetYaw() const
+{
+	return DequantizeAngle(_yaw);
+}
+
+bool SpiritState::operator==(const SpiritState& that) const
+{
+	return
+		!memcmp(_position, that._position, sizeof(_position)) &&
+		!memcmp(_velocity, that._velocity, sizeof(_velocity)) &&
+		_pitch == that._pitch &&
+		_yaw == that._yaw;
+}
+
+// SnapshotCommon:
+
+void SnapshotCommon::InitView(RView view) const
+{
+	view._vStates.assign(_maxEntities, SpiritState());
+	view._vActive.assign(_maxEntities, 0);
+	view._time = 0;
+	view._seq = 0;
+}
+
+void SnapshotCommon::WriteReportHeader(BYTE* p, BYTE reportID, int size)
+{
+	p[0] = reportID;
+	const UINT16 seq = +Channel::Seq::unreliable;
+	const UINT16 size16 = static_cast<UINT16>(size);
+	memcpy(p + REPORT_ID_SIZE, &seq, 2);
+	memcpy(p + REPORT_ID_SIZE + 2, &size16, 2);
+}
+
+void SnapshotCommon::WriteState(RBitWriter bw, RcSpiritState base, RcSpiritState state)
+{
+	// Position, each axis: changed, small delta or full value:
+	VERUS_FOR(i, 3)
+	{
+		const INT32 delta = state._position[i] - base._position[i];
+		bw.WriteBool(delta != 0);
+		if (!delta)
+			continue;
+		const bool small = IsSmall(delta, s_smallPositionBits);
+		bw.WriteBool(small);
+		if (small)
+			bw.WriteSigned(delta, s_smallPositionBits);
+		else
+			bw.WriteSigned(state._position[i], SpiritState::s_positionBits);
+	}
+
+	// Velocity is often constant, so one bit for all axes:
+	const bool velocityChanged = memcmp(state._velocity, base._velocity, sizeof(state._velocity)) != 0;
+	bw.WriteBool(velocityChanged);
+	if (velocityChanged)
+	{
+		VERUS_FOR(i, 3)
+		{
+			const INT32 delta = state._velocity[i] - base._velocity[i];
+			const bool small = IsSmall(delta, s_smallVelocityBits);
+			bw.WriteBool(small);
+			if (small)
+				bw.WriteSigned(delta, s_smallVelocityBits);
+			else
+				bw.WriteSigned(state._velocity[i], SpiritState::s_velocityBits);
+		}
+	}
+
+	bw.WriteBool(state._pitch != base._pitch);
+	if (state._pitch != base._pitch)
+		bw.Write(state._pitch, SpiritState::s_angleBits);
+	bw.WriteBool(state._yaw != base._yaw);
+	if (state._yaw != base._yaw)
+		bw.Write(state._yaw, SpiritState::s_angleBits);
+}
+
+void SnapshotCommon::ReadState(RBitReader br, RcSpiritState base, RSpiritState state)
+{
+	SpiritState result = base; // Base and state can be the same object.
+
+	VERUS_FOR(i, 3)
+	{
+		if (!br.ReadBool())
+			continue;
+		if (br.ReadBool())
+			result._position[i] = base._position[i] + br.ReadSigned(s_smallPositionBits);
+		else
+			result._position[i] = br.ReadSigned(SpiritState::s_positionBits);
+	}
+
+	if (br.ReadBool())
+	{
+		VERUS_FOR(i, 3)
+		{
+			if (br.ReadBool())
+				result._velocity[i] = static_cast<INT16>(base._velocity[i] + br.ReadSigned(s_smallVelocityBits));
+			else
+				result._velocity[i] = static_cast<INT16>(br.ReadSigned(SpiritState::s_velocityBits));
+		}
+	}
+
+	if (br.ReadBool())
+		result._pitch = static_cast<UINT16>(br.Read(SpiritState::s_angleBits));
+	if (br.ReadBool())
+		result._yaw = static_cast<UINT16>(br.Read(SpiritState::s_angleBits));
+
+	state = result;
+}
+
+int SnapshotCommon::GetMaxStateBits()
+{
+	return
+		3 * (2 + SpiritState::s_positionBits) +
+		1 + 3 * (1 + SpiritState::s_velocityBits) +
+		2 * (1 + SpiritState::s_angleBits);
+}
+
+// SnapshotServer:
+
+SnapshotServer::SnapshotServer()
+{
+}
+
+SnapshotServer::~SnapshotServer()
+{
+	Done();
+}
+
+void SnapshotServer::Init(int maxEntities, int maxClients)
+{
+	VERUS_INIT();
+
+	_maxEntities = maxEntities;
+	_indexBits = 1;
+	while ((1 << _indexBits) < _maxEntities)
+		_indexBits++;
+	InitView(_emptyView);
+	InitView(_current);
+	_vClients.resize(maxClients);
+	for (auto& client : _vClients)
+	{
+		for (auto& view : client._views)
+			InitView(view);
+	}
+}
+
+void SnapshotServer::Done()
+{
+	VERUS_DONE(SnapshotServer);
+}
+
+void SnapshotServer::SetState(int index, RcSpiritState state)
+{
+	_current._vStates[index] = state;
+	_current._vActive[index] = 1;
+}
+
+void SnapshotServer::SetState(int index, Game::RSpirit spirit)
+{
+	_current._vStates[index].FromSpirit(spirit);
+	_current._vActive[index] = 1;
+}
+
+void SnapshotServer::Remove(int index)
+{
+	_current._vActive[index] = 0;
+}
+
+void SnapshotServer::Capture(INT64 now)
+{
+	_current._seq++;
+	if (!_current._seq) // Zero means no snapshot.
+		_current._seq++;
+	_current._time = static_cast<UINT32>(now / 1000);
+}
+
+int SnapshotServer::WriteReport(int client, BYTE reportID, BYTE* p, int maxSize)
+{
+	VERUS_RT_ASSERT(_current._seq);
+	RClient c = _vClients[client];
+
+	// Baseline is the last snapshot, which client has:
+	PcView pBase = &_emptyView;
+	if (c._ackedSeq)
+	{
+		RcView ackedView = c._views[c._ackedSeq % s_viewCount];
+		const UINT16 age = _current._seq - c._ackedSeq;
+		if (ackedView._seq == c._ackedSeq && age < s_viewCount)
+			pBase = &ackedView;
+	}
+
+	RView view = c._views[_current._seq % s_viewCount];
+	VERUS_RT_ASSERT(view._seq != _current._seq); // Only one report per client per snapshot.
+	if (pBase != &view)
+	{
+		view._vStates = pBase->_vStates;
+		view._vActive = pBase->_vActive;
+	}
+	view._seq = _current._seq;
+	view._time = _current._time;
+
+	BitWriter bw(p + s_reportHeaderSize, maxSize - s_reportHeaderSize);
+	bw.Write(_current._seq, 16);
+	bw.Write(pBase->_seq, 16);
+	bw.Write(_current._time, 32);
+
+	// Changed entities, what doesn't fit will be sent next time, because it's not in the view:
+	const int maxEntityBits = 2 + _indexBits + GetMaxStateBits();
+	const int start = c._nextEntity;
+	int prevIndex = -1;
+	VERUS_FOR(i, _maxEntities)
+	{
+		const int index = (start + i) % _maxEntities;
+		const bool active = !!_current._vActive[index];
+		const bool wasActive = !!view._vActive[index];
+		if (active == wasActive && (!active || view._vStates[index] == _current._vStates[index]))
+			continue;
+
+		if (bw.GetBitCount() + maxEntityBits + 1 > bw.GetCapacity())
+		{
+			c._nextEntity = index;
+			break;
+		}
+
+		bw.WriteBool(true);
+		if (prevIndex < 0)
+		{
+			bw.Write(index, _indexBits);
+		}
+		else
+		{
+			const int delta = (index - prevIndex - 1 + _maxEntities) % _maxEntities;
+			const bool small = delta < (1 << s_smallIndexBits);
+			bw.WriteBool(small);
+			bw.Write(delta, small ? s_smallIndexBits : _indexBits);
+		}
+		prevIndex = index;
+
+		bw.WriteBool(active);
+		if (active)
+		{
+			WriteState(bw, wasActive ? view._vStates[index] : SpiritState(), _current._vStates[index]);
+			view._vStates[index] = _current._vStates[index];
+		}
+		view._vActive[index] = active;
+	}
+	bw.WriteBool(false);
+	VERUS_RT_ASSERT(!bw.IsOverflow());
+
+	const int size = s_reportHeaderSize + bw.GetSize();
+	WriteReportHeader(p, reportID, size);
+	return size;
+}
+
+void SnapshotServer::OnAckReport(int client, const BYTE* p)
+{
+	if (Channel::GetReportSize(p) < s_ackReportSize)
+		return;
+	UINT16 seq;
+	memcpy(&seq, p + s_reportHeaderSize, 2);
+	RClient c = _vClients[client];
+	if (seq != c._views[seq % s_viewCount]._seq)
+		return; // Too old or invalid.
+	if (!c._ackedSeq || static_cast<INT16>(seq - c._ackedSeq) > 0)
+		c._ackedSeq = seq;
+}
+
+void SnapshotServer::ResetClient(int client)
+{
+	RClient c = _vClients[client];
+	c._ackedSeq = 0;
+	c._nextEntity = 0;
+	for (auto& view : c._views)
+		view._seq = 0;
+}
+
+// SnapshotClient:
+
+SnapshotClient::SnapshotClient()
+{
+}
+
+SnapshotClient::~SnapshotClient()
+{
+	Done();
+}
+
+void SnapshotClient::Init(int maxEntities)
+{
+	VERUS_INIT();
+
+	_maxEntities = maxEntities;
+	_indexBits = 1;
+	while ((1 << _indexBits) < _maxEntities)
+		_indexBits++;
+	InitView(_emptyView);
+	InitView(_decoded);
+	for (auto& view : _views)
+		InitView(view);
+	_vEntities.resize(_maxEntities);
+}
+
+void SnapshotClient::Done()
+{
+	VERUS_DONE(SnapshotClient);
+}
+
+bool SnapshotClient::OnReport(const BYTE* p, INT64 now)
+{
+	const int size = Channel::GetReportSize(p);
+	if (size <= s_reportHeaderSize)
+		return false;
+	BitReader br(p + s_reportHeaderSize, size - s_reportHeaderSize);
+	const UINT16 seq = static_cast<UINT16>(br.Read(16));
+	const UINT16 baseSeq = static_cast<UINT16>(br.Read(16));
+	const UINT32 time = br.Read(32);
+	if (br.IsOverflow() || !seq)
+		return false;
+	if (_latestSeq && static_cast<INT16>(seq - _latestSeq) <= 0)
+		return false; // Old or duplicate.
+
+	PcView pBase = &_emptyView;
+	if (baseSeq)
+	{
+		pBase = &_views[baseSeq % s_viewCount];
+		if (pBase->_seq != baseSeq)
+			return false; // Baseline is lost, wait for the next snapshot.
+	}
+	_decoded._vStates = pBase->_vStates;
+	_decoded._vActive = pBase->_vActive;
+
+	int prevIndex = -1;
+	while (br.ReadBool())
+	{
+		int index = 0;
+		if (prevIndex < 0)
+		{
+			index = br.Read(_indexBits);
+		}
+		else
+		{
+			const int delta = br.ReadBool() ? br.Read(s_smallIndexBits) : br.Read(_indexBits);
+			index = (prevIndex + 1 + delta) % _maxEntities;
+		}
+		if (br.IsOverflow() || index >= _maxEntities)
+			return false;
+		prevIndex = index;
+
+		const bool active = br.ReadBool();
+		if (active)
+			ReadState(br, _decoded._vActive[index] ? _decoded._vStates[index] : SpiritState(), _decoded._vStates[index]);
+		_decoded._vActive[index] = active;
+	}
+	if (br.IsOverflow())
+		return false;
+
+	_decoded._seq = seq;
+	_decoded._time = time;
+	std::swap(_views[seq % s_viewCount], _decoded);
+
+	// Server time in microseconds, which doesn't wrap:
+	const INT64 serverTime = _latestSeq ?
+		_latestTime + static_cast<INT32>(time - static_cast<UINT32>(_latestTime / 1000)) * 1000LL :
+		time * 1000LL;
+
+	// Estimate clock offset, interval and jitter for the delay:
+	const INT64 offset = serverTime - now;
+	if (!_latestSeq)
+	{
+		_timeOffset = offset;
+		_renderTime = serverTime - GetDelay();
+	}
+	else
+	{
+		_interval += (serverTime - _latestTime - _interval) / 8;
+		const INT64 deviation = offset - _timeOffset;
+		_jitter += (std::abs(deviation) - _jitter) / 8;
+		if (deviation > 0)
+			_timeOffset = offset; // Faster than before.
+		else
+			_timeOffset += deviation / 16;
+	}
+	_latestSeq = seq;
+	_latestTime = serverTime;
+
+	// Jitter buffer:
+	RcView view = _views[seq % s_viewCount];
+	VERUS_FOR(i, _maxEntities)
+	{
+		REntity entity = _vEntities[i];
+		if (!view._vActive[i])
+		{
+			entity._count = 0;
+			continue;
+		}
+		RKeyframe keyframe = entity._keyframes[entity._head];
+		keyframe._time = serverTime;
+		keyframe._state = view._vStates[i];
+		entity._head = (entity._head + 1) % s_sampleCount;
+		entity._count = Math::Min(entity._count + 1, s_sampleCount);
+	}
+
+	return true;
+}
+
+int SnapshotClient::WriteAckReport(BYTE reportID, BYTE* p) const
+{
+	WriteReportHeader(p, reportID, s_ackReportSize);
+	memcpy(p + s_reportHeaderSize, &_latestSeq, 2);
+	return s_ackReportSize;
+}
+
+void SnapshotClient::Update(INT64 now)
+{
+	if (!_latestSeq)
+		return;
+	_renderTime = Math::Max(_renderTime, now + _timeOffset - GetDelay()); // Never goes back.
+}
+
+INT64 SnapshotClient::GetDelay() const
+{
+	return Math::Clamp<INT64>(_interval + _interval / 2 + 2 * _jitter, s_minDelay, s_maxDelay);
+}
+
+bool SnapshotClient::Sample(int index, RPoint3 pos, RVector3 velocity, float& pitch, float& yaw) const
+{
+	RcEntity entity = _vEntities[index];
+	if (!entity._count)
+		return false;
+
+	RcKeyframe newest = entity.GetKeyframe(0);
+	if (_renderTime >= newest._time) // Extrapolate:
+	{
+		const INT64 dt = Math::Min(_renderTime - newest._time, s_maxExtrapolation);
+		velocity = newest._state.GetVelocity();
+		pos = newest._state.GetPosition() + velocity * (dt * 0.000001f);
+		pitch = newest._state.GetPitch();
+		yaw = newest._state.GetYaw();
+		return true;
+	}
+
+	// Interpolate between two keyframes around render time:
+	for (int age = 1; age < entity._count; ++age)
+	{
+		RcKeyframe a = entity.GetKeyframe(age);
+		if (_renderTime < a._time)
+			continue;
+		RcKeyframe b = entity.GetKeyframe(age - 1);
+		const float ratio = static_cast<float>(_renderTime - a._time) / (b._time - a._time);
+		pos = VMath::lerp(ratio, a._state.GetPosition(), b._state.GetPosition());
+		velocity = VMath::lerp(ratio, a._state.GetVelocity(), b._state.GetVelocity());
+		// Shortest arc:
+		pitch = Math::WrapAngle(a._state.GetPitch() + ratio * static_cast<INT16>(b._state._pitch - a._state._pitch) / s_angleScale);
+		yaw = Math::WrapAngle(a._state.GetYaw() + ratio * static_cast<INT16>(b._state._yaw - a._state._yaw) / s_angleScale);
+		return true;
+	}
+
+	// Too far in the past, use the oldest one:
+	RcKeyframe oldest = entity.GetKeyframe(entity._count - 1);
+	pos = oldest._state.GetPosition();
+	velocity = oldest._state.GetVelocity();
+	pitch = oldest._state.GetPitch();
+	yaw = oldest._state.GetYaw();
+	return true;
+}
+
+bool SnapshotClient::ApplyTo(int index, Game::RSpirit spirit) const
+{
+	Point3 pos;
+	Vector3 velocity;
+	float pitch = 0;
+	float yaw = 0;
+	if (!Sample(index, pos, velocity, pitch, yaw))
+		return false;
+	spirit.SetRemoteState(pos, velocity, pitch, yaw);
+	return true;
+}
+
+void SnapshotClient::Test()
+{
+	// Client must decode exactly what server thinks it has, despite loss, reordering and truncation:
+	const int entityCount = 20;
+	const int maxSize = 100;
+	const INT64 tickTime = 50 * 1000;
+	SnapshotServer server;
+	SnapshotClient client;
+	server.Init(entityCount, 1);
+	client.Init(entityCount);
+	TestLink link(7, 0.25f, 30 * 1000, 30 * 1000);
+	Random random(7);
+	Vector<Vector3> vVelocities(entityCount);
+	Vector<Point3> vPositions(entityCount);
+	VERUS_FOR(i, entityCount)
+	{
+		vPositions[i] = Point3(random.NextFloat(-100, 100), 0, random.NextFloat(-100, 100));
+		vVelocities[i] = Vector3(random.NextFloat(-5, 5), 0, random.NextFloat(-5, 5));
+	}
+	BYTE report[maxSize];
+	int decodedCount = 0;
+	INT64 now = 0;
+	VERUS_FOR(tick, 600)
+	{
+		const bool moving = tick < 400;
+		if (400 == tick)
+			link._loss = 0;
+		VERUS_FOR(i, entityCount)
+		{
+			if (moving && !(random.Next() % 100))
+			{
+				server.Remove(i);
+				continue;
+			}
+			if (moving)
+				vPositions[i] += vVelocities[i] * (tickTime * 0.000001f);
+			SpiritState state;
+			state.Quantize(vPositions[i], vVelocities[i], 0, i * 0.3f);
+			server.SetState(i, state);
+		}
+		server.Capture(now);
+		const int size = server.WriteReport(0, REPORT_USER, report, maxSize);
+		VERUS_RT_ASSERT(size <= maxSize);
+		link.Send(1, report, size, now);
+
+		link.Deliver(now, [&](int to, const BYTE* p, int size)
+			{
+				if (to) // Client:
+				{
+					if (!client.OnReport(p, now))
+						return;
+					decodedCount++;
+					RcView view = client._views[client._latestSeq % s_viewCount];
+					RcView expected = server._vClients[0]._views[client._latestSeq % s_viewCount];
+					VERUS_RT_ASSERT(view._seq == expected._seq);
+					VERUS_RT_ASSERT(view._vActive == expected._vActive);
+					VERUS_FOR(i, entityCount)
+						VERUS_RT_ASSERT(!view._vActive[i] || view._vStates[i] == expected._vStates[i]);
+					BYTE ack[s_ackReportSize];
+					link.Send(0, ack, client.WriteAckReport(REPORT_USER + 1, ack), now);
+				}
+				else
+				{
+					server.OnAckReport(0, p);
+				}
+			});
+		now += tickTime;
+	}
+	VERUS_RT_ASSERT(decodedCount > 300);
+	// When nothing moves, client catches up:
+	RcView view = client._views[client._latestSeq % s_viewCount];
+	VERUS_FOR(i, entityCount)
+		VERUS_RT_ASSERT(view._vActive[i] && view._vStates[i] == server._current._vStates[i]);
+
+	// Interpolation and extrapolation:
+	SnapshotServer server2;
+	SnapshotClient client2;
+	server2.Init(1, 1);
+	client2.Init(1);
+	SpiritState state;
+	state.Quantize(Point3(0), Vector3(0), 0, 3);
+	server2.SetState(0, state);
+	server2.Capture(0);
+	server2.WriteReport(0, REPORT_USER, report, maxSize);
+	VERUS_RT_ASSERT(client2.OnReport(report, 0));
+	client2.WriteAckReport(REPORT_USER + 1, report);
+	server2.OnAckReport(0, report);
+	state.Quantize(Point3(10, 0, 0), Vector3(100, 0, 0), 0, -3);
+	server2.SetState(0, state);
+	server2.Capture(100 * 1000);
+	server2.WriteReport(0, REPORT_USER, report, maxSize);
+	VERUS_RT_ASSERT(client2.OnReport(report, 100 * 1000));
+	Point3 pos;
+	Vector3 velocity;
+	float pitch = 0;
+	float yaw = 0;
+	client2._renderTime = 50 * 1000;
+	client2.Sample(0, pos, velocity, pitch, yaw);
+	VERUS_RT_ASSERT(abs(pos.getX() - 5) < 0.01f && abs(yaw) > 3.1f); // Yaw goes through PI, not zero.
+	client2._renderTime = 150 * 1000;
+	client2.Sample(0, pos, velocity, pitch, yaw);
+	VERUS_RT_ASSERT(abs(pos.getX() - 15) < 0.01f);
+	client2._renderTime = 1000 * 1000;
+	client2.Sample(0, pos, velocity, pitch, yaw);
+	VERUS_RT_ASSERT(abs(pos.getX() - 35) < 0.01f); // Extrapolation is limited.
+}
+
+void SnapshotClient::Benchmark()
+{
+	const int playerCount = 32;
+	const int tickCount = 60 * 20;
+	const int snapshotRate = 3; // 20 Hz.
+	const INT64 tickTime = 1000 * 1000 / 60;
+	const int maxReportSize = Channel::s_mtu - Channel::s_headerSize;
+	const int rawEntitySize = 2 + 3 * 4 + 3 * 4 + 2 * 4; // Index and floats.
+
+	// Players walk around, some of them stand still. Returns bytes per client per second:
+	auto Simulate = [=](bool delta, double& reportBytes, INT64& delay)
+	{
+		SnapshotServer server;
+		server.Init(playerCount, playerCount);
+		Vector<SnapshotClient> clients(playerCount);
+		Vector<Channel> serverChannels(playerCount);
+		Vector<Channel> clientChannels(playerCount);
+		VERUS_FOR(i, playerCount)
+		{
+			clients[i].Init(playerCount);
+			serverChannels[i].Init(maxReportSize, 8);
+			clientChannels[i].Init(maxReportSize, 8);
+		}
+		TestLink link(1, 0.02f, 40 * 1000, 10 * 1000);
+		Random random(1);
+		Vector<Point3> vPositions(playerCount);
+		Vector<float> vYaws(playerCount);
+		VERUS_FOR(i, playerCount)
+		{
+			vPositions[i] = Point3(random.NextFloat(-200, 200), 5, random.NextFloat(-200, 200));
+			vYaws[i] = random.NextFloat(-VERUS_PI, VERUS_PI);
+		}
+		Vector<BYTE> vReport(maxReportSize);
+		UINT64 wireBytes = 0;
+		UINT64 totalReportBytes = 0;
+		INT64 now = 0;
+		delay = 0;
+		VERUS_FOR(tick, tickCount)
+		{
+			VERUS_FOR(i, playerCount)
+			{
+				if (!(random.Next() % 120)) // Turn every two seconds or so.
+					vYaws[i] = Math::WrapAngle(vYaws[i] + random.NextFloat(-1, 1));
+				const float speed = (i % 4) ? 4.f : 0.f;
+				const Vector3 velocity = Vector3(sin(vYaws[i]), 0, cos(vYaws[i])) * speed;
+				vPositions[i] += velocity * (tickTime * 0.000001f);
+				SpiritState state;
+				state.Quantize(vPositions[i], velocity, 0, vYaws[i]);
+				server.SetState(i, state);
+			}
+
+			if (!(tick % snapshotRate))
+			{
+				server.Capture(now);
+				VERUS_FOR(i, playerCount)
+				{
+					if (!delta)
+						server.ResetClient(i);
+					const int size = server.WriteReport(i, REPORT_USER, vReport.data(), maxReportSize);
+					totalReportBytes += size;
+					serverChannels[i].PushUnreliable(vReport.data());
+				}
+			}
+
+			VERUS_FOR(i, playerCount)
+			{
+				serverChannels[i].Flush(now, [&link, &wireBytes, i, now, playerCount](const BYTE* p, int size)
+					{
+						wireBytes += size + 28; // With UDP/IPv4 headers.
+						link.Send(playerCount + i, p, size, now);
+					});
+				clientChannels[i].Flush(now, [&link, i, now](const BYTE* p, int size) { link.Send(i, p, size, now); });
+			}
+			link.Deliver(now, [&](int to, const BYTE* p, int size)
+				{
+					if (to < playerCount)
+						serverChannels[to].OnDatagram(p, size, now);
+					else
+						clientChannels[to - playerCount].OnDatagram(p, size, now);
+				});
+			VERUS_FOR(i, playerCount)
+			{
+				serverChannels[i].ProcessReports([&server, i](const BYTE* p)
+					{
+						server.OnAckReport(i, p);
+						return Continue::yes;
+					});
+				SnapshotClient& client = clients[i];
+				Channel& clientChannel = clientChannels[i];
+				clientChannel.ProcessReports([&client, &clientChannel, &vReport, now](const BYTE* p)
+					{
+						if (client.OnReport(p, now))
+						{
+							BYTE ack[s_ackReportSize];
+							client.WriteAckReport(REPORT_USER + 1, ack);
+							clientChannel.PushUnreliable(ack);
+						}
+						return Continue::yes;
+					});
+				client.Update(now);
+			}
+			now += tickTime;
+		}
+		VERUS_FOR(i, playerCount)
+			delay += clients[i].GetDelay();
+		delay /= playerCount;
+		const double seconds = tickCount * tickTime * 0.000001;
+		reportBytes = totalReportBytes / (seconds * playerCount);
+		return wireBytes / (seconds * playerCount);
+	};
+
+	double deltaReportBytes = 0;
+	double fullReportBytes = 0;
+	INT64 delay = 0;
+	const double deltaWireBytes = Simulate(true, deltaReportBytes, delay);
+	const double fullWireBytes = Simulate(false, fullReportBytes, delay);
+	const double rawBytes = (1000 * 1000.0 / (snapshotRate * tickTime)) * playerCount * rawEntitySize;
+	VERUS_LOG_INFO("Benchmark(); " << playerCount << " players, per entity per client per second: delta "
+		<< deltaReportBytes / playerCount << " bytes (wire " << deltaWireBytes / playerCount << "), full state "
+		<< fullReportBytes / playerCount << " bytes (wire " << fullWireBytes / playerCount << "), raw floats "
+		<< rawBytes / playerCount << " bytes, interpolation delay: " << delay * 0.001 << " ms");
+}
+
+// SnapshotSync:
+
+SnapshotSync::SnapshotSync()
+{
+}
+
+SnapshotSync::~SnapshotSync()
+{
+	Done();
+}
+
+void SnapshotSync::Init(int maxEntities, BYTE snapshotReportID, BYTE ackReportID)
+{
+	VERUS_INIT();
+	VERUS_QREF_MP;
+
+	VERUS_RT_ASSERT(snapshotReportID >= REPORT_USER && ackReportID >= REPORT_USER && snapshotReportID != ackReportID);
+	_snapshotReportID = snapshotReportID;
+	_ackReportID = ackReportID;
+	_vReport.resize(mp.GetMaxReportSize());
+	if (mp.IsServer())
+		_server.Init(maxEntities, mp.GetMaxPlayers());
+	else
+		_client.Init(maxEntities);
+}
+
+void SnapshotSync::Done()
+{
+	_server.Done();
+	_client.Done();
+	VERUS_DONE(SnapshotSync);
+}
+
+void SnapshotSync::SendSnapshots(INT64 now)
+{
+	VERUS_QREF_MP;
+	VERUS_RT_ASSERT(mp.IsServer());
+
+	_server.Capture(now);
+	int lastID = 0;
+	for (int id = 1; id < mp.GetMaxPlayers(); ++id) // Player 0 is the server.
+	{
+		if (mp.IsActivePlayer(id))
+			lastID = id;
+	}
+	for (int id = 1; id <= lastID; ++id)
+	{
+		if (!mp.IsActivePlayer(id))
+			continue;
+		_server.WriteReport(id, _snapshotReportID, _vReport.data(), Utils::Cast32(_vReport.size()));
+		mp.SendReportAsync(id, _vReport.data(), id != lastID); // Network thread wakes up once.
+	}
+}
+
+bool SnapshotSync::OnReportFrom(int id, const BYTE* p, INT64 now)
+{
+	VERUS_QREF_MP;
+
+	if (_snapshotReportID == p[0])
+	{
+		if (!mp.IsServer() && _client.OnReport(p, now))
+		{
+			_client.WriteAckReport(_ackReportID, _vReport.data());
+			mp.SendReportAsync(id, _vReport.data());
+		}
+		return true;
+	}
+	if (_ackReportID == p[0])
+	{
+		if (mp.IsServer())
+			_server.OnAckReport(id, p);
+		return true;
+	}
+	return false;
+}
+
+void SnapshotSync::ResetClient(int id)
+{
+	if (_server.IsInitialized())
+		_server.ResetClient(id);
+}
@@ -0,0 +1,211 @@
+// Copyright (C) 2021-2022, Dmitry Maluev (dmaluev@gmail.com). All rights reserved.
+#pragma once
+
+namespace verus
+{
+	namespace Net
+	{
+		// Quantized state of a remote Spirit. Position has 4 mm precision, velocity has 1/64 m/s precision.
+		struct SpiritState
+		{
+			static const int s_positionBits = 24; // Signed, about 32 km range.
+			static const int s_velocityBits = 16;
+			static const int s_angleBits = 16;
+
+			INT32  _position[3] = {};
+			INT16  _velocity[3] = {};
+			UINT16 _pitch = 0;
+			UINT16 _yaw = 0;
+
+			void Quantize(RcPoint3 pos, RcVector3 velocity, float pitch, float yaw);
+			void FromSpirit(Game::RSpirit spirit);
+
+			Point3 GetPosition() const;
+			Vector3 GetVelocity() const;
+			float GetPitch() const;
+			float GetYaw() const;
+
+			bool operator==(const SpiritState& that) const;
+			bool operator!=(const SpiritState& that) const { return !(*this == that); }
+		};
+		VERUS_TYPEDEFS(SpiritState);
+
+		// Snapshot report has this layout: {id, seq, size, data}, data is bit-packed:
+		// {snapshot seq, baseline seq, server time, entities}, baseline seq is zero if there is no baseline.
+		// Only entities and fields, which differ from the baseline, are written. Baseline is the last snapshot
+		// acked by the client, so snapshot reports should be unreliable.
+		// Ack report is {id, seq, size, snapshot seq}.
+		// With Multiplayer: server calls WriteReport() for each client after Capture() and sends it with SendReportAsync(),
+		// client passes it to OnReport() in Multiplayer_OnReportFrom() and sends WriteAckReport() back.
+		// Multiplayer_IsReliable() should return false for both IDs, maxReportSize limits the snapshot.
+		class SnapshotCommon
+		{
+		public:
+			static const int s_viewCount = 32; // Snapshots, which can be used as baseline.
+			static const int s_reportHeaderSize = REPORT_ID_SIZE + 4;
+			static const int s_ackReportSize = s_reportHeaderSize + 2;
+
+		protected:
+			struct View
+			{
+				Vector<SpiritState> _vStates;
+				Vector<BYTE>        _vActive;
+				UINT32              _time = 0; // Server time in milliseconds.
+				UINT16              _seq = 0;
+			};
+			VERUS_TYPEDEFS(View);
+
+			View _emptyView;
+			int  _maxEntities = 0;
+			int  _indexBits = 0;
+
+			void InitView(RView view) const;
+			static void WriteReportHeader(BYTE* p, BYTE reportID, int size);
+			static void WriteState(RBitWriter bw, RcSpiritState base, RcSpiritState state);
+			static void ReadState(RBitReader br, RcSpiritState base, RSpiritState state);
+			static int GetMaxStateBits();
+		};
+		VERUS_TYPEDEFS(SnapshotCommon);
+
+		// Server keeps the states of all entities and what each client should have, writes delta-compressed snapshots.
+		class SnapshotServer : public Object, public SnapshotCommon
+		{
+			friend class SnapshotClient; // For Test().
+
+			struct Client
+			{
+				View   _views[s_viewCount]; // What client has after each snapshot, indexed by seq.
+				UINT16 _ackedSeq = 0;
+				int    _nextEntity = 0; // Where to start, if the previous snapshot was truncated.
+			};
+			VERUS_TYPEDEFS(Client);
+
+			Vector<Client> _vClients;
+			View           _current;
+
+		public:
+			SnapshotServer();
+			~SnapshotServer();
+
+			void Init(int maxEntities, int maxClients);
+			void Done();
+
+			void SetState(int index, RcSpiritState state);
+			void SetState(int index, Game::RSpirit spirit);
+			void Remove(int index);
+			// Call this once per snapshot tick, after all states are set. Time is in microseconds:
+			void Capture(INT64 now);
+
+			// Writes snapshot report for the client, returns report's size. Entities, which do not fit into maxSize,
+			// are sent in the next snapshot. Use Multiplayer::SendReportAsync() to send it:
+			int WriteReport(int client, BYTE reportID, BYTE* p, int maxSize);
+			void OnAckReport(int client, const BYTE* p);
+			// Next snapshot for this client will have full state:
+			void ResetClient(int client);
+
+			UINT16 GetSeq() const { return _current._seq; }
+		};
+		VERUS_TYPEDEFS(SnapshotServer);
+
+		// Client decodes snapshots and keeps a jitter buffer for each entity. Entities are rendered in the past,
+		// between two snapshots, the delay adapts to snapshot interval and jitter. If no snapshot arrives in time,
+		// entities are extrapolated using their velocity for a short time.
+		class SnapshotClient : public Object, public SnapshotCommon
+		{
+			static const int s_sampleCount = 8;
+			static const INT64 s_minDelay = 20 * 1000;
+			static const INT64 s_maxDelay = 500 * 1000;
+			static const INT64 s_maxExtrapolation = 250 * 1000;
+
+			struct Keyframe
+			{
+				INT64       _time = 0; // Server time in microseconds.
+				SpiritState _state;
+			};
+			VERUS_TYPEDEFS(Keyframe);
+
+			struct Entity
+			{
+				Keyframe _keyframes[s_sampleCount]; // Jitter buffer.
+				int      _head = 0;
+				int      _count = 0;
+
+				RcKeyframe GetKeyframe(int age) const { return _keyframes[(_head - 1 - age + 2 * s_sampleCount) % s_sampleCount]; }
+			};
+			VERUS_TYPEDEFS(Entity);
+
+			View           _views[s_viewCount];
+			View           _decoded;
+			Vector<Entity> _vEntities;
+			INT64          _timeOffset = 0; // Server time minus local time.
+			INT64          _jitter = 0;
+			INT64          _interval = 50 * 1000; // Between snapshots.
+			INT64          _renderTime = 0;
+			INT64          _latestTime = 0;
+			UINT16         _latestSeq = 0;
+
+		public:
+			SnapshotClient();
+			~SnapshotClient();
+
+			void Init(int maxEntities);
+			void Done();
+
+			// Returns false if the report is old, corrupt or its baseline is missing. Time is in microseconds:
+			bool OnReport(const BYTE* p, INT64 now);
+			// Acks the latest snapshot, returns report's size:
+			int WriteAckReport(BYTE reportID, BYTE* p) const;
+
+			// Advances render time, call this once per frame:
+			void Update(INT64 now);
+			INT64 GetRenderTime() const { return _renderTime; }
+			INT64 GetDelay() const;
+
+			bool IsActive(int index) const { return _vEntities[index]._count > 0; }
+			// Returns false if the entity is not active:
+			bool Sample(int index, RPoint3 pos, RVector3 velocity, float& pitch, float& yaw) const;
+			bool ApplyTo(int index, Game::RSpirit spirit) const;
+
+			static void Test();
+			// Server and 32 clients over a simulated link, results are written to log:
+			static void Benchmark();
+		};
+		VERUS_TYPEDEFS(SnapshotClient);
+
+		// Sends snapshots with Multiplayer. Entity's index is usually player's ID.
+		// Game's MultiplayerDelegate should pass reports to OnReportFrom() first and return false from
+		// Multiplayer_IsReliable(), if IsSnapshotReport() is true. Multiplayer_OnConnect() should call ResetClient().
+		class SnapshotSync : public Object
+		{
+			SnapshotServer _server;
+			SnapshotClient _client;
+			Vector<BYTE>   _vReport;
+			BYTE           _snapshotReportID = 0;
+			BYTE           _ackReportID = 0;
+
+		public:
+			SnapshotSync();
+			~SnapshotSync();
+
+			void Init(int maxEntities, BYTE snapshotReportID, BYTE ackReportID);
+			void Done();
+
+			bool IsSnapshotReport(const BYTE* p) const { return _snapshotReportID == p[0] || _ackReportID == p[0]; }
+
+			// Server captures states, which were set with GetServer().SetState(), and sends a snapshot to each player.
+			// Time is in microseconds:
+			void SendSnapshots(INT64 now);
+			// Returns false if this is not a snapshot report. Client decodes the snapshot and sends an ack:
+			bool OnReportFrom(int id, const BYTE* p, INT64 now);
+			void ResetClient(int id);
+
+			// Client calls this once per frame, then ApplyTo() for each remote Spirit:
+			void Update(INT64 now) { _client.Update(now); }
+			bool ApplyTo(int index, Game::RSpirit spirit) const { return _client.ApplyTo(index, spirit); }
+
+			RSnapshotServer GetServer() { return _server; }
+			RSnapshotClient GetClient() { return _client; }
+		};
+		VERUS_TYPEDEFS(SnapshotSync);
+	}
+}
@@ -161,6 +161,19 @@ void Socket::Udp(int port)
 			closesocket(_socket);
 			throw VERUS_RECOVERABLE << "ioctlsocket(FIONBIO); " << WSAGetLastError();
 		}
+		// Event, which is signaled when a datagram arrives, so that there is no need to poll:
+		_hReadEvent = WSACreateEvent();
+		if (WSA_INVALID_EVENT == _hReadEvent || WSAEventSelect(_socket, _hReadEvent, FD_READ))
+		{
+			const int error = WSAGetLastError();
+			if (_hReadEvent != WSA_INVALID_EVENT)
+			{
+				WSACloseEvent(_hReadEvent);
+				_hReadEvent = WSA_INVALID_EVENT;
+			}
+			closesocket(_socket);
+			throw VERUS_RECOVERABLE << "WSAEventSelect(); " << error;
+		}
 	}
 	else
 		throw VERUS_RECOVERABLE << "socket(); " << WSAGetLastError();
@@ -173,6 +186,11 @@ void Socket::Close()
 		closesocket(_socket);
 		_socket = INVALID_SOCKET;
 	}
+	if (_hReadEvent != WSA_INVALID_EVENT)
+	{
+		WSACloseEvent(_hReadEvent);
+		_hReadEvent = WSA_INVALID_EVENT;
+	}
 
 	CloseAllClients();
 
@@ -216,6 +234,24 @@ int Socket::RecvFrom(void* p, int size, RAddr addr) const
 	return ret;
 }
 
+int Socket::WaitForRead(WSAEVENT hWakeEvent, int timeoutMs)
+{
+	VERUS_RT_ASSERT(_hReadEvent != WSA_INVALID_EVENT);
+	const WSAEVENT events[] = { _hReadEvent, hWakeEvent };
+	const DWORD count = (WSA_INVALID_EVENT == hWakeEvent) ? 1 : 2;
+	const DWORD ret = WSAWaitForMultipleEvents(count, events, FALSE, Math::Max(0, timeoutMs), FALSE);
+	if (WSA_WAIT_EVENT_0 == ret)
+	{
+		// Resets the event, FD_READ is signaled again after the next recvfrom() if there is more data:
+		WSANETWORKEVENTS networkEvents;
+		WSAEnumNetworkEvents(_socket, _hReadEvent, &networkEvents);
+		return 0;
+	}
+	if (WSA_WAIT_EVENT_0 + 1 == ret)
+		return 1;
+	return -1;
+}
+
 void Socket::ThreadProc()
 {
 	SOCKET s = 0;
@@ -22,6 +22,7 @@ namespace verus
 
 			static WSADATA  s_wsaData;
 			SOCKET          _socket = INVALID_SOCKET;
+			WSAEVENT        _hReadEvent = WSA_INVALID_EVENT; // For UDP socket.
 			std::thread     _thread;
 			Vector<PClient> _vClients;
 			int             _maxClients = 1;
@@ -44,6 +45,10 @@ namespace verus
 			int     Recv(void* p, int size) const;
 			int RecvFrom(void* p, int size, RAddr addr) const;
 
+			// Blocks until UDP socket has data to read, hWakeEvent is signaled or timeout is reached.
+			// Returns 0 for socket, 1 for hWakeEvent, -1 for timeout or error:
+			int WaitForRead(WSAEVENT hWakeEvent, int timeoutMs);
+
 			void SetMaxClients(int count) { _maxClients = count; }
 			void SetClientBufferSize(int size) { _clientBufferSize = size; }
 
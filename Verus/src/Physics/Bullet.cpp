@@ -4,8 +4,54 @@
 using namespace verus;
 using namespace verus::Physics;
 
+namespace
+{
+	// Calls the function for each broadphase proxy, which the tree traversal reaches:
+	template<typename TFunc>
+	class DbvtCollide : public btDbvt::ICollide
+	{
+		TFunc _func;
+
+	public:
+		DbvtCollide(TFunc func) : _func(func) {}
+
+		virtual void Process(const btDbvtNode* pLeaf) override
+		{
+			_func(static_cast<btBroadphaseProxy*>(pLeaf->data));
+		}
+	};
+
+	// Same as btDbvtBroadphase::rayTest, but the stack is provided by the caller, so it can be used by many threads:
+	void TraverseBroadphase(
+		btDbvtBroadphase* pBroadphase,
+		const btVector3& from,
+		const btVector3& to,
+		const btVector3& aabbMin,
+		const btVector3& aabbMax,
+		btAlignedObjectArray<const btDbvtNode*>& stack,
+		btDbvt::ICollide& policy)
+	{
+		btVector3 dir = to - from;
+		dir.normalize();
+		btVector3 dirInv;
+		unsigned int signs[3];
+		VERUS_FOR(i, 3)
+		{
+			dirInv[i] = (0 == dir[i]) ? btScalar(BT_LARGE_FLOAT) : 1 / dir[i];
+			signs[i] = dirInv[i] < 0;
+		}
+		const btScalar lambdaMax = dir.dot(to - from);
+		VERUS_FOR(i, 2) // Dynamic and fixed sets.
+		{
+			if (pBroadphase->m_sets[i].m_root)
+				pBroadphase->m_sets[i].rayTestInternal(pBroadphase->m_sets[i].m_root, from, to, dirInv, signs, lambdaMax, aabbMin, aabbMax, stack, policy);
+		}
+	}
+}
+
 Bullet::Bullet()
 {
+	_asyncStepInFlight = false;
 }
 
 Bullet::~Bullet()
@@ -41,10 +87,14 @@ void Bullet::Init()
 
 	// See: http://bulletphysics.org/Bullet/phpBB3/viewtopic.php?t=6773:
 	_pDiscreteDynamicsWorld->getDispatchInfo().m_allowedCcdPenetration = 0.0001f;
+
+	if (settings._physicsAsyncSimulation)
+		EnableAsyncSimulation(true);
 }
 
 void Bullet::Done()
 {
+	EnableAsyncSimulation(false);
 	EnableDebugPlane(false);
 	DeleteAllCollisionObjects();
 
@@ -69,6 +119,7 @@ btRigidBody* Bullet::AddNewRigidBody(
 	void* pPlacementRigidBody)
 {
 	btAssert(!pShape || pShape->getShapeType() != INVALID_SHAPE_PROXYTYPE);
+	WaitForAsyncStep();
 
 	const bool dynamic = (mass != 0);
 
@@ -88,6 +139,7 @@ btRigidBody* Bullet::AddNewRigidBody(
 	else
 		pRigidBody = new btRigidBody(rbci);
 	_pDiscreteDynamicsWorld->addRigidBody(pRigidBody, group, mask);
+	ResetInterpolatedTransform(pRigidBody, startTransform);
 
 	return pRigidBody;
 }
@@ -102,6 +154,7 @@ btRigidBody* Bullet::AddNewRigidBody(
 	const btTransform* pCenterOfMassOffset)
 {
 	btAssert(!pShape || pShape->getShapeType() != INVALID_SHAPE_PROXYTYPE);
+	WaitForAsyncStep();
 
 	const bool dynamic = (mass != 0);
 
@@ -114,6 +167,7 @@ btRigidBody* Bullet::AddNewRigidBody(
 	btRigidBody::btRigidBodyConstructionInfo rbci(mass, pMotionState, pShape, localInertia);
 	btRigidBody* pRigidBody = new(localRigidBody.GetRigidBodyData()) btRigidBody(rbci);
 	_pDiscreteDynamicsWorld->addRigidBody(pRigidBody, group, mask);
+	ResetInterpolatedTransform(pRigidBody, startTransform);
 
 	return pRigidBody;
 }
@@ -122,6 +176,7 @@ void Bullet::DeleteAllCollisionObjects()
 {
 	if (!_pDiscreteDynamicsWorld.Get())
 		return;
+	WaitForAsyncStep();
 
 	for (int i = _pDiscreteDynamicsWorld->getNumCollisionObjects() - 1; i >= 0; --i)
 	{
@@ -132,6 +187,8 @@ void Bullet::DeleteAllCollisionObjects()
 		_pDiscreteDynamicsWorld->removeCollisionObject(pObject);
 		delete pObject;
 	}
+	VERUS_FOR(i, 2)
+		_mapSnapshots[i].clear(); // Addresses can be reused.
 }
 
 void Bullet::Simulate()
@@ -139,15 +196,364 @@ void Bullet::Simulate()
 	if (!_pDiscreteDynamicsWorld.Get())
 		return;
 	VERUS_UPDATE_ONCE_CHECK;
+	VERUS_PROFILE_SCOPE("Bullet::Simulate");
 
 	VERUS_QREF_TIMER;
-	_pDiscreteDynamicsWorld->stepSimulation(_pauseSimulation ? 0 : dt, s_defaultMaxSubSteps);
+	if (!_asyncSimulation)
+	{
+		_pDiscreteDynamicsWorld->stepSimulation(_pauseSimulation ? 0 : dt, s_defaultMaxSubSteps);
+		return;
+	}
+
+	// Step boundary:
+	if (_stepPlanned) // StartAsyncStep() was not called? Step now.
+		StartAsyncStep();
+	WaitForAsyncStep();
+
+	// Plan fixed steps, which will overlap with drawing of this frame:
+	if (!_pauseSimulation)
+		_accumulator += dt;
+	const int stepCount = static_cast<int>(_accumulator / _fixedTimeStep);
+	_accumulator -= stepCount * _fixedTimeStep;
+	_plannedStepCount = Math::Min(stepCount, s_defaultMaxSubSteps); // Drop the time, which cannot be simulated.
+	_plannedAlpha = Math::Clamp<float>(_accumulator / _fixedTimeStep, 0, 1);
+	_stepPlanned = true;
+}
+
+void Bullet::EnableAsyncSimulation(bool b, int stepsPerSecond)
+{
+	if (b)
+	{
+		WaitForAsyncStep();
+		_fixedTimeStep = 1.f / Math::Max(stepsPerSecond, 1);
+		if (_asyncSimulation)
+			return;
+
+		_accumulator = 0;
+		_plannedStepCount = 0;
+		_plannedAlpha = _pendingAlpha = _alpha = 0;
+		_stepPlanned = false;
+		_snapshotReady = false;
+		VERUS_FOR(i, 2)
+			_mapSnapshots[i].clear();
+
+		_stopThread = false;
+		_thread = std::thread(&Bullet::ThreadProc, this);
+		_asyncSimulation = true;
+	}
+	else
+	{
+		if (!_asyncSimulation)
+			return;
+
+		// Can be called by destructor, so exceptions are not rethrown here:
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_cv.wait(lock, [this]() { return !_asyncStepCount; });
+			_stopThread = true;
+		}
+		_cv.notify_all();
+		_thread.join();
+		_asyncSimulation = false;
+		_asyncStepInFlight = false;
+		_asyncException = nullptr;
+
+		for (auto& func : _vQueuedEdits)
+			func();
+		_vQueuedEdits.clear();
+		VERUS_FOR(i, 2)
+			_mapSnapshots[i].clear();
+		_stepPlanned = false;
+	}
+}
+
+void Bullet::StartAsyncStep()
+{
+	if (!_asyncSimulation || !_stepPlanned)
+		return;
+
+	_stepPlanned = false;
+	_asyncStepInFlight = true;
+	_pendingAlpha = _plannedAlpha;
+	_snapshotReady = _plannedStepCount > 0;
+	if (_plannedStepCount > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_asyncStepCount = _plannedStepCount;
+		}
+		_cv.notify_all();
+	}
+}
+
+void Bullet::WaitForAsyncStep()
+{
+	// The thread itself can use the world from callbacks:
+	if (!_asyncStepInFlight || std::this_thread::get_id() == _thread.get_id())
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_cv.wait(lock, [this]() { return !_asyncStepCount; });
+	}
+	_asyncStepInFlight = false;
+
+	PublishSnapshot();
+
+	// Edits, which were made during the step:
+	for (auto& func : _vQueuedEdits)
+		func();
+	_vQueuedEdits.clear();
+
+	if (_asyncException)
+	{
+		std::exception_ptr ex = _asyncException;
+		_asyncException = nullptr;
+		std::rethrow_exception(ex);
+	}
+}
+
+void Bullet::QueueEdit(TEditFunc func)
+{
+	if (_asyncStepInFlight && std::this_thread::get_id() != _thread.get_id())
+		_vQueuedEdits.push_back(std::move(func));
+	else
+		func();
+}
+
+bool Bullet::GetInterpolatedTransform(const btCollisionObject* pObject, btTransform& tr)
+{
+	if (_asyncSimulation && !pObject->isStaticOrKinematicObject())
+	{
+		const TMapSnapshot& map = _mapSnapshots[_publishedSnapshot];
+		auto it = map.find(pObject);
+		if (it != map.end())
+		{
+			RcSnapshotEntry entry = it->second;
+			tr.setOrigin(entry._trPrev.getOrigin().lerp(entry._trCurr.getOrigin(), _alpha));
+			tr.setRotation(entry._trPrev.getRotation().slerp(entry._trCurr.getRotation(), _alpha));
+			return true;
+		}
+		// Not in the snapshot yet, motion state can be written by the thread:
+		WaitForAsyncStep();
+	}
+
+	const btRigidBody* pRigidBody = btRigidBody::upcast(pObject);
+	if (pRigidBody && pRigidBody->getMotionState())
+		pRigidBody->getMotionState()->getWorldTransform(tr);
+	else
+		tr = pObject->getWorldTransform();
+	return false;
+}
+
+void Bullet::ResetInterpolatedTransform(const btCollisionObject* pObject, const btTransform& tr)
+{
+	if (!_asyncSimulation || pObject->isStaticOrKinematicObject())
+		return;
+
+	// Published snapshot is only used by this thread:
+	RSnapshotEntry entry = _mapSnapshots[_publishedSnapshot][pObject];
+	entry._trPrev = tr;
+	entry._trCurr = tr;
+}
+
+void Bullet::StepFixed(int count)
+{
+	VERUS_PROFILE_SCOPE("Bullet::StepFixed");
+	// Snapshot, which is not published, is written by this thread:
+	TMapSnapshot& map = _mapSnapshots[1 - _publishedSnapshot];
+	VERUS_FOR(i, count)
+	{
+		if (count - 1 == i)
+			CaptureSnapshot(map, true);
+		_pDiscreteDynamicsWorld->stepSimulation(_fixedTimeStep, 0, _fixedTimeStep);
+	}
+	CaptureSnapshot(map, false);
+}
+
+void Bullet::CaptureSnapshot(TMapSnapshot& map, bool prev)
+{
+	// Previous transforms are captured first, objects cannot be added or removed until current transforms are captured:
+	if (prev)
+		_snapshotStamp++;
+	const int count = _pDiscreteDynamicsWorld->getNumCollisionObjects();
+	const btCollisionObjectArray& objects = _pDiscreteDynamicsWorld->getCollisionObjectArray();
+	VERUS_FOR(i, count)
+	{
+		const btCollisionObject* pObject = objects[i];
+		if (pObject->isStaticOrKinematicObject())
+			continue;
+
+		btTransform tr;
+		const btRigidBody* pRigidBody = btRigidBody::upcast(pObject);
+		if (pRigidBody && pRigidBody->getMotionState())
+			pRigidBody->getMotionState()->getWorldTransform(tr);
+		else
+			tr = pObject->getWorldTransform();
+
+		RSnapshotEntry entry = map[pObject];
+		if (prev)
+		{
+			entry._trPrev = tr;
+			entry._stamp = _snapshotStamp;
+		}
+		else
+		{
+			if (entry._stamp != _snapshotStamp) // New object?
+				entry._trPrev = tr;
+			entry._trCurr = tr;
+			entry._stamp = _snapshotStamp;
+		}
+	}
+
+	if (!prev) // Remove objects, which are no longer in the world:
+	{
+		for (auto it = map.begin(); it != map.end();)
+		{
+			if (it->second._stamp != _snapshotStamp)
+				it = map.erase(it);
+			else
+				++it;
+		}
+	}
+}
+
+void Bullet::PublishSnapshot()
+{
+	if (_snapshotReady)
+	{
+		_publishedSnapshot = 1 - _publishedSnapshot;
+		_snapshotReady = false;
+	}
+	_alpha = _pendingAlpha;
+}
+
+void Bullet::ThreadProc()
+{
+	VERUS_PROFILE_THREAD("Physics");
+	while (true)
+	{
+		int stepCount = 0;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_cv.wait(lock, [this]() { return _asyncStepCount > 0 || _stopThread; });
+			if (_stopThread)
+				break;
+			stepCount = _asyncStepCount;
+		}
+
+		try
+		{
+			StepFixed(stepCount);
+		}
+		catch (...)
+		{
+			_asyncException = std::current_exception();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_asyncStepCount = 0;
+		}
+		_cv.notify_all();
+	}
+}
+
+void Bullet::RayTestBatch(const RayQuery* pQueries, PRayHit pHits, int count)
+{
+	if (!_pDiscreteDynamicsWorld.Get() || count <= 0)
+		return;
+
+	btDiscreteDynamicsWorld* pWorld = GetWorld(); // Wait for async step.
+	btDbvtBroadphase* pBroadphase = _pBroadphaseInterface.Get();
+	const btScalar allowedPenetration = pWorld->getDispatchInfo().m_allowedCcdPenetration;
+
+	auto TestOne = [pBroadphase, allowedPenetration](RcRayQuery query, RRayHit hit, btAlignedObjectArray<const btDbvtNode*>& stack)
+	{
+		hit = RayHit();
+		if (!memcmp(query._pointA.ToPointer(), query._pointB.ToPointer(), sizeof(float) * 3))
+			return;
+		const btVector3 from(query._pointA.Bullet()), to(query._pointB.Bullet());
+		btTransform trA, trB;
+		trA.setIdentity();
+		trB.setIdentity();
+		trA.setOrigin(from);
+		trB.setOrigin(to);
+
+		const btCollisionObject* pHitObject = nullptr;
+		if (query._radius > 0)
+		{
+			btSphereShape sphere(query._radius);
+			btCollisionWorld::ClosestConvexResultCallback ccrc(from, to);
+			ccrc.m_collisionFilterGroup = +Group::ray;
+			ccrc.m_collisionFilterMask = +query._mask;
+			DbvtCollide policy([&](btBroadphaseProxy* pProxy)
+				{
+					if (!ccrc.needsCollision(pProxy))
+						return;
+					btCollisionObject* pObject = static_cast<btCollisionObject*>(pProxy->m_clientObject);
+					btCollisionWorld::objectQuerySingle(&sphere, trA, trB,
+						pObject, pObject->getCollisionShape(), pObject->getWorldTransform(), ccrc, allowedPenetration);
+				});
+			const btVector3 extent(query._radius, query._radius, query._radius);
+			TraverseBroadphase(pBroadphase, from, to, -extent, extent, stack, policy);
+			if (ccrc.hasHit())
+			{
+				pHitObject = ccrc.m_hitCollisionObject;
+				hit._point = ccrc.m_hitPointWorld;
+				hit._normal = ccrc.m_hitNormalWorld;
+				hit._fraction = ccrc.m_closestHitFraction;
+			}
+		}
+		else
+		{
+			btCollisionWorld::ClosestRayResultCallback crrc(from, to);
+			crrc.m_collisionFilterGroup = +Group::ray;
+			crrc.m_collisionFilterMask = +query._mask;
+			DbvtCollide policy([&](btBroadphaseProxy* pProxy)
+				{
+					if (!crrc.needsCollision(pProxy))
+						return;
+					btCollisionObject* pObject = static_cast<btCollisionObject*>(pProxy->m_clientObject);
+					btCollisionWorld::rayTestSingle(trA, trB,
+						pObject, pObject->getCollisionShape(), pObject->getWorldTransform(), crrc);
+				});
+			const btVector3 extent(0, 0, 0);
+			TraverseBroadphase(pBroadphase, from, to, extent, extent, stack, policy);
+			if (crrc.hasHit())
+			{
+				pHitObject = crrc.m_collisionObject;
+				hit._point = crrc.m_hitPointWorld;
+				hit._normal = crrc.m_hitNormalWorld;
+				hit._fraction = crrc.m_closestHitFraction;
+			}
+		}
+
+		if (pHitObject)
+		{
+			hit._pUserPtr = static_cast<PUserPtr>(pHitObject->getUserPointer());
+			hit._hit = true;
+		}
+	};
+
+	// Small chunks of queries share the traversal stack:
+	const int chunkSize = 64;
+	const int chunkCount = (count + chunkSize - 1) / chunkSize;
+	Parallel::For(0, chunkCount, [pQueries, pHits, count, chunkSize, &TestOne](int chunk)
+		{
+			btAlignedObjectArray<const btDbvtNode*> stack;
+			const int from = chunk * chunkSize;
+			const int to = Math::Min(from + chunkSize, count);
+			for (int i = from; i < to; ++i)
+				TestOne(pQueries[i], pHits[i], stack);
+		});
 }
 
 void Bullet::DebugDraw()
 {
 	if (!_pDiscreteDynamicsWorld.Get() || !_pDiscreteDynamicsWorld->getDebugDrawer())
 		return;
+	WaitForAsyncStep();
 
 	VERUS_QREF_DD;
 	dd.Begin(CGI::DebugDraw::Type::lines, nullptr, false);
@@ -157,6 +563,7 @@ void Bullet::DebugDraw()
 
 void Bullet::SetDebugDrawMode(DebugDrawMode mode)
 {
+	WaitForAsyncStep();
 	if (!_pDiscreteDynamicsWorld->getDebugDrawer())
 		return;
 
@@ -183,6 +590,7 @@ void Bullet::EnableDebugPlane(bool b)
 {
 	if (b == !!_pStaticPlaneRigidBody.Get())
 		return;
+	WaitForAsyncStep();
 
 	if (b)
 	{
@@ -259,3 +667,73 @@ CSZ Bullet::GroupToString(int index)
 		return text[index];
 	return nullptr;
 }
+
+void Bullet::Benchmark()
+{
+	if (!IsValidSingleton() || !I().IsInitialized())
+		return;
+	RBullet bullet = I();
+	btDiscreteDynamicsWorld* pWorld = bullet.GetWorld();
+
+	// Terrain-like heightfield with blocks on it:
+	const int side = 256;
+	Vector<float> vHeights(side * side);
+	VERUS_FOR(i, side)
+	{
+		VERUS_FOR(j, side)
+			vHeights[i * side + j] = sin(i * 0.05f) * cos(j * 0.05f) * 8;
+	}
+	btHeightfieldTerrainShape heightfieldShape(side, side, vHeights.data(), 1, -8, 8, 1, PHY_FLOAT, false);
+	btBoxShape boxShape(btVector3(1, 1, 1));
+
+	Random random(1234);
+	Vector<btRigidBody*> vBodies;
+	btTransform tr;
+	tr.setIdentity();
+	vBodies.push_back(bullet.AddNewRigidBody(0, tr, &heightfieldShape, +Group::terrain));
+	VERUS_FOR(i, 1000)
+	{
+		tr.setOrigin(btVector3(random.NextFloat(-120, 120), random.NextFloat(-4, 8), random.NextFloat(-120, 120)));
+		vBodies.push_back(bullet.AddNewRigidBody(0, tr, &boxShape, +Group::immovable));
+	}
+
+	const int rayCount = 10000;
+	Vector<RayQuery> vQueries(rayCount);
+	Vector<RayHit> vHits(rayCount);
+	for (auto& query : vQueries)
+	{
+		query._pointA = Point3(random.NextFloat(-120, 120), 50, random.NextFloat(-120, 120));
+		query._pointB = Point3(random.NextFloat(-120, 120), -50, random.NextFloat(-120, 120));
+	}
+
+	int serialHitCount = 0;
+	const double serialMs = Utils::MeasureBestTime([&]()
+		{
+			serialHitCount = 0;
+			for (const auto& query : vQueries)
+			{
+				const btVector3 from(query._pointA.Bullet()), to(query._pointB.Bullet());
+				btCollisionWorld::ClosestRayResultCallback crrc(from, to);
+				crrc.m_collisionFilterGroup = +Group::ray;
+				crrc.m_collisionFilterMask = +query._mask;
+				pWorld->rayTest(from, to, crrc);
+				if (crrc.hasHit())
+					serialHitCount++;
+			}
+		});
+	const double batchMs = Utils::MeasureBestTime([&]()
+		{
+			bullet.RayTestBatch(vQueries.data(), vHits.data(), rayCount);
+		});
+	const int batchHitCount = Utils::Cast32(std::count_if(vHits.begin(), vHits.end(), [](RcRayHit hit) { return hit._hit; }));
+	VERUS_RT_ASSERT(serialHitCount == batchHitCount);
+
+	for (auto pRigidBody : vBodies)
+	{
+		pWorld->removeRigidBody(pRigidBody);
+		delete pRigidBody->getMotionState();
+		delete pRigidBody;
+	}
+
+	VERUS_LOG_INFO("Benchmark(); " << rayCount << " rays, serial: " << serialMs << " ms, batch: " << batchMs << " ms, hits: " << batchHitCount);
+}
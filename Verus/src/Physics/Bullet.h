@@ -66,9 +66,50 @@ namespace verus
 			basic
 		};
 
+		// Ray or sphere sweep for batched queries:
+		struct RayQuery
+		{
+			Point3 _pointA = Point3(0);
+			Point3 _pointB = Point3(0);
+			float  _radius = 0; // Sphere sweep if not zero.
+			Group  _mask = Group::all;
+		};
+		VERUS_TYPEDEFS(RayQuery);
+
+		struct RayHit
+		{
+			Point3   _point = Point3(0);
+			Vector3  _normal = Vector3(0);
+			PUserPtr _pUserPtr = nullptr; // Node, terrain, character, etc.
+			float    _fraction = 1;
+			bool     _hit = false;
+		};
+		VERUS_TYPEDEFS(RayHit);
+
+		// Bullet owns the dynamics world and steps it.
+		// In async mode the world is stepped at a fixed rate on a separate thread, which overlaps with rendering:
+		// * Simulate() is a step boundary: it waits for the step, applies queued edits and publishes the snapshot
+		// * StartAsyncStep() hands the steps, which were planned by Simulate(), to the thread
+		// * GetWorld() waits for the step, so that the world is never accessed by two threads
+		// * dynamic bodies are read from the snapshot, which is interpolated between the last two steps
 		class Bullet : public Singleton<Bullet>, public Object
 		{
+		public:
+			typedef std::function<void()> TEditFunc;
+
+		private:
 			static const int s_defaultMaxSubSteps = 8;
+			static const int s_defaultStepsPerSecond = 60;
+
+			// Only dynamic objects are in the snapshot, they are found by address:
+			struct SnapshotEntry
+			{
+				btTransform _trPrev;
+				btTransform _trCurr;
+				UINT32      _stamp = 0; // Entries of removed objects have old stamp.
+			};
+			VERUS_TYPEDEFS(SnapshotEntry);
+			typedef HashMap<const btCollisionObject*, SnapshotEntry> TMapSnapshot;
 
 			LocalPtr<btDefaultCollisionConfiguration>     _pCollisionConfiguration;
 			LocalPtr<btCollisionDispatcher>               _pDispatcher;
@@ -82,6 +123,29 @@ namespace verus
 			Group                                         _mainMask = Group::immovable | Group::terrain;
 			bool                                          _pauseSimulation = false;
 
+			// <Async>
+			std::thread                                   _thread;
+			std::mutex                                    _mutex;
+			std::condition_variable                       _cv;
+			std::atomic_bool                              _asyncStepInFlight; // Cleared at step boundary.
+			std::exception_ptr                            _asyncException;
+			Vector<TEditFunc>                             _vQueuedEdits;
+			TMapSnapshot                                  _mapSnapshots[2];
+			int                                           _publishedSnapshot = 0;
+			UINT32                                        _snapshotStamp = 0;
+			int                                           _plannedStepCount = 0; // Planned by Simulate().
+			int                                           _asyncStepCount = 0; // Taken by the thread.
+			bool                                          _stopThread = false;
+			bool                                          _stepPlanned = false;
+			bool                                          _asyncSimulation = false;
+			bool                                          _snapshotReady = false;
+			float                                         _fixedTimeStep = 1.f / s_defaultStepsPerSecond;
+			float                                         _accumulator = 0;
+			float                                         _plannedAlpha = 0;
+			float                                         _pendingAlpha = 0;
+			float                                         _alpha = 0;
+			// </Async>
+
 		public:
 			Bullet();
 			~Bullet();
@@ -89,7 +153,13 @@ namespace verus
 			void Init();
 			void Done();
 
-			btDiscreteDynamicsWorld* GetWorld() { return _pDiscreteDynamicsWorld.Get(); }
+			// Waits for async step, call it on the main thread:
+			btDiscreteDynamicsWorld* GetWorld()
+			{
+				if (_asyncStepInFlight)
+					WaitForAsyncStep();
+				return _pDiscreteDynamicsWorld.Get();
+			}
 
 			btRigidBody* AddNewRigidBody(
 				float mass,
@@ -115,6 +185,22 @@ namespace verus
 			void PauseSimualtion(bool b) { _pauseSimulation = b; }
 			bool IsSimulationPaused() const { return _pauseSimulation; }
 
+			// <Async>
+			void EnableAsyncSimulation(bool b, int stepsPerSecond = s_defaultStepsPerSecond);
+			bool IsAsyncSimulation() const { return _asyncSimulation; }
+			// Call it after game update, before the frame is drawn:
+			void StartAsyncStep();
+			// Also applies queued edits:
+			void WaitForAsyncStep();
+			// Runs the function now, or at step boundary if the world is being stepped:
+			void QueueEdit(TEditFunc func);
+			// Transform, which should be rendered. In async mode dynamic objects are interpolated between the last two steps,
+			// motion state is never read while the world is being stepped. Returns true if the transform is interpolated:
+			bool GetInterpolatedTransform(const btCollisionObject* pObject, btTransform& tr);
+			// Use it after teleporting the object, so that it doesn't slide to the new place, new objects are also added:
+			void ResetInterpolatedTransform(const btCollisionObject* pObject, const btTransform& tr);
+			// </Async>
+
 			void DebugDraw();
 			void SetDebugDrawMode(DebugDrawMode mode);
 			void EnableDebugPlane(bool b);
@@ -126,6 +212,19 @@ namespace verus
 
 			Group GetMainMask() const { return _mainMask; }
 			void SetMainMask(Group mask) { _mainMask = mask; }
+
+			// Finds the closest hit for each query. Queries are split between worker threads, which
+			// traverse broadphase trees directly with their own stacks, so the world must not change meanwhile:
+			void RayTestBatch(const RayQuery* pQueries, PRayHit pHits, int count);
+
+			// Compares batched and serial ray tests against heightfield and boxes, results are written to log:
+			static void Benchmark();
+
+		private:
+			void StepFixed(int count);
+			void CaptureSnapshot(TMapSnapshot& map, bool prev);
+			void PublishSnapshot();
+			void ThreadProc();
 		};
 		VERUS_TYPEDEFS(Bullet);
 	}
@@ -10,11 +10,11 @@ namespace verus
 		public:
 			static inline void Encrypt(
 				RcString password,
-				const Vector<BYTE>& vData,
-				Vector<BYTE>& vCipher,
+				const BYTE* pData,
+				BYTE* pCipher,
+				size_t size,
 				size_t skip = 787)
 			{
-				vCipher.resize(vData.size());
 				size_t i, j, a;
 				BYTE key[256];
 				BYTE box[256];
@@ -28,7 +28,7 @@ namespace verus
 					j = (j + box[i] + key[i]) & 0xFF;
 					std::swap(box[i], box[j]);
 				}
-				const size_t count = vData.size() + skip;
+				const size_t count = size + skip;
 				for (a = j = i = 0; i < count; ++i)
 				{
 					a = (a + 1) & 0xFF;
@@ -36,10 +36,20 @@ namespace verus
 					std::swap(box[a], box[j]);
 					const BYTE k = box[(box[a] + box[j]) & 0xFF];
 					if (i >= skip)
-						vCipher[i - skip] = vData[i - skip] ^ k;
+						pCipher[i - skip] = pData[i - skip] ^ k;
 				}
 			}
 
+			static inline void Encrypt(
+				RcString password,
+				const Vector<BYTE>& vData,
+				Vector<BYTE>& vCipher,
+				size_t skip = 787)
+			{
+				vCipher.resize(vData.size());
+				Encrypt(password, vData.data(), vCipher.data(), vData.size(), skip);
+			}
+
 			static inline void Decrypt(
 				RcString password,
 				const Vector<BYTE>& vCipher,
@@ -49,6 +59,16 @@ namespace verus
 				Encrypt(password, vCipher, vData, skip);
 			}
 
+			static inline void Decrypt(
+				RcString password,
+				const BYTE* pCipher,
+				BYTE* pData,
+				size_t size,
+				size_t skip = 787)
+			{
+				Encrypt(password, pCipher, pData, size, skip);
+			}
+
 			static inline void Test()
 			{
 				// See: https://tools.ietf.org/html/rfc6229
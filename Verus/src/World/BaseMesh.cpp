@@ -4,6 +4,20 @@
 using namespace verus;
 using namespace verus::World;
 
+namespace
+{
+	// Block must contain exactly count elements, which are copied at once:
+	template<typename T>
+	void ReadBlock(IO::RStreamPtr sp, INT64 blockSize, Vector<T>& v, int count)
+	{
+		if (count < 0 || blockSize != static_cast<INT64>(sizeof(T)) * count)
+			throw VERUS_RECOVERABLE << "ReadBlock(); Invalid block size: " << blockSize;
+		VERUS_RT_ASSERT(v.empty());
+		v.resize(count);
+		sp.Read(v.data(), blockSize);
+	}
+}
+
 BaseMesh::BaseMesh()
 {
 	VERUS_ZERO_MEM(_posDeq);
@@ -13,6 +27,8 @@ BaseMesh::BaseMesh()
 	VERUS_CT_ASSERT(16 == sizeof(VertexInputBinding1));
 	VERUS_CT_ASSERT(16 == sizeof(VertexInputBinding2));
 	VERUS_CT_ASSERT(8 == sizeof(VertexInputBinding3));
+	VERUS_CT_ASSERT(40 == sizeof(Meshlet));
+	VERUS_CT_ASSERT(68 == sizeof(X3DMeshHeader));
 }
 
 BaseMesh::~BaseMesh()
@@ -35,10 +51,34 @@ void BaseMesh::Done()
 }
 
 void BaseMesh::Async_WhenLoaded(CSZ url, RcBlob blob)
+{
+	Async_Process(url, blob);
+	Async_Commit(url, blob);
+}
+
+void BaseMesh::Async_Process(CSZ url, RcBlob blob)
 {
 	if (_url == url)
 	{
-		Load(blob);
+		_asyncParsed = Load(blob);
+		return;
+	}
+}
+
+void BaseMesh::Async_Commit(CSZ url, RcBlob blob)
+{
+	if (_url == url)
+	{
+		if (!_asyncParsed)
+			return;
+		_asyncParsed = false;
+		if (!_loadOnly)
+		{
+			if (_initShape)
+				InitShape(Transform3::identity());
+			CreateDeviceBuffers();
+		}
+		_loaded = true;
 		LoadPrimaryBones();
 		LoadRig();
 		LoadWarp();
@@ -46,7 +86,7 @@ void BaseMesh::Async_WhenLoaded(CSZ url, RcBlob blob)
 	}
 }
 
-void BaseMesh::Load(RcBlob blob)
+bool BaseMesh::Load(RcBlob blob)
 {
 	IO::StreamPtr sp(blob);
 	UINT32 magic = 0;
@@ -55,7 +95,8 @@ void BaseMesh::Load(RcBlob blob)
 	{
 		if (magic == 'D3X<')
 		{
-			return LoadX3D3(blob);
+			LoadX3D3(blob);
+			return true;
 		}
 		else
 		{
@@ -63,6 +104,7 @@ void BaseMesh::Load(RcBlob blob)
 		}
 	}
 	VERUS_LOG_WARN("Load(); Old X3D version");
+	return false;
 }
 
 void BaseMesh::LoadX3D3(RcBlob blob)
@@ -71,6 +113,7 @@ void BaseMesh::LoadX3D3(RcBlob blob)
 
 	bool hasNormals = false;
 	bool hasTBN = false;
+	bool indices32 = false;
 	UINT32 temp;
 	UINT32 blockType = 0;
 	INT64 blockSize = 0;
@@ -88,8 +131,72 @@ void BaseMesh::LoadX3D3(RcBlob blob)
 		sp >> temp;
 		sp >> blockType;
 		sp >> blockSize;
+		if (blockSize < 0 || sp.GetOffset() + blockSize > sp.GetSize())
+			throw VERUS_RECOVERABLE << "LoadX3D3(); Invalid block size: " << blockSize;
 		switch (blockType)
 		{
+		case '>HM<': // Version 3.2, bindings are stored as is:
+		{
+			X3DMeshHeader header;
+			if (blockSize != sizeof(header))
+				throw VERUS_RECOVERABLE << "LoadX3D3(); Invalid mesh header size: " << blockSize;
+			sp.Read(&header, sizeof(header));
+			_vertCount = header._vertCount;
+			_indexCount = header._indexCount;
+			_faceCount = _indexCount / 3;
+			memcpy(_posDeq, header._posDeq, sizeof(_posDeq));
+			memcpy(_tc0Deq, header._tc0Deq, sizeof(_tc0Deq));
+			memcpy(_tc1Deq, header._tc1Deq, sizeof(_tc1Deq));
+			_robotic = !!(header._flags & X3DFlags::robotic);
+			indices32 = !!(header._flags & X3DFlags::indices32);
+		}
+		break;
+		case '>BI<':
+		{
+			UINT32 maxIndex = 0;
+			if (indices32)
+			{
+				ReadBlock(sp, blockSize, _vIndices32, _indexCount);
+				if (!_vIndices32.empty())
+					maxIndex = *std::max_element(_vIndices32.begin(), _vIndices32.end());
+			}
+			else
+			{
+				ReadBlock(sp, blockSize, _vIndices, _indexCount);
+				if (!_vIndices.empty())
+					maxIndex = *std::max_element(_vIndices.begin(), _vIndices.end());
+			}
+			if (_indexCount && maxIndex >= static_cast<UINT32>(_vertCount))
+				throw VERUS_RECOVERABLE << "LoadX3D3(); Index out of bounds: " << maxIndex << ", vertex count: " << _vertCount;
+		}
+		break;
+		case '>0B<':
+		{
+			hasNormals = true;
+			ReadBlock(sp, blockSize, _vBinding0, _vertCount);
+		}
+		break;
+		case '>1B<':
+		{
+			ReadBlock(sp, blockSize, _vBinding1, _vertCount);
+		}
+		break;
+		case '>2B<':
+		{
+			hasTBN = true;
+			ReadBlock(sp, blockSize, _vBinding2, _vertCount);
+		}
+		break;
+		case '>3B<':
+		{
+			ReadBlock(sp, blockSize, _vBinding3, _vertCount);
+		}
+		break;
+		case '>LM<':
+		{
+			ReadBlock(sp, blockSize, _vMeshlets, Utils::Cast32(blockSize / sizeof(Meshlet)));
+		}
+		break;
 		case '>XI<':
 		{
 			sp.ReadString(buffer);
@@ -301,11 +408,6 @@ void BaseMesh::LoadX3D3(RcBlob blob)
 		_vBinding2.resize(_vertCount);
 		RecalculateTangentSpace();
 	}
-
-	if (_initShape)
-		InitShape(Transform3::identity());
-
-	CreateDeviceBuffers();
 }
 
 void BaseMesh::LoadPrimaryBones()
@@ -464,13 +566,19 @@ void BaseMesh::RecalculateTangentSpace()
 		DequantizeUsingDeq2D(_vBinding0[i]._tc0, _tc0Deq, vTex[i]);
 	}
 
-	Math::TangentSpaceTools::RecalculateNormals(_vIndices, vV, vN, 1);
+	if (!_vIndices.empty())
+		Math::TangentSpaceTools::RecalculateNormals(_vIndices, vV, vN, 1);
+	else
+		Math::TangentSpaceTools::RecalculateNormals(_vIndices32, vV, vN, 1);
 	VERUS_FOR(i, _vertCount)
 		Convert::SnormToSint8(&vN[i].x, _vBinding0[i]._nrm, 3);
 
 	if (!_vBinding2.empty())
 	{
-		Math::TangentSpaceTools::RecalculateTangentSpace(_vIndices, vV, vN, vTex, vTan, vBin);
+		if (!_vIndices.empty())
+			Math::TangentSpaceTools::RecalculateTangentSpace(_vIndices, vV, vN, vTex, vTan, vBin);
+		else
+			Math::TangentSpaceTools::RecalculateTangentSpace(_vIndices32, vV, vN, vTex, vTan, vBin);
 		VERUS_FOR(i, _vertCount)
 		{
 			Convert::SnormToSint16(&vTan[i].x, _vBinding2[i]._tan, 3);
@@ -704,3 +812,200 @@ String BaseMesh::ToObjString() const
 
 	return ss.str();
 }
+
+void BaseMesh::Benchmark()
+{
+	// Synthetic X3D files in memory, each vertex has position, normal, tangent space and texture coordinates:
+	class Writer
+	{
+		Vector<BYTE> _vData;
+		size_t       _blockOffset = 0;
+
+	public:
+		Writer(CSZ version)
+		{
+			Write("<X3D>" VERUS_CRNL VERUS_CRNL "<VN>", 13);
+			const BYTE len = static_cast<BYTE>(strlen(version));
+			Write(&len, 1);
+			Write(version, len);
+		}
+
+		void Write(const void* p, size_t size)
+		{
+			const BYTE* pData = static_cast<const BYTE*>(p);
+			_vData.insert(_vData.end(), pData, pData + size);
+		}
+
+		void WriteCount(int count)
+		{
+			const String s = std::to_string(count);
+			const BYTE len = static_cast<BYTE>(s.length());
+			Write(&len, 1);
+			Write(_C(s), len);
+		}
+
+		void BeginBlock(CSZ type)
+		{
+			Write(VERUS_CRNL VERUS_CRNL, 4);
+			Write(type, 4);
+			_blockOffset = _vData.size();
+			const INT64 zero = 0;
+			Write(&zero, sizeof(zero));
+		}
+
+		void EndBlock()
+		{
+			const INT64 size = _vData.size() - _blockOffset - sizeof(INT64);
+			memcpy(&_vData[_blockOffset], &size, sizeof(size));
+		}
+
+		Blob GetBlob() const { return Blob(_vData.data(), _vData.size()); }
+	};
+
+	auto MakeVersion31 = [](int side)
+	{
+		const int vertCount = side * side;
+		const int faceCount = (side - 1) * (side - 1) * 2;
+		Writer writer("3.1");
+		const float deq[6] = { 1, 1, 1, 0, 0, 0 };
+
+		writer.BeginBlock("<IX>");
+		writer.WriteCount(faceCount);
+		VERUS_FOR(i, side - 1)
+		{
+			VERUS_FOR(j, side - 1)
+			{
+				const UINT16 indices[6] =
+				{
+					static_cast<UINT16>(i * side + j), static_cast<UINT16>((i + 1) * side + j), static_cast<UINT16>(i * side + j + 1),
+					static_cast<UINT16>(i * side + j + 1), static_cast<UINT16>((i + 1) * side + j), static_cast<UINT16>((i + 1) * side + j + 1)
+				};
+				writer.Write(indices, sizeof(indices));
+			}
+		}
+		writer.EndBlock();
+
+		writer.BeginBlock("<VX>");
+		writer.WriteCount(vertCount);
+		writer.Write(deq, sizeof(deq));
+		VERUS_FOR(i, vertCount)
+		{
+			const short pos[3] = { static_cast<short>(i % side * 65534 / (side - 1) - SHRT_MAX), 0, static_cast<short>(i / side * 65534 / (side - 1) - SHRT_MAX) };
+			writer.Write(pos, sizeof(pos));
+		}
+		writer.EndBlock();
+
+		writer.BeginBlock("<NL>");
+		VERUS_FOR(i, vertCount)
+		{
+			const char nrm[3] = { 0, 127, 0 };
+			writer.Write(nrm, sizeof(nrm));
+		}
+		writer.EndBlock();
+
+		writer.BeginBlock("<TS>");
+		VERUS_FOR(i, vertCount)
+		{
+			const char tanBin[6] = { 127, 0, 0, 0, 0, 127 };
+			writer.Write(tanBin, sizeof(tanBin));
+		}
+		writer.EndBlock();
+
+		writer.BeginBlock("<T0>");
+		const float tc0Deq[4] = { 1, 1, 0, 0 };
+		writer.Write(tc0Deq, sizeof(tc0Deq));
+		VERUS_FOR(i, vertCount)
+		{
+			const short tc[2] = { static_cast<short>(i % side * 65534 / (side - 1) - SHRT_MAX), static_cast<short>(i / side * 65534 / (side - 1) - SHRT_MAX) };
+			writer.Write(tc, sizeof(tc));
+		}
+		writer.EndBlock();
+
+		return writer;
+	};
+
+	auto MakeVersion32 = [](int side)
+	{
+		const int vertCount = side * side;
+		const int indexCount = (side - 1) * (side - 1) * 6;
+		Writer writer("3.2");
+
+		X3DMeshHeader header = {};
+		header._vertCount = vertCount;
+		header._indexCount = indexCount;
+		header._flags = (vertCount > USHRT_MAX + 1) ? X3DFlags::indices32 : X3DFlags::none;
+		header._posDeq[0] = header._posDeq[1] = header._posDeq[2] = 1;
+		header._tc0Deq[0] = header._tc0Deq[1] = 1;
+		writer.BeginBlock("<MH>");
+		writer.Write(&header, sizeof(header));
+		writer.EndBlock();
+
+		Vector<UINT32> vIndices;
+		vIndices.reserve(indexCount);
+		VERUS_FOR(i, side - 1)
+		{
+			VERUS_FOR(j, side - 1)
+			{
+				const UINT32 indices[6] =
+				{
+					UINT32(i * side + j), UINT32((i + 1) * side + j), UINT32(i * side + j + 1),
+					UINT32(i * side + j + 1), UINT32((i + 1) * side + j), UINT32((i + 1) * side + j + 1)
+				};
+				vIndices.insert(vIndices.end(), indices, indices + 6);
+			}
+		}
+		writer.BeginBlock("<IB>");
+		if (header._flags & X3DFlags::indices32)
+		{
+			writer.Write(vIndices.data(), vIndices.size() * sizeof(UINT32));
+		}
+		else
+		{
+			const Vector<UINT16> vIndices16(vIndices.begin(), vIndices.end());
+			writer.Write(vIndices16.data(), vIndices16.size() * sizeof(UINT16));
+		}
+		writer.EndBlock();
+
+		Vector<VertexInputBinding0> vBinding0(vertCount);
+		Vector<VertexInputBinding2> vBinding2(vertCount);
+		VERUS_FOR(i, vertCount)
+		{
+			const short x = static_cast<short>(static_cast<INT64>(i % side) * 65534 / (side - 1) - SHRT_MAX);
+			const short z = static_cast<short>(static_cast<INT64>(i / side) * 65534 / (side - 1) - SHRT_MAX);
+			vBinding0[i]._pos[0] = x;
+			vBinding0[i]._pos[2] = z;
+			vBinding0[i]._tc0[0] = x;
+			vBinding0[i]._tc0[1] = z;
+			vBinding0[i]._nrm[1] = 127;
+			vBinding2[i]._tan[0] = SHRT_MAX;
+			vBinding2[i]._bin[2] = SHRT_MAX;
+		}
+		writer.BeginBlock("<B0>");
+		writer.Write(vBinding0.data(), vBinding0.size() * sizeof(VertexInputBinding0));
+		writer.EndBlock();
+		writer.BeginBlock("<B2>");
+		writer.Write(vBinding2.data(), vBinding2.size() * sizeof(VertexInputBinding2));
+		writer.EndBlock();
+
+		return writer;
+	};
+
+	auto Measure = [](RcBlob blob)
+	{
+		const int runCount = 5;
+		BaseMesh meshes[runCount]; // Destructors are not measured.
+		int index = 0;
+		return Utils::MeasureBestTime([&meshes, &index, &blob]() { meshes[index++].LoadX3D3(blob); }, runCount);
+	};
+
+	const int side = 256; // Largest mesh with 16-bit indices.
+	const Writer writer31 = MakeVersion31(side);
+	const Writer writer32 = MakeVersion32(side);
+	const double ms31 = Measure(writer31.GetBlob());
+	const double ms32 = Measure(writer32.GetBlob());
+	const Writer writerLarge = MakeVersion32(1024);
+	const double msLarge = Measure(writerLarge.GetBlob());
+
+	VERUS_LOG_INFO("Benchmark(); X3D 3.1: " << ms31 << " ms, 3.2: " << ms32 << " ms (" << side * side << " vertices)"
+		<< ", 3.2 with 32-bit indices: " << msLarge << " ms (" << 1024 * 1024 << " vertices)");
+}
@@ -7,7 +7,9 @@ namespace verus
 	{
 		class BaseMesh : public Object, public IO::AsyncDelegate, public AllocatorAware
 		{
-		protected:
+		public:
+			// X3D 3.2 stores vertex bindings, index buffer and meshlets exactly like they are in memory.
+			// Each block is loaded with one memcpy, older versions are converted.
 			struct VertexInputBinding0 // 16 bytes, common.
 			{
 				short _pos[4];
@@ -37,12 +39,46 @@ namespace verus
 			};
 			VERUS_TYPEDEFS(VertexInputBinding3);
 
+			// Small group of nearby triangles (up to 64 vertices and 124 triangles), which can be culled as a whole.
+			// Triangle is back facing if dot(normalize(center - eye), coneAxis) >= coneCutoff + radius / distance(center, eye).
+			struct Meshlet // 40 bytes.
+			{
+				UINT32 _firstIndex;
+				UINT32 _indexCount;
+				float  _center[3]; // Bounding sphere in mesh space.
+				float  _radius;
+				float  _coneAxis[3];
+				float  _coneCutoff; // One if there is no cone.
+			};
+			VERUS_TYPEDEFS(Meshlet);
+
+			enum class X3DFlags : UINT32
+			{
+				none = 0,
+				robotic = (1 << 0),
+				indices32 = (1 << 1)
+			};
+
+			// Header of the X3D 3.2 block <MH>:
+			struct X3DMeshHeader
+			{
+				UINT32   _vertCount;
+				UINT32   _indexCount;
+				X3DFlags _flags;
+				float    _posDeq[6];
+				float    _tc0Deq[4];
+				float    _tc1Deq[4];
+			};
+			VERUS_TYPEDEFS(X3DMeshHeader);
+
+		protected:
 			Vector<UINT16>              _vIndices;
 			Vector<UINT32>              _vIndices32;
 			Vector<VertexInputBinding0> _vBinding0;
 			Vector<VertexInputBinding1> _vBinding1;
 			Vector<VertexInputBinding2> _vBinding2;
 			Vector<VertexInputBinding3> _vBinding3;
+			Vector<Meshlet>             _vMeshlets;
 			Anim::Skeleton              _skeleton;
 			Anim::Warp                  _warp;
 			String                      _warpURL;
@@ -58,6 +94,8 @@ namespace verus
 			bool                        _loadOnly = false;
 			bool                        _robotic = false;
 			bool                        _initShape = false;
+			bool                        _loaded = false;
+			bool                        _asyncParsed = false; // Set by Async_Process, if Async_Commit should create resources.
 
 		public:
 			BaseMesh();
@@ -74,10 +112,13 @@ namespace verus
 			int GetBoneCount() const { return _boneCount; }
 
 			virtual void Async_WhenLoaded(CSZ url, RcBlob blob) override;
+			virtual void Async_Process(CSZ url, RcBlob blob) override;
+			virtual void Async_Commit(CSZ url, RcBlob blob) override;
 
-			VERUS_P(void Load(RcBlob blob));
+			// Only parses the data, GPU resources are created by Async_Commit:
+			VERUS_P(bool Load(RcBlob blob)); // Returns false for unsupported version.
 			VERUS_P(void LoadX3D3(RcBlob blob));
-			bool IsLoaded() const { return !!_vertCount; }
+			bool IsLoaded() const { return _loaded; }
 
 			// Load extra:
 			VERUS_P(void LoadPrimaryBones());
@@ -87,10 +128,13 @@ namespace verus
 			// Data:
 			const UINT16* GetIndices() const { return _vIndices.data(); }
 			const UINT32* GetIndices32() const { return _vIndices32.data(); }
+			UINT32 GetIndexAt(int index) const { return _vIndices.empty() ? _vIndices32[index] : _vIndices[index]; }
 			PcVertexInputBinding0 GetVertexInputBinding0() const { return _vBinding0.data(); }
 			PcVertexInputBinding1 GetVertexInputBinding1() const { return _vBinding1.data(); }
 			PcVertexInputBinding2 GetVertexInputBinding2() const { return _vBinding2.data(); }
 			PcVertexInputBinding3 GetVertexInputBinding3() const { return _vBinding3.data(); }
+			int GetMeshletCount() const { return Utils::Cast32(_vMeshlets.size()); }
+			PcMeshlet GetMeshlets() const { return _vMeshlets.data(); }
 
 			// Quantization / dequantization:
 			static void ComputeDeq(glm::vec3& scale, glm::vec3& bias, const glm::vec3& extents, const glm::vec3& minPos);
@@ -164,6 +208,9 @@ namespace verus
 
 			String ToXmlString() const;
 			String ToObjString() const;
+
+			// Compares X3D 3.1 and 3.2 loading, results are written to log:
+			static void Benchmark();
 		};
 		VERUS_TYPEDEFS(BaseMesh);
 	}
@@ -248,6 +248,7 @@ void Camera::LoadState(int slot)
 void MainCamera::operator=(RcMainCamera that)
 {
 	Camera::operator=(that);
+	_matPrevVP = that._matPrevVP; // Copy can be used for drawing, see BaseGame.
 	_currentFrame = UINT64_MAX;
 }
 
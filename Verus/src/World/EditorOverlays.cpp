@@ -210,20 +210,27 @@ void EditorOverlays::DrawCircle(PcTransform3 pMat, float radius, UINT32 color)
 
 void EditorOverlays::DrawTerrainCircle(RcPoint3 pos, float radius, UINT32 color, RTerrain terrain)
 {
-	CGI::DebugDraw::I().Begin(CGI::DebugDraw::Type::lines, nullptr, false);
 	const int lineCount = Utils::Cast32(_vCircle.size() >> 1);
-	Point3 a = VMath::scale(_vCircle[0]._pos, radius) + Vector3(pos);
-	float xz[2] = { a.getX(), a.getZ() };
-	a.setY(terrain.GetHeightAt(xz));
-	VERUS_FOR(i, lineCount)
+	const int pointCount = lineCount + 1;
+
+	// Heights of all points are found with one batch of rays:
+	Vector<Point3> vPoints(pointCount);
+	Vector<float> vXZ(pointCount * 2);
+	Vector<float> vHeights(pointCount);
+	VERUS_FOR(i, pointCount)
 	{
-		Point3 b = VMath::scale(_vCircle[(i << 1) + 1]._pos, radius) + Vector3(pos);
-		xz[0] = b.getX();
-		xz[1] = b.getZ();
-		b.setY(terrain.GetHeightAt(xz));
-		CGI::DebugDraw::I().AddLine(a, b, color);
-		a = b;
+		const int index = i ? ((i - 1) << 1) + 1 : 0;
+		vPoints[i] = VMath::scale(_vCircle[index]._pos, radius) + Vector3(pos);
+		vXZ[(i << 1) + 0] = vPoints[i].getX();
+		vXZ[(i << 1) + 1] = vPoints[i].getZ();
 	}
+	terrain.GetHeightsAt(vXZ.data(), vHeights.data(), pointCount);
+	VERUS_FOR(i, pointCount)
+		vPoints[i].setY(vHeights[i]);
+
+	CGI::DebugDraw::I().Begin(CGI::DebugDraw::Type::lines, nullptr, false);
+	VERUS_FOR(i, lineCount)
+		CGI::DebugDraw::I().AddLine(vPoints[i], vPoints[i + 1], color);
 	CGI::DebugDraw::I().End();
 }
 
@@ -65,9 +65,9 @@ void LightMapBaker::Init(RcDesc desc)
 		const int offset = i * 3;
 		const int indices[3] =
 		{
-			_desc._pMesh->GetIndices()[offset + 0],
-			_desc._pMesh->GetIndices()[offset + 1],
-			_desc._pMesh->GetIndices()[offset + 2]
+			static_cast<int>(_desc._pMesh->GetIndexAt(offset + 0)),
+			static_cast<int>(_desc._pMesh->GetIndexAt(offset + 1)),
+			static_cast<int>(_desc._pMesh->GetIndexAt(offset + 2))
 		};
 		_vFaces[i]._v[0] = vVerts[indices[0]];
 		_vFaces[i]._v[1] = vVerts[indices[1]];
@@ -118,6 +118,7 @@ namespace verus
 			int            _nPart = -1;
 			int            _xPart = -1;
 			int            _refCount = 0;
+			int            _sortRank = 0; // See WorldManager::SortVisibleNodes().
 
 			Material();
 			~Material();
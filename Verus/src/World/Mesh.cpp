@@ -608,7 +608,7 @@ void Mesh::ResetInstanceCount()
 void Mesh::PushInstance(RcTransform3 matW, RcVector4 instData)
 {
 	VERUS_RT_ASSERT(!_vInstanceBuffer.empty());
-	if (!_vertCount)
+	if (!_loaded)
 		return;
 	if (IsInstanceBufferFull())
 		return;
@@ -620,7 +620,7 @@ void Mesh::PushInstance(RcTransform3 matW, RcVector4 instData)
 bool Mesh::IsInstanceBufferFull()
 {
 	VERUS_RT_ASSERT(!_vInstanceBuffer.empty());
-	if (!_vertCount)
+	if (!_loaded)
 		return false;
 	return _instanceCount >= _instanceCapacity;
 }
@@ -628,7 +628,7 @@ bool Mesh::IsInstanceBufferFull()
 bool Mesh::IsInstanceBufferEmpty(bool fromFirstInstance)
 {
 	VERUS_RT_ASSERT(!_vInstanceBuffer.empty());
-	if (!_vertCount)
+	if (!_loaded)
 		return true;
 	return GetInstanceCount(fromFirstInstance) <= 0;
 }
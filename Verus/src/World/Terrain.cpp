@@ -720,6 +720,9 @@ void Terrain::Done()
 		s_shader[SHADER_MAIN]->FreeDescriptorSet(_cshFS);
 	}
 
+	if (CGI::Renderer::IsLoaded())
+		CGI::Renderer::I().GetDS().DoneByTerrain(_tex[TEX_HEIGHTMAP]);
+
 	_tex.Done();
 	_pipe.Done();
 	_geo.Done();
@@ -1068,6 +1071,24 @@ float Terrain::GetHeightAt(const float xz[2]) const
 	return 0;
 }
 
+void Terrain::GetHeightsAt(const float* pXZ, float* pHeights, int count) const
+{
+	VERUS_QREF_BULLET;
+
+	Vector<Physics::RayQuery> vQueries(count);
+	Vector<Physics::RayHit> vHits(count);
+	VERUS_FOR(i, count)
+	{
+		const float* xz = pXZ + (i << 1);
+		vQueries[i]._pointA = Point3(xz[0], 500, xz[1]);
+		vQueries[i]._pointB = Point3(xz[0], -500, xz[1]);
+		vQueries[i]._mask = Physics::Group::terrain;
+	}
+	bullet.RayTestBatch(vQueries.data(), vHits.data(), count);
+	VERUS_FOR(i, count)
+		pHeights[i] = vHits[i]._hit ? vHits[i]._point.getY() : 0;
+}
+
 float Terrain::GetHeightAt(RcPoint3 pos) const
 {
 	const float xz[2] = { pos.getX(), pos.getZ() };
@@ -240,6 +240,8 @@ namespace verus
 			static constexpr float ConvertHeight(short h) { return h * 0.01f; }
 			static constexpr int ConvertHeight(float h) { return static_cast<int>(h * 100); }
 			float GetHeightAt(const float xz[2]) const;
+			// Same as GetHeightAt for many points, pXZ has two values per point, rays are batched:
+			void GetHeightsAt(const float* pXZ, float* pHeights, int count) const;
 			float GetHeightAt(RcPoint3 pos) const;
 			float GetHeightAt(const int ij[2], int lod = 0, short* pRaw = nullptr) const;
 			void SetHeightAt(const int ij[2], short h);
@@ -78,93 +78,644 @@ void WorldManager::UpdateParts()
 
 void WorldManager::Layout()
 {
+	VERUS_PROFILE_SCOPE("WorldManager::Layout");
 	VERUS_QREF_ATMO;
 	VERUS_QREF_CONST_SETTINGS;
 
-	// Allocate enough space:
-	if (_vVisibleNodes.size() != _vNodes.size())
-		_vVisibleNodes.resize(_vNodes.size());
+	if (!_renderStatePublished) // Published state already has visible nodes for all passes.
+	{
+		// Allocate enough space:
+		if (_vVisibleNodes.size() != _vNodes.size())
+			_vVisibleNodes.resize(_vNodes.size());
+
+		_visibleCount = 0;
+		VERUS_ZERO_MEM(_visibleCountPerType);
+
+		// <Traverse>
+		PCamera pPrevPassCamera = nullptr;
+		// For CSM we need to create geometry beyond the view frustum (1st slice):
+		if (settings._sceneShadowQuality >= App::Settings::Quality::high && atmo.GetShadowMapBaker().IsBaking())
+		{
+			PCamera pPassCameraCSM = atmo.GetShadowMapBaker().GetPassCameraCSM();
+			if (pPassCameraCSM)
+				pPrevPassCamera = SetPassCamera(pPassCameraCSM);
+		}
+		_octree.TraverseVisible(_pPassCamera->GetFrustum());
+		// Back to original camera:
+		if (pPrevPassCamera)
+			SetPassCamera(pPrevPassCamera);
+		// </Traverse>
+
+		VERUS_RT_ASSERT(!_visibleCountPerType[+NodeType::unknown]);
+		SortVisibleNodes();
+
+		for (auto& x : TStoreTerrainNodes::_list)
+			x.Layout();
+	}
+}
+
+void WorldManager::PublishRenderState()
+{
+	VERUS_PROFILE_SCOPE("WorldManager::PublishRenderState");
+
+	// Shadow map camera from the last frame, the one which is drawn next is not known yet:
+	PCamera pPassCameraCSM = nullptr;
+	if (Atmosphere::IsValidSingleton() && Atmosphere::I().IsInitialized())
+		pPassCameraCSM = Atmosphere::I().GetShadowMapBaker().GetPassCameraCSM();
+
+	// Allocate enough space for both frustums:
+	if (_vVisibleNodes.size() < _vNodes.size() * 2)
+		_vVisibleNodes.resize(_vNodes.size() * 2);
 
 	_visibleCount = 0;
 	VERUS_ZERO_MEM(_visibleCountPerType);
 
 	// <Traverse>
-	PCamera pPrevPassCamera = nullptr;
-	// For CSM we need to create geometry beyond the view frustum (1st slice):
-	if (settings._sceneShadowQuality >= App::Settings::Quality::high && atmo.GetShadowMapBaker().IsBaking())
+	_octree.TraverseVisible(_pPassCamera->GetFrustum());
+	if (pPassCameraCSM)
 	{
-		PCamera pPassCameraCSM = atmo.GetShadowMapBaker().GetPassCameraCSM();
-		if (pPassCameraCSM)
-			pPrevPassCamera = SetPassCamera(pPassCameraCSM);
+		_octree.TraverseVisible(pPassCameraCSM->GetFrustum());
+
+		// Nodes in both frustums were added twice:
+		std::sort(_vVisibleNodes.begin(), _vVisibleNodes.begin() + _visibleCount);
+		_visibleCount = Utils::Cast32(std::unique(_vVisibleNodes.begin(), _vVisibleNodes.begin() + _visibleCount) - _vVisibleNodes.begin());
+		VERUS_ZERO_MEM(_visibleCountPerType);
+		VERUS_FOR(i, _visibleCount)
+			_visibleCountPerType[+_vVisibleNodes[i]->GetType()]++;
 	}
-	_octree.TraverseVisible(_pPassCamera->GetFrustum());
-	// Back to original camera:
-	if (pPrevPassCamera)
-		SetPassCamera(pPrevPassCamera);
 	// </Traverse>
 
 	VERUS_RT_ASSERT(!_visibleCountPerType[+NodeType::unknown]);
-	std::sort(_vVisibleNodes.begin(), _vVisibleNodes.begin() + _visibleCount, [](PBaseNode pA, PBaseNode pB)
+	SortVisibleNodes();
+	CopyVisibleNodes();
+
+	for (auto& x : TStoreTerrainNodes::_list)
+		x.Layout();
+
+	_renderStatePublished = true; // Before released models are deleted, see DeleteNode().
+	HoldRenderResources();
+}
+
+void WorldManager::UnpublishRenderState()
+{
+	ReleaseRenderResources(Utils::Cast32(_vRenderModelNodes.size()), Utils::Cast32(_vRenderMaterials.size()));
+	_vRenderBlocks.clear();
+	_vRenderLights.clear();
+	_renderStatePublished = false;
+}
+
+void WorldManager::HoldRenderResources()
+{
+	const int prevModelNodeCount = Utils::Cast32(_vRenderModelNodes.size());
+	const int prevMaterialCount = Utils::Cast32(_vRenderMaterials.size());
+
+	for (const auto& block : _vRenderBlocks)
+	{
+		_vRenderModelNodes.push_back(block._modelNode);
+		_vRenderMaterials.push_back(block._material);
+	}
+	std::sort(_vRenderModelNodes.begin() + prevModelNodeCount, _vRenderModelNodes.end());
+	std::sort(_vRenderMaterials.begin() + prevMaterialCount, _vRenderMaterials.end());
+	_vRenderModelNodes.erase(std::unique(_vRenderModelNodes.begin() + prevModelNodeCount, _vRenderModelNodes.end()), _vRenderModelNodes.end());
+	_vRenderMaterials.erase(std::unique(_vRenderMaterials.begin() + prevMaterialCount, _vRenderMaterials.end()), _vRenderMaterials.end());
+
+	// Add new references before the old ones are released:
+	for (int i = prevModelNodeCount; i < static_cast<int>(_vRenderModelNodes.size()); ++i)
+		_vRenderModelNodes[i]->AddRef();
+	for (int i = prevMaterialCount; i < static_cast<int>(_vRenderMaterials.size()); ++i)
+		_vRenderMaterials[i]->AddRef();
+
+	ReleaseRenderResources(prevModelNodeCount, prevMaterialCount);
+}
+
+void WorldManager::ReleaseRenderResources(int modelNodeCount, int materialCount)
+{
+	VERUS_QREF_MM;
+
+	VERUS_FOR(i, modelNodeCount)
+	{
+		PModelNode pModelNode = _vRenderModelNodes[i].Get();
+		if (pModelNode->GetRefCount() > 1)
+			pModelNode->Done(); // Some block nodes still use it.
+		else
+			DeleteNode(pModelNode); // Block nodes, which used it, were deleted.
+	}
+	_vRenderModelNodes.erase(_vRenderModelNodes.begin(), _vRenderModelNodes.begin() + modelNodeCount);
+
+	VERUS_FOR(i, materialCount)
+		mm.DeleteMaterial(_C(_vRenderMaterials[i]->_name));
+	_vRenderMaterials.erase(_vRenderMaterials.begin(), _vRenderMaterials.begin() + materialCount);
+}
+
+bool WorldManager::CompareVisibleNodes(PBaseNode pA, PBaseNode pB)
+{
+	// Sort by node type?
+	const NodeType typeA = pA->GetType();
+	const NodeType typeB = pB->GetType();
+	if (typeA != typeB)
+		return typeA < typeB;
+
+	// Both are blocks?
+	if (NodeType::block == typeA)
+	{
+		PBlockNode pBlockNodeA = static_cast<PBlockNode>(pA);
+		PBlockNode pBlockNodeB = static_cast<PBlockNode>(pB);
+		MaterialPtr materialA = pBlockNodeA->GetMaterial();
+		MaterialPtr materialB = pBlockNodeB->GetMaterial();
+
+		if (materialA && materialB) // A and B have materials, compare them.
+		{
+			const bool ab = *materialA < *materialB;
+			const bool ba = *materialB < *materialA;
+			if (ab || ba)
+				return ab;
+		}
+		else if (materialA) // A is with material, B is without, so A goes first.
+		{
+			return true;
+		}
+		else if (materialB) // A is without material, B is with, so B goes first.
 		{
-			// Sort by node type?
-			const NodeType typeA = pA->GetType();
-			const NodeType typeB = pB->GetType();
-			if (typeA != typeB)
-				return typeA < typeB;
-
-			// Both are blocks?
-			if (NodeType::block == typeA)
+			return false;
+		}
+
+		// Equal materials or none have any material, compare models used:
+		ModelNodePtr modelNodeA = pBlockNodeA->GetModelNode();
+		ModelNodePtr modelNodeB = pBlockNodeB->GetModelNode();
+		if (modelNodeA != modelNodeB)
+			return modelNodeA < modelNodeB;
+	}
+
+	// Both are lights?
+	if (NodeType::light == typeA)
+	{
+		PLightNode pLightNodeA = static_cast<PLightNode>(pA);
+		PLightNode pLightNodeB = static_cast<PLightNode>(pB);
+		const CGI::LightType lightTypeA = pLightNodeA->GetLightType();
+		const CGI::LightType lightTypeB = pLightNodeB->GetLightType();
+		if (lightTypeA != lightTypeB)
+			return lightTypeA < lightTypeB;
+	}
+
+	// Draw same node types front-to-back:
+	return pA->GetDistToHeadSq() < pB->GetDistToHeadSq();
+}
+
+void WorldManager::SortVisibleNodes()
+{
+	if (_visibleCount < 2)
+		return;
+
+	if (_vSortKeys.size() < _vVisibleNodes.size())
+	{
+		_vSortKeys.resize(_vVisibleNodes.size());
+		_vSortTempKeys.resize(_vVisibleNodes.size());
+		_vSortIndices.resize(_vVisibleNodes.size());
+		_vSortTempIndices.resize(_vVisibleNodes.size());
+		_vSortNodes.resize(_vVisibleNodes.size());
+	}
+
+	// Same order as CompareVisibleNodes, but in a single number:
+	// [63..59] node type, [58..32] material and model rank or light type, [31..0] distance.
+	// Distance is not negative, so float bits can be compared as integers.
+	VERUS_CT_ASSERT(+NodeType::count <= 32);
+	const RcPoint3 headPos = _pHeadCamera->GetEyePosition();
+	VERUS_FOR(i, _visibleCount)
+	{
+		PBaseNode pNode = _vVisibleNodes[i];
+		const NodeType type = pNode->GetType();
+		const float distSq = VMath::distSqr(headPos, pNode->GetPosition());
+		UINT32 distBits;
+		memcpy(&distBits, &distSq, sizeof(distBits));
+		UINT64 key = (static_cast<UINT64>(type) << 59) | distBits;
+		if (NodeType::block == type)
+		{
+			PBlockNode pBlockNode = static_cast<PBlockNode>(pNode);
+			if (pBlockNode->GetMaterial())
+				pBlockNode->GetMaterial()->_sortRank = -1;
+			if (pBlockNode->GetModelNode())
+				pBlockNode->GetModelNode()->SetSortRank(-1);
+		}
+		else if (NodeType::light == type)
+		{
+			PLightNode pLightNode = static_cast<PLightNode>(pNode);
+			key |= static_cast<UINT64>(pLightNode->GetLightType()) << 32;
+		}
+		_vSortKeys[i] = key;
+		_vSortIndices[i] = i;
+	}
+
+	if (_visibleCountPerType[+NodeType::block])
+	{
+		auto IsBlock = [this](int i)
+		{
+			return NodeType::block == static_cast<NodeType>(_vSortKeys[i] >> 59);
+		};
+
+		// Collect unique materials and models:
+		_vSortMaterials.clear();
+		_vSortModelNodes.clear();
+		VERUS_FOR(i, _visibleCount)
+		{
+			if (!IsBlock(i))
+				continue;
+			PBlockNode pBlockNode = static_cast<PBlockNode>(_vVisibleNodes[i]);
+			PMaterial pMaterial = pBlockNode->GetMaterial().Get();
+			if (pMaterial && -1 == pMaterial->_sortRank)
+			{
+				pMaterial->_sortRank = 0;
+				_vSortMaterials.push_back(pMaterial);
+			}
+			PModelNode pModelNode = pBlockNode->GetModelNode().Get();
+			if (pModelNode && -1 == pModelNode->GetSortRank())
+			{
+				pModelNode->SetSortRank(0);
+				_vSortModelNodes.push_back(pModelNode);
+			}
+		}
+
+		// Rank materials using Material::operator<, equal materials get the same rank:
+		std::sort(_vSortMaterials.begin(), _vSortMaterials.end(), [](PMaterial pA, PMaterial pB)
 			{
-				PBlockNode pBlockNodeA = static_cast<PBlockNode>(pA);
-				PBlockNode pBlockNodeB = static_cast<PBlockNode>(pB);
-				MaterialPtr materialA = pBlockNodeA->GetMaterial();
-				MaterialPtr materialB = pBlockNodeB->GetMaterial();
+				return *pA < *pB;
+			});
+		int rank = 0;
+		const int materialCount = Utils::Cast32(_vSortMaterials.size());
+		VERUS_FOR(i, materialCount)
+		{
+			if (i && *_vSortMaterials[i - 1] < *_vSortMaterials[i])
+				rank++;
+			_vSortMaterials[i]->_sortRank = rank;
+		}
+
+		// Models are compared by address, blocks without model have zero rank, like null pointer:
+		std::sort(_vSortModelNodes.begin(), _vSortModelNodes.end());
+		const int modelNodeCount = Utils::Cast32(_vSortModelNodes.size());
+		VERUS_FOR(i, modelNodeCount)
+			_vSortModelNodes[i]->SetSortRank(i + 1);
+
+		const int noMaterialRank = (1 << 13) - 1; // Blocks without material go last.
+		if (rank >= noMaterialRank || modelNodeCount >= (1 << 14))
+		{
+			// Doesn't fit into the key, this should never happen:
+			std::sort(_vVisibleNodes.begin(), _vVisibleNodes.begin() + _visibleCount, CompareVisibleNodes);
+			return;
+		}
 
-				if (materialA && materialB) // A and B have materials, compare them.
+		VERUS_FOR(i, _visibleCount)
+		{
+			if (!IsBlock(i))
+				continue;
+			PBlockNode pBlockNode = static_cast<PBlockNode>(_vVisibleNodes[i]);
+			const UINT64 materialRank = pBlockNode->GetMaterial() ? pBlockNode->GetMaterial()->_sortRank : noMaterialRank;
+			const UINT64 modelRank = pBlockNode->GetModelNode() ? pBlockNode->GetModelNode()->GetSortRank() : 0;
+			_vSortKeys[i] |= (materialRank << 46) | (modelRank << 32);
+		}
+	}
+
+	Math::RadixSort(_vSortKeys.data(), _vSortIndices.data(), _vSortTempKeys.data(), _vSortTempIndices.data(), _visibleCount);
+
+	VERUS_FOR(i, _visibleCount)
+		_vSortNodes[i] = _vVisibleNodes[_vSortIndices[i]];
+	std::copy(_vSortNodes.begin(), _vSortNodes.begin() + _visibleCount, _vVisibleNodes.begin());
+
+#ifdef _DEBUG
+	VERUS_RT_ASSERT(std::is_sorted(_vVisibleNodes.begin(), _vVisibleNodes.begin() + _visibleCount, CompareVisibleNodes));
+#endif
+}
+
+void WorldManager::CopyVisibleNodes()
+{
+	_vRenderBlocks.resize(_visibleCountPerType[+NodeType::block]);
+	_vRenderLights.resize(_visibleCountPerType[+NodeType::light]);
+
+	const int blockOffset = FindOffsetFor(NodeType::block);
+	VERUS_FOR(i, _visibleCountPerType[+NodeType::block])
+	{
+		PBlockNode pBlockNode = static_cast<PBlockNode>(_vVisibleNodes[blockOffset + i]);
+		RRenderBlock block = _vRenderBlocks[i];
+		block._matW = pBlockNode->GetTransform();
+		block._color = pBlockNode->GetColor();
+		block._modelNode = pBlockNode->GetModelNode();
+		block._material = pBlockNode->GetMaterial();
+	}
+
+	const int lightOffset = FindOffsetFor(NodeType::light);
+	VERUS_FOR(i, _visibleCountPerType[+NodeType::light])
+	{
+		PLightNode pLightNode = static_cast<PLightNode>(_vVisibleNodes[lightOffset + i]);
+		RRenderLight light = _vRenderLights[i];
+		light._matW = pLightNode->GetTransform();
+		light._instData = pLightNode->GetInstData();
+		light._lightType = pLightNode->GetLightType();
+	}
+}
+
+int WorldManager::GetDrawOffset(NodeType type) const
+{
+	return _renderStatePublished ? 0 : FindOffsetFor(type);
+}
+
+int WorldManager::GetDrawCount(NodeType type) const
+{
+	if (!_renderStatePublished)
+		return _visibleCountPerType[+type];
+	if (NodeType::block == type)
+		return Utils::Cast32(_vRenderBlocks.size());
+	if (NodeType::light == type)
+		return Utils::Cast32(_vRenderLights.size());
+	return 0;
+}
+
+WorldManager::DrawBlock WorldManager::GetDrawBlock(int index)
+{
+	DrawBlock block;
+	if (_renderStatePublished)
+	{
+		RcRenderBlock renderBlock = _vRenderBlocks[index];
+		block._pMatW = &renderBlock._matW;
+		block._pColor = &renderBlock._color;
+		block._modelNode = renderBlock._modelNode;
+		block._material = renderBlock._material;
+	}
+	else
+	{
+		PBlockNode pBlockNode = static_cast<PBlockNode>(_vVisibleNodes[index]);
+		block._pMatW = &pBlockNode->GetTransform();
+		block._pColor = &pBlockNode->GetColor();
+		block._modelNode = pBlockNode->GetModelNode();
+		block._material = pBlockNode->GetMaterial();
+	}
+	return block;
+}
+
+WorldManager::DrawLight WorldManager::GetDrawLight(int index)
+{
+	DrawLight light;
+	if (_renderStatePublished)
+	{
+		RcRenderLight renderLight = _vRenderLights[index];
+		light._pMatW = &renderLight._matW;
+		light._instData = renderLight._instData;
+		light._lightType = renderLight._lightType;
+	}
+	else
+	{
+		PLightNode pLightNode = static_cast<PLightNode>(_vVisibleNodes[index]);
+		light._pMatW = &pLightNode->GetTransform();
+		light._instData = pLightNode->GetInstData();
+		light._lightType = pLightNode->GetLightType();
+	}
+	return light;
+}
+
+void WorldManager::BenchmarkSortVisibleNodes()
+{
+	// Stand-ins for blocks and lights, which need no content. Like real nodes, they are allocated one by one
+	// and compared through pointers, models by address and materials like Material::operator<:
+	struct FakeMaterial
+	{
+		String _name;
+		void*  _pTex = nullptr;
+		int    _blending = 0;
+		int    _sortRank = 0;
+
+		bool operator<(const FakeMaterial& that) const
+		{
+			if (_blending != that._blending)
+				return _blending < that._blending;
+			if (_pTex != that._pTex)
+				return _pTex < that._pTex;
+			return _name < that._name;
+		}
+	};
+	struct FakeModel
+	{
+		int _sortRank = 0;
+	};
+	struct FakeNode
+	{
+		FakeMaterial*  _pMaterial = nullptr;
+		FakeModel*     _pModel = nullptr;
+		Point3         _pos = Point3(0);
+		NodeType       _type = NodeType::block;
+		CGI::LightType _lightType = CGI::LightType::none;
+
+		virtual ~FakeNode() {}
+		virtual NodeType GetType() const { return _type; }
+	};
+
+	const int count = 20000;
+	const int materialCount = 200;
+	const int modelCount = 100;
+
+	Random random(1234);
+	Vector<std::unique_ptr<FakeMaterial>> vMaterials(materialCount);
+	VERUS_FOR(i, materialCount)
+	{
+		vMaterials[i] = std::make_unique<FakeMaterial>();
+		vMaterials[i]->_name = "Material" + std::to_string(i);
+		vMaterials[i]->_pTex = reinterpret_cast<void*>(static_cast<INT64>(random.Next(1, 50)));
+		vMaterials[i]->_blending = random.Next(0, 1);
+	}
+	Vector<std::unique_ptr<FakeModel>> vModels(modelCount);
+	VERUS_FOR(i, modelCount)
+		vModels[i] = std::make_unique<FakeModel>();
+	Vector<std::unique_ptr<FakeNode>> vNodes(count);
+	Vector<FakeNode*> vShuffled(count);
+	VERUS_FOR(i, count)
+	{
+		vNodes[i] = std::make_unique<FakeNode>();
+		FakeNode* pNode = vNodes[i].get();
+		pNode->_pos = Point3(random.NextFloat(-500, 500), random.NextFloat(0, 50), random.NextFloat(-500, 500));
+		if (random.Next(0, 9))
+		{
+			// Some blocks have no material or no model:
+			pNode->_type = NodeType::block;
+			pNode->_pMaterial = random.Next(0, 49) ? vMaterials[random.Next(0, materialCount - 1)].get() : nullptr;
+			pNode->_pModel = random.Next(0, 49) ? vModels[random.Next(0, modelCount - 1)].get() : nullptr;
+		}
+		else
+		{
+			pNode->_type = NodeType::light;
+			pNode->_lightType = static_cast<CGI::LightType>(random.Next(+CGI::LightType::dir, +CGI::LightType::spot));
+		}
+		vShuffled[i] = pNode;
+	}
+	std::shuffle(vShuffled.begin(), vShuffled.end(), random.GetGenerator());
+	const Point3 headPos(0, 10, 0);
+
+	// Same order as CompareVisibleNodes:
+	Vector<FakeNode*> vSorted(count);
+	const double sortMs = Utils::MeasureBestTime([&vShuffled, &vSorted, &headPos]()
+		{
+			std::copy(vShuffled.begin(), vShuffled.end(), vSorted.begin());
+			std::sort(vSorted.begin(), vSorted.end(), [&headPos](FakeNode* pA, FakeNode* pB)
 				{
-					const bool ab = *materialA < *materialB;
-					const bool ba = *materialB < *materialA;
-					if (ab || ba)
-						return ab;
-				}
-				else if (materialA) // A is with material, B is without, so A goes first.
+					if (pA->GetType() != pB->GetType())
+						return pA->GetType() < pB->GetType();
+					if (NodeType::block == pA->GetType())
+					{
+						if (pA->_pMaterial && pB->_pMaterial)
+						{
+							const bool ab = *pA->_pMaterial < *pB->_pMaterial;
+							const bool ba = *pB->_pMaterial < *pA->_pMaterial;
+							if (ab || ba)
+								return ab;
+						}
+						else if (pA->_pMaterial != pB->_pMaterial)
+						{
+							return pA->_pMaterial != nullptr; // Blocks without material go last.
+						}
+						if (pA->_pModel != pB->_pModel)
+							return pA->_pModel < pB->_pModel;
+					}
+					else if (NodeType::light == pA->GetType())
+					{
+						if (pA->_lightType != pB->_lightType)
+							return pA->_lightType < pB->_lightType;
+					}
+					const float distSqA = VMath::distSqr(headPos, pA->_pos);
+					const float distSqB = VMath::distSqr(headPos, pB->_pos);
+					return distSqA < distSqB;
+				});
+		});
+
+	// Same steps as SortVisibleNodes:
+	Vector<UINT64> vKeys(count), vTempKeys(count);
+	Vector<UINT32> vIndices(count), vTempIndices(count);
+	Vector<FakeMaterial*> vSortMaterials;
+	Vector<FakeModel*> vSortModels;
+	const double radixMs = Utils::MeasureBestTime([&]()
+		{
+			VERUS_FOR(i, count)
+			{
+				FakeNode* pNode = vShuffled[i];
+				const NodeType type = pNode->GetType();
+				const float distSq = VMath::distSqr(headPos, pNode->_pos);
+				UINT32 distBits;
+				memcpy(&distBits, &distSq, sizeof(distBits));
+				UINT64 key = (static_cast<UINT64>(type) << 59) | distBits;
+				if (NodeType::block == type)
 				{
-					return true;
+					if (pNode->_pMaterial)
+						pNode->_pMaterial->_sortRank = -1;
+					if (pNode->_pModel)
+						pNode->_pModel->_sortRank = -1;
 				}
-				else if (materialB) // A is without material, B is with, so B goes first.
+				else if (NodeType::light == type)
 				{
-					return false;
+					key |= static_cast<UINT64>(pNode->_lightType) << 32;
 				}
+				vKeys[i] = key;
+				vIndices[i] = i;
+			}
 
-				// Equal materials or none have any material, compare models used:
-				ModelNodePtr modelNodeA = pBlockNodeA->GetModelNode();
-				ModelNodePtr modelNodeB = pBlockNodeB->GetModelNode();
-				if (modelNodeA != modelNodeB)
-					return modelNodeA < modelNodeB;
+			vSortMaterials.clear();
+			vSortModels.clear();
+			VERUS_FOR(i, count)
+			{
+				FakeNode* pNode = vShuffled[i];
+				if (NodeType::block != pNode->GetType())
+					continue;
+				if (pNode->_pMaterial && -1 == pNode->_pMaterial->_sortRank)
+				{
+					pNode->_pMaterial->_sortRank = 0;
+					vSortMaterials.push_back(pNode->_pMaterial);
+				}
+				if (pNode->_pModel && -1 == pNode->_pModel->_sortRank)
+				{
+					pNode->_pModel->_sortRank = 0;
+					vSortModels.push_back(pNode->_pModel);
+				}
+			}
+			std::sort(vSortMaterials.begin(), vSortMaterials.end(), [](FakeMaterial* pA, FakeMaterial* pB) { return *pA < *pB; });
+			int rank = 0;
+			const int sortMaterialCount = Utils::Cast32(vSortMaterials.size());
+			VERUS_FOR(i, sortMaterialCount)
+			{
+				if (i && *vSortMaterials[i - 1] < *vSortMaterials[i])
+					rank++;
+				vSortMaterials[i]->_sortRank = rank;
 			}
+			std::sort(vSortModels.begin(), vSortModels.end());
+			const int sortModelCount = Utils::Cast32(vSortModels.size());
+			VERUS_FOR(i, sortModelCount)
+				vSortModels[i]->_sortRank = i + 1;
 
-			// Both are lights?
-			if (NodeType::light == typeA)
+			const int noMaterialRank = (1 << 13) - 1;
+			VERUS_FOR(i, count)
 			{
-				PLightNode pLightNodeA = static_cast<PLightNode>(pA);
-				PLightNode pLightNodeB = static_cast<PLightNode>(pB);
-				const CGI::LightType lightTypeA = pLightNodeA->GetLightType();
-				const CGI::LightType lightTypeB = pLightNodeB->GetLightType();
-				if (lightTypeA != lightTypeB)
-					return lightTypeA < lightTypeB;
+				FakeNode* pNode = vShuffled[i];
+				if (NodeType::block != pNode->GetType())
+					continue;
+				const UINT64 materialRank = pNode->_pMaterial ? pNode->_pMaterial->_sortRank : noMaterialRank;
+				const UINT64 modelRank = pNode->_pModel ? pNode->_pModel->_sortRank : 0;
+				vKeys[i] |= (materialRank << 46) | (modelRank << 32);
 			}
 
-			// Draw same node types front-to-back:
-			return pA->GetDistToHeadSq() < pB->GetDistToHeadSq();
+			Math::RadixSort(vKeys.data(), vIndices.data(), vTempKeys.data(), vTempIndices.data(), count);
 		});
 
-	for (auto& x : TStoreTerrainNodes::_list)
-		x.Layout();
+	bool same = true;
+	VERUS_FOR(i, count)
+	{
+		if (vSorted[i] != vShuffled[vIndices[i]])
+		{
+			same = false;
+			break;
+		}
+	}
+
+	VERUS_LOG_INFO("BenchmarkSortVisibleNodes(); " << count << " synthetic nodes, std::sort: " << sortMs << " ms, radix sort: " << radixMs << " ms, same order: " << same);
+}
+
+void WorldManager::BenchmarkSortWorldNodes()
+{
+	// Uses all nodes of the loaded world, as if they were all visible, in random order:
+	const int count = Utils::Cast32(_vNodes.size());
+	if (count < 2 || !_pHeadCamera)
+		return;
+
+	const Vector<PBaseNode> vVisibleNodes = _vVisibleNodes;
+	const int visibleCount = _visibleCount;
+	int visibleCountPerType[+NodeType::count];
+	memcpy(visibleCountPerType, _visibleCountPerType, sizeof(visibleCountPerType));
+
+	Random random(1234);
+	Vector<PBaseNode> vShuffled = _vNodes;
+	std::shuffle(vShuffled.begin(), vShuffled.end(), random.GetGenerator());
+
+	_vVisibleNodes.resize(count);
+	_visibleCount = count;
+	VERUS_ZERO_MEM(_visibleCountPerType);
+	for (auto pNode : vShuffled)
+		_visibleCountPerType[+pNode->GetType()]++;
+
+	// Both include copying of the input:
+	const double sortMs = Utils::MeasureBestTime([this, &vShuffled]()
+		{
+			std::copy(vShuffled.begin(), vShuffled.end(), _vVisibleNodes.begin());
+			std::sort(_vVisibleNodes.begin(), _vVisibleNodes.begin() + _visibleCount, CompareVisibleNodes);
+		});
+	const double radixMs = Utils::MeasureBestTime([this, &vShuffled]()
+		{
+			std::copy(vShuffled.begin(), vShuffled.end(), _vVisibleNodes.begin());
+			SortVisibleNodes();
+		});
+	const bool sorted = std::is_sorted(_vVisibleNodes.begin(), _vVisibleNodes.begin() + _visibleCount, CompareVisibleNodes);
+
+	_vVisibleNodes = vVisibleNodes;
+	_visibleCount = visibleCount;
+	memcpy(_visibleCountPerType, visibleCountPerType, sizeof(_visibleCountPerType));
+
+	VERUS_LOG_INFO("BenchmarkSortWorldNodes(); " << count << " nodes, std::sort: " << sortMs << " ms, radix sort: " << radixMs << " ms, sorted: " << sorted);
 }
 
 void WorldManager::Draw()
 {
-	if (!_visibleCountPerType[+NodeType::block])
+	const int count = GetDrawCount(NodeType::block);
+	if (!count)
 		return;
 
 	VERUS_QREF_RENDERER;
@@ -176,8 +727,8 @@ void WorldManager::Draw()
 	auto cb = renderer.GetCommandBuffer();
 	auto shader = Mesh::GetShader();
 
-	const int begin = FindOffsetFor(NodeType::block);
-	const int end = begin + _visibleCountPerType[+NodeType::block];
+	const int begin = GetDrawOffset(NodeType::block);
+	const int end = begin + count;
 	shader->BeginBindDescriptors();
 	for (int i = begin; i <= end; ++i)
 	{
@@ -188,10 +739,9 @@ void WorldManager::Draw()
 			break;
 		}
 
-		PBaseNode pNode = _vVisibleNodes[i];
-		PBlockNode pBlockNode = static_cast<PBlockNode>(pNode);
-		ModelNodePtr nextModelNode = pBlockNode->GetModelNode();
-		MaterialPtr nextMaterial = pBlockNode->GetMaterial();
+		const DrawBlock block = GetDrawBlock(i);
+		ModelNodePtr nextModelNode = block._modelNode;
+		MaterialPtr nextMaterial = block._material;
 
 		if (!nextModelNode->IsLoaded() || !nextMaterial->IsLoaded())
 			continue; // Not ready.
@@ -225,14 +775,15 @@ void WorldManager::Draw()
 		}
 
 		if (modelNode)
-			modelNode->PushInstance(pBlockNode->GetTransform(), pBlockNode->GetColor());
+			modelNode->PushInstance(*block._pMatW, *block._pColor);
 	}
 	shader->EndBindDescriptors();
 }
 
 void WorldManager::DrawSimple(DrawSimpleMode mode)
 {
-	if (!_visibleCountPerType[+NodeType::block])
+	const int count = GetDrawCount(NodeType::block);
+	if (!count)
 		return;
 
 	VERUS_QREF_RENDERER;
@@ -244,8 +795,8 @@ void WorldManager::DrawSimple(DrawSimpleMode mode)
 	auto cb = renderer.GetCommandBuffer();
 	auto shader = Mesh::GetSimpleShader();
 
-	const int begin = FindOffsetFor(NodeType::block);
-	const int end = begin + _visibleCountPerType[+NodeType::block];
+	const int begin = GetDrawOffset(NodeType::block);
+	const int end = begin + count;
 	shader->BeginBindDescriptors();
 	for (int i = begin; i <= end; ++i)
 	{
@@ -256,10 +807,9 @@ void WorldManager::DrawSimple(DrawSimpleMode mode)
 			break;
 		}
 
-		PBaseNode pNode = _vVisibleNodes[i];
-		PBlockNode pBlockNode = static_cast<PBlockNode>(pNode);
-		ModelNodePtr nextModelNode = pBlockNode->GetModelNode();
-		MaterialPtr nextMaterial = pBlockNode->GetMaterial();
+		const DrawBlock block = GetDrawBlock(i);
+		ModelNodePtr nextModelNode = block._modelNode;
+		MaterialPtr nextMaterial = block._material;
 
 		if (!nextModelNode->IsLoaded() || !nextMaterial->IsLoaded())
 			continue; // Not ready.
@@ -293,7 +843,7 @@ void WorldManager::DrawSimple(DrawSimpleMode mode)
 		}
 
 		if (modelNode)
-			modelNode->PushInstance(pBlockNode->GetTransform(), pBlockNode->GetColor());
+			modelNode->PushInstance(*block._pMatW, *block._pColor);
 	}
 	shader->EndBindDescriptors();
 }
@@ -318,7 +868,8 @@ void WorldManager::DrawTerrainNodesSimple(DrawSimpleMode mode)
 
 void WorldManager::DrawLights()
 {
-	if (!_visibleCountPerType[+NodeType::light])
+	const int count = GetDrawCount(NodeType::light);
+	if (!count)
 		return;
 
 	VERUS_QREF_RENDERER;
@@ -340,8 +891,8 @@ void WorldManager::DrawLights()
 		}
 	};
 
-	const int begin = FindOffsetFor(NodeType::light);
-	const int end = begin + _visibleCountPerType[+NodeType::light];
+	const int begin = GetDrawOffset(NodeType::light);
+	const int end = begin + count;
 	for (int i = begin; i <= end; ++i)
 	{
 		if (i == end)
@@ -350,9 +901,8 @@ void WorldManager::DrawLights()
 			break;
 		}
 
-		PBaseNode pNode = _vVisibleNodes[i];
-		PLightNode pLightNode = static_cast<PLightNode>(pNode);
-		const CGI::LightType nextType = pLightNode->GetLightType();
+		const DrawLight light = GetDrawLight(i);
+		const CGI::LightType nextType = light._lightType;
 
 		if (nextType != type)
 		{
@@ -376,14 +926,14 @@ void WorldManager::DrawLights()
 #ifdef VERUS_RELEASE_DEBUG
 		if (CGI::LightType::dir == type) // Must not be scaled!
 		{
-			RcTransform3 matW = pLightNode->GetTransform();
+			RcTransform3 matW = *light._pMatW;
 			const Vector3 s = matW.GetScale();
 			VERUS_RT_ASSERT(glm::all(glm::epsilonEqual(s.GLM(), glm::vec3(1), glm::vec3(VERUS_FLOAT_THRESHOLD))));
 		}
 #endif
 
 		if (pMesh)
-			pMesh->PushInstance(pLightNode->GetTransform(), pLightNode->GetInstData());
+			pMesh->PushInstance(*light._pMatW, light._instData);
 	}
 }
 
@@ -453,6 +1003,19 @@ Continue WorldManager::Octree_ProcessNode(void* pToken, void* pUser)
 	return Continue::yes;
 }
 
+Continue WorldManager::Octree_ProcessNodes(void* const* ppTokens, int count, void* pUser)
+{
+	VERUS_FOR(i, count)
+	{
+		PBaseNode pNode = static_cast<PBaseNode>(ppTokens[i]);
+		if (pNode->IsDisabled())
+			continue;
+		_vVisibleNodes[_visibleCount++] = pNode;
+		_visibleCountPerType[+pNode->GetType()]++;
+	}
+	return Continue::yes;
+}
+
 bool WorldManager::RayTest(RcPoint3 pointA, RcPoint3 pointB, Physics::Group mask)
 {
 	return RayTestEx(pointA, pointB, nullptr, nullptr, nullptr, nullptr, mask);
@@ -542,18 +1105,52 @@ bool WorldManager::RayTestEx(RcPoint3 pointA, RcPoint3 pointB, PBlockNodePtr pBl
 	return false;
 }
 
+void WorldManager::RayTestBatch(const Physics::RayQuery* pQueries, Physics::PRayHit pHits, int count, PBaseNode* pNodes)
+{
+	VERUS_QREF_BULLET;
+	bullet.RayTestBatch(pQueries, pHits, count);
+	if (!pNodes)
+		return;
+	VERUS_FOR(i, count)
+	{
+		pNodes[i] = nullptr;
+		Physics::PUserPtr p = pHits[i]._pUserPtr;
+		if (!p)
+			continue;
+		const int type = p->UserPtr_GetType();
+		if (type != +NodeType::terrain && type != +NodeType::character && type != +NodeType::vehicle)
+			pNodes[i] = static_cast<PBaseNode>(p);
+	}
+}
+
 Matrix3 WorldManager::GetBasisAt(RcPoint3 point, Physics::Group mask) const
+{
+	Matrix3 basis;
+	GetBasisAt(&point, &basis, 1, mask);
+	return basis;
+}
+
+void WorldManager::GetBasisAt(const Point3* pPoints, PMatrix3 pBases, int count, Physics::Group mask) const
 {
 	VERUS_QREF_BULLET;
-	const btVector3 from = point.Bullet();
-	const btVector3 to = from - btVector3(0, 100, 0);
-	btCollisionWorld::ClosestRayResultCallback crrc(from, to);
-	crrc.m_collisionFilterGroup = +Physics::Group::ray;
-	crrc.m_collisionFilterMask = +mask;
-	bullet.GetWorld()->rayTest(from, to, crrc);
-	if (crrc.hasHit())
-	{
-		glm::vec3 nreal = Vector3(crrc.m_hitNormalWorld).GLM(), nrm(0, 1, 0), tan(1, 0, 0), bin(0, 0, 1);
+	Vector<Physics::RayQuery> vQueries(count);
+	Vector<Physics::RayHit> vHits(count);
+	VERUS_FOR(i, count)
+	{
+		vQueries[i]._pointA = pPoints[i];
+		vQueries[i]._pointB = pPoints[i] - Vector3(0, 100, 0);
+		vQueries[i]._mask = mask;
+	}
+	bullet.RayTestBatch(vQueries.data(), vHits.data(), count);
+
+	VERUS_FOR(i, count)
+	{
+		if (!vHits[i]._hit)
+		{
+			pBases[i] = Matrix3::identity();
+			continue;
+		}
+		glm::vec3 nreal = vHits[i]._normal.GLM(), nrm(0, 1, 0), tan(1, 0, 0), bin(0, 0, 1);
 		const float angle = glm::angle(nrm, nreal);
 		VERUS_RT_ASSERT(angle <= VERUS_PI * 0.5f);
 		if (angle >= Math::ToRadians(1))
@@ -564,10 +1161,8 @@ Matrix3 WorldManager::GetBasisAt(RcPoint3 point, Physics::Group mask) const
 			tan = mat * tan;
 			bin = mat * bin;
 		}
-		return Matrix3(Vector3(tan), Vector3(nreal), Vector3(bin));
+		pBases[i] = Matrix3(Vector3(tan), Vector3(nreal), Vector3(bin));
 	}
-	else
-		return Matrix3::identity();
 }
 
 btBoxShape* WorldManager::GetPickingShape()
@@ -822,6 +1417,8 @@ void WorldManager::DeleteNode(NodeType type, CSZ name, bool hierarchy)
 
 void WorldManager::DeleteAllNodes()
 {
+	if (_renderStatePublished) // Held references would keep models.
+		UnpublishRenderState();
 	while (!_vNodes.empty())
 		DeleteNode(_vNodes.back());
 }
@@ -31,6 +31,42 @@ namespace verus
 			private TStorePathNodes, private TStorePhysicsNodes, private TStorePrefabNodes,
 			private TStoreShakerNodes, private TStoreSoundNodes, private TStoreTerrainNodes
 		{
+			// Draw methods use these copies instead of the nodes, see PublishRenderState():
+			struct RenderBlock
+			{
+				Transform3   _matW;
+				Vector4      _color;
+				ModelNodePtr _modelNode;
+				MaterialPtr  _material;
+			};
+			VERUS_TYPEDEFS(RenderBlock);
+
+			struct RenderLight
+			{
+				Transform3     _matW;
+				Vector4        _instData;
+				CGI::LightType _lightType = CGI::LightType::none;
+			};
+			VERUS_TYPEDEFS(RenderLight);
+
+			// Points to the published copy or, when nothing is published, to the visible node:
+			struct DrawBlock
+			{
+				PcTransform3 _pMatW = nullptr;
+				PcVector4    _pColor = nullptr;
+				ModelNodePtr _modelNode;
+				MaterialPtr  _material;
+			};
+			VERUS_TYPEDEFS(DrawBlock);
+
+			struct DrawLight
+			{
+				PcTransform3   _pMatW = nullptr;
+				Vector4        _instData;
+				CGI::LightType _lightType = CGI::LightType::none;
+			};
+			VERUS_TYPEDEFS(DrawLight);
+
 			Math::Octree         _octree;
 			LocalPtr<btBoxShape> _pPickingShape;
 			PCamera              _pPassCamera = nullptr; // Render pass camera for getting view and projection matrices.
@@ -38,12 +74,24 @@ namespace verus
 			PMainCamera          _pViewCamera = nullptr; // Current view camera which is valid only inside DrawView method (eye camera).
 			Vector<PBaseNode>    _vNodes;
 			Vector<PBaseNode>    _vVisibleNodes;
+			Vector<PBaseNode>    _vSortNodes;
+			Vector<UINT64>       _vSortKeys;
+			Vector<UINT64>       _vSortTempKeys;
+			Vector<UINT32>       _vSortIndices;
+			Vector<UINT32>       _vSortTempIndices;
+			Vector<PMaterial>    _vSortMaterials;
+			Vector<PModelNode>   _vSortModelNodes;
+			Vector<RenderBlock>  _vRenderBlocks;
+			Vector<RenderLight>  _vRenderLights;
+			Vector<ModelNodePtr> _vRenderModelNodes; // References, which are held by published state.
+			Vector<MaterialPtr>  _vRenderMaterials; // References, which are held by published state.
 			Random               _random;
 			int                  _visibleCount = 0;
 			int                  _visibleCountPerType[+NodeType::count];
 			int                  _worldSide = 0;
 			int                  _recursionDepth = 0;
 			float                _pickingShapeHalfExtent = 0.05f;
+			bool                 _renderStatePublished = false;
 
 		public:
 			struct Desc
@@ -89,6 +137,20 @@ namespace verus
 			void DrawSelectedRelationshipLines();
 			void DrawEditorOverlays(DrawEditorOverlaysFlags flags);
 
+			// <RenderState>
+			// Pipelined frames: nodes are changed by update, while the previous frame is drawn. This method must be called
+			// at the sync point; it does the layout for head camera, shadow map camera and terrain nodes, and copies visible
+			// blocks and lights, with their world matrices and instance data. Until unpublished, Layout() does nothing and
+			// Draw methods use only this copy. Selected bounds and editor overlays still use the nodes. Terrain, forest,
+			// water, atmosphere and particles are not copied, so BaseGame doesn't pipeline frames, which use them.
+			void PublishRenderState();
+			void UnpublishRenderState();
+			bool IsRenderStatePublished() const { return _renderStatePublished; }
+			// Models and materials, which are used by the copy, are not deleted, until the next sync point:
+			void HoldRenderResources();
+			void ReleaseRenderResources(int modelNodeCount, int materialCount);
+			// </RenderState>
+
 			static bool IsDrawingDepth(DrawDepth dd);
 
 			static int GetEditorOverlaysAlpha(int originalAlpha, float distSq, float fadeDistSq);
@@ -106,12 +168,18 @@ namespace verus
 			// Octree (Acceleration Structure):
 			Math::ROctree GetOctree() { return _octree; }
 			virtual Continue Octree_ProcessNode(void* pToken, void* pUser) override;
+			virtual Continue Octree_ProcessNodes(void* const* ppTokens, int count, void* pUser) override;
 
 			bool RayTest(RcPoint3 pointA, RcPoint3 pointB, Physics::Group mask = Physics::Group::all);
 			bool RayTestEx(RcPoint3 pointA, RcPoint3 pointB, PBlockNodePtr pBlock = nullptr,
 				PPoint3 pPoint = nullptr, PVector3 pNormal = nullptr, const float* pRadius = nullptr,
 				Physics::Group mask = Physics::Group::all);
+			// Many independent rays and sphere sweeps, which are tested in parallel. For each hit, which is not
+			// terrain, character or vehicle, pNodes (can be nullptr) gets the node:
+			void RayTestBatch(const Physics::RayQuery* pQueries, Physics::PRayHit pHits, int count, PBaseNode* pNodes = nullptr);
 			Matrix3 GetBasisAt(RcPoint3 point, Physics::Group mask = Physics::Group::immovable) const;
+			// Same as GetBasisAt for many points, rays are batched:
+			void GetBasisAt(const Point3* pPoints, PMatrix3 pBases, int count, Physics::Group mask = Physics::Group::immovable) const;
 
 			btBoxShape* GetPickingShape();
 			float GetPickingShapeHalfExtent() const { return _pickingShapeHalfExtent; }
@@ -376,6 +444,20 @@ namespace verus
 			String EnsureUniqueName(CSZ name, PcBaseNode pSkipNode = nullptr);
 			void SortNodes();
 			int FindOffsetFor(NodeType type) const;
+			// Visible nodes are sorted using radix sort and 64-bit keys, which give the same order as this function:
+			static bool CompareVisibleNodes(PBaseNode pA, PBaseNode pB);
+			void SortVisibleNodes();
+			// Copies sorted visible blocks and lights for draw methods, only for published state:
+			void CopyVisibleNodes();
+			// Draw methods read published copy, if there is one, otherwise visible nodes, in range [offset, offset + count):
+			int GetDrawOffset(NodeType type) const;
+			int GetDrawCount(NodeType type) const;
+			DrawBlock GetDrawBlock(int index);
+			DrawLight GetDrawLight(int index);
+			// Compares comparison-based sort with radix sort on synthetic blocks and lights, results are written to log:
+			static void BenchmarkSortVisibleNodes();
+			// Same, but on all nodes of the loaded world, does nothing if it's empty:
+			void BenchmarkSortWorldNodes();
 
 			int GetNodeCount(int* pPerType = nullptr, bool excludeGenerated = false) const;
 			int GetIndexOf(PcBaseNode pTargetNode, bool excludeGenerated = false) const;
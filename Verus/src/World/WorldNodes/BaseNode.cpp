@@ -507,9 +507,12 @@ void BaseNode::UpdateRigidBodyTransform()
 	{
 		// https://pybullet.org/Bullet/phpBB3/viewtopic.php?t=6729
 		VERUS_QREF_BULLET;
-		_pRigidBody->setWorldTransform(_trGlobal.Bullet());
-		_pRigidBody->getMotionState()->setWorldTransform(_trGlobal.Bullet());
-		bullet.GetWorld()->updateSingleAabb(_pRigidBody);
+		btDiscreteDynamicsWorld* pWorld = bullet.GetWorld(); // Wait for async step before changing the body.
+		const btTransform tr = _trGlobal.Bullet();
+		_pRigidBody->setWorldTransform(tr);
+		_pRigidBody->getMotionState()->setWorldTransform(tr);
+		pWorld->updateSingleAabb(_pRigidBody);
+		bullet.ResetInterpolatedTransform(_pRigidBody, tr);
 	}
 	wm.BroadcastOnNodeRigidBodyTransformUpdated(this, true);
 }
@@ -204,7 +204,7 @@ void BlockNode::RemoveMaterial()
 
 MaterialPtr BlockNode::GetMaterial(bool orModelMat)
 {
-	if (!_material && orModelMat)
+	if (!_material && orModelMat && _modelNode)
 		return _modelNode->GetMaterial();
 	return _material;
 }
@@ -13,6 +13,7 @@ namespace verus
 			Mesh        _mesh;
 			MaterialPwn _material;
 			int         _refCount = 0;
+			int         _sortRank = 0;
 
 		public:
 			struct Desc : BaseNode::Desc
@@ -30,6 +31,10 @@ namespace verus
 			void AddRef() { _refCount++; }
 			int GetRefCount() const { return _refCount; }
 
+			// See WorldManager::SortVisibleNodes():
+			int GetSortRank() const { return _sortRank; }
+			void SetSortRank(int rank) { _sortRank = rank; }
+
 			void Init(RcDesc desc);
 			bool Done();
 
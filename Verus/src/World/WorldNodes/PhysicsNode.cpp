@@ -73,7 +73,7 @@ void PhysicsNode::Update()
 	if (BodyType::staticBody != _bodyType && pBlockNode && _pRigidBody && _pRigidBody->isActive() && !bullet.IsSimulationPaused())
 	{
 		btTransform btr;
-		_pRigidBody->getMotionState()->getWorldTransform(btr);
+		bullet.GetInterpolatedTransform(_pRigidBody, btr); // Async simulation has smooth snapshot.
 		pBlockNode->OverrideGlobalTransform(Transform3(btr) * VMath::inverse(GetTransform(true)));
 	}
 }
@@ -507,28 +507,44 @@ void PhysicsNode::SetFriction(float friction)
 {
 	_friction = Math::Clamp<float>(friction, 0, 1);
 	if (_pRigidBody)
-		_pRigidBody->setFriction(friction);
+	{
+		VERUS_QREF_BULLET;
+		btRigidBody* pRigidBody = _pRigidBody;
+		bullet.QueueEdit([pRigidBody, friction]() { pRigidBody->setFriction(friction); });
+	}
 }
 
 void PhysicsNode::SetRestitution(float restitution)
 {
 	_restitution = Math::Clamp<float>(restitution, 0, 1);
 	if (_pRigidBody)
-		_pRigidBody->setRestitution(restitution);
+	{
+		VERUS_QREF_BULLET;
+		btRigidBody* pRigidBody = _pRigidBody;
+		bullet.QueueEdit([pRigidBody, restitution]() { pRigidBody->setRestitution(restitution); });
+	}
 }
 
 void PhysicsNode::SetLinearDamping(float linearDamping)
 {
 	_linearDamping = Math::Clamp<float>(linearDamping, 0, 1);
 	if (_pRigidBody)
-		_pRigidBody->setDamping(_linearDamping, _angularDamping);
+	{
+		VERUS_QREF_BULLET;
+		btRigidBody* pRigidBody = _pRigidBody;
+		bullet.QueueEdit([pRigidBody, linear = _linearDamping, angular = _angularDamping]() { pRigidBody->setDamping(linear, angular); });
+	}
 }
 
 void PhysicsNode::SetAngularDamping(float angularDamping)
 {
 	_angularDamping = Math::Clamp<float>(angularDamping, 0, 1);
 	if (_pRigidBody)
-		_pRigidBody->setDamping(_linearDamping, _angularDamping);
+	{
+		VERUS_QREF_BULLET;
+		btRigidBody* pRigidBody = _pRigidBody;
+		bullet.QueueEdit([pRigidBody, linear = _linearDamping, angular = _angularDamping]() { pRigidBody->setDamping(linear, angular); });
+	}
 }
 
 // PhysicsNodePtr:
@@ -19,6 +19,10 @@
 #	pragma comment(lib, "ShLwApi.lib")
 #else
 #	include <dlfcn.h>
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
 #endif
 
 // SDL:
@@ -139,6 +143,7 @@ using namespace Microsoft::WRL;
 #include <limits>
 #include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <random>
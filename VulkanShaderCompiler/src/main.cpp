@@ -89,6 +89,14 @@ extern "C"
 		}
 	}
 
+	// Part of the key in shader cache, so increase the revision when compile options change:
+	VERUS_DLL_EXPORT CSZ VulkanCompilerVersion()
+	{
+		static const std::string version = std::string("r1, glslang ") + glslang::GetGlslVersionString();
+		return version.c_str();
+	}
+
+	// Can be called from multiple threads, results are thread-local:
 	VERUS_DLL_EXPORT bool VulkanCompile(CSZ source, CSZ sourceName, CSZ* defines, ShaderInclude* pInclude,
 		CSZ entryPoint, CSZ target, UINT32 flags, UINT32** ppCode, UINT32* pSize, CSZ* ppErrorMsgs)
 	{